@@ -1,13 +1,26 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <windows.h>
 
+#include "AutoScrollDriver.h"
+#include "CadenceController.h"
 #include "CaptureSession.h"
+#include "ClipboardPublisher.h"
 #include "ConfigManager.h"
+#include "FileWatcher.h"
 #include "HotkeyManager.h"
+#include "JobScheduler.h"
+#include "MemoryAccounting.h"
+#include "SessionQueue.h"
 #include "SettingsWindow.h"
+#include "StartupTimeline.h"
 #include "WebProcessor.h"
 
 class Application {
@@ -21,30 +34,71 @@ public:
 private:
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
+    void StartConfigWatcher();
+    void ApplyConfigChange(ConfigManager&& manager, const AppConfig& updated);
     void OnCreate();
     void OnSize();
     void OnCommand(WPARAM wParam);
+    void HandleHotkeyAction(hotkey::Action action);
     void ToggleCaptureMode();
+    // Asks whether to resume the newest session that was interrupted by a crash.
+    void OfferResume();
     void EnterCaptureMode();
     void ExitCaptureMode();
-    void HandleCaptureRequest();
-    void StartProcessing(const std::vector<std::wstring>& capturedFiles);
+    void CancelCaptureMode();
+    void DropLastCapture();
+    void RepublishLastSession();
+    void HandleCaptureRequest(UINT notches);
+    void StartAutoScroll(HWND target);
+    void StopAutoScroll();
+    void OnAutoScrollTick();
+    void FinishAtEndOfList(size_t repeatedFrames = 0);
+    void LogInputStats();
+    // Takes over a finished session and prepares it in the background.
+    void StartProcessing(std::unique_ptr<CaptureSession> session);
+    // `owner` is the in-flight session the frames belong to, or null for a republish.
+    void QueueProcessing(std::shared_ptr<const std::vector<Frame>> frames, const std::wstring& label, const CaptureSession* owner);
+    void FinishProcessing(JobStatus status, const CaptureSession* owner, const std::vector<Frame>& frames,
+                          DataUrls dataUrls, const std::wstring& label);
+    size_t InFlightBytes() const;
+    size_t MemoryBudgetBytes() const;
+    static std::wstring SessionLabel(const CaptureSession& session);
+    // Runs `callback` on the UI thread via kJobCallbackMessage.
+    void DispatchToUi(std::function<void()> callback);
     void HandleWebError(const std::wstring& message);
+    // Logs the startup timeline once, when the page is ready or failed to load.
+    void LogStartupReport();
     void UpdateStatus(const std::wstring& text);
     void OpenOutputFolder();
     void ShowSettingsDialog();
     void ClearSessionDirectory();
+    // Streams the last finished session into output\<session>.zip.
+    void ExportSession();
+    // Applies the [paths] retention limits to old sessions in the background.
+    void CollectSessions();
+    // Switches to a changed objectDirectory once no session or cleanup job
+    // uses the current store; false while it has to wait.
+    bool ApplyPendingObjectDirectory();
     std::wstring BuildIdleStatus() const;
     void LoadWindowIcon();
-    std::wstring FindIconAsset() const;
+    // Installs new window icons and destroys the ones they replace; null keeps the current icon.
+    void SetWindowIcons(HICON largeIcon, HICON smallIcon);
+    static std::wstring FindIconAsset(const std::wstring& baseDirectory);
     std::wstring MakeAbsolutePath(const std::wstring& relative) const;
     void EnsureDirectories();
-    bool CopyImagesToClipboard(const std::vector<std::wstring>& files);
+    bool CopyFramesToClipboard(const std::vector<Frame>& frames);
+    void RenderClipboardFormat(UINT nativeFormat);
     void EnsureUIFont();
 
+    // Declared first so its origin is taken before any other member is built.
+    StartupTimeline startup_;
+    bool startupReported_ = false;
+
     HINSTANCE instance_ = nullptr;
     HWND hwnd_ = nullptr;
     HWND statusStatic_ = nullptr;
+    // Per-subsystem memory under the status text, refreshed with it.
+    HWND memoryStatic_ = nullptr;
     HFONT uiFont_ = nullptr;
     HICON appIconLarge_ = nullptr;
     HICON appIconSmall_ = nullptr;
@@ -52,15 +106,40 @@ private:
     std::wstring baseDirectory_;
     std::wstring outputDirectory_;
     std::wstring sessionDirectory_;
+    std::wstring logDirectory_;
 
     ConfigManager configManager_;
     AppConfig config_{};
+    // Built-in values that a reload falls back to for keys missing from the file.
+    AppConfig defaultConfig_{};
+    std::unique_ptr<FileWatcher> configWatcher_;
 
     HotkeyManager hotkeyManager_;
-    CaptureSession captureSession_;
+    // The session being captured, sessions still being prepared (oldest first)
+    // and the last one published, kept for republishing.
+    std::unique_ptr<CaptureSession> captureSession_;
+    std::deque<std::unique_ptr<CaptureSession>> inFlightSessions_;
+    std::unique_ptr<CaptureSession> lastSession_;
+    // Shared by sessions that dedupe frames and by the jobs that delete sessions.
+    std::shared_ptr<ObjectStore> objectStore_;
     WebProcessor webProcessor_;
+    ClipboardPublisher clipboardPublisher_;
+    CadenceController cadence_{ CadenceSettings{} };
+    AutoScrollDriver autoScroll_{ AutoScrollSettings{} };
+    std::vector<motion::RowSignature> autoProbeSignatures_;
+    bool autoScrollActive_ = false;
+
+    std::unique_ptr<JobScheduler> jobs_;
+    JobHandle processingJob_;
+    JobHandle clearJob_;
+    JobHandle retentionJob_;
+    JobHandle exportJob_;
+    size_t processingJobs_ = 0;
 
     bool captureModeActive_ = false;
-    bool processingInFlight_ = false;
+    // Interrupted session the next EnterCaptureMode continues instead of starting afresh.
+    std::wstring resumeSessionRoot_;
+    // An objectDirectory edit waiting for ApplyPendingObjectDirectory().
+    std::optional<std::wstring> pendingObjectDirectory_;
     std::vector<std::wstring> currentCapturedFiles_;
 };
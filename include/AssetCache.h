@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct AssetRequest {
+    std::string url;
+    std::string ifNoneMatch;
+    std::string ifModifiedSince;
+};
+
+struct AssetResponse {
+    int status = 0;
+    std::string etag;
+    std::string lastModified;
+    std::string contentType;
+    std::string cacheControl;
+    std::vector<uint8_t> body;
+};
+
+// Transport used by the cache to reach the origin. Returns false on transport
+// failure (no response at all); HTTP errors are reported through status.
+class AssetFetcher {
+public:
+    virtual ~AssetFetcher() = default;
+    virtual bool Fetch(const AssetRequest& request, AssetResponse& response) = 0;
+};
+
+struct CachedAsset {
+    std::string url;
+    std::string hash;
+    std::string etag;
+    std::string lastModified;
+    std::string contentType;
+    int64_t storedAt = 0;
+    int64_t maxAge = 0;
+    uint64_t size = 0;
+};
+
+// On-disk, content-addressed cache for the receipt_factor site assets. Bodies
+// live under objects/<xx>/<sha256>, and index.txt maps each URL to its body hash
+// and validators. All timestamps are seconds since the Unix epoch.
+class AssetCache {
+public:
+    enum class Source {
+        Cache,
+        Network,
+        Miss
+    };
+
+    struct Result {
+        Source source = Source::Miss;
+        CachedAsset asset;
+        std::vector<uint8_t> body;
+        bool needsRevalidation = false;
+    };
+
+    explicit AssetCache(const std::filesystem::path& root);
+
+    bool Open();
+
+    // Serves from disk whenever a body is present (stale entries are flagged for
+    // background revalidation); otherwise fetches and stores the asset.
+    Result Resolve(const std::string& url, AssetFetcher& fetcher, int64_t now);
+    // Issues a conditional request with the stored ETag / Last-Modified.
+    bool Revalidate(const std::string& url, AssetFetcher& fetcher, int64_t now);
+
+    std::optional<CachedAsset> Lookup(const std::string& url) const;
+    bool ReadBody(const CachedAsset& asset, std::vector<uint8_t>& body) const;
+    // `stored`, when given, receives the entry as indexed (hash, maxAge and
+    // validators), also for a no-store response that is not kept.
+    bool Store(const std::string& url, const AssetResponse& response, int64_t now, CachedAsset* stored = nullptr);
+    bool IsFresh(const CachedAsset& asset, int64_t now) const;
+
+private:
+    std::filesystem::path ObjectPath(const std::string& hash) const;
+    bool WriteObject(const std::string& hash, const std::vector<uint8_t>& body) const;
+    void ReleaseObjectLocked(const std::string& hash);
+    bool SaveIndexLocked() const;
+
+    std::filesystem::path root_;
+    std::filesystem::path indexPath_;
+    std::map<std::string, CachedAsset> entries_;
+    // Objects being written by Store() but not indexed yet, by hash.
+    std::map<std::string, int> pendingObjects_;
+    mutable std::mutex mutex_;
+};
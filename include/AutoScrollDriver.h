@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ScrollMotion.h"
+
+struct AutoScrollSettings {
+    uint32_t notchesPerStep = 3;
+    // Delay between a scroll and the first settle probe, and between probes.
+    uint32_t settleIntervalMs = 60;
+    // Capture anyway if no motion has been seen after this long (the list is
+    // at its end, or the probes cannot measure it).
+    uint32_t maxSettleMs = 1000;
+    // Stop the run if a view that moved has not come to rest after this long.
+    uint32_t maxMotionMs = 5000;
+    // Stop the run after this many steps in a row that left the view where it
+    // was, even if the session's end-of-list detection is off or stricter.
+    uint32_t maxStillSteps = 3;
+    uint32_t maxCaptures = 1000;
+};
+
+// Hands-free capture loop: capture, scroll, wait for the view to settle,
+// capture again, until the capture session reports the end of the list. The
+// app polls the driver from a timer, performs the returned command and reports
+// the result; the driver itself does no I/O and only sees millisecond timestamps.
+class AutoScrollDriver {
+public:
+    enum class State {
+        Idle,
+        Capturing,
+        Scrolling,
+        Settling,
+        Finished
+    };
+
+    enum class Command {
+        None,
+        Capture,
+        Scroll,
+        Probe,
+        Finish
+    };
+
+    enum class FinishReason {
+        None,
+        EndOfList,
+        ViewStopped,
+        CaptureLimit,
+        CaptureFailed,
+        SettleTimeout,
+        Stopped
+    };
+
+    explicit AutoScrollDriver(const AutoScrollSettings& settings);
+
+    void Start(uint64_t nowMs);
+    void Stop();
+
+    // Returns the command due at `nowMs`, or None while waiting for a delay or
+    // for the result of the previous command.
+    Command Poll(uint64_t nowMs);
+
+    // Pass success=false when the grab failed, and endOfList once the session's
+    // EndOfListDetector has fired.
+    void OnCaptured(bool success, bool endOfList, uint64_t nowMs);
+    void OnScrolled(uint64_t nowMs);
+    // `sincePrevious` compares this probe with the previous probe (or with the
+    // last capture for the first probe after a scroll). The view counts as
+    // settled once a probe matches the one before it after motion was seen,
+    // or two probes in a row match when none was; the first probe alone never
+    // settles it, since the view may not have started moving yet.
+    void OnProbe(const motion::ShiftEstimate& sincePrevious, uint64_t nowMs);
+
+    void SetNotches(uint32_t notches);
+    uint32_t Notches() const { return notches_; }
+
+    State GetState() const { return state_; }
+    FinishReason Reason() const { return reason_; }
+    bool Active() const { return state_ != State::Idle && state_ != State::Finished; }
+    uint32_t Captures() const { return captures_; }
+    // Captures in a row, ending with the last one, taken after a step that did
+    // not move the view; each repeats the frame before it.
+    uint32_t StillSteps() const { return stillSteps_; }
+
+private:
+    void Finish(FinishReason reason);
+    void Schedule(State state, uint64_t dueMs);
+
+    AutoScrollSettings settings_;
+    State state_ = State::Idle;
+    FinishReason reason_ = FinishReason::None;
+    bool awaitingResult_ = false;
+    uint64_t dueMs_ = 0;
+    uint64_t settleStartedMs_ = 0;
+    uint32_t probes_ = 0;
+    uint32_t stillProbes_ = 0;
+    bool moved_ = false;
+    uint32_t notches_ = 1;
+    uint32_t captures_ = 0;
+    uint32_t stillSteps_ = 0;
+};
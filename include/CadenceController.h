@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "ScrollMotion.h"
+
+struct CadenceSettings {
+    // Share of each frame that should repeat content from the previous one.
+    double targetOverlap = 0.25;
+    uint32_t minNotches = 1;
+    uint32_t maxNotches = 30;
+};
+
+// Chooses how many wheel notches to wait between captures. Each capture reports
+// how far the content actually moved for the notches spent; the controller keeps
+// a running pixels-per-notch estimate and picks the largest notch count that
+// still leaves targetOverlap of the frame in common. Pure logic, no I/O.
+class CadenceController {
+public:
+    explicit CadenceController(const CadenceSettings& settings);
+
+    void Reset(uint32_t notches);
+    // Returns the updated notches-per-capture.
+    uint32_t Observe(uint32_t notches, const motion::ShiftEstimate& estimate, uint32_t frameHeight);
+
+    uint32_t NotchesPerCapture() const { return notches_; }
+    double PixelsPerNotch() const { return pixelsPerNotch_; }
+    const CadenceSettings& Settings() const { return settings_; }
+
+private:
+    uint32_t Clamp(uint32_t notches) const;
+
+    CadenceSettings settings_;
+    uint32_t notches_ = 1;
+    double pixelsPerNotch_ = 0.0;
+};
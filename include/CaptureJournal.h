@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Write-ahead journal for a capture session (session.journal next to raw\).
+// A 16-byte header ("CHRNJRNL", u32 version, u32 0) is followed by records of
+// u32 payload length, u32 CRC-32 of type and payload, u8 type and the payload,
+// all little-endian. A frame is journalled only after its PNG is on disk, and
+// a cleanly ended session closes with an End record; a journal without one
+// belongs to a session that was interrupted and can be resumed.
+namespace journal {
+
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr const wchar_t* kFileName = L"session.journal";
+
+enum class RecordType : uint8_t {
+    Begin = 1,
+    Frame = 2,
+    // Withdraws the live frame with the same index.
+    Drop = 3,
+    End = 4,
+};
+
+struct FrameEntry {
+    uint32_t index = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Size and CRC-32 of the PNG, so a resume can tell a complete file from a torn one.
+    uint32_t pngBytes = 0;
+    uint32_t pngCrc = 0;
+    // File name inside raw\, UTF-8.
+    std::string file;
+};
+
+struct JournalState {
+    bool complete = false;
+    // Frames still live after replaying drops, ordered by index.
+    std::vector<FrameEntry> frames;
+    // Length of the intact prefix; anything after it is a torn or corrupt tail.
+    uint64_t validBytes = 0;
+};
+
+// Fsyncs are batched: the journal is synced once `maxRecords` records are
+// pending or `maxDelayMs` has passed since the last sync, and always on End.
+// Appends check the delay themselves; the owner calls SyncIfDue from a timer
+// so records written just before the session goes idle are synced too.
+struct SyncPolicy {
+    uint32_t maxRecords = 8;
+    uint32_t maxDelayMs = 500;
+};
+
+class Writer {
+public:
+    explicit Writer(SyncPolicy policy = {});
+    ~Writer();
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    // Starts a new journal with a Begin record.
+    bool Create(const std::filesystem::path& path);
+    // Reopens an interrupted journal for appending, cutting off any torn tail.
+    bool Reopen(const std::filesystem::path& path, const JournalState& state);
+    bool AppendFrame(const FrameEntry& frame);
+    bool AppendDrop(uint32_t index);
+    // Writes End, syncs and closes.
+    bool Finish();
+    // Closes without an End record, leaving the session resumable.
+    void Close();
+    bool Sync();
+    // Syncs if records are pending and `maxDelayMs` has passed since the last sync.
+    bool SyncIfDue();
+    bool IsOpen() const { return file_ != nullptr; }
+    uint64_t Syncs() const { return syncs_; }
+    uint32_t PendingRecords() const { return pendingRecords_; }
+
+private:
+    bool Append(RecordType type, const std::vector<uint8_t>& payload);
+
+    SyncPolicy policy_;
+    std::FILE* file_ = nullptr;
+    uint32_t pendingRecords_ = 0;
+    std::chrono::steady_clock::time_point lastSync_{};
+    uint64_t syncs_ = 0;
+};
+
+// Replays a journal. Fails only when the header is missing or wrong; reading
+// stops at the first truncated record or CRC mismatch.
+bool ReadJournal(const std::filesystem::path& path, JournalState& state);
+
+struct IncompleteSession {
+    std::filesystem::path root;
+    size_t frames = 0;
+};
+
+// Session folders under `root` whose journal has frames but no End record, newest first.
+std::vector<IncompleteSession> FindIncompleteSessions(const std::filesystem::path& root);
+// Appends End to an interrupted journal so it is no longer offered for resume.
+bool MarkAbandoned(const std::filesystem::path& sessionRoot);
+
+} // namespace journal
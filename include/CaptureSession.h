@@ -1,29 +1,72 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <windows.h>
 
+#include "CaptureJournal.h"
+#include "EndOfListDetector.h"
+#include "FrameStore.h"
+#include "MemoryAccounting.h"
+#include "ObjectStore.h"
+#include "SessionManifest.h"
+
 class CaptureSession {
 public:
     CaptureSession();
 
     bool Begin(HWND targetWindow, const std::wstring& baseDirectory);
-    std::wstring CaptureNext();
+    // Continues an interrupted session from its journal: frames whose PNGs
+    // survived intact are reloaded and numbering carries on after them.
+    bool Resume(HWND targetWindow, const std::wstring& sessionRoot);
+    // With a store, frames are written through it and deduplicated across sessions.
+    void SetObjectStore(std::shared_ptr<ObjectStore> store) { objectStore_ = std::move(store); }
+    // Pass afterScroll when the view was scrolled since the previous capture;
+    // only those frames count towards end-of-list detection.
+    std::wstring CaptureNext(bool afterScroll = false);
     std::vector<std::wstring> End();
+    // Deletes the newest frame from memory and disk so the next capture reuses its number.
+    bool DropLast();
+    void SetEndOfList(const EndOfListSettings& settings) { endOfList_ = EndOfListDetector(settings); }
+    // True once scrolling has stopped moving the content (see EndOfListDetector).
+    bool AtEndOfList() const { return endOfList_.Reached(); }
+    // Deletes the frames captured after the list stopped moving, or the last
+    // `atLeast` if the caller saw more of them; returns how many.
+    size_t DropTrailingDuplicates(size_t atLeast = 0);
+    // Ends the session and deletes everything it wrote.
+    void Cancel();
+    // Fsyncs journal records left pending since the last sync; called from a timer.
+    void SyncJournal() { journal_.SyncIfDue(); }
+    // Grabs the target window without encoding or storing it; used to detect
+    // when scrolling has settled.
+    bool Probe(std::vector<motion::RowSignature>& signatures);
     bool IsActive() const { return active_; }
     HWND TargetWindow() const { return targetWindow_; }
     const std::wstring& SessionRoot() const { return sessionRoot_; }
+    const FrameStore& Frames() const { return frames_; }
+    // The arena behind this session's frames and PNG buffers; null once the session has ended.
+    const SessionArena* Arena() const { return arena_.get(); }
+    // Memory allocated or charged for this session alone; kept after End().
+    const std::shared_ptr<memory::Ledger>& MemoryLedger() const { return ledger_; }
 
 private:
-    bool CaptureWindowToFile(HWND hwnd, const std::wstring& filePath);
-    std::wstring NextCaptureFilename() const;
+    bool CaptureWindow(HWND hwnd, Frame& frame);
+    bool GrabWindow(HWND hwnd, Frame& frame);
+    bool RemoveLast(bool restorePixels = true);
+    void AppendManifest(const Frame& frame);
 
     HWND targetWindow_ = nullptr;
     std::wstring baseDirectory_;
     std::wstring sessionRoot_;
     std::wstring rawDirectory_;
-    std::vector<std::wstring> capturedFiles_;
+    FrameStore frames_;
+    manifest::Writer manifest_;
+    journal::Writer journal_;
+    std::shared_ptr<ObjectStore> objectStore_;
+    std::shared_ptr<memory::Ledger> ledger_;
+    std::shared_ptr<SessionArena> arena_;
+    EndOfListDetector endOfList_{ EndOfListSettings{} };
     size_t captureIndex_ = 0;
     bool active_ = false;
 };
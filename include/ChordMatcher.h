@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace hotkey {
+
+// Virtual-key codes the matcher treats specially. Values match the Win32 VK_*
+// constants so hook data can be fed in unchanged.
+constexpr uint8_t kKeyShift = 0x10;
+constexpr uint8_t kKeyControl = 0x11;
+constexpr uint8_t kKeyMenu = 0x12;
+constexpr uint8_t kKeyLeftWin = 0x5B;
+constexpr uint8_t kKeyRightWin = 0x5C;
+constexpr uint8_t kKeyLeftShift = 0xA0;
+constexpr uint8_t kKeyRightShift = 0xA1;
+constexpr uint8_t kKeyLeftControl = 0xA2;
+constexpr uint8_t kKeyRightControl = 0xA3;
+constexpr uint8_t kKeyLeftMenu = 0xA4;
+constexpr uint8_t kKeyRightMenu = 0xA5;
+// Windows has no generic Win key code; 0x07 is unassigned and stands in for
+// "either Win key" the same way VK_SHIFT does for the two Shift keys.
+constexpr uint8_t kKeyAnyWin = 0x07;
+
+enum class Action : uint8_t {
+    Toggle,
+    CaptureNow,
+    CancelSession,
+    DropLastFrame,
+    Republish,
+    Count
+};
+
+// Fixed 256-bit set indexed by virtual-key code.
+class KeySet {
+public:
+    void Set(uint8_t key) { words_[key >> 6] |= Bit(key); }
+    void Reset(uint8_t key) { words_[key >> 6] &= ~Bit(key); }
+    bool Test(uint8_t key) const { return (words_[key >> 6] & Bit(key)) != 0; }
+    void Clear() { words_ = {}; }
+    bool Empty() const { return (words_[0] | words_[1] | words_[2] | words_[3]) == 0; }
+    size_t Count() const;
+    // True when every key in `other` is also in this set.
+    bool Contains(const KeySet& other) const {
+        return ((words_[0] & other.words_[0]) == other.words_[0]) &
+               ((words_[1] & other.words_[1]) == other.words_[1]) &
+               ((words_[2] & other.words_[2]) == other.words_[2]) &
+               ((words_[3] & other.words_[3]) == other.words_[3]);
+    }
+
+private:
+    static uint64_t Bit(uint8_t key) { return uint64_t{ 1 } << (key & 63); }
+
+    std::array<uint64_t, 4> words_{};
+};
+
+// Tracks held keys and matches them against a small table of chord bindings.
+// A binding fires on any key-down while all of its keys are held, then stays
+// latched until one of its keys or any modifier is released. When several
+// bindings match, the one with the most keys wins. No allocation after Bind.
+class ChordMatcher {
+public:
+    static constexpr size_t kMaxBindings = static_cast<size_t>(Action::Count);
+
+    // Replaces the chord for `action`; an empty set disables it.
+    void Bind(Action action, const KeySet& keys);
+    void ClearBindings();
+    // Forgets held keys and latches (e.g. after the bindings change).
+    void ResetState();
+
+    std::optional<Action> KeyDown(uint32_t key);
+    void KeyUp(uint32_t key);
+
+    const KeySet& Held() const { return held_; }
+
+private:
+    struct Binding {
+        KeySet keys;
+        size_t weight = 0;
+        Action action = Action::Toggle;
+    };
+
+    void UpdateGenericKeys();
+    void Rebuild();
+
+    std::array<KeySet, kMaxBindings> chords_{};
+    // Enabled bindings ordered by descending weight.
+    std::array<Binding, kMaxBindings> table_{};
+    size_t tableSize_ = 0;
+    KeySet held_;
+    uint32_t latched_ = 0;
+};
+
+bool IsModifierKey(uint32_t key);
+
+} // namespace hotkey
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FrameStore.h"
+
+namespace clipboard {
+
+// CF_DIB block: BITMAPINFOHEADER followed by the frame's pixels (32bpp, top-down).
+size_t DibPacketSize(const Frame& frame);
+bool WriteDibPacket(const Frame& frame, uint8_t* dst, size_t size);
+
+// Registered "PNG" format: the already-encoded PNG bytes, unchanged.
+size_t PngPacketSize(const Frame& frame);
+bool WritePngPacket(const Frame& frame, uint8_t* dst, size_t size);
+
+// CF_HDROP block: DROPFILES header followed by the frames' file paths as a
+// double-null-terminated UTF-16 list. Frames without a path are skipped.
+size_t FileListPacketSize(const std::vector<Frame>& frames);
+bool WriteFileListPacket(const std::vector<Frame>& frames, uint8_t* dst, size_t size);
+
+} // namespace clipboard
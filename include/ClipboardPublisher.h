@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "FrameStore.h"
+#include "MemoryAccounting.h"
+
+enum class ClipboardFormat {
+    Dib,
+    Png,
+    FileList
+};
+
+// Thin seam over the OS clipboard so the render-on-demand logic can run without it.
+class ClipboardBackend {
+public:
+    using Writer = std::function<bool(uint8_t* data, size_t size)>;
+
+    virtual ~ClipboardBackend() = default;
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+    virtual bool Empty() = 0;
+    virtual bool IsOwner() const = 0;
+    // Announces a format without data; the OS asks for it later.
+    virtual bool Offer(ClipboardFormat format) = 0;
+    // Supplies a format's data; `write` fills a block of `size` bytes in place.
+    virtual bool Provide(ClipboardFormat format, size_t size, const Writer& write) = 0;
+};
+
+// Publishes frames with delayed rendering: nothing is converted until another
+// application actually asks for a format (WM_RENDERFORMAT), or until the owner
+// window goes away while still holding the clipboard (WM_RENDERALLFORMATS).
+// The image formats always carry the last frame; with `includeFileList` the
+// whole session is also offered as a file list pointing at the frames on disk.
+class ClipboardPublisher {
+public:
+    bool Publish(ClipboardBackend& backend, const std::vector<Frame>& frames, bool includeFileList);
+    bool Render(ClipboardBackend& backend, ClipboardFormat format);
+    bool RenderAll(ClipboardBackend& backend);
+    void Release();
+
+    bool HasContent() const { return !frames_.empty(); }
+
+private:
+    std::vector<Frame> frames_;
+    std::vector<ClipboardFormat> offered_;
+    // Packets handed to the OS, charged once per format until the next publish.
+    std::vector<ClipboardFormat> rendered_;
+    memory::Charge charge_{ memory::Tag::Clipboard };
+};
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <windows.h>
 
+#include "IniDocument.h"
+
 struct HotkeyConfig {
     UINT primaryKey = VK_RSHIFT;
     bool requireWin = true;
@@ -17,17 +20,87 @@ struct HotkeyConfig {
     ShiftMode shiftMode = ShiftMode::RightOnly;
 };
 
+// Optional chords for in-session actions, stored as strings such as
+// "Win+Ctrl+F9" under [bindings]. A primaryKey of 0 disables the binding.
+struct HotkeyBindings {
+    HotkeyConfig captureNow{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+    HotkeyConfig cancelSession{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+    HotkeyConfig dropLastFrame{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+    HotkeyConfig republish{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+};
+
 struct AppPaths {
     std::wstring outputDirectory;
     std::wstring sessionDirectory;
+    // Shared frame objects used when dedupeFrames is on.
+    std::wstring objectDirectory;
+    // Session history limits enforced by the background collector; 0 disables.
+    uint64_t maxSessionBytes = 2ull << 30;
+    int64_t maxSessionAgeSeconds = 30 * 86400;
+    UINT keepLastN = 20;
 };
 
 struct AppConfig {
     HotkeyConfig hotkey;
+    HotkeyBindings bindings;
     AppPaths paths;
     UINT scrollsPerCapture = 3;
+    // Adjust scrollsPerCapture during a session from the measured frame overlap.
+    bool adaptiveCadence = false;
+    UINT targetOverlapPercent = 25;
+    // Hold back wheel input while captures are still pending.
+    bool scrollPacing = false;
+    UINT maxPendingCaptures = 1;
+    bool autoScroll = false;
+    // Post-scroll frames without motion that end the session; 0 turns detection off.
+    UINT endOfListFrames = 2;
+    UINT endOfListTolerance = 0;
+    // Finished sessions that may still be preparing when a new capture starts;
+    // 0 waits for each session to finish first.
+    UINT maxInFlightSessions = 2;
+    // Image sets the page bridge can page through.
+    UINT maxPublishedSets = 5;
+    // Cap for in-flight session frames, and separately for published images.
+    UINT memoryBudgetMegabytes = 512;
+    // Store frames once in the content-addressed object store and link sessions to them.
+    bool dedupeFrames = false;
+    enum class ClipboardMode {
+        LastFrame,
+        AllFrames
+    };
+    ClipboardMode clipboardMode = ClipboardMode::LastFrame;
+    // Writes every hook event to logs\input-<timestamp>.bin for later replay.
+    bool recordInput = false;
 };
 
+// Which groups of settings differ between two configs, so a reload only
+// touches the subsystems that care.
+struct ConfigDiff {
+    bool hotkey = false;
+    bool bindings = false;
+    bool paths = false;
+    bool scrollsPerCapture = false;
+    bool scrollPacing = false;
+    bool publishing = false;
+    bool recordInput = false;
+    bool retention = false;
+    // Kept apart from `paths`: reopening the object store under running
+    // sessions or jobs would leave two indexes for the same objects.
+    bool objectDirectory = false;
+    // Settings that are read when next used (cadence, end of list, auto
+    // scroll, clipboard mode, in-flight limit, dedupe) and need no action.
+    bool deferred = false;
+
+    bool Any() const {
+        return hotkey || bindings || paths || scrollsPerCapture || scrollPacing || publishing || recordInput || retention ||
+               objectDirectory || deferred;
+    }
+};
+
+ConfigDiff DiffConfig(const AppConfig& before, const AppConfig& after);
+
+// Reads config.ini once into an IniDocument and writes it back only when a
+// value actually changed; comments and unknown keys survive a save.
 class ConfigManager {
 public:
     explicit ConfigManager(const std::wstring& baseDirectory);
@@ -40,4 +113,5 @@ public:
 private:
     std::wstring baseDirectory_;
     std::wstring configPath_;
+    IniDocument document_;
 };
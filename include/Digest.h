@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace digest {
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+class Sha256 {
+public:
+    Sha256();
+
+    void Update(const void* data, size_t size);
+    Sha256Digest Finish();
+
+private:
+    void ProcessBlock(const uint8_t* block);
+
+    std::array<uint32_t, 8> state_{};
+    std::array<uint8_t, 64> buffer_{};
+    size_t bufferSize_ = 0;
+    uint64_t totalBytes_ = 0;
+};
+
+Sha256Digest ComputeSha256(const void* data, size_t size);
+std::string ToHex(const Sha256Digest& digest);
+
+// CRC-32 (IEEE 802.3, as used by zlib and ZIP). Pass the previous result as
+// `crc` to continue a running checksum over several buffers.
+uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+
+} // namespace digest
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "ScrollMotion.h"
+
+struct EndOfListSettings {
+    // Consecutive post-scroll frames without motion that end the list; 0 disables detection.
+    uint32_t stillFrames = 2;
+    // Shifts up to this many pixels still count as no motion.
+    uint32_t tolerancePx = 0;
+};
+
+// Decides when scrolling has reached the bottom of the list: the content stops
+// moving for stillFrames captures in a row even though the wheel kept turning.
+// Frames that were not preceded by a scroll must not be fed in. Pure logic.
+class EndOfListDetector {
+public:
+    explicit EndOfListDetector(const EndOfListSettings& settings);
+
+    void Reset();
+    // `sincePrevious` is the motion relative to the previous frame (empty when
+    // it could not be measured). Returns true once the end has been reached.
+    bool Observe(const std::optional<motion::ShiftEstimate>& sincePrevious);
+
+    bool Reached() const { return reached_; }
+    // Newest frames that repeat the one before them.
+    uint32_t TrailingDuplicates() const { return stillFrames_; }
+    // Returns the duplicate count and forgets it, so the frames are only dropped once.
+    uint32_t TakeTrailingDuplicates();
+    const EndOfListSettings& Settings() const { return settings_; }
+
+private:
+    EndOfListSettings settings_;
+    uint32_t stillFrames_ = 0;
+    bool reached_ = false;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+// Watches a single file for changes. Editors and our own IniDocument::Save
+// replace files by rename, so backends watch the parent directory and match
+// the file name. Bursts of events are coalesced: the callback fires once the
+// file has been quiet for a short while. The callback runs on the watcher's
+// own thread.
+class FileWatcher {
+public:
+    using Callback = std::function<void()>;
+
+    virtual ~FileWatcher() = default;
+
+    virtual bool Start(const std::filesystem::path& file, Callback onChanged) = 0;
+    // Blocks until the watcher thread has exited; no callback runs afterwards.
+    virtual void Stop() = 0;
+
+    // ReadDirectoryChangesW on Windows, inotify on Linux.
+    static std::unique_ptr<FileWatcher> Create();
+};
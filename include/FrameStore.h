@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <optional>
+#include <vector>
+
+#include "Digest.h"
+#include "ScrollMotion.h"
+#include "SessionArena.h"
+
+// Polymorphic so session buffers can come from a SessionArena; a default
+// constructed buffer uses the heap.
+using ByteBuffer = std::pmr::vector<uint8_t>;
+
+// An empty buffer whose bytes are allocated from `resource` (a SessionArena or
+// a memory::Ledger resource), which stays alive until the last such buffer is
+// released. A null resource gives a heap buffer.
+std::shared_ptr<ByteBuffer> MakeSessionBuffer(const std::shared_ptr<std::pmr::memory_resource>& resource);
+// The same with the buffer's shared-ownership block placed in the arena as
+// well, so making a buffer does not touch the heap while the arena has room.
+std::shared_ptr<ByteBuffer> MakeSessionBuffer(const std::shared_ptr<SessionArena>& arena);
+
+// One captured frame. Pixels are 32bpp BGRX, top-down, `stride` bytes per row.
+// Buffers are shared so a frame can outlive its slot in the store (e.g. while
+// it is published to the clipboard) without copying. The path and row
+// signatures use the resource the frame was made with; a copy uses the heap.
+struct Frame {
+    Frame() = default;
+    explicit Frame(std::pmr::memory_resource* resource)
+        : path(resource), signatures(resource) {
+    }
+
+    size_t index = 0;
+    std::pmr::wstring path;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    std::shared_ptr<const ByteBuffer> pixels;
+    std::shared_ptr<const ByteBuffer> png;
+    // Screen position of the captured window, capture time (ms since the Unix
+    // epoch), PNG encode time and the PNG's SHA-256; recorded in the manifest.
+    int32_t left = 0;
+    int32_t top = 0;
+    uint64_t capturedAtMs = 0;
+    uint32_t encodeMicros = 0;
+    digest::Sha256Digest sha256{};
+    // The raw file is a link into the shared ObjectStore and holds a reference there.
+    bool shared = false;
+    // Row signatures of this frame and its measured motion relative to the
+    // previous frame (empty for the first frame or after a size change).
+    std::pmr::vector<motion::RowSignature> signatures;
+    std::optional<motion::ShiftEstimate> shift;
+};
+
+// In-memory frames for the current session. Encoded PNG bytes are kept for every
+// frame; raw pixels only for the most recent one. With a session arena, the
+// frame list and what NewFrame() and NewBuffer() hand out are allocated from
+// it, so adding a frame does not touch the heap while the arena has room.
+class FrameStore {
+public:
+    // Turns a frame's PNG back into pixels with stride width * 4; returns null
+    // when the PNG does not decode to the frame's dimensions.
+    using PixelDecoder = std::function<std::shared_ptr<const ByteBuffer>(const Frame& frame)>;
+
+    void SetPixelDecoder(PixelDecoder decoder) { decoder_ = std::move(decoder); }
+    void Clear();
+    // Clears the store and allocates from `arena` from now on; null uses the heap.
+    void Reset(std::shared_ptr<SessionArena> arena);
+    // An empty frame, and an empty PNG buffer, allocated from the store's arena.
+    Frame NewFrame() const;
+    std::shared_ptr<ByteBuffer> NewBuffer() const { return MakeSessionBuffer(arena_); }
+    const Frame& Add(Frame frame);
+    // Removes the newest frame. The frame before it becomes the last one and
+    // regains its pixels through the decoder, if one is set; a caller dropping
+    // several frames can skip that and call RestoreLastPixels() once.
+    bool DropLast(bool restorePixels = true);
+    // Decodes the last frame's PNG if its pixels were released. True when the
+    // last frame has pixels afterwards.
+    bool RestoreLastPixels();
+    // Swaps the newest frame for `frame` without touching the others.
+    const Frame& ReplaceLast(Frame frame);
+
+    bool Empty() const { return frames_.empty(); }
+    size_t Size() const { return frames_.size(); }
+    const Frame& Last() const { return frames_.back(); }
+    const std::pmr::vector<Frame>& Frames() const { return frames_; }
+    // Encoded and raw bytes held by the store.
+    size_t Bytes() const;
+
+private:
+    // Declared first so the list is released before its arena.
+    std::shared_ptr<SessionArena> arena_;
+    std::pmr::vector<Frame> frames_;
+    PixelDecoder decoder_;
+};
@@ -2,48 +2,123 @@
 
 #include <atomic>
 #include <functional>
-#include <unordered_set>
+#include <future>
+#include <memory>
+#include <thread>
 #include <windows.h>
 
 #include "ConfigManager.h"
+#include "InputLog.h"
+#include "InputProcessor.h"
+#include "InputQueue.h"
+#include "LatencyHistogram.h"
+#include "ScrollPacer.h"
 
 class HotkeyManager {
 public:
-    using ToggleCallback = std::function<void()>;
-    using CaptureRequest = std::function<void()>;
+    using ActionCallback = std::function<void(hotkey::Action)>;
+    using CaptureRequest = std::function<void(UINT notches)>;
+
+    // Hook-procedure run times in nanoseconds. slowHooks counts invocations that
+    // took at least half of the system's LowLevelHooksTimeout.
+    struct HookLatencyReport {
+        LatencyHistogram::Summary keyboard;
+        LatencyHistogram::Summary mouse;
+        uint64_t slowHooks = 0;
+        DWORD timeoutMs = 0;
+    };
+
+    struct PacingReport {
+        ScrollPacer::Stats stats;
+        // Time from holding a wheel notch back to re-injecting it, in nanoseconds.
+        LatencyHistogram::Summary releaseLatency;
+        uint64_t droppedEvents = 0;
+    };
+
+    // dwExtraInfo carried by wheel input this process injects itself.
+    static constexpr ULONG_PTR kSyntheticInputTag = 0x43485243;
 
     HotkeyManager();
     ~HotkeyManager();
 
-    bool Initialize(const HotkeyConfig& config, UINT scrollsPerCapture, ToggleCallback onToggle, CaptureRequest onCaptureRequest);
-    void UpdateConfig(const HotkeyConfig& config);
+    bool Initialize(const HotkeyConfig& config, const HotkeyBindings& bindings, UINT scrollsPerCapture, ActionCallback onAction, CaptureRequest onCaptureRequest);
+    void UpdateConfig(const HotkeyConfig& config, const HotkeyBindings& bindings);
     void Shutdown();
 
     bool IsCaptureModeEnabled() const { return captureMode_.load(); }
     void SetCaptureMode(bool enabled);
     void SetScrollsPerCapture(UINT count);
+    UINT ScrollsPerCapture() const { return processor_.ScrollsPerCapture(); }
+
+    // Appends every keyboard and mouse hook event to a binary log (see
+    // InputLog.h): wheel notches outside capture mode and the ones the pacer
+    // holds back are logged too, marked so replay can tell them apart. Mouse
+    // moves and buttons are only queued while a recording is open.
+    bool StartRecording(const std::wstring& path);
+    void StopRecording();
+
+    HookLatencyReport HookLatency() const;
+    void ResetHookLatency();
+
+    // With pacing on, downward wheel notches are held back while
+    // `maxPendingCaptures` scroll-triggered captures are still unfinished, and
+    // re-injected as NotifyCaptureCompleted reports them done. Takes effect the
+    // next time capture mode is enabled.
+    void SetScrollPacing(bool enabled, UINT maxPendingCaptures);
+    void NotifyCaptureCompleted();
+    PacingReport Pacing() const;
 
 private:
     static LRESULT CALLBACK KeyboardProc(int code, WPARAM wParam, LPARAM lParam);
     static LRESULT CALLBACK MouseProc(int code, WPARAM wParam, LPARAM lParam);
+    static LRESULT CALLBACK NotifyWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
+    static void CALLBACK PacerTimerProc(HWND hwnd, UINT message, UINT_PTR id, DWORD time);
 
-    void HandleKeyboardEvent(WPARAM wParam, const KBDLLHOOKSTRUCT* data);
-    void HandleMouseEvent(WPARAM wParam, const MSLLHOOKSTRUCT* data);
-    bool CheckToggleCondition(UINT vkCode, bool isKeyDown);
-    void ResetCombinationLatch();
+    bool CreateNotifyWindow();
+    void InputThreadMain(std::promise<bool>& started);
+    void PushEvent(const InputEvent& event);
+    void DrainInput();
+    void ProcessEvent(const InputEvent& event);
+    void ApplyBindings();
+    void RecordHookLatency(LatencyHistogram& histogram, LONGLONG startTicks);
+    uint64_t NowNanoseconds() const;
+    bool HandleInputThreadMessage(const MSG& msg);
+    void InjectWheel(const int16_t* deltas, size_t count);
 
     HotkeyConfig config_{};
-    ToggleCallback onToggle_{};
+    HotkeyBindings bindings_{};
+    ActionCallback onAction_{};
     CaptureRequest onCaptureRequest_{};
 
     static HotkeyManager* instance_;
 
+    // Hooks live on a dedicated input thread so a busy UI thread never delays
+    // system-wide input; events reach the UI thread through queue_.
     HHOOK keyboardHook_ = nullptr;
     HHOOK mouseHook_ = nullptr;
+    std::thread inputThread_;
+    DWORD inputThreadId_ = 0;
+    HWND notifyWindow_ = nullptr;
+    InputQueue queue_;
+
+    LatencyHistogram keyboardLatency_;
+    LatencyHistogram mouseLatency_;
+    LONGLONG qpcFrequency_ = 1;
+    DWORD hookTimeoutMs_ = 0;
+    uint64_t slowHookThresholdNs_ = 0;
+    std::atomic<uint64_t> slowHooks_{ 0 };
+    uint64_t reportedSlowHooks_ = 0;
+
+    // pacer_ and pacerTimer_ belong to the input thread; the app thread talks to
+    // them through thread messages.
+    ScrollPacer pacer_;
+    UINT_PTR pacerTimer_ = 0;
+    std::atomic<bool> pacingEnabled_{ false };
+    std::atomic<UINT> maxPendingCaptures_{ 1 };
+    std::atomic<UINT> pacerNotches_{ 1 };
 
-    std::unordered_set<UINT> keysDown_;
+    InputProcessor processor_;
+    std::unique_ptr<inputlog::Writer> recorder_;
+    std::atomic<bool> recording_{ false };
     std::atomic<bool> captureMode_{ false };
-    std::atomic<bool> consumedCombination_{ false };
-    UINT scrollsPerCapture_ = 1;
-    UINT pendingScrolls_ = 0;
 };
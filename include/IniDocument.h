@@ -0,0 +1,84 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// In-memory INI file. Parsed once, queried and edited in place, and written
+// back in one go. Lines the model does not touch (comments, blank lines,
+// unknown keys and sections) are kept verbatim and in order, so saving only
+// changes the values that were set. Section and key names compare
+// case-insensitively, as with the Win32 profile API. Text is held as UTF-8;
+// Load() converts UTF-16 files and legacy code page files. Platform-neutral.
+class IniDocument {
+public:
+    // How the file was stored. Save() writes the same encoding back, except
+    // that Legacy files become UTF-8 with a BOM, so editors that assume the
+    // ANSI code page for BOM-less files still read them right.
+    enum class Encoding {
+        Utf8,
+        Utf8Bom,
+        Utf16Le,
+        Utf16Be,
+        Legacy
+    };
+
+    // Converts text in the system's legacy code page to UTF-8.
+    using LegacyDecoder = std::function<std::string(const std::string&)>;
+
+    // A missing file yields an empty document and false; the document is then
+    // still usable and Save() creates the file. UTF-16 needs a BOM. Anything
+    // else that is not valid UTF-8 goes through `legacy`, or is read as
+    // Latin-1 without one.
+    bool Load(const std::filesystem::path& path, const LegacyDecoder& legacy = {});
+    // Parses UTF-8 text; a leading BOM is skipped.
+    void Parse(const std::string& text);
+    std::string Serialize() const;
+    // Writes to a temporary file next to `path` and renames it over the
+    // original, so readers never see a half-written file. Clears Dirty().
+    bool Save(const std::filesystem::path& path);
+
+    bool Has(const std::string& section, const std::string& key) const;
+    std::optional<std::string> Get(const std::string& section, const std::string& key) const;
+    std::string GetString(const std::string& section, const std::string& key, const std::string& fallback) const;
+    // Leading decimal digits with an optional sign; the fallback when absent,
+    // unparsable or out of range.
+    long long GetInt(const std::string& section, const std::string& key, long long fallback) const;
+    bool GetBool(const std::string& section, const std::string& key, bool fallback) const;
+
+    // Setters only mark the document dirty when the stored text changes. New
+    // keys go after the last key of their section; new sections at the end.
+    void Set(const std::string& section, const std::string& key, const std::string& value);
+    void SetInt(const std::string& section, const std::string& key, long long value);
+    void SetBool(const std::string& section, const std::string& key, bool value);
+
+    bool Dirty() const { return dirty_; }
+    Encoding FileEncoding() const { return encoding_; }
+
+private:
+    struct Line {
+        // Verbatim text for comments, blank lines and anything unparsable.
+        std::string raw;
+        std::string key;
+        std::string value;
+        bool isEntry = false;
+    };
+
+    struct Section {
+        // Empty for the lines before the first [section] header.
+        std::string name;
+        std::string header;
+        std::vector<Line> lines;
+    };
+
+    const Line* Find(const std::string& section, const std::string& key) const;
+    Line* Find(const std::string& section, const std::string& key);
+    Section& EnsureSection(const std::string& section);
+
+    std::vector<Section> sections_;
+    std::string newline_ = "\r\n";
+    Encoding encoding_ = Encoding::Utf8;
+    bool dirty_ = false;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "InputProcessor.h"
+#include "InputQueue.h"
+#include "ScrollPacer.h"
+
+// Binary input log: a 16-byte header ("CHRNINPT", u32 version, u32 record
+// size) followed by fixed 16-byte little-endian InputEvent records. Version 2
+// records every keyboard and mouse hook event; version 1 logs only had keys
+// and the wheel notches that reached the app in capture mode.
+namespace inputlog {
+
+constexpr uint32_t kVersion = 2;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kRecordSize = 16;
+
+void EncodeRecord(const InputEvent& event, uint8_t* out);
+InputEvent DecodeRecord(const uint8_t* in);
+
+class Writer {
+public:
+    ~Writer();
+
+    bool Open(const std::filesystem::path& path);
+    bool Append(const InputEvent& event);
+    bool Flush();
+    void Close();
+    bool IsOpen() const { return out_.is_open(); }
+    uint64_t Count() const { return count_; }
+
+private:
+    std::ofstream out_;
+    uint64_t count_ = 0;
+};
+
+// Reads a whole log. Fails on a bad header; a truncated trailing record is dropped.
+bool ReadLog(const std::filesystem::path& path, std::vector<InputEvent>& events);
+
+struct ReplayStats {
+    size_t events = 0;
+    size_t actions = 0;
+    size_t captureRequests = 0;
+    // Wheel notches the pacer held back and later re-injected (ReplayPaced only).
+    size_t held = 0;
+    size_t released = 0;
+};
+
+using ReplayHandler = std::function<void(const InputEvent&, const InputProcessor::Result&)>;
+
+// Feeds events through `processor` in order, skipping ones the pacer held
+// back. A speed of 1 reproduces the recorded timing, 10 plays ten times
+// faster, and 0 (or less) runs without waiting.
+ReplayStats Replay(const std::vector<InputEvent>& events, InputProcessor& processor, double speed, const ReplayHandler& handler);
+
+struct PacedReplayOptions {
+    // Log milliseconds from a scroll-triggered capture request to its
+    // completion. Negative uses the log's CaptureDone markers instead.
+    int32_t captureMs = -1;
+    uint32_t tickMs = ScrollPacer::kTickMs;
+    uint64_t timeoutNs = ScrollPacer::kLostCaptureNs;
+    double speed = 0.0;
+};
+
+// Replays with the scroll pacer in front of the processor, as the hooks run
+// with pacing on: in capture mode every wheel notch goes through `pacer`,
+// completions and timer ticks release held notches, and released notches are
+// processed again as re-injected ones. Held and re-injected records already in
+// the log are skipped because the pacer produces its own. The handler sees the
+// stream a live recording would have logged, Held and CaptureDone included.
+// The caller configures `pacer` (maxOutstanding) before replaying.
+ReplayStats ReplayPaced(const std::vector<InputEvent>& events, InputProcessor& processor, ScrollPacer& pacer,
+                        const PacedReplayOptions& options, const ReplayHandler& handler);
+
+} // namespace inputlog
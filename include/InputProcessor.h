@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "ChordMatcher.h"
+#include "InputQueue.h"
+
+// Platform-neutral half of the hotkey pipeline: chord matching plus the
+// scroll accumulator that turns wheel notches into capture requests. Live
+// input and replayed logs both go through Process.
+class InputProcessor {
+public:
+    struct Result {
+        std::optional<hotkey::Action> action;
+        bool captureRequested = false;
+        // Wheel notches accumulated for this capture request.
+        uint32_t notches = 0;
+    };
+
+    hotkey::ChordMatcher& Matcher() { return matcher_; }
+    const hotkey::ChordMatcher& Matcher() const { return matcher_; }
+
+    void SetCaptureMode(bool enabled);
+    bool CaptureMode() const { return captureMode_; }
+    void SetScrollsPerCapture(uint32_t count);
+    uint32_t ScrollsPerCapture() const { return scrollsPerCapture_; }
+
+    Result Process(const InputEvent& event);
+
+private:
+    hotkey::ChordMatcher matcher_;
+    bool captureMode_ = false;
+    uint32_t scrollsPerCapture_ = 1;
+    uint32_t pendingScrolls_ = 0;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "SpscRing.h"
+
+// Fixed-size record for one low-level hook event. CaptureMode is a marker the
+// app thread inserts when capture mode changes (flags holds the new state) so
+// recorded logs replay with the same scroll gating; CaptureDone marks a
+// scroll-triggered capture the app finished, which frees notches the scroll
+// pacer held. vkCode is the key, or the VK_*BUTTON code for mouse buttons;
+// MouseMove keeps the cursor's screen x and y in vkCode and flags instead of
+// the hook flags.
+struct InputEvent {
+    enum class Kind : uint8_t {
+        KeyDown,
+        KeyUp,
+        Wheel,
+        CaptureMode,
+        MouseMove,
+        MouseDown,
+        MouseUp,
+        HorizontalWheel,
+        CaptureDone
+    };
+    // Bits in `marks`.
+    // The OS reported the event as injected.
+    static constexpr uint8_t kInjected = 1;
+    // A wheel notch the scroll pacer released earlier.
+    static constexpr uint8_t kReinjected = 2;
+    // Held back by the scroll pacer; the target window and the app did not see it.
+    static constexpr uint8_t kHeld = 4;
+
+    Kind kind = Kind::KeyDown;
+    uint8_t marks = 0;
+    int16_t wheelDelta = 0;
+    uint32_t vkCode = 0;
+    uint32_t flags = 0;
+    uint32_t time = 0;
+};
+
+static_assert(sizeof(InputEvent) == 16, "InputEvent must stay a compact fixed-size record");
+
+// Hand-off between the input thread (producer) and the app thread (consumer).
+// Wake-ups are coalesced: the producer is told to signal the consumer only for
+// the first event after each drain.
+class InputQueue {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    // Producer side. Returns true when the consumer needs to be woken.
+    bool Push(const InputEvent& event) {
+        if (!ring_.TryPush(event)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return !wakePending_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // Consumer side. The wake flag is re-armed before popping so an event pushed
+    // during the drain always triggers another wake-up.
+    template <typename Handler>
+    size_t Drain(Handler&& handler) {
+        wakePending_.store(false, std::memory_order_release);
+        size_t count = 0;
+        InputEvent event;
+        while (ring_.TryPop(event)) {
+            handler(event);
+            ++count;
+        }
+        return count;
+    }
+
+    size_t Depth() const { return ring_.SizeApprox(); }
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    SpscRing<InputEvent, kCapacity> ring_;
+    std::atomic<bool> wakePending_{ false };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
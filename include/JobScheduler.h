@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class JobPriority {
+    High,
+    Normal,
+    Low
+};
+
+enum class JobStatus {
+    Pending,
+    Running,
+    Succeeded,
+    Failed,
+    Cancelled
+};
+
+class JobScheduler;
+
+// Shared cancellation flag. Copies observe the same flag.
+class CancellationToken {
+public:
+    CancellationToken();
+
+    void Cancel() const;
+    bool IsCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+namespace jobs_detail {
+struct JobState;
+}
+
+// What a running job sees: its cancellation token and a progress sink.
+class JobContext {
+public:
+    const CancellationToken& Token() const { return token_; }
+    bool IsCancelled() const { return token_.IsCancelled(); }
+    // `fraction` is clamped to [0, 1]. Reports arrive at the progress callback
+    // at most once per percent.
+    void ReportProgress(float fraction);
+    // Outcome of the job this one continues from; Succeeded for plain jobs.
+    JobStatus Antecedent() const { return antecedent_; }
+
+private:
+    friend class JobScheduler;
+    JobContext(JobScheduler& scheduler, jobs_detail::JobState& state, JobStatus antecedent);
+
+    JobScheduler& scheduler_;
+    jobs_detail::JobState& state_;
+    CancellationToken token_;
+    JobStatus antecedent_;
+};
+
+// Returns false on failure. A job that returns after its token was cancelled
+// counts as cancelled whatever it returns.
+using JobFunction = std::function<bool(JobContext&)>;
+
+struct JobOptions {
+    JobPriority priority = JobPriority::Normal;
+    // Both callbacks go through the scheduler's dispatcher, i.e. the UI thread in the app.
+    std::function<void(JobStatus)> onComplete;
+    std::function<void(float)> onProgress;
+    // Shared with other jobs to cancel them as a group; a fresh token by default.
+    CancellationToken token;
+};
+
+class JobHandle {
+public:
+    JobHandle() = default;
+
+    bool Valid() const { return state_ != nullptr; }
+    uint64_t Id() const;
+    JobStatus Status() const;
+    float Progress() const;
+    // Pending or running.
+    bool Active() const;
+    void Cancel() const;
+    // Blocks until the job has finished (not until its callbacks have run).
+    // Must not be called from the dispatcher thread for jobs whose
+    // continuations need it.
+    void Wait() const;
+
+private:
+    friend class JobScheduler;
+    explicit JobHandle(std::shared_ptr<jobs_detail::JobState> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<jobs_detail::JobState> state_;
+};
+
+// Fixed pool of workers, each with its own per-priority deques. Workers pop
+// their own newest job first and steal the oldest job from a sibling when they
+// run dry; higher priorities are always drained first. Completion and progress
+// callbacks are handed to the dispatcher, which the app implements by posting a
+// window message, so they run on the UI thread. Platform-neutral.
+class JobScheduler {
+public:
+    using Dispatcher = std::function<void(std::function<void()>)>;
+
+    // 0 threads means hardware_concurrency - 1 (at least one). Without a
+    // dispatcher, callbacks run on the worker that finished the job.
+    explicit JobScheduler(unsigned threads = 0, Dispatcher dispatcher = nullptr);
+    ~JobScheduler();
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    JobHandle Submit(JobFunction work, JobOptions options = {});
+    // Runs `work` once `parent` has finished in any state; Antecedent() tells
+    // which. Cancelling the parent does not cancel the continuation.
+    JobHandle ContinueWith(const JobHandle& parent, JobFunction work, JobOptions options = {});
+
+    // Cancels every pending job and joins the workers. Callbacks of jobs that
+    // never ran are not invoked. Called by the destructor.
+    void Shutdown();
+
+    unsigned ThreadCount() const { return static_cast<unsigned>(workers_.size()); }
+    uint64_t Steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    friend class JobContext;
+
+    static constexpr size_t kPriorityCount = 3;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<jobs_detail::JobState>> jobs[kPriorityCount];
+    };
+
+    void Enqueue(std::shared_ptr<jobs_detail::JobState> state);
+    std::shared_ptr<jobs_detail::JobState> Dequeue(size_t self);
+    void WorkerLoop(size_t index);
+    void Run(const std::shared_ptr<jobs_detail::JobState>& state);
+    void Complete(const std::shared_ptr<jobs_detail::JobState>& state, JobStatus status);
+    void Dispatch(std::function<void()> callback);
+
+    Dispatcher dispatcher_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_{ 0 };
+    std::atomic<size_t> nextQueue_{ 0 };
+    std::atomic<uint64_t> nextId_{ 0 };
+    std::atomic<uint64_t> steals_{ 0 };
+    bool stopping_ = false;
+};
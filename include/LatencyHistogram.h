@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear latency histogram in the spirit of HdrHistogram: values below 32
+// are counted exactly, larger values fall into 16 sub-buckets per power of two
+// (worst-case relative error 1/16). Record is wait-free and safe from any
+// number of threads; readers see a relaxed but monotonic view.
+class LatencyHistogram {
+public:
+    static constexpr size_t kLinearBuckets = 32;
+    static constexpr size_t kSubBuckets = 16;
+    static constexpr size_t kBucketCount = kLinearBuckets + (64 - 5) * kSubBuckets;
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        uint64_t mean = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+    };
+
+    LatencyHistogram();
+
+    void Record(uint64_t value);
+    void Reset();
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+    // Smallest bucket upper bound covering `quantile` (0..1) of the samples.
+    uint64_t ValueAtQuantile(double quantile) const;
+    Summary Summarize() const;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketLowerBound(size_t index);
+    static uint64_t BucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+    std::atomic<uint64_t> count_{ 0 };
+    std::atomic<uint64_t> sum_{ 0 };
+    std::atomic<uint64_t> min_{ UINT64_MAX };
+    std::atomic<uint64_t> max_{ 0 };
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+// Minimal append-only diagnostics log. Lines go to the file opened with Open
+// (UTF-8) and to the debugger via OutputDebugString. Safe from any thread.
+namespace logging {
+
+enum class Level {
+    Info,
+    Warning,
+    Error
+};
+
+bool Open(const std::wstring& path);
+void Close();
+void Write(Level level, const std::wstring& message);
+
+inline void Info(const std::wstring& message) { Write(Level::Info, message); }
+inline void Warning(const std::wstring& message) { Write(Level::Warning, message); }
+inline void Error(const std::wstring& message) { Write(Level::Error, message); }
+
+} // namespace logging
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+
+// Byte counters per subsystem, so a long session can show which part of the
+// pipeline is holding memory. Process-wide counters see everything; a Ledger
+// additionally sees what was allocated or charged for one capture session, so
+// sessions that overlap keep separate peaks. Counters are atomic; any thread
+// may charge or release them.
+namespace memory {
+
+enum class Tag {
+    // Raw window pixels from the grabber.
+    Capture,
+    // Encoded PNGs held by the session's FrameStore (its arena).
+    FrameStore,
+    // Base64 data URLs on their way to or held by the page bridge.
+    Bridge,
+    // Packets rendered onto the OS clipboard.
+    Clipboard,
+};
+
+constexpr size_t kTagCount = 4;
+
+struct Usage {
+    size_t current = 0;
+    // Highest `current` since the counters were created.
+    size_t peak = 0;
+};
+
+using Snapshot = std::array<Usage, kTagCount>;
+
+// Process-wide counters.
+void Add(Tag tag, size_t bytes);
+void Subtract(Tag tag, size_t bytes);
+Usage Get(Tag tag);
+Snapshot Take();
+const wchar_t* TagName(Tag tag);
+// "Memory now/peak: capture 8/16 MB, frames 40/40 MB, ..." for the status line.
+std::wstring FormatSummary(const Snapshot& usage, const wchar_t* heading = L"Memory now/peak:");
+
+// Heap resource that charges every allocation to `tag` until it is freed.
+std::pmr::memory_resource* Resource(Tag tag);
+
+// Counters for one session. Create with std::make_shared: buffers allocated
+// through Resource() keep the ledger alive, since they may outlive the session
+// (e.g. while published to the clipboard).
+class Ledger : public std::enable_shared_from_this<Ledger> {
+public:
+    Ledger();
+    ~Ledger();
+    Ledger(const Ledger&) = delete;
+    Ledger& operator=(const Ledger&) = delete;
+
+    // Session counters only; Resource() and Charge update both.
+    void Add(Tag tag, size_t bytes);
+    void Subtract(Tag tag, size_t bytes);
+    Usage Get(Tag tag) const;
+    Snapshot Take() const;
+
+    // Heap resource charging `tag` here and process-wide.
+    std::shared_ptr<std::pmr::memory_resource> Resource(Tag tag);
+
+private:
+    std::array<std::atomic<size_t>, kTagCount> current_{};
+    std::array<std::atomic<size_t>, kTagCount> peak_{};
+    std::array<std::unique_ptr<std::pmr::memory_resource>, kTagCount> resources_;
+};
+
+// Holds bytes against a tag until reset or destroyed. Movable, so it can live
+// inside the structure whose memory it stands for.
+class Charge {
+public:
+    explicit Charge(Tag tag, size_t bytes = 0);
+    // Also counts the bytes in `ledger`, when given.
+    Charge(Tag tag, std::shared_ptr<Ledger> ledger, size_t bytes = 0);
+    ~Charge();
+    Charge(Charge&& other) noexcept;
+    Charge& operator=(Charge&& other) noexcept;
+    Charge(const Charge&) = delete;
+    Charge& operator=(const Charge&) = delete;
+
+    void Add(size_t bytes);
+    void Reset();
+    size_t Bytes() const { return bytes_; }
+
+private:
+    Tag tag_;
+    std::shared_ptr<Ledger> ledger_;
+    size_t bytes_ = 0;
+};
+
+} // namespace memory
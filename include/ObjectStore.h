@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Digest.h"
+
+// Content-addressed store for encoded frames shared by all sessions. Each
+// distinct PNG is written once as objects\<2 hex>\<62 hex>.png and sessions
+// hard-link their raw\ files to it, so a repeat capture of an unchanged list
+// writes nothing new. Reference counts live in objects\index.bin: a 16-byte
+// header ("CHRNOBJX", u32 version, u32 record size) followed by fixed 48-byte
+// records (sha256, u64 size, u32 refs, u32 reserved) that are updated in place.
+//
+// Because sessions hold hard links, an object removed by Collect() never takes
+// a session's frames with it; a count that drifted after a crash only delays
+// reclaiming space or causes one extra write later. Thread-safe.
+class ObjectStore {
+public:
+    struct Stats {
+        size_t objects = 0;
+        uint64_t bytes = 0;
+        // Put() calls satisfied by an existing object, and those that wrote one.
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    ~ObjectStore();
+
+    // The one live store for `root`, opened on first use. Two instances over
+    // the same index.bin would assign slots independently and overwrite each
+    // other's counts, so the app only ever obtains stores through here.
+    // `indexLoaded` is false when an unreadable index had to be started over.
+    static std::shared_ptr<ObjectStore> ForDirectory(const std::filesystem::path& root, bool* indexLoaded = nullptr);
+
+    // Loads the index if the store already exists; the directory is created on first Put().
+    bool Open(const std::filesystem::path& root);
+    // Makes `target` a link to the object for `sha256`, writing the object
+    // first if it is new, and takes a reference. False if neither a link nor
+    // a copy could be made.
+    bool Put(const digest::Sha256Digest& sha256, const void* data, size_t size, const std::filesystem::path& target);
+    // Drops a reference taken by Put(); counts never go below zero.
+    void Release(const digest::Sha256Digest& sha256);
+    uint32_t References(const digest::Sha256Digest& sha256) const;
+    // Deletes objects nobody references and compacts the index. Returns the bytes reclaimed.
+    uint64_t Collect();
+    Stats GetStats() const;
+    std::filesystem::path ObjectPath(const digest::Sha256Digest& sha256) const;
+
+private:
+    struct Entry {
+        uint64_t size = 0;
+        uint32_t refs = 0;
+        size_t slot = 0;
+    };
+
+    struct DigestHash {
+        size_t operator()(const digest::Sha256Digest& sha256) const;
+    };
+
+    bool EnsureIndex();
+    bool WriteSlot(const digest::Sha256Digest& sha256, const Entry& entry);
+
+    mutable std::mutex mutex_;
+    std::filesystem::path root_;
+    std::fstream index_;
+    std::unordered_map<digest::Sha256Digest, Entry, DigestHash> entries_;
+    size_t slots_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// Vertical motion estimation between consecutive captures of a scrolling view.
+// Frames are reduced to per-row signatures (average BGR intensity in a few
+// column bands), which are cheap to keep around and to compare.
+namespace motion {
+
+constexpr size_t kSignatureBands = 4;
+using RowSignature = std::array<uint16_t, kSignatureBands>;
+
+struct ShiftEstimate {
+    // False when no shift explains the frames (e.g. the view scrolled past the
+    // previous frame, leaving a gap).
+    bool valid = false;
+    // Rows the content moved up: current row y shows previous row y + shift.
+    uint32_t shift = 0;
+    // Fraction of moving rows that matched at `shift`.
+    double matchRatio = 0.0;
+};
+
+// `pixels` is 32bpp BGRX, top-down.
+std::vector<RowSignature> ComputeRowSignatures(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride);
+// The same into `signatures`, whose resource decides where they are allocated.
+void ComputeRowSignatures(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride,
+                          std::pmr::vector<RowSignature>& signatures);
+
+// Rows that are unchanged in place (fixed headers, borders) are ignored; if every
+// row is unchanged the estimate is a valid shift of 0. Views up to 4096 rows
+// tall are estimated without allocating.
+ShiftEstimate EstimateShift(std::span<const RowSignature> previous, std::span<const RowSignature> current);
+
+} // namespace motion
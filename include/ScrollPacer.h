@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "LatencyHistogram.h"
+
+// Backpressure for scroll-driven capture. The pacer mirrors the app's
+// notches-per-capture count on the input thread; once a capture has been
+// triggered and not yet completed, further downward notches are held back
+// instead of reaching the target window, and are handed back for re-injection
+// when the app reports the capture done. Upward scrolling always passes and
+// discards anything held. Not thread-safe except for Snapshot/ReleaseLatency.
+class ScrollPacer {
+public:
+    static constexpr size_t kMaxHeld = 256;
+    // How often the input thread calls OnTick, and the timeout it passes.
+    static constexpr uint32_t kTickMs = 100;
+    static constexpr uint64_t kLostCaptureNs = 750ull * 1000000;
+
+    enum class Decision {
+        Pass,
+        Hold
+    };
+
+    struct Stats {
+        uint64_t held = 0;
+        uint64_t released = 0;
+        uint64_t discarded = 0;
+        uint64_t overflowed = 0;
+        uint32_t maxOutstanding = 0;
+    };
+
+    void Configure(uint32_t notchesPerCapture, uint32_t maxOutstanding);
+    void SetNotchesPerCapture(uint32_t notches);
+    // Forgets held notches and pending captures and clears statistics.
+    void Reset();
+
+    // `reinjected` marks notches this pacer released earlier; they are counted
+    // but never held again.
+    Decision OnWheel(int16_t delta, bool reinjected, uint64_t nowNs);
+    // The app finished one capture. Writes the deltas to re-inject now.
+    size_t OnCaptureCompleted(uint64_t nowNs, int16_t* release, size_t capacity);
+    // Treats captures older than `timeoutNs` as lost so input never stays blocked.
+    size_t OnTick(uint64_t nowNs, uint64_t timeoutNs, int16_t* release, size_t capacity);
+    // Hands back everything still held (e.g. when capture mode ends).
+    size_t ReleaseAll(uint64_t nowNs, int16_t* release, size_t capacity);
+
+    uint32_t Outstanding() const { return outstanding_; }
+    size_t HeldCount() const { return heldCount_; }
+    Stats Snapshot() const;
+    const LatencyHistogram& ReleaseLatency() const { return releaseLatency_; }
+
+private:
+    struct HeldNotch {
+        int16_t delta = 0;
+        uint64_t heldAt = 0;
+    };
+
+    size_t Release(uint64_t nowNs, size_t count, int16_t* release, size_t capacity);
+
+    uint32_t notchesPerCapture_ = 1;
+    uint32_t maxOutstanding_ = 1;
+    uint32_t passedSinceCapture_ = 0;
+    uint32_t outstanding_ = 0;
+    uint64_t outstandingSince_ = 0;
+
+    std::array<HeldNotch, kMaxHeld> held_{};
+    size_t heldHead_ = 0;
+    size_t heldCount_ = 0;
+
+    std::atomic<uint64_t> heldTotal_{ 0 };
+    std::atomic<uint64_t> releasedTotal_{ 0 };
+    std::atomic<uint64_t> discardedTotal_{ 0 };
+    std::atomic<uint64_t> overflowedTotal_{ 0 };
+    std::atomic<uint32_t> maxOutstandingSeen_{ 0 };
+    LatencyHistogram releaseLatency_;
+};
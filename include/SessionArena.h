@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+// Passes allocations through to `upstream` and counts them. Wrap a resource
+// in one to check that a code path does not allocate: Allocations() stays
+// flat across it. Safe to use from several threads.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    uint64_t Allocations() const { return allocations_.load(std::memory_order_relaxed); }
+    uint64_t Deallocations() const { return deallocations_.load(std::memory_order_relaxed); }
+    size_t BytesInUse() const { return bytesInUse_.load(std::memory_order_relaxed); }
+    size_t PeakBytes() const { return peakBytes_.load(std::memory_order_relaxed); }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* upstream_;
+    std::atomic<uint64_t> allocations_{ 0 };
+    std::atomic<uint64_t> deallocations_{ 0 };
+    std::atomic<size_t> bytesInUse_{ 0 };
+    std::atomic<size_t> peakBytes_{ 0 };
+};
+
+// Monotonic memory for one capture session. Allocation bumps a pointer in
+// fixed-size chunks; requests larger than a quarter chunk get a block of
+// their own, so a big PNG never strands most of a chunk. Deallocation is a
+// no-op and everything is returned to the upstream at once when the arena
+// is destroyed. The list of upstream blocks is kept inside the blocks
+// themselves, so the upstream is the only memory an arena ever touches.
+//
+// Allocate from one thread at a time. Containers may be destroyed on any
+// thread, since deallocation touches no state.
+class SessionArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kDefaultChunkBytes = 256 * 1024;
+
+    explicit SessionArena(size_t chunkBytes = kDefaultChunkBytes,
+                          std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    // Keeps `upstream` alive for as long as the arena.
+    SessionArena(size_t chunkBytes, std::shared_ptr<std::pmr::memory_resource> upstream);
+    ~SessionArena() override;
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+
+    // Bytes handed out, and bytes taken from the upstream to back them.
+    size_t BytesAllocated() const { return bytesAllocated_; }
+    size_t BytesReserved() const { return counter_.BytesInUse(); }
+    // Upstream allocations; a hot path that fits in the current chunk adds none.
+    uint64_t UpstreamAllocations() const { return counter_.Allocations(); }
+
+private:
+    // Heads each chunk; large blocks get theirs from the current chunk.
+    struct Block {
+        Block* next = nullptr;
+        void* pointer = nullptr;
+        size_t bytes = 0;
+        size_t alignment = 0;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void* Bump(size_t bytes, size_t alignment);
+
+    // Declared first so it is released after the blocks are returned to it.
+    std::shared_ptr<std::pmr::memory_resource> upstreamOwner_;
+    CountingResource counter_;
+    size_t chunkBytes_;
+    std::byte* cursor_ = nullptr;
+    size_t remaining_ = 0;
+    size_t bytesAllocated_ = 0;
+    Block* blocks_ = nullptr;
+};
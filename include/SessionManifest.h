@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Digest.h"
+
+// Per-session binary manifest (session.manifest next to raw\): a 16-byte
+// header ("CHRNMNFT", u32 version, u32 record size) followed by fixed 96-byte
+// little-endian records. Records are only ever appended, so a reader can map
+// the file and index record i at kHeaderSize + i * kRecordSize; a crash
+// leaves a valid prefix.
+namespace manifest {
+
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kRecordSize = 96;
+
+enum class RecordKind : uint8_t {
+    Frame = 1,
+    // Withdraws the live frame with the same index (drop-last, end-of-list trim).
+    Drop = 2,
+    // The session's own per-subsystem memory once it was published (clipboard
+    // packets are rendered later, on paste); only `memory` is set.
+    Memory = 3,
+};
+
+// Current and peak bytes of one subsystem, in memory::Tag order (capture,
+// frame store, bridge, clipboard).
+struct MemoryUsage {
+    uint64_t current = 0;
+    uint64_t peak = 0;
+};
+
+constexpr size_t kMemoryTags = 4;
+
+struct FrameRecord {
+    RecordKind kind = RecordKind::Frame;
+    // 1-based, matching shot_NNNN.png.
+    uint32_t index = 0;
+    // Wall-clock capture time, milliseconds since the Unix epoch.
+    uint64_t capturedAtMs = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Captured region in screen coordinates; the size matches width x height.
+    int32_t roiLeft = 0;
+    int32_t roiTop = 0;
+    // Measured scroll relative to the previous frame.
+    bool shiftValid = false;
+    uint32_t shiftRows = 0;
+    float matchRatio = 0.0f;
+    uint64_t pngBytes = 0;
+    uint32_t encodeMicros = 0;
+    // SHA-256 of the encoded PNG.
+    digest::Sha256Digest sha256{};
+    // The raw file links to the ObjectStore object and holds a reference to it.
+    bool shared = false;
+    // RecordKind::Memory only.
+    std::array<MemoryUsage, kMemoryTags> memory{};
+};
+
+void EncodeRecord(const FrameRecord& record, uint8_t* out);
+FrameRecord DecodeRecord(const uint8_t* in);
+// Checks the magic, version and record size of a mapped or loaded header.
+bool ValidHeader(const uint8_t* in, size_t size);
+
+class Writer {
+public:
+    ~Writer();
+
+    // With `append`, an existing manifest is continued (its torn tail cut off)
+    // instead of replaced; used when an interrupted session is resumed.
+    bool Open(const std::filesystem::path& path, bool append = false);
+    // Each record is flushed as it is written so the manifest tracks the raw folder.
+    bool Append(const FrameRecord& record);
+    void Close();
+    bool IsOpen() const { return out_.is_open(); }
+    uint64_t Count() const { return count_; }
+
+private:
+    std::ofstream out_;
+    uint64_t count_ = 0;
+};
+
+// Reads every record in file order. Fails on a bad header; a truncated
+// trailing record is dropped.
+bool ReadManifest(const std::filesystem::path& path, std::vector<FrameRecord>& records);
+// Replays Drop records and returns the surviving frames ordered by index.
+std::vector<FrameRecord> LiveFrames(const std::vector<FrameRecord>& records);
+
+} // namespace manifest
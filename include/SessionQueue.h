@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "MemoryAccounting.h"
+#include "SessionArena.h"
+
+// Bookkeeping for captures that overlap: when a new capture may start while
+// earlier sessions are still being prepared, and the queue of image sets the
+// page bridge pages through once they are published.
+namespace sessions {
+
+// True when a new capture may start with `inFlight` earlier sessions still
+// holding `inFlightBytes` of frames. The first capture is always allowed;
+// maxInFlight 0 means each session must finish before the next one starts.
+bool CanStartCapture(size_t inFlight, size_t inFlightBytes, size_t maxInFlight, size_t budgetBytes);
+
+} // namespace sessions
+
+// Data URLs for one set of frames. They are encoded into an arena of their
+// own that goes with the last holder, so a set is released in one go. Move,
+// rather than assign, between holders: assigning copies onto the heap.
+struct DataUrls {
+    DataUrls() = default;
+    explicit DataUrls(std::shared_ptr<SessionArena> owner)
+        : arena(std::move(owner)), urls(arena.get()) {
+    }
+
+    // Declared first so the strings are released before the arena.
+    std::shared_ptr<SessionArena> arena;
+    std::pmr::vector<std::pmr::wstring> urls;
+};
+
+// Published image sets, oldest first. The newest set is selected when it is
+// added; the oldest sets are dropped once more than maxSets are held or they
+// exceed maxBytes, but the newest one always stays.
+class PublishedSets {
+public:
+    struct Set {
+        std::wstring label;
+        DataUrls dataUrls;
+        size_t bytes = 0;
+        memory::Charge charge{ memory::Tag::Bridge };
+    };
+
+    // False (and nothing changes) for an empty set.
+    bool Publish(const std::wstring& label, DataUrls dataUrls);
+    // maxSets 0 is treated as 1.
+    void SetLimits(size_t maxSets, size_t maxBytes);
+    // Moves the selection by `delta` sets, clamped to the oldest and newest.
+    void Select(long long delta);
+
+    bool Empty() const { return sets_.empty(); }
+    size_t Size() const { return sets_.size(); }
+    size_t Bytes() const { return bytes_; }
+    size_t SelectedIndex() const { return selected_; }
+    // Only valid when not Empty().
+    const Set& Selected() const { return sets_[selected_]; }
+
+private:
+    void Trim();
+
+    std::deque<Set> sets_;
+    size_t selected_ = 0;
+    size_t bytes_ = 0;
+    size_t maxSets_ = 5;
+    size_t maxBytes_ = 512ull * 1024 * 1024;
+};
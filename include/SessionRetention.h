@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Limits for the session history under [paths]. Zero disables a limit.
+struct RetentionPolicy {
+    uint64_t maxSessionBytes = 0;
+    int64_t maxSessionAgeSeconds = 0;
+    // The newest keepLastN sessions survive the age and size limits.
+    uint32_t keepLastN = 0;
+};
+
+struct SessionInfo {
+    std::filesystem::path path;
+    uint64_t bytes = 0;
+    // Newest write inside the session.
+    std::filesystem::file_time_type modified{};
+};
+
+// Retention policy engine and incremental collector for session folders.
+// Platform-neutral; callers pick the thread and I/O priority.
+namespace retention {
+
+struct CollectResult {
+    size_t sessionsRemoved = 0;
+    uint64_t bytesReclaimed = 0;
+    bool cancelled = false;
+    bool ok = true;
+};
+
+// One entry per sub-directory of `root`.
+std::vector<SessionInfo> ScanSessions(const std::filesystem::path& root);
+
+// Sessions the policy wants gone, oldest first. Age limits apply first, then
+// the oldest remaining sessions go until the total fits maxSessionBytes.
+// Protected paths (the active and in-flight sessions) are never selected but
+// still count towards the total.
+std::vector<SessionInfo> SelectForDeletion(std::vector<SessionInfo> sessions, const RetentionPolicy& policy,
+                                           std::filesystem::file_time_type now,
+                                           const std::vector<std::filesystem::path>& protectedPaths);
+
+// Deletes the selected sessions one file at a time, checking `cancelled`
+// between sessions so a large history never blocks for long. A session is
+// only counted as removed once its folder is gone; its session.manifest is
+// deleted last so one left half-deleted still lists its shared frames.
+CollectResult Collect(const std::vector<SessionInfo>& sessions, const std::function<bool()>& cancelled);
+
+// "1536", "512K", "2G" (binary units). False on anything else.
+bool ParseByteSize(const std::string& text, uint64_t& bytes);
+std::string FormatByteSize(uint64_t bytes);
+// "90s", "30m", "12h", "7d"; a bare number means days. False on anything else.
+bool ParseDuration(const std::string& text, int64_t& seconds);
+std::string FormatDuration(int64_t seconds);
+
+} // namespace retention
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Records named startup phases and milestones against one origin and formats
+// them for the log. Phases may be recorded from any thread, so work moved to
+// the job scheduler still shows up on the same timeline.
+class StartupTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StartupTimeline(Clock::time_point origin = Clock::now());
+
+    // Records the span between construction and destruction under `name`.
+    class Phase {
+    public:
+        Phase(StartupTimeline& timeline, std::wstring name);
+        ~Phase();
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        StartupTimeline& timeline_;
+        std::wstring name_;
+        Clock::time_point start_;
+    };
+
+    void Record(const std::wstring& name, Clock::time_point start, Clock::time_point end);
+    // A point in time such as "first window"; the first mark of a name wins.
+    void Mark(const std::wstring& name);
+    std::optional<double> MilestoneMs(const std::wstring& name) const;
+    // One line per phase or milestone, ordered by start time, in milliseconds since the origin.
+    std::wstring Report() const;
+
+private:
+    struct Entry {
+        std::wstring name;
+        double startMs = 0.0;
+        double endMs = 0.0;
+        bool milestone = false;
+    };
+
+    double ToMs(Clock::time_point time) const;
+
+    mutable std::mutex mutex_;
+    Clock::time_point origin_;
+    std::vector<Entry> entries_;
+};
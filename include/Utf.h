@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+namespace util {
+
+struct TranscodeResult {
+    size_t read = 0;
+    size_t written = 0;
+};
+
+// Worst-case output sizes, in code units, for a single-pass conversion.
+constexpr size_t MaxUtf16Length(size_t utf8Length) { return utf8Length; }
+constexpr size_t MaxUtf8Length(size_t utf16Length) { return utf16Length * 3; }
+
+// Both converters match the Win32 CP_UTF8 conversions with flags == 0: malformed
+// input (invalid UTF-8 subparts, unpaired surrogates) is replaced by U+FFFD.
+// They write at most `capacity` units and stop before a code point that would not
+// fit, so callers can convert into an optimistic buffer and grow only if needed.
+TranscodeResult Utf8ToUtf16(const char* src, size_t length, char16_t* dst, size_t capacity);
+TranscodeResult Utf16ToUtf8(const char16_t* src, size_t length, char* dst, size_t capacity);
+
+bool IsValidUtf8(const char* src, size_t length);
+
+} // namespace util
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <windows.h>
 
@@ -16,6 +18,11 @@ std::string WideToUtf8(const std::wstring& wstr);
 std::wstring PathFromExecutable(const std::wstring& relative);
 std::vector<std::wstring> Split(const std::wstring& input, wchar_t delimiter);
 std::wstring Base64FromBytes(const std::vector<uint8_t>& data);
+// `prefix` is written ahead of the encoding, so a data URL costs one allocation.
+std::wstring Base64FromBytes(const uint8_t* data, size_t size, std::wstring_view prefix = {});
+// The same into `out`, whose allocator decides where it lives; false (and `out`
+// empty) on failure.
+bool Base64FromBytes(const uint8_t* data, size_t size, std::wstring_view prefix, std::pmr::wstring& out);
 std::vector<uint8_t> Base64ToBytes(const std::wstring& base64);
 
 } // namespace util
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -8,24 +11,56 @@
 #include <windows.h>
 #include <webview2.h>
 
+#include "AssetCache.h"
+#include "JobScheduler.h"
+#include "MemoryAccounting.h"
+#include "SessionQueue.h"
+
 class WebProcessor {
 public:
     using ErrorCallback = std::function<void(const std::wstring& message)>;
+    // Startup progress: "WebView2 environment ready", "WebView2 controller ready", "page ready".
+    using MilestoneCallback = std::function<void(const wchar_t* name)>;
 
     WebProcessor();
     ~WebProcessor();
 
+    // Starts creating the WebView2 environment, which needs no window, so it
+    // can overlap the rest of startup. Initialize() calls it if nobody did.
+    bool Prepare();
     bool Initialize(HWND parentWindow);
     void Resize(const RECT& bounds);
     void SetErrorCallback(ErrorCallback cb) { errorCallback_ = std::move(cb); }
-    void UpdateClipboardImages(const std::vector<std::wstring>& dataUrls);
+    void SetMilestoneCallback(MilestoneCallback cb) { milestoneCallback_ = std::move(cb); }
+    void SetAssetCacheDirectory(const std::wstring& directory) { assetCacheDirectory_ = directory; }
+    // Asset requests are resolved on this scheduler at low priority; without
+    // one the cache stays off. Must stay alive while WebView2 can raise requests.
+    void SetJobScheduler(JobScheduler* jobs) { jobs_ = jobs; }
+    // Adds a set of images as the newest page and selects it. The oldest pages
+    // are dropped once more than maxSets are held or they exceed maxBytes.
+    void PublishImages(const std::wstring& label, DataUrls dataUrls);
+    void SetPublishLimits(size_t maxSets, size_t maxBytes);
+    size_t PublishedBytes() const { return publishedSets_.Bytes(); }
 
 private:
+    void CreateController();
+    void Milestone(const wchar_t* name) const;
     void SetupEventHandlers();
     void HandleWebMessage(const std::wstring& message);
     void PostStringMessage(const std::wstring& message) const;
     void SendClipboardResponse(const std::wstring& requestId) const;
     void NotifyClipboardInventory() const;
+    void SelectPage(long long delta);
+    bool CreateDispatchWindow();
+    void HandleAssetRequest(ICoreWebView2WebResourceRequestedEventArgs* args);
+    void CompleteAssetRequest(uint64_t id, std::unique_ptr<AssetCache::Result> result);
+    bool ServeAsset(ICoreWebView2WebResourceRequestedEventArgs* args, const AssetCache::Result& result) const;
+    static LRESULT CALLBACK DispatchWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
+
+    struct PendingAsset {
+        Microsoft::WRL::ComPtr<ICoreWebView2WebResourceRequestedEventArgs> args;
+        Microsoft::WRL::ComPtr<ICoreWebView2Deferral> deferral;
+    };
 
     Microsoft::WRL::ComPtr<ICoreWebView2Environment> environment_;
     Microsoft::WRL::ComPtr<ICoreWebView2Controller> controller_;
@@ -36,7 +71,19 @@ private:
     bool hasPendingBounds_ = false;
 
     bool bridgeReady_ = false;
+    bool environmentRequested_ = false;
 
-    std::vector<std::wstring> clipboardImages_;
+    // The bridge serves the selected set.
+    PublishedSets publishedSets_;
     ErrorCallback errorCallback_{};
+    MilestoneCallback milestoneCallback_{};
+
+    std::wstring assetCacheDirectory_;
+    std::shared_ptr<AssetCache> assetCache_;
+    JobScheduler* jobs_ = nullptr;
+    // Shared by every asset job so the destructor can cancel them together.
+    CancellationToken assetJobs_;
+    HWND dispatchWindow_ = nullptr;
+    std::map<uint64_t, PendingAsset> pendingAssets_;
+    uint64_t nextAssetRequestId_ = 0;
 };
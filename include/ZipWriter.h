@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Streaming ZIP writer for already-compressed payloads. Every entry is stored
+// (method 0), so writing costs one pass over the data to checksum it. Sizes
+// are known before an entry starts; only the CRC-32 is patched into the local
+// header afterwards. ZIP64 records are added automatically for entries or
+// archives past 4 GB and for more than 65535 entries. Memory use is one
+// fixed copy buffer plus a small record per entry.
+class ZipWriter {
+public:
+    ~ZipWriter();
+
+    // Entries are stamped with `modified` (local time); 0 means now.
+    bool Open(const std::filesystem::path& path, std::time_t modified = 0);
+    // Names use '/' separators and are stored as UTF-8.
+    bool AddBytes(const std::string& name, const void* data, size_t size);
+    bool AddFile(const std::string& name, const std::filesystem::path& source);
+    // Writes the central directory; the archive is not readable before this.
+    bool Finish();
+    // Closes and deletes an unfinished archive.
+    void Abort();
+    bool IsOpen() const { return out_.is_open(); }
+    uint64_t BytesWritten() const { return offset_; }
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t crc = 0;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+    };
+
+    bool BeginEntry(const std::string& name, uint64_t size);
+    bool EndEntry(uint32_t crc);
+    bool Write(const void* data, size_t size);
+
+    std::ofstream out_;
+    std::filesystem::path path_;
+    std::vector<Entry> entries_;
+    std::vector<char> buffer_;
+    uint64_t offset_ = 0;
+    uint16_t dosTime_ = 0;
+    uint16_t dosDate_ = 0;
+};
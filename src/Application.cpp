@@ -1,10 +1,10 @@
 #include "Application.h"
 
+#include <algorithm>
 #include <filesystem>
-#include <fstream>
-#include <iterator>
 #include <shellapi.h>
 #include <shlobj.h>
+#include <string_view>
 #include <vector>
 #include <cstring>
 #include <cstdint>
@@ -14,153 +14,164 @@
 
 #include "Utility.h"
 #include "HotkeyUtils.h"
+#include "CaptureJournal.h"
+#include "Log.h"
+#include "SessionQueue.h"
+#include "SessionRetention.h"
+#include "ZipWriter.h"
 #include "resource.h"
 
 namespace {
 const wchar_t kWindowClassName[] = L"ReceiptFactorCaptureWindow";
 const int kStatusControlId = 2001;
+const int kMemoryControlId = 2002;
 const int kMenuOpenOutput = 3001;
 const int kMenuClearSessions = 3002;
 const int kMenuSettings = 3003;
+const int kMenuExportSession = 3004;
+const wchar_t kPngClipboardFormat[] = L"PNG";
+// Carries a heap-allocated std::function posted by the job scheduler; lParam owns it.
+const UINT kJobCallbackMessage = WM_APP + 1;
+const UINT_PTR kAutoScrollTimerId = 4001;
+const UINT kAutoScrollTickMs = 15;
+const UINT_PTR kJournalSyncTimerId = 4002;
+const UINT kJournalSyncTickMs = 250;
+
+// One decoded, scaled copy of the window icon in 32bpp premultiplied BGRA.
+struct IconImage {
+    UINT size = 0;
+    std::vector<BYTE> pixels;
+};
 
-Microsoft::WRL::ComPtr<IWICImagingFactory> g_clipboardWicFactory;
-
-bool EnsureClipboardFactory() {
-    if (!g_clipboardWicFactory) {
-        auto hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&g_clipboardWicFactory));
-        if (FAILED(hr)) {
-            g_clipboardWicFactory.Reset();
-            return false;
-        }
-    }
-    return true;
-}
-
-bool LoadImagePixels(const std::wstring& path, std::vector<BYTE>& pixels, UINT& width, UINT& height, UINT& stride, UINT targetSize = 0) {
-    if (!EnsureClipboardFactory()) {
+// Decodes the PNG once and scales that bitmap to every requested size. Runs
+// on a job worker, so it uses its own WIC factory.
+bool DecodeIconImages(const std::wstring& path, const std::vector<UINT>& sizes, std::vector<IconImage>& images) {
+    Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+    auto hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+    if (FAILED(hr)) {
         return false;
     }
-
     Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
-    auto hr = g_clipboardWicFactory->CreateDecoderFromFilename(path.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder);
+    hr = factory->CreateDecoderFromFilename(path.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder);
     if (FAILED(hr)) {
         return false;
     }
-
     Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
     hr = decoder->GetFrame(0, &frame);
     if (FAILED(hr)) {
         return false;
     }
+    Microsoft::WRL::ComPtr<IWICBitmap> decoded;
+    hr = factory->CreateBitmapFromSource(frame.Get(), WICBitmapCacheOnLoad, &decoded);
+    if (FAILED(hr)) {
+        return false;
+    }
 
-    Microsoft::WRL::ComPtr<IWICBitmapSource> source;
-    if (targetSize > 0) {
+    for (const UINT size : sizes) {
         Microsoft::WRL::ComPtr<IWICBitmapScaler> scaler;
-        hr = g_clipboardWicFactory->CreateBitmapScaler(&scaler);
+        hr = factory->CreateBitmapScaler(&scaler);
         if (FAILED(hr)) {
             return false;
         }
-        hr = scaler->Initialize(frame.Get(), targetSize, targetSize, WICBitmapInterpolationModeHighQualityCubic);
+        hr = scaler->Initialize(decoded.Get(), size, size, WICBitmapInterpolationModeHighQualityCubic);
         if (FAILED(hr)) {
             return false;
         }
-        hr = scaler.As(&source);
-    } else {
-        hr = frame.As(&source);
-    }
-    if (FAILED(hr) || !source) {
-        return false;
-    }
-
-    Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
-    hr = g_clipboardWicFactory->CreateFormatConverter(&converter);
-    if (FAILED(hr)) {
-        return false;
-    }
-
-    hr = converter->Initialize(source.Get(), GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
-    if (FAILED(hr)) {
-        return false;
-    }
-
-    hr = converter->GetSize(&width, &height);
-    if (FAILED(hr)) {
-        return false;
-    }
-
-    stride = width * 4;
-    const UINT bufferSize = stride * height;
-    pixels.resize(bufferSize);
-
-    hr = converter->CopyPixels(nullptr, stride, bufferSize, pixels.data());
-    if (FAILED(hr)) {
-        pixels.clear();
-        return false;
+        Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+        hr = factory->CreateFormatConverter(&converter);
+        if (FAILED(hr)) {
+            return false;
+        }
+        hr = converter->Initialize(scaler.Get(), GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+        if (FAILED(hr)) {
+            return false;
+        }
+        IconImage image;
+        image.size = size;
+        image.pixels.resize(static_cast<size_t>(size) * size * 4);
+        hr = converter->CopyPixels(nullptr, size * 4, static_cast<UINT>(image.pixels.size()), image.pixels.data());
+        if (FAILED(hr)) {
+            return false;
+        }
+        images.push_back(std::move(image));
     }
     return true;
 }
 
-bool CreateClipboardBitmaps(const std::wstring& path, HBITMAP& outBitmap, HGLOBAL& outDib) {
-    outBitmap = nullptr;
-    outDib = nullptr;
-
-    UINT width = 0;
-    UINT height = 0;
-    UINT stride = 0;
-    std::vector<BYTE> pixels;
-    if (!LoadImagePixels(path, pixels, width, height, stride)) {
-        return false;
+class Win32ClipboardBackend : public ClipboardBackend {
+public:
+    explicit Win32ClipboardBackend(HWND owner) : owner_(owner) {}
+
+    static UINT NativeFormat(ClipboardFormat format) {
+        switch (format) {
+            case ClipboardFormat::Dib:
+                return CF_DIB;
+            case ClipboardFormat::Png:
+                return RegisterClipboardFormatW(kPngClipboardFormat);
+            case ClipboardFormat::FileList:
+                return CF_HDROP;
+        }
+        return 0;
     }
 
-    BITMAPINFOHEADER header = {};
-    header.biSize = sizeof(BITMAPINFOHEADER);
-    header.biWidth = static_cast<LONG>(width);
-    header.biHeight = -static_cast<LONG>(height);
-    header.biPlanes = 1;
-    header.biBitCount = 32;
-    header.biCompression = BI_RGB;
-    header.biSizeImage = stride * height;
-
-    void* dibBits = nullptr;
-    HBITMAP hBitmap = CreateDIBSection(nullptr, reinterpret_cast<BITMAPINFO*>(&header), DIB_RGB_COLORS, &dibBits, nullptr, 0);
-    if (!hBitmap || !dibBits) {
-        if (hBitmap) {
-            DeleteObject(hBitmap);
+    static std::optional<ClipboardFormat> FromNative(UINT native) {
+        if (native == CF_DIB) {
+            return ClipboardFormat::Dib;
         }
-        return false;
+        if (native == CF_HDROP) {
+            return ClipboardFormat::FileList;
+        }
+        if (native != 0 && native == RegisterClipboardFormatW(kPngClipboardFormat)) {
+            return ClipboardFormat::Png;
+        }
+        return std::nullopt;
     }
-    std::memcpy(dibBits, pixels.data(), header.biSizeImage);
 
-    const SIZE_T dibSize = sizeof(BITMAPINFOHEADER) + header.biSizeImage;
-    HGLOBAL hDib = GlobalAlloc(GHND | GMEM_SHARE, dibSize);
-    if (!hDib) {
-        DeleteObject(hBitmap);
-        return false;
+    bool Open() override { return OpenClipboard(owner_) != FALSE; }
+    void Close() override { CloseClipboard(); }
+    bool Empty() override { return EmptyClipboard() != FALSE; }
+    bool IsOwner() const override { return GetClipboardOwner() == owner_; }
+
+    bool Offer(ClipboardFormat format) override {
+        const UINT native = NativeFormat(format);
+        if (native == 0) {
+            return false;
+        }
+        // A null handle asks the system to send WM_RENDERFORMAT on first paste.
+        SetLastError(ERROR_SUCCESS);
+        SetClipboardData(native, nullptr);
+        return GetLastError() == ERROR_SUCCESS;
     }
 
-    auto* dibData = static_cast<BYTE*>(GlobalLock(hDib));
-    if (!dibData) {
-        GlobalFree(hDib);
-        DeleteObject(hBitmap);
-        return false;
+    bool Provide(ClipboardFormat format, size_t size, const Writer& write) override {
+        const UINT native = NativeFormat(format);
+        if (native == 0 || size == 0) {
+            return false;
+        }
+        HGLOBAL block = GlobalAlloc(GMEM_MOVEABLE, size);
+        if (!block) {
+            return false;
+        }
+        auto* data = static_cast<uint8_t*>(GlobalLock(block));
+        const bool written = data && write(data, size);
+        if (data) {
+            GlobalUnlock(block);
+        }
+        if (!written || !SetClipboardData(native, block)) {
+            GlobalFree(block);
+            return false;
+        }
+        return true;
     }
-    std::memcpy(dibData, &header, sizeof(BITMAPINFOHEADER));
-    std::memcpy(dibData + sizeof(BITMAPINFOHEADER), pixels.data(), header.biSizeImage);
-    GlobalUnlock(hDib);
 
-    outBitmap = hBitmap;
-    outDib = hDib;
-    return true;
-}
+private:
+    HWND owner_ = nullptr;
+};
 
-HICON LoadIconFromPng(const std::wstring& path, UINT targetSize) {
-    UINT width = 0;
-    UINT height = 0;
-    UINT stride = 0;
-    std::vector<BYTE> pixels;
-    if (!LoadImagePixels(path, pixels, width, height, stride, targetSize)) {
-        return nullptr;
-    }
+HICON CreateIconFromImage(const IconImage& image) {
+    const UINT width = image.size;
+    const UINT height = image.size;
+    const UINT stride = width * 4;
 
     BITMAPINFOHEADER header = {};
     header.biSize = sizeof(BITMAPINFOHEADER);
@@ -182,7 +193,7 @@ HICON LoadIconFromPng(const std::wstring& path, UINT targetSize) {
         }
         return nullptr;
     }
-    std::memcpy(bits, pixels.data(), header.biSizeImage);
+    std::memcpy(bits, image.pixels.data(), header.biSizeImage);
 
     HBITMAP mask = CreateBitmap(width, height, 1, 1, nullptr);
 
@@ -202,6 +213,52 @@ HICON LoadIconFromPng(const std::wstring& path, UINT targetSize) {
     return icon;
 }
 
+// Wheel-down input for the auto-scroll driver. The tag keeps the hook from
+// counting or pacing these notches like the user's own.
+void SendWheelNotches(uint32_t notches) {
+    std::vector<INPUT> inputs(notches);
+    for (auto& input : inputs) {
+        input.type = INPUT_MOUSE;
+        input.mi.dwFlags = MOUSEEVENTF_WHEEL;
+        input.mi.mouseData = static_cast<DWORD>(-WHEEL_DELTA);
+        input.mi.dwExtraInfo = HotkeyManager::kSyntheticInputTag;
+    }
+    if (!inputs.empty()) {
+        SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+    }
+}
+
+// Object store references held by a session's frames, read from its manifest
+// before the session is deleted.
+std::vector<digest::Sha256Digest> SharedFrames(const std::filesystem::path& sessionRoot) {
+    std::vector<manifest::FrameRecord> records;
+    std::vector<digest::Sha256Digest> shared;
+    if (manifest::ReadManifest(sessionRoot / L"session.manifest", records)) {
+        for (const auto& record : manifest::LiveFrames(records)) {
+            if (record.shared) {
+                shared.push_back(record.sha256);
+            }
+        }
+    }
+    return shared;
+}
+
+// Appends the session's own memory use (its ledger) to its manifest.
+void AppendMemoryRecord(const std::wstring& sessionRoot, const memory::Snapshot& usage) {
+    const auto path = std::filesystem::path(sessionRoot) / L"session.manifest";
+    std::error_code ec;
+    manifest::Writer writer;
+    if (!std::filesystem::exists(path, ec) || !writer.Open(path, true)) {
+        return;
+    }
+    manifest::FrameRecord record;
+    record.kind = manifest::RecordKind::Memory;
+    for (size_t i = 0; i < memory::kTagCount; ++i) {
+        record.memory[i] = manifest::MemoryUsage{ usage[i].current, usage[i].peak };
+    }
+    writer.Append(record);
+}
+
 } // namespace
 
 Application::Application(HINSTANCE instance)
@@ -216,10 +273,18 @@ Application::Application(HINSTANCE instance)
     config_.hotkey.shiftMode = HotkeyConfig::ShiftMode::RightOnly;
     config_.paths.outputDirectory = L"output";
     config_.paths.sessionDirectory = L"temp\\sessions";
+    config_.paths.objectDirectory = L"temp\\objects";
     config_.scrollsPerCapture = 3;
+    config_.clipboardMode = AppConfig::ClipboardMode::LastFrame;
 }
 
 Application::~Application() {
+    configWatcher_.reset();
+    processingJob_.Cancel();
+    clearJob_.Cancel();
+    retentionJob_.Cancel();
+    exportJob_.Cancel();
+    jobs_.reset();
     hotkeyManager_.Shutdown();
     if (uiFont_) {
         DeleteObject(uiFont_);
@@ -237,13 +302,50 @@ Application::~Application() {
 }
 
 bool Application::Initialize(int nCmdShow) {
-    if (FAILED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED))) {
-        return false;
+    {
+        StartupTimeline::Phase phase(startup_, L"COM");
+        if (FAILED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED))) {
+            return false;
+        }
     }
 
-    configManager_.Load(config_);
-    configManager_.Save(config_);
-    EnsureDirectories();
+    // The WebView2 environment needs no window; starting it first lets the
+    // browser process launch while the rest of startup runs.
+    webProcessor_.SetErrorCallback([this](const std::wstring& message) {
+        HandleWebError(message);
+    });
+    webProcessor_.SetMilestoneCallback([this](const wchar_t* name) {
+        startup_.Mark(name);
+        if (std::wstring_view(name) == L"page ready") {
+            LogStartupReport();
+        }
+    });
+    {
+        StartupTimeline::Phase phase(startup_, L"WebView2 environment request");
+        webProcessor_.Prepare();
+    }
+
+    defaultConfig_ = config_;
+    {
+        StartupTimeline::Phase phase(startup_, L"Config load");
+        configManager_.Load(config_);
+        // Only writes when the file is missing keys.
+        configManager_.Save(config_);
+    }
+    {
+        StartupTimeline::Phase phase(startup_, L"Directories and log");
+        EnsureDirectories();
+        logging::Open(util::JoinPath(logDirectory_, L"chronos.log"));
+    }
+    {
+        StartupTimeline::Phase phase(startup_, L"Job scheduler");
+        jobs_ = std::make_unique<JobScheduler>(0, [this](std::function<void()> callback) {
+            DispatchToUi(std::move(callback));
+        });
+    }
+    webProcessor_.SetJobScheduler(jobs_.get());
+    webProcessor_.SetAssetCacheDirectory(MakeAbsolutePath(L"cache\\assets"));
+    webProcessor_.SetPublishLimits(config_.maxPublishedSets, MemoryBudgetBytes());
 
     WNDCLASSW wc = {};
     wc.lpfnWndProc = Application::WindowProc;
@@ -256,40 +358,153 @@ bool Application::Initialize(int nCmdShow) {
         return false;
     }
 
-    hwnd_ = CreateWindowExW(
-        0,
-        kWindowClassName,
-        L"Receipt Factor Auto Generator",
-        WS_OVERLAPPEDWINDOW,
-        CW_USEDEFAULT,
-        CW_USEDEFAULT,
-        1100,
-        800,
-        nullptr,
-        nullptr,
-        instance_,
-        this);
-    if (!hwnd_) {
-        return false;
+    {
+        StartupTimeline::Phase phase(startup_, L"Create window");
+        hwnd_ = CreateWindowExW(
+            0,
+            kWindowClassName,
+            L"Receipt Factor Auto Generator",
+            WS_OVERLAPPEDWINDOW,
+            CW_USEDEFAULT,
+            CW_USEDEFAULT,
+            1100,
+            800,
+            nullptr,
+            nullptr,
+            instance_,
+            this);
+        if (!hwnd_) {
+            return false;
+        }
+
+        ShowWindow(hwnd_, nCmdShow);
+        UpdateWindow(hwnd_);
     }
+    startup_.Mark(L"first window");
 
-    ShowWindow(hwnd_, nCmdShow);
-    UpdateWindow(hwnd_);
+    {
+        StartupTimeline::Phase phase(startup_, L"Hotkeys");
+        if (!hotkeyManager_.Initialize(
+                config_.hotkey,
+                config_.bindings,
+                config_.scrollsPerCapture,
+                [this](hotkey::Action action) { HandleHotkeyAction(action); },
+                [this](UINT notches) { HandleCaptureRequest(notches); })) {
+            MessageBoxW(hwnd_, L"Failed to initialize global hotkeys.", L"Error", MB_OK | MB_ICONERROR);
+            return false;
+        }
+        hotkeyManager_.SetScrollPacing(config_.scrollPacing, config_.maxPendingCaptures);
+        if (config_.recordInput) {
+            hotkeyManager_.StartRecording(util::JoinPath(logDirectory_, L"input-" + util::TimestampString() + L".bin"));
+        }
+    }
 
-    if (!hotkeyManager_.Initialize(
-            config_.hotkey,
-            config_.scrollsPerCapture,
-            [this]() { ToggleCaptureMode(); },
-            [this]() { HandleCaptureRequest(); })) {
-        MessageBoxW(hwnd_, L"Failed to initialize global hotkeys.", L"Error", MB_OK | MB_ICONERROR);
-        return false;
+    {
+        StartupTimeline::Phase phase(startup_, L"Config watcher");
+        StartConfigWatcher();
     }
+    startup_.Mark(L"interactive");
+    // May block on a prompt, so it stays out of the interactive figure.
+    OfferResume();
+    CollectSessions();
+    return true;
+}
 
-    webProcessor_.SetErrorCallback([this](const std::wstring& message) {
-        HandleWebError(message);
-    });
+void Application::LogStartupReport() {
+    if (startupReported_) {
+        return;
+    }
+    startupReported_ = true;
+    logging::Info(startup_.Report());
+}
 
-    return true;
+void Application::OfferResume() {
+    const auto interrupted = journal::FindIncompleteSessions(std::filesystem::path(sessionDirectory_));
+    if (interrupted.empty()) {
+        return;
+    }
+    // Only the newest is offered; older ones stay on disk for the collector.
+    for (size_t i = 1; i < interrupted.size(); ++i) {
+        journal::MarkAbandoned(interrupted[i].root);
+    }
+    const auto& newest = interrupted.front();
+    const std::wstring frames = std::to_wstring(newest.frames) + (newest.frames == 1 ? L" frame" : L" frames");
+    const std::wstring prompt = L"A capture session was interrupted after " + frames +
+                                L". Continue it the next time capture starts?";
+    if (MessageBoxW(hwnd_, prompt.c_str(), L"Resume capture", MB_ICONQUESTION | MB_YESNO) != IDYES) {
+        journal::MarkAbandoned(newest.root);
+        return;
+    }
+    resumeSessionRoot_ = newest.root.wstring();
+    logging::Info(L"Resuming interrupted session " + newest.root.filename().wstring() + L" (" + frames + L").");
+    UpdateStatus(L"The interrupted session (" + frames + L") continues with the next capture. " + BuildIdleStatus());
+}
+
+void Application::StartConfigWatcher() {
+    configWatcher_ = FileWatcher::Create();
+    // Parsing happens on the watcher thread; only the finished config crosses to the UI thread.
+    const bool started = configWatcher_->Start(std::filesystem::path(configManager_.GetConfigPath()),
+        [this, base = baseDirectory_, defaults = defaultConfig_]() {
+            auto manager = std::make_shared<ConfigManager>(base);
+            auto updated = std::make_shared<AppConfig>(defaults);
+            manager->Load(*updated);
+            DispatchToUi([this, manager, updated]() { ApplyConfigChange(std::move(*manager), *updated); });
+        });
+    if (!started) {
+        configWatcher_.reset();
+        logging::Warning(L"Could not watch config.ini; edits take effect after a restart.");
+    }
+}
+
+void Application::ApplyConfigChange(ConfigManager&& manager, const AppConfig& updated) {
+    const auto diff = DiffConfig(config_, updated);
+    if (!diff.Any()) {
+        return;
+    }
+    configManager_ = std::move(manager);
+    const std::wstring objectDirectory = config_.paths.objectDirectory;
+    config_ = updated;
+
+    if (diff.hotkey || diff.bindings) {
+        hotkeyManager_.UpdateConfig(config_.hotkey, config_.bindings);
+    }
+    // With adaptive cadence the running session keeps its own notch count.
+    if (diff.scrollsPerCapture && !(captureModeActive_ && config_.adaptiveCadence)) {
+        hotkeyManager_.SetScrollsPerCapture(config_.scrollsPerCapture);
+    }
+    if (diff.scrollPacing) {
+        hotkeyManager_.SetScrollPacing(config_.scrollPacing, config_.maxPendingCaptures);
+    }
+    if (diff.objectDirectory) {
+        // The store is only swapped once nothing can still write to or release from it.
+        pendingObjectDirectory_ = config_.paths.objectDirectory;
+        config_.paths.objectDirectory = objectDirectory;
+        if (!ApplyPendingObjectDirectory()) {
+            logging::Info(L"The new objectDirectory takes effect once running sessions and cleanup finish.");
+        }
+    }
+    if (diff.paths) {
+        // A session already capturing keeps writing to the folder it started in.
+        EnsureDirectories();
+    }
+    if (diff.publishing) {
+        webProcessor_.SetPublishLimits(config_.maxPublishedSets, MemoryBudgetBytes());
+    }
+    if (diff.recordInput) {
+        if (config_.recordInput) {
+            hotkeyManager_.StartRecording(util::JoinPath(logDirectory_, L"input-" + util::TimestampString() + L".bin"));
+        } else {
+            hotkeyManager_.StopRecording();
+        }
+    }
+    if (diff.retention || diff.paths) {
+        CollectSessions();
+    }
+
+    logging::Info(L"Reloaded config.ini.");
+    if (!captureModeActive_ && processingJobs_ == 0) {
+        UpdateStatus(L"Settings reloaded. " + BuildIdleStatus());
+    }
 }
 
 int Application::Run() {
@@ -325,6 +540,36 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT message, WPARAM wParam,
         case WM_COMMAND:
             app->OnCommand(wParam);
             return 0;
+        case WM_RENDERFORMAT:
+            app->RenderClipboardFormat(static_cast<UINT>(wParam));
+            return 0;
+        case WM_RENDERALLFORMATS: {
+            Win32ClipboardBackend backend(hwnd);
+            app->clipboardPublisher_.RenderAll(backend);
+            return 0;
+        }
+        case WM_DESTROYCLIPBOARD:
+            app->clipboardPublisher_.Release();
+            return 0;
+        case kJobCallbackMessage: {
+            std::unique_ptr<std::function<void()>> callback(reinterpret_cast<std::function<void()>*>(lParam));
+            if (callback && *callback) {
+                (*callback)();
+            }
+            return 0;
+        }
+        case WM_TIMER:
+            if (wParam == kAutoScrollTimerId) {
+                app->OnAutoScrollTick();
+                return 0;
+            }
+            if (wParam == kJournalSyncTimerId) {
+                if (app->captureSession_) {
+                    app->captureSession_->SyncJournal();
+                }
+                return 0;
+            }
+            return DefWindowProcW(hwnd, message, wParam, lParam);
         case WM_DESTROY:
             PostQuitMessage(0);
             return 0;
@@ -338,22 +583,32 @@ void Application::OnCreate() {
     HMENU fileMenu = CreatePopupMenu();
     AppendMenuW(fileMenu, MF_STRING, kMenuOpenOutput, L"Open capture folder");
     AppendMenuW(fileMenu, MF_STRING, kMenuClearSessions, L"Clear capture folder");
+    AppendMenuW(fileMenu, MF_STRING, kMenuExportSession, L"Export session");
     AppendMenuW(fileMenu, MF_STRING, kMenuSettings, L"Hotkey settings");
     AppendMenuW(menuBar, MF_POPUP, reinterpret_cast<UINT_PTR>(fileMenu), L"Actions");
     SetMenu(hwnd_, menuBar);
 
     statusStatic_ = CreateWindowExW(0, L"STATIC", L"Ready.", WS_CHILD | WS_VISIBLE,
                                     16, 16, 600, 24, hwnd_, reinterpret_cast<HMENU>(static_cast<INT_PTR>(kStatusControlId)), instance_, nullptr);
+    memoryStatic_ = CreateWindowExW(0, L"STATIC", L"", WS_CHILD | WS_VISIBLE,
+                                    16, 40, 600, 20, hwnd_, reinterpret_cast<HMENU>(static_cast<INT_PTR>(kMemoryControlId)), instance_, nullptr);
 
     EnsureUIFont();
     if (uiFont_ && statusStatic_) {
         SendMessageW(statusStatic_, WM_SETFONT, reinterpret_cast<WPARAM>(uiFont_), TRUE);
     }
+    if (uiFont_ && memoryStatic_) {
+        SendMessageW(memoryStatic_, WM_SETFONT, reinterpret_cast<WPARAM>(uiFont_), TRUE);
+    }
 
-    LoadWindowIcon();
+    {
+        StartupTimeline::Phase phase(startup_, L"Window icon");
+        LoadWindowIcon();
+    }
 
     UpdateStatus(BuildIdleStatus());
 
+    StartupTimeline::Phase phase(startup_, L"WebView2 controller request");
     if (!webProcessor_.Initialize(hwnd_)) {
         MessageBoxW(hwnd_, L"Failed to initialize embedded browser.", L"Error", MB_ICONERROR | MB_OK);
     }
@@ -369,11 +624,15 @@ void Application::OnSize() {
     GetClientRect(hwnd_, &client);
     const int padding = 16;
     const int statusHeight = 24;
+    const int memoryHeight = 20;
     if (statusStatic_) {
         MoveWindow(statusStatic_, padding, padding, client.right - (padding * 2), statusHeight, TRUE);
     }
+    if (memoryStatic_) {
+        MoveWindow(memoryStatic_, padding, padding + statusHeight, client.right - (padding * 2), memoryHeight, TRUE);
+    }
     RECT webRect = client;
-    webRect.top = padding * 2 + statusHeight;
+    webRect.top = padding * 2 + statusHeight + memoryHeight;
     if (webRect.top < webRect.bottom) {
         webProcessor_.Resize(webRect);
     }
@@ -387,6 +646,9 @@ void Application::OnCommand(WPARAM wParam) {
         case kMenuClearSessions:
             ClearSessionDirectory();
             break;
+        case kMenuExportSession:
+            ExportSession();
+            break;
         case kMenuSettings:
             ShowSettingsDialog();
             break;
@@ -395,10 +657,29 @@ void Application::OnCommand(WPARAM wParam) {
     }
 }
 
-void Application::ToggleCaptureMode() {
-    if (processingInFlight_) {
-        return;
+void Application::HandleHotkeyAction(hotkey::Action action) {
+    switch (action) {
+        case hotkey::Action::Toggle:
+            ToggleCaptureMode();
+            break;
+        case hotkey::Action::CaptureNow:
+            HandleCaptureRequest(0);
+            break;
+        case hotkey::Action::CancelSession:
+            CancelCaptureMode();
+            break;
+        case hotkey::Action::DropLastFrame:
+            DropLastCapture();
+            break;
+        case hotkey::Action::Republish:
+            RepublishLastSession();
+            break;
+        default:
+            break;
     }
+}
+
+void Application::ToggleCaptureMode() {
     if (captureModeActive_) {
         ExitCaptureMode();
     } else {
@@ -410,21 +691,58 @@ void Application::EnterCaptureMode() {
     if (captureModeActive_) {
         return;
     }
+    if (clearJob_.Active()) {
+        UpdateStatus(L"Wait until the capture folder is cleared.");
+        return;
+    }
+    if (!sessions::CanStartCapture(inFlightSessions_.size(), InFlightBytes(), config_.maxInFlightSessions, MemoryBudgetBytes())) {
+        UpdateStatus(L"Still preparing " + std::to_wstring(inFlightSessions_.size()) + L" earlier sessions. Try again shortly.");
+        return;
+    }
     HWND target = GetForegroundWindow();
     if (!target || target == hwnd_) {
         MessageBoxW(hwnd_, L"Please focus the game window before starting capture mode.", L"Notice", MB_OK | MB_ICONINFORMATION);
         return;
     }
-    if (!captureSession_.Begin(target, sessionDirectory_)) {
-        MessageBoxW(hwnd_, L"Failed to begin capture session.", L"Error", MB_OK | MB_ICONERROR);
+    auto session = std::make_unique<CaptureSession>();
+    EndOfListSettings endOfList;
+    endOfList.stillFrames = config_.endOfListFrames;
+    endOfList.tolerancePx = config_.endOfListTolerance;
+    session->SetEndOfList(endOfList);
+    if (config_.dedupeFrames) {
+        session->SetObjectStore(objectStore_);
+    }
+    const bool resuming = !resumeSessionRoot_.empty();
+    const bool begun = resuming ? session->Resume(target, resumeSessionRoot_) : session->Begin(target, sessionDirectory_);
+    resumeSessionRoot_.clear();
+    if (!begun) {
+        MessageBoxW(hwnd_, resuming ? L"Failed to resume the interrupted capture session." : L"Failed to begin capture session.",
+                    L"Error", MB_OK | MB_ICONERROR);
         return;
     }
+    captureSession_ = std::move(session);
     currentCapturedFiles_.clear();
+    for (const auto& frame : captureSession_->Frames().Frames()) {
+        currentCapturedFiles_.emplace_back(frame.path);
+    }
     captureModeActive_ = true;
+    SetTimer(hwnd_, kJournalSyncTimerId, kJournalSyncTickMs, nullptr);
+    hotkeyManager_.ResetHookLatency();
+    hotkeyManager_.SetScrollsPerCapture(config_.scrollsPerCapture);
+    if (config_.adaptiveCadence) {
+        CadenceSettings settings;
+        settings.targetOverlap = config_.targetOverlapPercent / 100.0;
+        cadence_ = CadenceController(settings);
+        cadence_.Reset(config_.scrollsPerCapture);
+    }
+    if (config_.autoScroll) {
+        StartAutoScroll(target);
+        return;
+    }
     hotkeyManager_.SetCaptureMode(true);
 
     const size_t previousCount = currentCapturedFiles_.size();
-    HandleCaptureRequest();
+    HandleCaptureRequest(0);
 
     std::wstring instruction = L"Scroll down ";
     instruction += std::to_wstring(config_.scrollsPerCapture);
@@ -448,74 +766,324 @@ void Application::ExitCaptureMode() {
         return;
     }
 
-    const auto finalPath = captureSession_.CaptureNext();
-    if (!finalPath.empty()) {
-        currentCapturedFiles_.push_back(finalPath);
-        std::wstring text = L"Captured final frame ";
-        text += std::to_wstring(currentCapturedFiles_.size());
-        UpdateStatus(text);
+    if (autoScrollActive_) {
+        // The driver's last capture already shows where scrolling stopped.
+        StopAutoScroll();
+    } else if (!captureSession_->AtEndOfList()) {
+        const auto finalPath = captureSession_->CaptureNext();
+        if (!finalPath.empty()) {
+            currentCapturedFiles_.push_back(finalPath);
+            std::wstring text = L"Captured final frame ";
+            text += std::to_wstring(currentCapturedFiles_.size());
+            UpdateStatus(text);
+        }
     }
 
     hotkeyManager_.SetCaptureMode(false);
     captureModeActive_ = false;
+    KillTimer(hwnd_, kJournalSyncTimerId);
+    LogInputStats();
+    if (const auto* arena = captureSession_->Arena()) {
+        logging::Info(L"Session arena: " + std::to_wstring(arena->BytesAllocated() / 1024) + L" KB allocated in " +
+                      std::to_wstring(arena->BytesReserved() / 1024) + L" KB from " +
+                      std::to_wstring(arena->UpstreamAllocations()) + L" upstream allocations.");
+    }
 
-    auto captured = captureSession_.End();
+    auto captured = captureSession_->End();
     currentCapturedFiles_ = captured;
+    if (config_.dedupeFrames) {
+        const auto stats = objectStore_->GetStats();
+        logging::Info(L"Frame store: " + std::to_wstring(stats.hits) + L" of " + std::to_wstring(stats.hits + stats.misses) +
+                      L" frames deduplicated, " + std::to_wstring(stats.objects) + L" objects.");
+    }
     if (captured.empty()) {
+        captureSession_.reset();
+        ApplyPendingObjectDirectory();
         UpdateStatus(L"Capture mode OFF. No frames captured.");
         return;
     }
     UpdateStatus(L"Preparing captures for clipboard...");
-    StartProcessing(captured);
+    StartProcessing(std::move(captureSession_));
 }
 
-void Application::HandleCaptureRequest() {
+void Application::CancelCaptureMode() {
     if (!captureModeActive_) {
         return;
     }
-    const auto path = captureSession_.CaptureNext();
+    StopAutoScroll();
+    hotkeyManager_.SetCaptureMode(false);
+    captureModeActive_ = false;
+    KillTimer(hwnd_, kJournalSyncTimerId);
+    LogInputStats();
+    captureSession_->Cancel();
+    captureSession_.reset();
+    ApplyPendingObjectDirectory();
+    currentCapturedFiles_.clear();
+    UpdateStatus(L"Capture cancelled. " + BuildIdleStatus());
+}
+
+void Application::DropLastCapture() {
+    if (!captureModeActive_ || !captureSession_->DropLast()) {
+        return;
+    }
+    if (!currentCapturedFiles_.empty()) {
+        currentCapturedFiles_.pop_back();
+    }
+    std::wstring text = L"Dropped last frame. ";
+    text += std::to_wstring(currentCapturedFiles_.size());
+    text += currentCapturedFiles_.size() == 1 ? L" frame kept." : L" frames kept.";
+    UpdateStatus(text);
+}
+
+void Application::RepublishLastSession() {
+    if (captureModeActive_ || processingJobs_ > 0 || !lastSession_ || lastSession_->Frames().Empty()) {
+        return;
+    }
+    UpdateStatus(L"Preparing captures for clipboard...");
+    const auto& kept = lastSession_->Frames().Frames();
+    QueueProcessing(std::make_shared<const std::vector<Frame>>(kept.begin(), kept.end()), SessionLabel(*lastSession_), nullptr);
+}
+
+void Application::StartAutoScroll(HWND target) {
+    AutoScrollSettings settings;
+    settings.notchesPerStep = config_.scrollsPerCapture;
+    // The session's detector decides when it is on; the driver's own check is
+    // the backstop for endOfListFrames=0.
+    settings.maxStillSteps = (std::max)(settings.maxStillSteps, static_cast<uint32_t>(config_.endOfListFrames));
+    autoScroll_ = AutoScrollDriver(settings);
+    autoProbeSignatures_.clear();
+
+    // Wheel input goes to the window under the cursor.
+    RECT rect = {};
+    POINT cursor = {};
+    if (GetWindowRect(target, &rect) && GetCursorPos(&cursor) && !PtInRect(&rect, cursor)) {
+        SetCursorPos((rect.left + rect.right) / 2, (rect.top + rect.bottom) / 2);
+    }
+
+    autoScrollActive_ = true;
+    autoScroll_.Start(GetTickCount64());
+    SetTimer(hwnd_, kAutoScrollTimerId, kAutoScrollTickMs, nullptr);
+    UpdateStatus(L"Auto capture running. Press " + hotkey::Describe(config_.hotkey) + L" to stop.");
+}
+
+void Application::StopAutoScroll() {
+    if (!autoScrollActive_) {
+        return;
+    }
+    KillTimer(hwnd_, kAutoScrollTimerId);
+    autoScroll_.Stop();
+    autoScrollActive_ = false;
+}
+
+void Application::OnAutoScrollTick() {
+    if (!autoScrollActive_) {
+        return;
+    }
+    switch (autoScroll_.Poll(GetTickCount64())) {
+        case AutoScrollDriver::Command::Capture: {
+            const auto path = captureSession_->CaptureNext(autoScroll_.Captures() > 0);
+            if (!path.empty()) {
+                currentCapturedFiles_.push_back(path);
+                const auto& frame = captureSession_->Frames().Last();
+                autoProbeSignatures_.assign(frame.signatures.begin(), frame.signatures.end());
+                if (config_.adaptiveCadence && frame.shift) {
+                    autoScroll_.SetNotches(cadence_.Observe(autoScroll_.Notches(), *frame.shift, frame.height));
+                }
+                UpdateStatus(L"Auto capture: frame " + std::to_wstring(currentCapturedFiles_.size()) + L". Press " +
+                             hotkey::Describe(config_.hotkey) + L" to stop.");
+            }
+            autoScroll_.OnCaptured(!path.empty(), captureSession_->AtEndOfList(), GetTickCount64());
+            break;
+        }
+        case AutoScrollDriver::Command::Scroll:
+            SendWheelNotches(autoScroll_.Notches());
+            autoScroll_.OnScrolled(GetTickCount64());
+            break;
+        case AutoScrollDriver::Command::Probe: {
+            std::vector<motion::RowSignature> signatures;
+            motion::ShiftEstimate estimate;
+            if (captureSession_->Probe(signatures)) {
+                estimate = motion::EstimateShift(autoProbeSignatures_, signatures);
+                autoProbeSignatures_ = std::move(signatures);
+            }
+            autoScroll_.OnProbe(estimate, GetTickCount64());
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (autoScroll_.GetState() == AutoScrollDriver::State::Finished) {
+        if (autoScroll_.Reason() == AutoScrollDriver::FinishReason::EndOfList) {
+            FinishAtEndOfList();
+        } else if (autoScroll_.Reason() == AutoScrollDriver::FinishReason::ViewStopped) {
+            FinishAtEndOfList(autoScroll_.StillSteps());
+        } else {
+            if (autoScroll_.Reason() == AutoScrollDriver::FinishReason::SettleTimeout) {
+                logging::Warning(L"Auto capture stopped: the view kept moving after a scroll.");
+            }
+            ExitCaptureMode();
+        }
+    }
+}
+
+void Application::FinishAtEndOfList(size_t repeatedFrames) {
+    const size_t dropped = captureSession_->DropTrailingDuplicates(repeatedFrames);
+    for (size_t i = 0; i < dropped && !currentCapturedFiles_.empty(); ++i) {
+        currentCapturedFiles_.pop_back();
+    }
+    logging::Info(L"End of list reached; dropped " + std::to_wstring(dropped) + L" repeated frames.");
+    ExitCaptureMode();
+}
+
+void Application::HandleCaptureRequest(UINT notches) {
+    if (!captureModeActive_) {
+        return;
+    }
+    const auto path = captureSession_->CaptureNext(notches > 0);
+    if (notches > 0) {
+        // Lets held-back wheel notches through even when the grab failed.
+        hotkeyManager_.NotifyCaptureCompleted();
+    }
     if (!path.empty()) {
         currentCapturedFiles_.push_back(path);
         std::wstring text = L"Captured frame ";
         text += std::to_wstring(currentCapturedFiles_.size());
+
+        const auto& frame = captureSession_->Frames().Last();
+        if (config_.adaptiveCadence && notches > 0 && frame.shift) {
+            const UINT next = cadence_.Observe(notches, *frame.shift, frame.height);
+            if (next != hotkeyManager_.ScrollsPerCapture()) {
+                hotkeyManager_.SetScrollsPerCapture(next);
+            }
+            text += L" (next after " + std::to_wstring(next) + (next == 1 ? L" scroll)" : L" scrolls)");
+        }
         UpdateStatus(text);
+        if (captureSession_->AtEndOfList() && !autoScrollActive_) {
+            FinishAtEndOfList();
+        }
     }
 }
 
-void Application::StartProcessing(const std::vector<std::wstring>& capturedFiles) {
-    if (capturedFiles.empty()) {
+void Application::LogInputStats() {
+    const auto report = hotkeyManager_.HookLatency();
+    const auto describe = [](const wchar_t* name, const LatencyHistogram::Summary& summary) {
+        wchar_t buffer[160] = {};
+        swprintf_s(buffer, L"%ls hook: %llu calls, p50 %.1f us, p99 %.1f us, max %.1f us", name,
+                   static_cast<unsigned long long>(summary.count), summary.p50 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0);
+        return std::wstring(buffer);
+    };
+    logging::Info(describe(L"Keyboard", report.keyboard));
+    logging::Info(describe(L"Mouse", report.mouse));
+    if (report.slowHooks > 0) {
+        logging::Warning(std::to_wstring(report.slowHooks) + L" hook calls this session took over half of LowLevelHooksTimeout (" +
+                         std::to_wstring(report.timeoutMs) + L" ms).");
+    }
+
+    if (config_.scrollPacing) {
+        const auto pacing = hotkeyManager_.Pacing();
+        wchar_t buffer[200] = {};
+        swprintf_s(buffer, L"Scroll pacing: max %u pending captures, %llu notches held, %llu released, %llu discarded, release p50 %.1f ms, max %.1f ms",
+                   pacing.stats.maxOutstanding,
+                   static_cast<unsigned long long>(pacing.stats.held),
+                   static_cast<unsigned long long>(pacing.stats.released),
+                   static_cast<unsigned long long>(pacing.stats.discarded),
+                   pacing.releaseLatency.p50 / 1e6, pacing.releaseLatency.max / 1e6);
+        logging::Info(buffer);
+        if (pacing.stats.overflowed > 0 || pacing.droppedEvents > 0) {
+            logging::Warning(L"Scroll pacing could not hold " + std::to_wstring(pacing.stats.overflowed) + L" notches; input queue dropped " +
+                             std::to_wstring(pacing.droppedEvents) + L" events.");
+        }
+    }
+}
+
+void Application::StartProcessing(std::unique_ptr<CaptureSession> session) {
+    if (!session || session->Frames().Empty()) {
         return;
     }
-    processingInFlight_ = true;
-    std::vector<std::wstring> dataUrls;
-    dataUrls.reserve(capturedFiles.size());
+    // The job works on a copy of the frame list (the image buffers are shared), never on the session.
+    const auto& captured = session->Frames().Frames();
+    auto frames = std::make_shared<const std::vector<Frame>>(captured.begin(), captured.end());
+    const auto label = SessionLabel(*session);
+    const CaptureSession* owner = session.get();
+    inFlightSessions_.push_back(std::move(session));
+    QueueProcessing(std::move(frames), label, owner);
+}
 
-    for (const auto& file : capturedFiles) {
-        std::ifstream fs(file, std::ios::binary);
-        if (!fs) {
-            continue;
+void Application::QueueProcessing(std::shared_ptr<const std::vector<Frame>> frames, const std::wstring& label, const CaptureSession* owner) {
+    ++processingJobs_;
+    // Only the job allocates from the arena; the published set releases it in one go.
+    auto dataUrls = std::make_shared<DataUrls>(std::make_shared<SessionArena>());
+
+    JobOptions options;
+    options.priority = JobPriority::High;
+    options.onProgress = [this](float fraction) {
+        if (!captureModeActive_) {
+            UpdateStatus(L"Preparing captures for clipboard... " + std::to_wstring(static_cast<int>(fraction * 100.0f)) + L"%");
         }
-        std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
-        if (buffer.empty()) {
-            continue;
+    };
+    // Covers the data URLs until the page bridge takes them over.
+    auto charge = std::make_shared<memory::Charge>(memory::Tag::Bridge, owner ? owner->MemoryLedger() : nullptr);
+    options.onComplete = [this, frames, dataUrls, label, owner, charge](JobStatus status) {
+        charge->Reset();
+        FinishProcessing(status, owner, *frames, std::move(*dataUrls), label);
+    };
+    // Chained behind the previous session so results are published in capture order.
+    processingJob_ = jobs_->ContinueWith(processingJob_, [frames, dataUrls, charge](JobContext& context) {
+        dataUrls->urls.reserve(frames->size());
+        for (size_t i = 0; i < frames->size(); ++i) {
+            if (context.IsCancelled()) {
+                return false;
+            }
+            const auto& frame = (*frames)[i];
+            context.ReportProgress(static_cast<float>(i) / static_cast<float>(frames->size()));
+            if (!frame.png || frame.png->empty()) {
+                continue;
+            }
+            auto& dataUrl = dataUrls->urls.emplace_back();
+            if (!util::Base64FromBytes(frame.png->data(), frame.png->size(), L"data:image/png;base64,", dataUrl)) {
+                dataUrls->urls.pop_back();
+                continue;
+            }
+            charge->Add(dataUrl.size() * sizeof(wchar_t));
         }
-        const std::wstring base64 = util::Base64FromBytes(buffer);
-        if (base64.empty()) {
-            continue;
+        return true;
+    }, std::move(options));
+}
+
+void Application::FinishProcessing(JobStatus status, const CaptureSession* owner, const std::vector<Frame>& frames,
+                                   DataUrls dataUrls, const std::wstring& label) {
+    --processingJobs_;
+    // The session stays around after publishing so it can be republished.
+    for (auto it = inFlightSessions_.begin(); it != inFlightSessions_.end(); ++it) {
+        if (it->get() == owner) {
+            lastSession_ = std::move(*it);
+            inFlightSessions_.erase(it);
+            break;
         }
-        dataUrls.push_back(L"data:image/png;base64," + base64);
     }
-
-    if (!dataUrls.empty()) {
-        webProcessor_.UpdateClipboardImages(dataUrls);
-    } else {
-        webProcessor_.UpdateClipboardImages({});
+    ApplyPendingObjectDirectory();
+    // The finished session is now the newest one kept; older ones may be over the limits.
+    CollectSessions();
+    if (status == JobStatus::Cancelled) {
+        UpdateStatus(L"Processing cancelled.");
+        return;
     }
+    // A newer capture owns the status line; the page still gets the images.
+    const bool quiet = captureModeActive_;
+
+    const size_t imageCount = dataUrls.urls.size();
+    webProcessor_.PublishImages(label, std::move(dataUrls));
 
-    const bool clipboardOk = CopyImagesToClipboard(capturedFiles);
-    processingInFlight_ = false;
+    const bool clipboardOk = CopyFramesToClipboard(frames);
+    if (owner && lastSession_) {
+        AppendMemoryRecord(lastSession_->SessionRoot(), lastSession_->MemoryLedger()->Take());
+    }
+    if (quiet && clipboardOk) {
+        return;
+    }
 
-    if (dataUrls.empty()) {
+    if (imageCount == 0) {
         UpdateStatus(L"No valid captures to prepare.");
         if (!clipboardOk) {
             MessageBoxW(hwnd_, L"Failed to copy capture to clipboard.", L"Clipboard error", MB_OK | MB_ICONERROR);
@@ -526,8 +1094,8 @@ void Application::StartProcessing(const std::vector<std::wstring>& capturedFiles
     std::wstring status;
     if (clipboardOk) {
         status = L"Images ready (";
-        status += std::to_wstring(dataUrls.size());
-        status += dataUrls.size() == 1 ? L" image). click Nbv{[h\t to import. (or you can just ctrl + V on the page.)" : L" images). click Nbv{[h\t to import. (or you can just ctrl + V on the page.)";
+        status += std::to_wstring(imageCount);
+        status += imageCount == 1 ? L" image). click Nbv{[h\t to import. (or you can just ctrl + V on the page.)" : L" images). click Nbv{[h\t to import. (or you can just ctrl + V on the page.)";
     } else {
         status = L"Images ready for the embedded page, but clipboard copy failed.";
         MessageBoxW(hwnd_, status.c_str(), L"Clipboard error", MB_OK | MB_ICONERROR);
@@ -536,6 +1104,8 @@ void Application::StartProcessing(const std::vector<std::wstring>& capturedFiles
 }
 
 void Application::HandleWebError(const std::wstring& message) {
+    // The page never becomes ready, so report what startup got through.
+    LogStartupReport();
     std::wstring text = L"Web error: " + message;
     UpdateStatus(text);
     MessageBoxW(hwnd_, text.c_str(), L"Web error", MB_OK | MB_ICONERROR);
@@ -545,6 +1115,14 @@ void Application::UpdateStatus(const std::wstring& text) {
     if (statusStatic_) {
         SetWindowTextW(statusStatic_, text.c_str());
     }
+    // Every status change is a point where memory may have moved. A running
+    // capture shows its own use; otherwise the whole process is shown.
+    if (memoryStatic_) {
+        const auto summary = captureSession_
+            ? memory::FormatSummary(captureSession_->MemoryLedger()->Take(), L"Session memory now/peak:")
+            : memory::FormatSummary(memory::Take());
+        SetWindowTextW(memoryStatic_, summary.c_str());
+    }
 }
 
 void Application::OpenOutputFolder() {
@@ -558,10 +1136,10 @@ void Application::ShowSettingsDialog() {
         return;
     }
     config_.hotkey = updated.value();
-    hotkeyManager_.UpdateConfig(config_.hotkey);
+    hotkeyManager_.UpdateConfig(config_.hotkey, config_.bindings);
     hotkeyManager_.SetScrollsPerCapture(config_.scrollsPerCapture);
     configManager_.Save(config_);
-    if (!captureModeActive_ && !processingInFlight_) {
+    if (!captureModeActive_ && processingJobs_ == 0) {
         UpdateStatus(BuildIdleStatus());
     }
 }
@@ -595,52 +1173,63 @@ std::wstring Application::BuildIdleStatus() const {
 }
 
 void Application::LoadWindowIcon() {
-    const std::wstring iconPath = FindIconAsset();
-    if (appIconLarge_) {
-        DestroyIcon(appIconLarge_);
-        appIconLarge_ = nullptr;
-    }
-    if (appIconSmall_) {
-        DestroyIcon(appIconSmall_);
-        appIconSmall_ = nullptr;
-    }
-
-    if (!iconPath.empty()) {
-        appIconLarge_ = LoadIconFromPng(iconPath, 256);
-        if (!appIconLarge_) {
-            appIconLarge_ = LoadIconFromPng(iconPath, 0);
+    // The embedded icon shows at once; a PNG next to the executable replaces
+    // it when the background decode finishes.
+    SetWindowIcons(static_cast<HICON>(LoadImageW(instance_, MAKEINTRESOURCEW(IDI_APPICON), IMAGE_ICON, 0, 0, LR_DEFAULTSIZE)),
+                   static_cast<HICON>(LoadImageW(instance_, MAKEINTRESOURCEW(IDI_APPICON), IMAGE_ICON, 16, 16, LR_DEFAULTCOLOR)));
+
+    auto images = std::make_shared<std::vector<IconImage>>();
+    JobOptions options;
+    options.priority = JobPriority::High;
+    options.onComplete = [this, images](JobStatus status) {
+        if (status != JobStatus::Succeeded || images->size() != 2) {
+            return;
         }
-
-        appIconSmall_ = LoadIconFromPng(iconPath, 32);
-        if (!appIconSmall_) {
-            appIconSmall_ = LoadIconFromPng(iconPath, 0);
+        SetWindowIcons(CreateIconFromImage((*images)[0]), CreateIconFromImage((*images)[1]));
+    };
+    jobs_->Submit([base = baseDirectory_, images, this](JobContext&) {
+        const std::wstring iconPath = FindIconAsset(base);
+        if (iconPath.empty()) {
+            return false;
         }
-    }
-
-    if (!appIconLarge_) {
-        appIconLarge_ = LoadIconW(instance_, MAKEINTRESOURCEW(IDI_APPICON));
-    }
-    if (!appIconSmall_) {
-        appIconSmall_ = static_cast<HICON>(LoadImageW(instance_, MAKEINTRESOURCEW(IDI_APPICON), IMAGE_ICON, 16, 16, LR_DEFAULTCOLOR));
-    }
+        if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+            return false;
+        }
+        bool decoded = false;
+        {
+            StartupTimeline::Phase phase(startup_, L"Icon decode");
+            decoded = DecodeIconImages(iconPath, { 256, 32 }, *images);
+        }
+        CoUninitialize();
+        return decoded;
+    }, std::move(options));
+}
 
-    if (appIconLarge_) {
-        SendMessageW(hwnd_, WM_SETICON, ICON_BIG, reinterpret_cast<LPARAM>(appIconLarge_));
-        SetClassLongPtrW(hwnd_, GCLP_HICON, reinterpret_cast<LONG_PTR>(appIconLarge_));
+void Application::SetWindowIcons(HICON largeIcon, HICON smallIcon) {
+    if (largeIcon) {
+        SendMessageW(hwnd_, WM_SETICON, ICON_BIG, reinterpret_cast<LPARAM>(largeIcon));
+        SetClassLongPtrW(hwnd_, GCLP_HICON, reinterpret_cast<LONG_PTR>(largeIcon));
+        if (appIconLarge_) {
+            DestroyIcon(appIconLarge_);
+        }
+        appIconLarge_ = largeIcon;
     }
-    if (appIconSmall_) {
-        SendMessageW(hwnd_, WM_SETICON, ICON_SMALL, reinterpret_cast<LPARAM>(appIconSmall_));
-        SetClassLongPtrW(hwnd_, GCLP_HICONSM, reinterpret_cast<LONG_PTR>(appIconSmall_));
+    if (smallIcon) {
+        SendMessageW(hwnd_, WM_SETICON, ICON_SMALL, reinterpret_cast<LPARAM>(smallIcon));
+        SetClassLongPtrW(hwnd_, GCLP_HICONSM, reinterpret_cast<LONG_PTR>(smallIcon));
+        if (appIconSmall_) {
+            DestroyIcon(appIconSmall_);
+        }
+        appIconSmall_ = smallIcon;
     }
 }
 
-std::wstring Application::FindIconAsset() const {
+std::wstring Application::FindIconAsset(const std::wstring& baseDirectory) {
     std::vector<std::wstring> candidates = {
-        util::JoinPath(baseDirectory_, L"appicon.png"),
-        util::JoinPath(baseDirectory_, L"..\\appicon.png"),
-        util::JoinPath(baseDirectory_, L"..\\resources\\appicon.png"),
-        util::JoinPath(baseDirectory_, L"resources\\appicon.png"),
-        L"C:\\Users\\yusir\\Documents\\receipt_kun_auto\\build\\appicon.png"
+        util::JoinPath(baseDirectory, L"appicon.png"),
+        util::JoinPath(baseDirectory, L"..\\appicon.png"),
+        util::JoinPath(baseDirectory, L"..\\resources\\appicon.png"),
+        util::JoinPath(baseDirectory, L"resources\\appicon.png")
     };
 
     for (auto& candidate : candidates) {
@@ -661,10 +1250,12 @@ void Application::ClearSessionDirectory() {
         MessageBoxW(hwnd_, L"Stop capture mode before clearing sessions.", L"Capture active", MB_OK | MB_ICONWARNING);
         return;
     }
-    if (processingInFlight_) {
+    if (processingJobs_ > 0 || clearJob_.Active()) {
         MessageBoxW(hwnd_, L"Wait until processing finishes before clearing sessions.", L"Processing", MB_OK | MB_ICONWARNING);
         return;
     }
+    // Clearing removes everything the collector would; don't race it over the same files.
+    retentionJob_.Cancel();
     if (sessionDirectory_.empty()) {
         return;
     }
@@ -674,81 +1265,261 @@ void Application::ClearSessionDirectory() {
         return;
     }
 
-    std::error_code ec;
-    const std::filesystem::path sessionPath(sessionDirectory_);
-    if (std::filesystem::exists(sessionPath, ec)) {
-        std::filesystem::remove_all(sessionPath, ec);
-        if (ec) {
+    JobOptions options;
+    options.priority = JobPriority::Low;
+    options.onProgress = [this](float fraction) {
+        UpdateStatus(L"Clearing session folder... " + std::to_wstring(static_cast<int>(fraction * 100.0f)) + L"%");
+    };
+    options.onComplete = [this](JobStatus status) {
+        ApplyPendingObjectDirectory();
+        if (status == JobStatus::Cancelled) {
+            UpdateStatus(L"Clearing the session folder was cancelled.");
+            return;
+        }
+        if (status != JobStatus::Succeeded) {
             UpdateStatus(L"Failed to clear session folder.");
             MessageBoxW(hwnd_, L"Failed to clear the session folder.", L"Error", MB_OK | MB_ICONERROR);
             return;
         }
-    }
-
-    util::EnsureDirectory(sessionDirectory_);
-    currentCapturedFiles_.clear();
-    UpdateStatus(L"Session folder cleared.");
+        currentCapturedFiles_.clear();
+        resumeSessionRoot_.clear();
+        UpdateStatus(L"Session folder cleared.");
+    };
+    UpdateStatus(L"Clearing session folder...");
+    clearJob_ = jobs_->Submit([directory = sessionDirectory_, store = objectStore_](JobContext& context) {
+        // One session at a time, so a cancel stops between sessions rather than mid-tree.
+        std::error_code ec;
+        const std::filesystem::path sessionPath(directory);
+        std::vector<std::filesystem::path> sessions;
+        for (std::filesystem::directory_iterator it(sessionPath, ec), end; !ec && it != end; it.increment(ec)) {
+            sessions.push_back(it->path());
+        }
+        bool ok = true;
+        for (size_t i = 0; i < sessions.size() && !context.IsCancelled(); ++i) {
+            const auto shared = SharedFrames(sessions[i]);
+            std::filesystem::remove_all(sessions[i], ec);
+            ok = ok && !ec;
+            if (!ec) {
+                for (const auto& sha256 : shared) {
+                    store->Release(sha256);
+                }
+            }
+            context.ReportProgress(static_cast<float>(i + 1) / static_cast<float>(sessions.size()));
+        }
+        store->Collect();
+        return util::EnsureDirectory(directory) && ok;
+    }, std::move(options));
 }
 
-std::wstring Application::MakeAbsolutePath(const std::wstring& relative) const {
-    std::filesystem::path p(relative);
-    if (p.is_absolute()) {
-        return p.wstring();
+void Application::ExportSession() {
+    if (!lastSession_ || lastSession_->Frames().Empty()) {
+        UpdateStatus(L"No finished session to export yet.");
+        return;
     }
-    return util::JoinPath(baseDirectory_, relative);
-}
+    if (exportJob_.Active()) {
+        UpdateStatus(L"An export is already running.");
+        return;
+    }
+    const auto label = SessionLabel(*lastSession_);
+    const std::filesystem::path target(util::JoinPath(outputDirectory_, label + L".zip"));
+    const auto manifestPath = std::filesystem::path(lastSession_->SessionRoot()) / L"session.manifest";
+    if (!util::EnsureDirectory(outputDirectory_)) {
+        UpdateStatus(L"Failed to create the output folder.");
+        return;
+    }
+    // Frames share their encoded PNGs, so the archive streams from memory without copying them.
+    const auto& kept = lastSession_->Frames().Frames();
+    auto frames = std::make_shared<const std::vector<Frame>>(kept.begin(), kept.end());
 
-void Application::EnsureDirectories() {
-    outputDirectory_ = MakeAbsolutePath(config_.paths.outputDirectory);
-    sessionDirectory_ = MakeAbsolutePath(config_.paths.sessionDirectory);
-    util::EnsureDirectory(sessionDirectory_);
+    JobOptions options;
+    options.onProgress = [this](float fraction) {
+        UpdateStatus(L"Exporting session... " + std::to_wstring(static_cast<int>(fraction * 100.0f)) + L"%");
+    };
+    options.onComplete = [this, target](JobStatus status) {
+        if (status == JobStatus::Succeeded) {
+            logging::Info(L"Exported " + target.wstring());
+            UpdateStatus(L"Exported to " + target.wstring());
+        } else if (status == JobStatus::Cancelled) {
+            UpdateStatus(L"Export cancelled.");
+        } else {
+            UpdateStatus(L"Failed to export the session.");
+        }
+    };
+    UpdateStatus(L"Exporting session...");
+    exportJob_ = jobs_->Submit([frames, manifestPath, target, folder = util::WideToUtf8(label)](JobContext& context) {
+        ZipWriter zip;
+        if (!zip.Open(target)) {
+            return false;
+        }
+        for (size_t i = 0; i < frames->size(); ++i) {
+            const Frame& frame = (*frames)[i];
+            const auto name = folder + "/" + util::WideToUtf8(std::filesystem::path(frame.path).filename().wstring());
+            const bool added = frame.png ? zip.AddBytes(name, frame.png->data(), frame.png->size())
+                                         : zip.AddFile(name, std::filesystem::path(frame.path));
+            if (!added || context.IsCancelled()) {
+                zip.Abort();
+                return false;
+            }
+            context.ReportProgress(static_cast<float>(i + 1) / static_cast<float>(frames->size() + 1));
+        }
+        std::error_code ec;
+        if (std::filesystem::exists(manifestPath, ec) && !zip.AddFile(folder + "/session.manifest", manifestPath)) {
+            zip.Abort();
+            return false;
+        }
+        return zip.Finish();
+    }, std::move(options));
 }
 
-bool Application::CopyImagesToClipboard(const std::vector<std::wstring>& files) {
-    if (files.empty()) {
-        return false;
+void Application::CollectSessions() {
+    if (sessionDirectory_.empty() || retentionJob_.Active() || clearJob_.Active()) {
+        return;
     }
-
-    const std::wstring& target = files.back();
-    HBITMAP hBitmap = nullptr;
-    HGLOBAL hDib = nullptr;
-    if (!CreateClipboardBitmaps(target, hBitmap, hDib)) {
-        return false;
+    RetentionPolicy policy;
+    policy.maxSessionBytes = config_.paths.maxSessionBytes;
+    policy.maxSessionAgeSeconds = config_.paths.maxSessionAgeSeconds;
+    policy.keepLastN = config_.paths.keepLastN;
+    if (policy.maxSessionBytes == 0 && policy.maxSessionAgeSeconds == 0) {
+        return;
     }
 
-    if (!OpenClipboard(hwnd_)) {
-        DeleteObject(hBitmap);
-        GlobalFree(hDib);
-        return false;
+    // Sessions the app still owns are never collected.
+    std::vector<std::filesystem::path> protectedPaths;
+    for (const auto* session : { captureSession_.get(), lastSession_.get() }) {
+        if (session) {
+            protectedPaths.emplace_back(session->SessionRoot());
+        }
     }
-
-    if (!EmptyClipboard()) {
-        CloseClipboard();
-        DeleteObject(hBitmap);
-        GlobalFree(hDib);
-        return false;
+    if (!resumeSessionRoot_.empty()) {
+        protectedPaths.emplace_back(resumeSessionRoot_);
+    }
+    for (const auto& session : inFlightSessions_) {
+        protectedPaths.emplace_back(session->SessionRoot());
     }
 
-    bool anySuccess = false;
+    auto result = std::make_shared<retention::CollectResult>();
+    JobOptions options;
+    options.priority = JobPriority::Low;
+    options.onComplete = [this, result](JobStatus status) {
+        ApplyPendingObjectDirectory();
+        if (status != JobStatus::Succeeded || result->sessionsRemoved == 0) {
+            return;
+        }
+        const std::wstring summary = L"Removed " + std::to_wstring(result->sessionsRemoved) + L" old sessions (" +
+                                     std::to_wstring(result->bytesReclaimed / (1024 * 1024)) + L" MB reclaimed).";
+        logging::Info(summary);
+        if (!captureModeActive_ && processingJobs_ == 0) {
+            UpdateStatus(summary + L" " + BuildIdleStatus());
+        }
+    };
+    retentionJob_ = jobs_->Submit([directory = sessionDirectory_, store = objectStore_, policy, protectedPaths = std::move(protectedPaths),
+                                   result](JobContext& context) {
+        // Background mode lowers this worker's I/O and memory priority so a
+        // large delete never competes with a capture for the disk.
+        const bool background = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != FALSE;
+        const auto started = std::filesystem::file_time_type::clock::now();
+        auto sessions = retention::ScanSessions(std::filesystem::path(directory));
+        // A capture may have started after the protected list was taken.
+        std::erase_if(sessions, [started](const SessionInfo& session) { return session.modified >= started; });
+        const auto doomed = retention::SelectForDeletion(std::move(sessions), policy, started, protectedPaths);
+        // Session by session, so object references are only released for sessions that are gone.
+        for (const auto& session : doomed) {
+            const auto shared = SharedFrames(session.path);
+            const auto removed = retention::Collect({ session }, [&context]() { return context.IsCancelled(); });
+            result->sessionsRemoved += removed.sessionsRemoved;
+            result->bytesReclaimed += removed.bytesReclaimed;
+            result->ok = result->ok && removed.ok;
+            if (removed.sessionsRemoved > 0) {
+                for (const auto& sha256 : shared) {
+                    store->Release(sha256);
+                }
+            }
+            if (removed.cancelled) {
+                result->cancelled = true;
+                break;
+            }
+        }
+        result->bytesReclaimed += store->Collect();
+        if (background) {
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+        }
+        return result->ok;
+    }, std::move(options));
+}
 
-    if (SetClipboardData(CF_DIB, hDib)) {
-        hDib = nullptr;
-        anySuccess = true;
+size_t Application::InFlightBytes() const {
+    size_t bytes = 0;
+    for (const auto& session : inFlightSessions_) {
+        bytes += session->Frames().Bytes();
     }
+    return bytes;
+}
 
-    if (SetClipboardData(CF_BITMAP, hBitmap)) {
-        hBitmap = nullptr;
-        anySuccess = true;
+size_t Application::MemoryBudgetBytes() const {
+    return static_cast<size_t>(config_.memoryBudgetMegabytes) * 1024 * 1024;
+}
+
+std::wstring Application::SessionLabel(const CaptureSession& session) {
+    return std::filesystem::path(session.SessionRoot()).filename().wstring();
+}
+
+void Application::DispatchToUi(std::function<void()> callback) {
+    auto pending = std::make_unique<std::function<void()>>(std::move(callback));
+    if (hwnd_ && PostMessageW(hwnd_, kJobCallbackMessage, 0, reinterpret_cast<LPARAM>(pending.get()))) {
+        pending.release();
     }
+}
 
-    CloseClipboard();
+std::wstring Application::MakeAbsolutePath(const std::wstring& relative) const {
+    std::filesystem::path p(relative);
+    if (p.is_absolute()) {
+        return p.wstring();
+    }
+    return util::JoinPath(baseDirectory_, relative);
+}
 
-    if (hBitmap) {
-        DeleteObject(hBitmap);
+bool Application::ApplyPendingObjectDirectory() {
+    if (!pendingObjectDirectory_) {
+        return true;
+    }
+    if (captureSession_ || !inFlightSessions_.empty() || retentionJob_.Active() || clearJob_.Active()) {
+        return false;
     }
-    if (hDib) {
-        GlobalFree(hDib);
+    config_.paths.objectDirectory = *pendingObjectDirectory_;
+    pendingObjectDirectory_.reset();
+    EnsureDirectories();
+    return true;
+}
+
+void Application::EnsureDirectories() {
+    outputDirectory_ = MakeAbsolutePath(config_.paths.outputDirectory);
+    sessionDirectory_ = MakeAbsolutePath(config_.paths.sessionDirectory);
+    logDirectory_ = MakeAbsolutePath(L"logs");
+    util::EnsureDirectory(sessionDirectory_);
+    util::EnsureDirectory(logDirectory_);
+    // The same directory yields the same instance, so an edit to other paths
+    // leaves sessions and jobs sharing one index.
+    bool indexLoaded = true;
+    objectStore_ = ObjectStore::ForDirectory(std::filesystem::path(MakeAbsolutePath(config_.paths.objectDirectory)), &indexLoaded);
+    if (!indexLoaded) {
+        logging::Warning(L"The frame object index is unreadable; deduplication starts over.");
     }
+}
+
+bool Application::CopyFramesToClipboard(const std::vector<Frame>& frames) {
+    // CF_BITMAP is synthesized by the system from CF_DIB, so only the DIB and the
+    // original PNG bytes are offered, plus CF_HDROP in AllFrames mode. All of
+    // them are rendered on demand.
+    Win32ClipboardBackend backend(hwnd_);
+    const bool includeFileList = config_.clipboardMode == AppConfig::ClipboardMode::AllFrames;
+    return clipboardPublisher_.Publish(backend, frames, includeFileList);
+}
 
-    return anySuccess;
+void Application::RenderClipboardFormat(UINT nativeFormat) {
+    const auto format = Win32ClipboardBackend::FromNative(nativeFormat);
+    if (!format) {
+        return;
+    }
+    Win32ClipboardBackend backend(hwnd_);
+    clipboardPublisher_.Render(backend, *format);
 }
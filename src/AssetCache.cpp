@@ -0,0 +1,316 @@
+#include "AssetCache.h"
+
+#include "Digest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+
+const char kIndexHeader[] = "chronos-asset-cache\t1";
+
+std::atomic<uint64_t> g_tempCounter{ 0 };
+
+std::string SanitizeField(const std::string& value) {
+    std::string result;
+    result.reserve(value.size());
+    for (char ch : value) {
+        if (ch != '\t' && ch != '\r' && ch != '\n') {
+            result.push_back(ch);
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> SplitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        const auto tab = line.find('\t', start);
+        if (tab == std::string::npos) {
+            fields.push_back(line.substr(start));
+            break;
+        }
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+    return fields;
+}
+
+// Returns the freshness lifetime in seconds, or -1 when the response must not be stored.
+int64_t ParseMaxAge(const std::string& cacheControl) {
+    std::string lower = cacheControl;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (lower.find("no-store") != std::string::npos) {
+        return -1;
+    }
+    if (lower.find("no-cache") != std::string::npos) {
+        return 0;
+    }
+    const auto pos = lower.find("max-age=");
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    int64_t value = 0;
+    for (size_t i = pos + 8; i < lower.size() && std::isdigit(static_cast<unsigned char>(lower[i])); ++i) {
+        value = value * 10 + (lower[i] - '0');
+    }
+    return value;
+}
+
+} // namespace
+
+AssetCache::AssetCache(const std::filesystem::path& root)
+    : root_(root),
+      indexPath_(root / "index.txt") {}
+
+bool AssetCache::Open() {
+    std::error_code ec;
+    std::filesystem::create_directories(root_ / "objects", ec);
+    if (ec) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+
+    std::ifstream in(indexPath_, std::ios::binary);
+    if (!in) {
+        return true;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != kIndexHeader) {
+        return true;
+    }
+    while (std::getline(in, line)) {
+        const auto fields = SplitFields(line);
+        if (fields.size() != 8 || fields[0].empty() || fields[1].empty()) {
+            continue;
+        }
+        CachedAsset asset;
+        asset.url = fields[0];
+        asset.hash = fields[1];
+        asset.size = std::strtoull(fields[2].c_str(), nullptr, 10);
+        asset.storedAt = std::strtoll(fields[3].c_str(), nullptr, 10);
+        asset.maxAge = std::strtoll(fields[4].c_str(), nullptr, 10);
+        asset.etag = fields[5];
+        asset.lastModified = fields[6];
+        asset.contentType = fields[7];
+        entries_[asset.url] = asset;
+    }
+    return true;
+}
+
+AssetCache::Result AssetCache::Resolve(const std::string& url, AssetFetcher& fetcher, int64_t now) {
+    Result result;
+    if (const auto cached = Lookup(url)) {
+        if (ReadBody(*cached, result.body)) {
+            result.source = Source::Cache;
+            result.asset = *cached;
+            result.needsRevalidation = !IsFresh(*cached, now);
+            return result;
+        }
+    }
+
+    AssetRequest request;
+    request.url = url;
+    AssetResponse response;
+    if (!fetcher.Fetch(request, response) || response.status != 200) {
+        return result;
+    }
+
+    // Described the same way whether or not the response was cacheable.
+    Store(url, response, now, &result.asset);
+    result.source = Source::Network;
+    result.body = std::move(response.body);
+    return result;
+}
+
+bool AssetCache::Revalidate(const std::string& url, AssetFetcher& fetcher, int64_t now) {
+    const auto cached = Lookup(url);
+    if (!cached) {
+        return false;
+    }
+
+    AssetRequest request;
+    request.url = url;
+    request.ifNoneMatch = cached->etag;
+    request.ifModifiedSince = cached->lastModified;
+    AssetResponse response;
+    if (!fetcher.Fetch(request, response)) {
+        return false;
+    }
+
+    if (response.status == 304) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(url);
+        if (it == entries_.end()) {
+            return false;
+        }
+        it->second.storedAt = now;
+        if (!response.cacheControl.empty()) {
+            it->second.maxAge = (std::max<int64_t>)(0, ParseMaxAge(response.cacheControl));
+        }
+        if (!response.etag.empty()) {
+            it->second.etag = SanitizeField(response.etag);
+        }
+        if (!response.lastModified.empty()) {
+            it->second.lastModified = SanitizeField(response.lastModified);
+        }
+        return SaveIndexLocked();
+    }
+    if (response.status == 200) {
+        return Store(url, response, now);
+    }
+    return false;
+}
+
+std::optional<CachedAsset> AssetCache::Lookup(const std::string& url) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(url);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+bool AssetCache::ReadBody(const CachedAsset& asset, std::vector<uint8_t>& body) const {
+    std::ifstream in(ObjectPath(asset.hash), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return body.size() == asset.size;
+}
+
+bool AssetCache::Store(const std::string& url, const AssetResponse& response, int64_t now, CachedAsset* stored) {
+    const int64_t maxAge = ParseMaxAge(response.cacheControl);
+    const auto hash = digest::ToHex(digest::ComputeSha256(response.body.data(), response.body.size()));
+
+    CachedAsset asset;
+    asset.url = SanitizeField(url);
+    asset.hash = hash;
+    asset.etag = SanitizeField(response.etag);
+    asset.lastModified = SanitizeField(response.lastModified);
+    asset.contentType = SanitizeField(response.contentType);
+    asset.storedAt = now;
+    asset.maxAge = (std::max<int64_t>)(0, maxAge);
+    asset.size = response.body.size();
+    if (stored) {
+        *stored = asset;
+    }
+    if (maxAge < 0) {
+        return false;
+    }
+
+    // The object is written outside the lock; until it is indexed, the
+    // pending count keeps a concurrent Store from releasing it as unused.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pendingObjects_[hash];
+    }
+    const bool written = WriteObject(hash, response.body);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pendingObjects_[hash] == 0) {
+        pendingObjects_.erase(hash);
+    }
+    if (!written) {
+        return false;
+    }
+    std::string previousHash;
+    auto it = entries_.find(asset.url);
+    if (it != entries_.end()) {
+        previousHash = it->second.hash;
+    }
+    entries_[asset.url] = asset;
+    if (!previousHash.empty() && previousHash != hash) {
+        ReleaseObjectLocked(previousHash);
+    }
+    return SaveIndexLocked();
+}
+
+bool AssetCache::IsFresh(const CachedAsset& asset, int64_t now) const {
+    return now >= asset.storedAt && now - asset.storedAt < asset.maxAge;
+}
+
+std::filesystem::path AssetCache::ObjectPath(const std::string& hash) const {
+    return root_ / "objects" / hash.substr(0, 2) / hash;
+}
+
+bool AssetCache::WriteObject(const std::string& hash, const std::vector<uint8_t>& body) const {
+    const auto path = ObjectPath(hash);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) == body.size()) {
+        return true;
+    }
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto tempPath = path;
+    tempPath += ".tmp" + std::to_string(++g_tempCounter);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return std::filesystem::exists(path, ec);
+    }
+    return true;
+}
+
+void AssetCache::ReleaseObjectLocked(const std::string& hash) {
+    if (pendingObjects_.count(hash) > 0) {
+        return;
+    }
+    for (const auto& [url, asset] : entries_) {
+        if (asset.hash == hash) {
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove(ObjectPath(hash), ec);
+}
+
+bool AssetCache::SaveIndexLocked() const {
+    std::ostringstream ss;
+    ss << kIndexHeader << '\n';
+    for (const auto& [url, asset] : entries_) {
+        ss << asset.url << '\t' << asset.hash << '\t' << asset.size << '\t'
+           << asset.storedAt << '\t' << asset.maxAge << '\t' << asset.etag << '\t'
+           << asset.lastModified << '\t' << asset.contentType << '\n';
+    }
+
+    auto tempPath = indexPath_;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        const auto text = ss.str();
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, indexPath_, ec);
+    return !ec;
+}
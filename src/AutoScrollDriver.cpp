@@ -0,0 +1,117 @@
+#include "AutoScrollDriver.h"
+
+#include <algorithm>
+
+AutoScrollDriver::AutoScrollDriver(const AutoScrollSettings& settings)
+    : settings_(settings) {
+    settings_.maxCaptures = (std::max)(1u, settings_.maxCaptures);
+    settings_.maxStillSteps = (std::max)(1u, settings_.maxStillSteps);
+    SetNotches(settings_.notchesPerStep);
+}
+
+void AutoScrollDriver::Start(uint64_t nowMs) {
+    reason_ = FinishReason::None;
+    captures_ = 0;
+    stillSteps_ = 0;
+    Schedule(State::Capturing, nowMs);
+}
+
+void AutoScrollDriver::Stop() {
+    if (Active()) {
+        Finish(FinishReason::Stopped);
+    }
+}
+
+AutoScrollDriver::Command AutoScrollDriver::Poll(uint64_t nowMs) {
+    if (!Active() || awaitingResult_ || nowMs < dueMs_) {
+        return Command::None;
+    }
+    awaitingResult_ = true;
+    switch (state_) {
+        case State::Capturing:
+            return Command::Capture;
+        case State::Scrolling:
+            return Command::Scroll;
+        case State::Settling:
+            return Command::Probe;
+        default:
+            awaitingResult_ = false;
+            return Command::None;
+    }
+}
+
+void AutoScrollDriver::OnCaptured(bool success, bool endOfList, uint64_t nowMs) {
+    if (state_ != State::Capturing) {
+        return;
+    }
+    if (!success) {
+        Finish(FinishReason::CaptureFailed);
+        return;
+    }
+    ++captures_;
+    if (endOfList) {
+        Finish(FinishReason::EndOfList);
+    } else if (stillSteps_ >= settings_.maxStillSteps) {
+        Finish(FinishReason::ViewStopped);
+    } else if (captures_ >= settings_.maxCaptures) {
+        Finish(FinishReason::CaptureLimit);
+    } else {
+        Schedule(State::Scrolling, nowMs);
+    }
+}
+
+void AutoScrollDriver::OnScrolled(uint64_t nowMs) {
+    if (state_ != State::Scrolling) {
+        return;
+    }
+    settleStartedMs_ = nowMs;
+    probes_ = 0;
+    stillProbes_ = 0;
+    moved_ = false;
+    Schedule(State::Settling, nowMs + settings_.settleIntervalMs);
+}
+
+void AutoScrollDriver::OnProbe(const motion::ShiftEstimate& sincePrevious, uint64_t nowMs) {
+    if (state_ != State::Settling) {
+        return;
+    }
+    const bool firstProbe = probes_++ == 0;
+    if (sincePrevious.valid && sincePrevious.shift > 0) {
+        moved_ = true;
+        stillProbes_ = 0;
+    } else if (sincePrevious.valid && !firstProbe) {
+        ++stillProbes_;
+    } else if (!sincePrevious.valid) {
+        // Unmeasurable (failed grab, or the view jumped past the last frame).
+        stillProbes_ = 0;
+    }
+
+    const bool settled = stillProbes_ >= (moved_ ? 1u : 2u);
+    const uint64_t elapsed = nowMs - settleStartedMs_;
+    if (settled || (!moved_ && elapsed >= settings_.maxSettleMs)) {
+        // Only a step whose probes matched counts as still; one that timed out
+        // unmeasured may well have moved.
+        stillSteps_ = settled && !moved_ ? stillSteps_ + 1 : 0;
+        Schedule(State::Capturing, nowMs);
+    } else if (moved_ && elapsed >= settings_.maxMotionMs) {
+        Finish(FinishReason::SettleTimeout);
+    } else {
+        Schedule(State::Settling, nowMs + settings_.settleIntervalMs);
+    }
+}
+
+void AutoScrollDriver::SetNotches(uint32_t notches) {
+    notches_ = (std::max)(1u, notches);
+}
+
+void AutoScrollDriver::Finish(FinishReason reason) {
+    reason_ = reason;
+    state_ = State::Finished;
+    awaitingResult_ = false;
+}
+
+void AutoScrollDriver::Schedule(State state, uint64_t dueMs) {
+    state_ = state;
+    dueMs_ = dueMs;
+    awaitingResult_ = false;
+}
@@ -0,0 +1,53 @@
+#include "CadenceController.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Weight of the newest pixels-per-notch sample.
+constexpr double kSmoothing = 0.5;
+
+} // namespace
+
+CadenceController::CadenceController(const CadenceSettings& settings)
+    : settings_(settings) {
+    settings_.targetOverlap = std::clamp(settings_.targetOverlap, 0.0, 0.95);
+    settings_.minNotches = (std::max)(1u, settings_.minNotches);
+    settings_.maxNotches = (std::max)(settings_.minNotches, settings_.maxNotches);
+    Reset(settings_.minNotches);
+}
+
+void CadenceController::Reset(uint32_t notches) {
+    notches_ = Clamp(notches);
+    pixelsPerNotch_ = 0.0;
+}
+
+uint32_t CadenceController::Observe(uint32_t notches, const motion::ShiftEstimate& estimate, uint32_t frameHeight) {
+    if (notches == 0 || frameHeight == 0) {
+        return notches_;
+    }
+    if (!estimate.valid) {
+        // No overlap at all: the last step overshot, so back off hard. It also
+        // moved at least a frame, which bounds the rate from below; without
+        // that the next estimate would still be the stale, too-low one.
+        pixelsPerNotch_ = (std::max)(pixelsPerNotch_, static_cast<double>(frameHeight) / static_cast<double>(notches));
+        notches_ = Clamp(notches / 2);
+        return notches_;
+    }
+    if (estimate.shift == 0) {
+        // Nothing moved (end of list or the game ignored the wheel); no information.
+        return notches_;
+    }
+
+    const double sample = static_cast<double>(estimate.shift) / static_cast<double>(notches);
+    pixelsPerNotch_ = pixelsPerNotch_ > 0.0 ? pixelsPerNotch_ + kSmoothing * (sample - pixelsPerNotch_) : sample;
+
+    const double budget = static_cast<double>(frameHeight) * (1.0 - settings_.targetOverlap);
+    notches_ = Clamp(static_cast<uint32_t>(std::floor(budget / pixelsPerNotch_)));
+    return notches_;
+}
+
+uint32_t CadenceController::Clamp(uint32_t notches) const {
+    return std::clamp(notches, settings_.minNotches, settings_.maxNotches);
+}
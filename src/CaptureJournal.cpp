@@ -0,0 +1,296 @@
+#include "CaptureJournal.h"
+
+#include "Digest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = { 'C', 'H', 'R', 'N', 'J', 'R', 'N', 'L' };
+constexpr size_t kRecordHeaderSize = 9;
+// Frame records are the largest; anything bigger is corruption.
+constexpr uint32_t kMaxPayload = 4096;
+
+void PutU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+void PutU64(std::vector<uint8_t>& out, uint64_t value) {
+    PutU32(out, static_cast<uint32_t>(value));
+    PutU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+uint16_t GetU16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t GetU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+std::FILE* OpenFile(const std::filesystem::path& path, bool truncate) {
+#ifdef _WIN32
+    return _wfopen(path.c_str(), truncate ? L"wb" : L"ab");
+#else
+    return std::fopen(path.c_str(), truncate ? "wb" : "ab");
+#endif
+}
+
+bool SyncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Applies one record to `state`; false for a record that makes no sense.
+bool ApplyRecord(journal::RecordType type, const uint8_t* payload, uint32_t length, journal::JournalState& state) {
+    using journal::RecordType;
+    switch (type) {
+        case RecordType::Begin:
+        case RecordType::End:
+            state.complete = type == RecordType::End;
+            return true;
+        case RecordType::Frame: {
+            if (length < 22) {
+                return false;
+            }
+            journal::FrameEntry frame;
+            frame.index = GetU32(payload);
+            frame.width = GetU32(payload + 4);
+            frame.height = GetU32(payload + 8);
+            frame.pngBytes = GetU32(payload + 12);
+            frame.pngCrc = GetU32(payload + 16);
+            const uint16_t nameLength = GetU16(payload + 20);
+            if (22u + nameLength != length) {
+                return false;
+            }
+            frame.file.assign(reinterpret_cast<const char*>(payload + 22), nameLength);
+            // A re-shot frame reuses the dropped index.
+            std::erase_if(state.frames, [&](const journal::FrameEntry& live) { return live.index == frame.index; });
+            state.frames.push_back(std::move(frame));
+            state.complete = false;
+            return true;
+        }
+        case RecordType::Drop: {
+            if (length != 4) {
+                return false;
+            }
+            const uint32_t index = GetU32(payload);
+            std::erase_if(state.frames, [&](const journal::FrameEntry& live) { return live.index == index; });
+            state.complete = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+namespace journal {
+
+Writer::Writer(SyncPolicy policy)
+    : policy_(policy) {
+}
+
+Writer::~Writer() {
+    Close();
+}
+
+bool Writer::Create(const std::filesystem::path& path) {
+    Close();
+    file_ = OpenFile(path, true);
+    if (!file_) {
+        return false;
+    }
+    std::vector<uint8_t> header(kMagic, kMagic + sizeof(kMagic));
+    PutU32(header, kVersion);
+    PutU32(header, 0);
+    if (std::fwrite(header.data(), 1, header.size(), file_) != header.size()) {
+        Close();
+        return false;
+    }
+    lastSync_ = std::chrono::steady_clock::now();
+    std::vector<uint8_t> payload;
+    PutU64(payload, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+    // The header and Begin are synced at once so the session is recognisable after a crash.
+    return Append(RecordType::Begin, payload) && Sync();
+}
+
+bool Writer::Reopen(const std::filesystem::path& path, const JournalState& state) {
+    Close();
+    std::error_code ec;
+    std::filesystem::resize_file(path, state.validBytes, ec);
+    if (ec) {
+        return false;
+    }
+    file_ = OpenFile(path, false);
+    lastSync_ = std::chrono::steady_clock::now();
+    return file_ != nullptr;
+}
+
+bool Writer::AppendFrame(const FrameEntry& frame) {
+    const auto nameLength = static_cast<uint16_t>(std::min<size_t>(frame.file.size(), kMaxPayload - 22));
+    std::vector<uint8_t> payload;
+    payload.reserve(22 + nameLength);
+    PutU32(payload, frame.index);
+    PutU32(payload, frame.width);
+    PutU32(payload, frame.height);
+    PutU32(payload, frame.pngBytes);
+    PutU32(payload, frame.pngCrc);
+    PutU16(payload, nameLength);
+    payload.insert(payload.end(), frame.file.begin(), frame.file.begin() + nameLength);
+    return Append(RecordType::Frame, payload);
+}
+
+bool Writer::AppendDrop(uint32_t index) {
+    std::vector<uint8_t> payload;
+    PutU32(payload, index);
+    return Append(RecordType::Drop, payload);
+}
+
+bool Writer::Finish() {
+    if (!file_) {
+        return false;
+    }
+    const bool ok = Append(RecordType::End, {}) && Sync();
+    Close();
+    return ok;
+}
+
+void Writer::Close() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    pendingRecords_ = 0;
+}
+
+bool Writer::Sync() {
+    if (!file_) {
+        return false;
+    }
+    pendingRecords_ = 0;
+    lastSync_ = std::chrono::steady_clock::now();
+    ++syncs_;
+    return SyncFile(file_);
+}
+
+bool Writer::SyncIfDue() {
+    if (!file_ || pendingRecords_ == 0 ||
+        std::chrono::steady_clock::now() - lastSync_ < std::chrono::milliseconds(policy_.maxDelayMs)) {
+        return true;
+    }
+    return Sync();
+}
+
+bool Writer::Append(RecordType type, const std::vector<uint8_t>& payload) {
+    if (!file_) {
+        return false;
+    }
+    std::vector<uint8_t> record;
+    record.reserve(kRecordHeaderSize + payload.size());
+    const auto typeByte = static_cast<uint8_t>(type);
+    PutU32(record, static_cast<uint32_t>(payload.size()));
+    PutU32(record, digest::Crc32(payload.data(), payload.size(), digest::Crc32(&typeByte, 1)));
+    record.push_back(typeByte);
+    record.insert(record.end(), payload.begin(), payload.end());
+    if (std::fwrite(record.data(), 1, record.size(), file_) != record.size()) {
+        return false;
+    }
+    // Without a sync the record still reaches the OS on fflush, which covers an
+    // app crash; the batched fsync, together with SyncIfDue, bounds what a
+    // power loss can take to about `maxDelayMs` of records.
+    if (std::fflush(file_) != 0) {
+        return false;
+    }
+    ++pendingRecords_;
+    const auto elapsed = std::chrono::steady_clock::now() - lastSync_;
+    if (pendingRecords_ >= policy_.maxRecords || elapsed >= std::chrono::milliseconds(policy_.maxDelayMs)) {
+        return Sync();
+    }
+    return true;
+}
+
+bool ReadJournal(const std::filesystem::path& path, JournalState& state) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0 ||
+        GetU32(bytes.data() + 8) != kVersion) {
+        return false;
+    }
+    state = JournalState{};
+    size_t offset = kHeaderSize;
+    while (bytes.size() - offset >= kRecordHeaderSize) {
+        const uint32_t length = GetU32(bytes.data() + offset);
+        if (length > kMaxPayload || bytes.size() - offset - kRecordHeaderSize < length) {
+            break;
+        }
+        const uint32_t crc = GetU32(bytes.data() + offset + 4);
+        const uint8_t* typeByte = bytes.data() + offset + 8;
+        if (digest::Crc32(typeByte + 1, length, digest::Crc32(typeByte, 1)) != crc ||
+            !ApplyRecord(static_cast<RecordType>(*typeByte), typeByte + 1, length, state)) {
+            break;
+        }
+        offset += kRecordHeaderSize + length;
+    }
+    state.validBytes = offset;
+    std::sort(state.frames.begin(), state.frames.end(), [](const FrameEntry& a, const FrameEntry& b) {
+        return a.index < b.index;
+    });
+    return true;
+}
+
+std::vector<IncompleteSession> FindIncompleteSessions(const std::filesystem::path& root) {
+    std::vector<IncompleteSession> sessions;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        JournalState state;
+        std::error_code entry;
+        if (!it->is_directory(entry) || !ReadJournal(it->path() / kFileName, state)) {
+            continue;
+        }
+        if (!state.complete && !state.frames.empty()) {
+            sessions.push_back({ it->path(), state.frames.size() });
+        }
+    }
+    // Session folders are named by timestamp.
+    std::sort(sessions.begin(), sessions.end(), [](const IncompleteSession& a, const IncompleteSession& b) {
+        return a.root.filename() > b.root.filename();
+    });
+    return sessions;
+}
+
+bool MarkAbandoned(const std::filesystem::path& sessionRoot) {
+    const auto path = sessionRoot / kFileName;
+    JournalState state;
+    Writer writer;
+    return ReadJournal(path, state) && writer.Reopen(path, state) && writer.Finish();
+}
+
+} // namespace journal
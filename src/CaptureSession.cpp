@@ -1,8 +1,12 @@
 #include "CaptureSession.h"
 
+#include "MemoryAccounting.h"
 #include "Utility.h"
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
 #include <memory>
 
 #include <wrl/client.h>
@@ -23,27 +27,21 @@ bool EnsureWicFactory() {
     return true;
 }
 
-bool SaveBitmapToPng(HBITMAP bitmap, const std::wstring& path) {
+bool EncodePixelsToPng(const BYTE* pixels, UINT width, UINT height, UINT stride, ByteBuffer& png) {
     if (!EnsureWicFactory()) {
         return false;
     }
-    BITMAP bmp = {};
-    if (!GetObjectW(bitmap, sizeof(BITMAP), &bmp)) {
-        return false;
-    }
 
+    // The capture DIB's alpha byte is undefined, so encode it as opaque BGR.
     Microsoft::WRL::ComPtr<IWICBitmap> wicBitmap;
-    auto hr = g_wicFactory->CreateBitmapFromHBITMAP(bitmap, nullptr, WICBitmapUsePremultipliedAlpha, &wicBitmap);
+    auto hr = g_wicFactory->CreateBitmapFromMemory(width, height, GUID_WICPixelFormat32bppBGR, stride, stride * height,
+                                                   const_cast<BYTE*>(pixels), &wicBitmap);
     if (FAILED(hr)) {
         return false;
     }
 
-    Microsoft::WRL::ComPtr<IWICStream> stream;
-    hr = g_wicFactory->CreateStream(&stream);
-    if (FAILED(hr)) {
-        return false;
-    }
-    hr = stream->InitializeFromFilename(path.c_str(), GENERIC_WRITE);
+    Microsoft::WRL::ComPtr<IStream> stream;
+    hr = CreateStreamOnHGlobal(nullptr, TRUE, &stream);
     if (FAILED(hr)) {
         return false;
     }
@@ -69,7 +67,7 @@ bool SaveBitmapToPng(HBITMAP bitmap, const std::wstring& path) {
         return false;
     }
 
-    hr = frame->SetSize(static_cast<UINT>(bmp.bmWidth), static_cast<UINT>(bmp.bmHeight));
+    hr = frame->SetSize(width, height);
     if (FAILED(hr)) {
         return false;
     }
@@ -93,12 +91,117 @@ bool SaveBitmapToPng(HBITMAP bitmap, const std::wstring& path) {
     if (FAILED(hr)) {
         return false;
     }
+
+    STATSTG stat = {};
+    hr = stream->Stat(&stat, STATFLAG_NONAME);
+    if (FAILED(hr)) {
+        return false;
+    }
+    png.resize(static_cast<size_t>(stat.cbSize.QuadPart));
+    const LARGE_INTEGER origin = {};
+    hr = stream->Seek(origin, STREAM_SEEK_SET, nullptr);
+    if (FAILED(hr)) {
+        return false;
+    }
+    ULONG read = 0;
+    hr = stream->Read(png.data(), static_cast<ULONG>(png.size()), &read);
+    if (FAILED(hr) || read != png.size()) {
+        png.clear();
+        return false;
+    }
     return true;
 }
 
+// Decodes a PNG back to 32bpp BGRX rows with stride width * 4.
+bool DecodePngToPixels(const ByteBuffer& png, ByteBuffer& pixels, UINT& width, UINT& height) {
+    if (!EnsureWicFactory()) {
+        return false;
+    }
+    Microsoft::WRL::ComPtr<IWICStream> stream;
+    auto hr = g_wicFactory->CreateStream(&stream);
+    if (FAILED(hr)) {
+        return false;
+    }
+    hr = stream->InitializeFromMemory(const_cast<BYTE*>(png.data()), static_cast<DWORD>(png.size()));
+    if (FAILED(hr)) {
+        return false;
+    }
+    Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
+    hr = g_wicFactory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &decoder);
+    if (FAILED(hr)) {
+        return false;
+    }
+    Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
+    hr = decoder->GetFrame(0, &frame);
+    if (FAILED(hr)) {
+        return false;
+    }
+    Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+    hr = g_wicFactory->CreateFormatConverter(&converter);
+    if (FAILED(hr)) {
+        return false;
+    }
+    hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppBGR, WICBitmapDitherTypeNone, nullptr, 0.0,
+                               WICBitmapPaletteTypeCustom);
+    if (FAILED(hr)) {
+        return false;
+    }
+    hr = converter->GetSize(&width, &height);
+    if (FAILED(hr)) {
+        return false;
+    }
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+    hr = converter->CopyPixels(nullptr, width * 4, static_cast<UINT>(pixels.size()), pixels.data());
+    return SUCCEEDED(hr);
+}
+
+// Backs FrameStore's PixelDecoder for frames whose pixels were released.
+std::shared_ptr<const ByteBuffer> DecodeFramePixels(const Frame& frame, const std::shared_ptr<std::pmr::memory_resource>& resource) {
+    auto pixels = MakeSessionBuffer(resource);
+    UINT width = 0;
+    UINT height = 0;
+    if (!frame.png || !DecodePngToPixels(*frame.png, *pixels, width, height) || width != frame.width || height != frame.height) {
+        return nullptr;
+    }
+    return pixels;
+}
+
+// Sized up front so an arena buffer is allocated once rather than grown.
+bool ReadBytesFromFile(const std::wstring& path, ByteBuffer& bytes) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(std::filesystem::path(path), ec);
+    std::ifstream in(std::filesystem::path(path), std::ios::binary);
+    if (ec || !in) {
+        return false;
+    }
+    bytes.resize(static_cast<size_t>(size));
+    in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return in.gcount() == static_cast<std::streamsize>(bytes.size());
+}
+
+bool WriteBytesToFile(const std::filesystem::path& path, const ByteBuffer& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+uint64_t NowUnixMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
 } // namespace
 
-CaptureSession::CaptureSession() = default;
+CaptureSession::CaptureSession()
+    : ledger_(std::make_shared<memory::Ledger>()) {
+    // Dropping frames hands the clipboard a new last frame, which needs pixels for CF_DIB.
+    frames_.SetPixelDecoder([this](const Frame& frame) {
+        return DecodeFramePixels(frame, ledger_->Resource(memory::Tag::Capture));
+    });
+}
 
 bool CaptureSession::Begin(HWND targetWindow, const std::wstring& baseDirectory) {
     if (active_) {
@@ -107,7 +210,10 @@ bool CaptureSession::Begin(HWND targetWindow, const std::wstring& baseDirectory)
     targetWindow_ = targetWindow;
     baseDirectory_ = baseDirectory;
     captureIndex_ = 0;
-    capturedFiles_.clear();
+    endOfList_.Reset();
+    ledger_ = std::make_shared<memory::Ledger>();
+    arena_ = std::make_shared<SessionArena>(SessionArena::kDefaultChunkBytes, ledger_->Resource(memory::Tag::FrameStore));
+    frames_.Reset(arena_);
 
     if (!IsWindow(targetWindow_)) {
         return false;
@@ -123,39 +229,269 @@ bool CaptureSession::Begin(HWND targetWindow, const std::wstring& baseDirectory)
     if (!util::EnsureDirectory(sessionRoot_) || !util::EnsureDirectory(rawDirectory_)) {
         return false;
     }
+    if (!journal_.Create(std::filesystem::path(sessionRoot_) / journal::kFileName)) {
+        return false;
+    }
+    // The manifest is a convenience for tools; a session still works without it.
+    manifest_.Open(std::filesystem::path(util::JoinPath(sessionRoot_, L"session.manifest")));
+
+    active_ = true;
+    return true;
+}
+
+bool CaptureSession::Resume(HWND targetWindow, const std::wstring& sessionRoot) {
+    if (active_ || !IsWindow(targetWindow)) {
+        return false;
+    }
+    const std::filesystem::path root(sessionRoot);
+    const auto journalPath = root / journal::kFileName;
+    journal::JournalState state;
+    if (!journal::ReadJournal(journalPath, state)) {
+        return false;
+    }
+    targetWindow_ = targetWindow;
+    baseDirectory_ = root.parent_path().wstring();
+    sessionRoot_ = sessionRoot;
+    rawDirectory_ = util::JoinPath(sessionRoot_, L"raw");
+    captureIndex_ = 0;
+    endOfList_.Reset();
+    ledger_ = std::make_shared<memory::Ledger>();
+    arena_ = std::make_shared<SessionArena>(SessionArena::kDefaultChunkBytes, ledger_->Resource(memory::Tag::FrameStore));
+    frames_.Reset(arena_);
+
+    // The manifest knows which frames hold object store references.
+    std::vector<manifest::FrameRecord> records;
+    manifest::ReadManifest(root / L"session.manifest", records);
+    const auto described = manifest::LiveFrames(records);
+    const auto isShared = [&](uint32_t index) {
+        return std::any_of(described.begin(), described.end(), [&](const manifest::FrameRecord& record) {
+            return record.index == index && record.shared;
+        });
+    };
+
+    // Drops only ever remove the newest frame, so live frames are numbered
+    // 1..N; the first gap or torn PNG ends what can be resumed.
+    for (const auto& entry : state.frames) {
+        const auto path = util::JoinPath(rawDirectory_, util::Utf8ToWide(entry.file));
+        auto png = frames_.NewBuffer();
+        if (entry.index != captureIndex_ + 1 || !ReadBytesFromFile(path, *png) || png->size() != entry.pngBytes ||
+            digest::Crc32(png->data(), png->size()) != entry.pngCrc) {
+            break;
+        }
+        Frame frame = frames_.NewFrame();
+        frame.index = entry.index;
+        frame.path.assign(path);
+        frame.width = entry.width;
+        frame.height = entry.height;
+        frame.sha256 = digest::ComputeSha256(png->data(), png->size());
+        frame.shared = isShared(entry.index);
+        frame.png = std::move(png);
+        frames_.Add(std::move(frame));
+        ++captureIndex_;
+    }
+
+    if (!journal_.Reopen(journalPath, state)) {
+        return false;
+    }
+    manifest_.Open(root / L"session.manifest", true);
+    if (objectStore_) {
+        for (const auto& record : described) {
+            if (record.index > captureIndex_ && record.shared) {
+                objectStore_->Release(record.sha256);
+            }
+        }
+    }
+    for (const auto& entry : state.frames) {
+        if (entry.index > captureIndex_) {
+            journal_.AppendDrop(entry.index);
+            manifest::FrameRecord drop;
+            drop.kind = manifest::RecordKind::Drop;
+            drop.index = entry.index;
+            manifest_.Append(drop);
+        }
+    }
+
+    // Row signatures of the last frame let the first new capture measure its
+    // scroll against what was captured before the interruption.
+    if (!frames_.Empty()) {
+        const Frame& last = frames_.Last();
+        if (auto pixels = DecodeFramePixels(last, ledger_->Resource(memory::Tag::Capture))) {
+            Frame restored = frames_.NewFrame();
+            restored = last;
+            restored.stride = restored.width * 4;
+            motion::ComputeRowSignatures(pixels->data(), restored.width, restored.height, restored.stride, restored.signatures);
+            restored.pixels = std::move(pixels);
+            frames_.ReplaceLast(std::move(restored));
+        }
+    }
 
     active_ = true;
     return true;
 }
 
-std::wstring CaptureSession::CaptureNext() {
+std::wstring CaptureSession::CaptureNext(bool afterScroll) {
     if (!active_ || !IsWindow(targetWindow_)) {
         return std::wstring();
     }
 
-    const auto fileName = NextCaptureFilename();
-    const auto fullPath = util::JoinPath(rawDirectory_, fileName);
-    if (!CaptureWindowToFile(targetWindow_, fullPath)) {
+    wchar_t fileName[32] = {};
+    swprintf_s(fileName, L"shot_%04zu.png", captureIndex_ + 1);
+    Frame frame = frames_.NewFrame();
+    if (!CaptureWindow(targetWindow_, frame)) {
+        return std::wstring();
+    }
+    // Built in the frame's own string, so the path comes from the session arena.
+    frame.path.assign(rawDirectory_).append(L"\\").append(fileName);
+    // A frame already in the shared store costs a hard link instead of a write.
+    frame.shared = objectStore_ && objectStore_->Put(frame.sha256, frame.png->data(), frame.png->size(), std::filesystem::path(frame.path));
+    if (!frame.shared && !WriteBytesToFile(std::filesystem::path(frame.path), *frame.png)) {
         return std::wstring();
     }
-    capturedFiles_.push_back(fullPath);
+    frame.index = captureIndex_ + 1;
+    motion::ComputeRowSignatures(frame.pixels->data(), frame.width, frame.height, frame.stride, frame.signatures);
+    if (!frames_.Empty()) {
+        const auto& previous = frames_.Last();
+        if (previous.width == frame.width && previous.height == frame.height) {
+            frame.shift = motion::EstimateShift(previous.signatures, frame.signatures);
+        }
+    }
+    if (afterScroll) {
+        endOfList_.Observe(frame.shift);
+    }
+    // The PNG is on disk, so the frame can be committed to the journal.
+    journal::FrameEntry entry;
+    entry.index = static_cast<uint32_t>(frame.index);
+    entry.width = frame.width;
+    entry.height = frame.height;
+    entry.pngBytes = static_cast<uint32_t>(frame.png->size());
+    entry.pngCrc = digest::Crc32(frame.png->data(), frame.png->size());
+    entry.file = util::WideToUtf8(fileName);
+    journal_.AppendFrame(entry);
+    AppendManifest(frame);
     ++captureIndex_;
-    return fullPath;
+    return std::wstring(frames_.Add(std::move(frame)).path);
 }
 
 std::vector<std::wstring> CaptureSession::End() {
     active_ = false;
+    manifest_.Close();
+    journal_.Finish();
     targetWindow_ = nullptr;
-    return capturedFiles_;
+    // Frame buffers hold the arena too; it is freed in one go with the last of them.
+    arena_.reset();
+    std::vector<std::wstring> files;
+    files.reserve(frames_.Size());
+    for (const auto& frame : frames_.Frames()) {
+        files.emplace_back(frame.path);
+    }
+    return files;
+}
+
+bool CaptureSession::DropLast() {
+    // The user is re-shooting, so any run of still frames starts over.
+    endOfList_.Reset();
+    return RemoveLast();
 }
 
-std::wstring CaptureSession::NextCaptureFilename() const {
-    wchar_t buffer[32] = {};
-    swprintf_s(buffer, L"shot_%04zu.png", captureIndex_ + 1);
-    return buffer;
+size_t CaptureSession::DropTrailingDuplicates(size_t atLeast) {
+    const size_t duplicates = (std::max)(static_cast<size_t>(endOfList_.TakeTrailingDuplicates()), atLeast);
+    size_t dropped = 0;
+    while (dropped < duplicates && RemoveLast(false)) {
+        ++dropped;
+    }
+    // Decoded once for the frame that is left last, not for every one dropped.
+    if (dropped > 0) {
+        frames_.RestoreLastPixels();
+    }
+    return dropped;
 }
 
-bool CaptureSession::CaptureWindowToFile(HWND hwnd, const std::wstring& filePath) {
+bool CaptureSession::RemoveLast(bool restorePixels) {
+    if (!active_ || frames_.Empty()) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::path(frames_.Last().path), ec);
+    manifest::FrameRecord drop;
+    drop.kind = manifest::RecordKind::Drop;
+    drop.index = static_cast<uint32_t>(frames_.Last().index);
+    manifest_.Append(drop);
+    journal_.AppendDrop(drop.index);
+    if (frames_.Last().shared && objectStore_) {
+        objectStore_->Release(frames_.Last().sha256);
+    }
+    frames_.DropLast(restorePixels);
+    --captureIndex_;
+    return true;
+}
+
+void CaptureSession::Cancel() {
+    const bool hadSession = active_;
+    End();
+    if (hadSession && objectStore_) {
+        for (const auto& frame : frames_.Frames()) {
+            if (frame.shared) {
+                objectStore_->Release(frame.sha256);
+            }
+        }
+    }
+    frames_.Clear();
+    captureIndex_ = 0;
+    if (hadSession && !sessionRoot_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove_all(std::filesystem::path(sessionRoot_), ec);
+    }
+}
+
+void CaptureSession::AppendManifest(const Frame& frame) {
+    manifest::FrameRecord record;
+    record.index = static_cast<uint32_t>(frame.index);
+    record.capturedAtMs = frame.capturedAtMs;
+    record.width = frame.width;
+    record.height = frame.height;
+    record.roiLeft = frame.left;
+    record.roiTop = frame.top;
+    if (frame.shift) {
+        record.shiftValid = frame.shift->valid;
+        record.shiftRows = frame.shift->shift;
+        record.matchRatio = static_cast<float>(frame.shift->matchRatio);
+    }
+    record.pngBytes = frame.png ? frame.png->size() : 0;
+    record.encodeMicros = frame.encodeMicros;
+    record.sha256 = frame.sha256;
+    record.shared = frame.shared;
+    manifest_.Append(record);
+}
+
+bool CaptureSession::Probe(std::vector<motion::RowSignature>& signatures) {
+    if (!active_ || !IsWindow(targetWindow_)) {
+        return false;
+    }
+    Frame frame;
+    if (!GrabWindow(targetWindow_, frame)) {
+        return false;
+    }
+    signatures = motion::ComputeRowSignatures(frame.pixels->data(), frame.width, frame.height, frame.stride);
+    return true;
+}
+
+bool CaptureSession::CaptureWindow(HWND hwnd, Frame& frame) {
+    if (!GrabWindow(hwnd, frame)) {
+        return false;
+    }
+    auto png = frames_.NewBuffer();
+    const auto encodeStart = std::chrono::steady_clock::now();
+    if (!EncodePixelsToPng(frame.pixels->data(), frame.width, frame.height, frame.stride, *png)) {
+        return false;
+    }
+    frame.encodeMicros = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - encodeStart).count());
+    frame.sha256 = digest::ComputeSha256(png->data(), png->size());
+    frame.png = std::move(png);
+    return true;
+}
+
+bool CaptureSession::GrabWindow(HWND hwnd, Frame& frame) {
     RECT rect = {};
     if (!GetWindowRect(hwnd, &rect)) {
         return false;
@@ -165,10 +501,30 @@ bool CaptureSession::CaptureWindowToFile(HWND hwnd, const std::wstring& filePath
     if (width <= 0 || height <= 0) {
         return false;
     }
+    frame.left = rect.left;
+    frame.top = rect.top;
+    frame.capturedAtMs = NowUnixMs();
+
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
 
     HDC hdcScreen = GetDC(nullptr);
     HDC hdcMem = CreateCompatibleDC(hdcScreen);
-    HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, width, height);
+    void* bits = nullptr;
+    HBITMAP hBitmap = CreateDIBSection(hdcScreen, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!hBitmap || !bits) {
+        if (hBitmap) {
+            DeleteObject(hBitmap);
+        }
+        DeleteDC(hdcMem);
+        ReleaseDC(nullptr, hdcScreen);
+        return false;
+    }
     HGDIOBJ oldObj = SelectObject(hdcMem, hBitmap);
 
     BOOL printed = PrintWindow(hwnd, hdcMem, PW_RENDERFULLCONTENT);
@@ -179,12 +535,20 @@ bool CaptureSession::CaptureWindowToFile(HWND hwnd, const std::wstring& filePath
     }
 
     SelectObject(hdcMem, oldObj);
+    GdiFlush();
 
-    bool saved = SaveBitmapToPng(hBitmap, filePath);
+    const UINT stride = static_cast<UINT>(width) * 4;
+    const auto* pixelBytes = static_cast<const BYTE*>(bits);
+    frame.width = static_cast<uint32_t>(width);
+    frame.height = static_cast<uint32_t>(height);
+    frame.stride = stride;
+    auto pixels = MakeSessionBuffer(ledger_->Resource(memory::Tag::Capture));
+    pixels->assign(pixelBytes, pixelBytes + static_cast<size_t>(stride) * height);
+    frame.pixels = std::move(pixels);
 
     DeleteObject(hBitmap);
     DeleteDC(hdcMem);
     ReleaseDC(nullptr, hdcScreen);
 
-    return saved;
+    return true;
 }
@@ -0,0 +1,134 @@
+#include "ChordMatcher.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace {
+
+uint32_t ActionBit(hotkey::Action action) {
+    return 1u << static_cast<uint32_t>(action);
+}
+
+} // namespace
+
+namespace hotkey {
+
+size_t KeySet::Count() const {
+    size_t count = 0;
+    for (auto word : words_) {
+        count += std::bitset<64>(word).count();
+    }
+    return count;
+}
+
+bool IsModifierKey(uint32_t key) {
+    switch (key) {
+        case kKeyShift:
+        case kKeyLeftShift:
+        case kKeyRightShift:
+        case kKeyControl:
+        case kKeyLeftControl:
+        case kKeyRightControl:
+        case kKeyMenu:
+        case kKeyLeftMenu:
+        case kKeyRightMenu:
+        case kKeyLeftWin:
+        case kKeyRightWin:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void ChordMatcher::Bind(Action action, const KeySet& keys) {
+    const auto slot = static_cast<size_t>(action);
+    if (slot >= kMaxBindings) {
+        return;
+    }
+    chords_[slot] = keys;
+    latched_ &= ~ActionBit(action);
+    Rebuild();
+}
+
+void ChordMatcher::ClearBindings() {
+    chords_ = {};
+    latched_ = 0;
+    Rebuild();
+}
+
+void ChordMatcher::ResetState() {
+    held_.Clear();
+    latched_ = 0;
+}
+
+std::optional<Action> ChordMatcher::KeyDown(uint32_t key) {
+    if (key > 0xFF) {
+        return std::nullopt;
+    }
+    held_.Set(static_cast<uint8_t>(key));
+    UpdateGenericKeys();
+
+    std::optional<Action> fired;
+    for (size_t i = 0; i < tableSize_; ++i) {
+        const auto& binding = table_[i];
+        if (!held_.Contains(binding.keys)) {
+            continue;
+        }
+        const uint32_t bit = ActionBit(binding.action);
+        // A more specific chord that already fired keeps its subsets quiet too.
+        if (!fired && (latched_ & bit) == 0) {
+            fired = binding.action;
+        }
+        latched_ |= bit;
+    }
+    return fired;
+}
+
+void ChordMatcher::KeyUp(uint32_t key) {
+    if (key > 0xFF) {
+        return;
+    }
+    const auto code = static_cast<uint8_t>(key);
+    const bool modifier = IsModifierKey(key);
+    held_.Reset(code);
+    UpdateGenericKeys();
+
+    for (size_t i = 0; i < tableSize_; ++i) {
+        const auto& binding = table_[i];
+        if (modifier || binding.keys.Test(code)) {
+            latched_ &= ~ActionBit(binding.action);
+        }
+    }
+}
+
+void ChordMatcher::UpdateGenericKeys() {
+    const auto mirror = [this](uint8_t generic, uint8_t left, uint8_t right) {
+        if (held_.Test(left) || held_.Test(right)) {
+            held_.Set(generic);
+        } else {
+            held_.Reset(generic);
+        }
+    };
+    mirror(kKeyShift, kKeyLeftShift, kKeyRightShift);
+    mirror(kKeyControl, kKeyLeftControl, kKeyRightControl);
+    mirror(kKeyMenu, kKeyLeftMenu, kKeyRightMenu);
+    mirror(kKeyAnyWin, kKeyLeftWin, kKeyRightWin);
+}
+
+void ChordMatcher::Rebuild() {
+    tableSize_ = 0;
+    for (size_t slot = 0; slot < kMaxBindings; ++slot) {
+        if (chords_[slot].Empty()) {
+            continue;
+        }
+        auto& binding = table_[tableSize_++];
+        binding.keys = chords_[slot];
+        binding.weight = chords_[slot].Count();
+        binding.action = static_cast<Action>(slot);
+    }
+    std::stable_sort(table_.begin(), table_.begin() + tableSize_, [](const Binding& a, const Binding& b) {
+        return a.weight > b.weight;
+    });
+}
+
+} // namespace hotkey
@@ -0,0 +1,145 @@
+#include "ClipboardData.h"
+
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+constexpr size_t kBitmapInfoHeaderSize = 40;
+constexpr uint32_t kBiRgb = 0;
+constexpr size_t kDropFilesSize = 20;
+
+void PutU16(uint8_t*& dst, uint16_t value) {
+    dst[0] = static_cast<uint8_t>(value);
+    dst[1] = static_cast<uint8_t>(value >> 8);
+    dst += 2;
+}
+
+void PutU32(uint8_t*& dst, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        dst[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+    dst += 4;
+}
+
+size_t ImageBytes(const Frame& frame) {
+    return static_cast<size_t>(frame.width) * 4 * frame.height;
+}
+
+// Number of UTF-16 units needed for a wide path (wchar_t is UTF-32 off Windows).
+size_t Utf16Length(std::wstring_view path) {
+    size_t length = 0;
+    for (wchar_t ch : path) {
+        length += static_cast<uint32_t>(ch) > 0xFFFF ? 2 : 1;
+    }
+    return length;
+}
+
+void PutUtf16(uint8_t*& dst, std::wstring_view path) {
+    for (wchar_t ch : path) {
+        const auto codePoint = static_cast<uint32_t>(ch);
+        if (codePoint > 0xFFFF) {
+            PutU16(dst, static_cast<uint16_t>(0xD800 + ((codePoint - 0x10000) >> 10)));
+            PutU16(dst, static_cast<uint16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+        } else {
+            PutU16(dst, static_cast<uint16_t>(codePoint));
+        }
+    }
+}
+
+bool HasPixels(const Frame& frame) {
+    return frame.pixels && frame.width > 0 && frame.height > 0 && frame.stride >= frame.width * 4 &&
+           frame.pixels->size() >= static_cast<size_t>(frame.stride) * frame.height;
+}
+
+} // namespace
+
+namespace clipboard {
+
+size_t DibPacketSize(const Frame& frame) {
+    if (!HasPixels(frame)) {
+        return 0;
+    }
+    return kBitmapInfoHeaderSize + ImageBytes(frame);
+}
+
+bool WriteDibPacket(const Frame& frame, uint8_t* dst, size_t size) {
+    if (!dst || size < DibPacketSize(frame) || !HasPixels(frame)) {
+        return false;
+    }
+
+    const uint32_t rowBytes = frame.width * 4;
+    PutU32(dst, static_cast<uint32_t>(kBitmapInfoHeaderSize));
+    PutU32(dst, frame.width);
+    PutU32(dst, static_cast<uint32_t>(-static_cast<int32_t>(frame.height)));
+    PutU16(dst, 1);
+    PutU16(dst, 32);
+    PutU32(dst, kBiRgb);
+    PutU32(dst, static_cast<uint32_t>(ImageBytes(frame)));
+    PutU32(dst, 0);
+    PutU32(dst, 0);
+    PutU32(dst, 0);
+    PutU32(dst, 0);
+
+    const uint8_t* src = frame.pixels->data();
+    if (frame.stride == rowBytes) {
+        std::memcpy(dst, src, ImageBytes(frame));
+        return true;
+    }
+    for (uint32_t y = 0; y < frame.height; ++y) {
+        std::memcpy(dst, src, rowBytes);
+        dst += rowBytes;
+        src += frame.stride;
+    }
+    return true;
+}
+
+size_t PngPacketSize(const Frame& frame) {
+    return frame.png ? frame.png->size() : 0;
+}
+
+bool WritePngPacket(const Frame& frame, uint8_t* dst, size_t size) {
+    const size_t required = PngPacketSize(frame);
+    if (!dst || required == 0 || size < required) {
+        return false;
+    }
+    std::memcpy(dst, frame.png->data(), required);
+    return true;
+}
+
+size_t FileListPacketSize(const std::vector<Frame>& frames) {
+    size_t units = 0;
+    for (const auto& frame : frames) {
+        if (!frame.path.empty()) {
+            units += Utf16Length(frame.path) + 1;
+        }
+    }
+    if (units == 0) {
+        return 0;
+    }
+    return kDropFilesSize + (units + 1) * sizeof(uint16_t);
+}
+
+bool WriteFileListPacket(const std::vector<Frame>& frames, uint8_t* dst, size_t size) {
+    const size_t required = FileListPacketSize(frames);
+    if (!dst || required == 0 || size < required) {
+        return false;
+    }
+
+    PutU32(dst, static_cast<uint32_t>(kDropFilesSize));
+    PutU32(dst, 0);
+    PutU32(dst, 0);
+    PutU32(dst, 0);
+    PutU32(dst, 1);
+    for (const auto& frame : frames) {
+        if (frame.path.empty()) {
+            continue;
+        }
+        PutUtf16(dst, frame.path);
+        PutU16(dst, 0);
+    }
+    PutU16(dst, 0);
+    return true;
+}
+
+} // namespace clipboard
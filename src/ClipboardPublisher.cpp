@@ -0,0 +1,107 @@
+#include "ClipboardPublisher.h"
+
+#include <algorithm>
+
+#include "ClipboardData.h"
+
+bool ClipboardPublisher::Publish(ClipboardBackend& backend, const std::vector<Frame>& frames, bool includeFileList) {
+    if (frames.empty()) {
+        return false;
+    }
+    std::vector<ClipboardFormat> formats;
+    if (includeFileList && clipboard::FileListPacketSize(frames) > 0) {
+        formats.push_back(ClipboardFormat::FileList);
+    }
+    if (clipboard::DibPacketSize(frames.back()) > 0) {
+        formats.push_back(ClipboardFormat::Dib);
+    }
+    if (clipboard::PngPacketSize(frames.back()) > 0) {
+        formats.push_back(ClipboardFormat::Png);
+    }
+    if (formats.empty() || !backend.Open()) {
+        return false;
+    }
+    if (!backend.Empty()) {
+        backend.Close();
+        return false;
+    }
+
+    // EmptyClipboard sends WM_DESTROYCLIPBOARD for any previous publish, so the
+    // new frames are only recorded afterwards.
+    if (includeFileList) {
+        frames_ = frames;
+    } else {
+        frames_.assign(1, frames.back());
+    }
+    offered_.clear();
+    rendered_.clear();
+    charge_.Reset();
+    for (auto format : formats) {
+        if (backend.Offer(format)) {
+            offered_.push_back(format);
+        }
+    }
+    backend.Close();
+
+    if (offered_.empty()) {
+        Release();
+        return false;
+    }
+    return true;
+}
+
+bool ClipboardPublisher::Render(ClipboardBackend& backend, ClipboardFormat format) {
+    if (frames_.empty() || std::find(offered_.begin(), offered_.end(), format) == offered_.end()) {
+        return false;
+    }
+    const Frame& frame = frames_.back();
+    size_t packetSize = 0;
+    bool provided = false;
+    switch (format) {
+        case ClipboardFormat::Dib:
+            packetSize = clipboard::DibPacketSize(frame);
+            provided = backend.Provide(format, packetSize, [&frame](uint8_t* data, size_t size) {
+                return clipboard::WriteDibPacket(frame, data, size);
+            });
+            break;
+        case ClipboardFormat::Png:
+            packetSize = clipboard::PngPacketSize(frame);
+            provided = backend.Provide(format, packetSize, [&frame](uint8_t* data, size_t size) {
+                return clipboard::WritePngPacket(frame, data, size);
+            });
+            break;
+        case ClipboardFormat::FileList:
+            packetSize = clipboard::FileListPacketSize(frames_);
+            provided = backend.Provide(format, packetSize, [this](uint8_t* data, size_t size) {
+                return clipboard::WriteFileListPacket(frames_, data, size);
+            });
+            break;
+    }
+    if (provided && std::find(rendered_.begin(), rendered_.end(), format) == rendered_.end()) {
+        rendered_.push_back(format);
+        charge_.Add(packetSize);
+    }
+    return provided;
+}
+
+bool ClipboardPublisher::RenderAll(ClipboardBackend& backend) {
+    if (frames_.empty() || !backend.Open()) {
+        return false;
+    }
+    bool anySuccess = false;
+    if (backend.IsOwner()) {
+        const auto formats = offered_;
+        for (auto format : formats) {
+            anySuccess = Render(backend, format) || anySuccess;
+        }
+    }
+    backend.Close();
+    return anySuccess;
+}
+
+void ClipboardPublisher::Release() {
+    frames_.clear();
+    offered_.clear();
+    rendered_.clear();
+    charge_.Reset();
+}
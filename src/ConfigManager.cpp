@@ -1,10 +1,14 @@
 #include "ConfigManager.h"
 
+#include "SessionRetention.h"
 #include "Utility.h"
 
+#include <algorithm>
 #include <array>
+#include <filesystem>
 #include <sstream>
 #include <cwctype>
+#include <vector>
 #include <windows.h>
 
 namespace {
@@ -54,27 +58,36 @@ constexpr std::array<KeyName, 37> kNamedKeys = { {
     {L"VK_RSHIFT", VK_RSHIFT}
 } };
 
-UINT VkFromString(const std::wstring& token) {
+bool TryVkFromString(const std::wstring& token, UINT& vk) {
     auto lower = util::ToLower(token);
     for (const auto& item : kNamedKeys) {
         if (lower == util::ToLower(item.name)) {
-            return item.vk;
+            vk = item.vk;
+            return true;
         }
     }
     if (token.size() == 1) {
         wchar_t ch = towupper(token[0]);
         SHORT scan = VkKeyScanW(ch);
         if (scan != -1) {
-            return static_cast<UINT>(scan & 0xFF);
+            vk = static_cast<UINT>(scan & 0xFF);
+            return true;
         }
     }
-    if (token.size() >= 2 && (token[0] == L'F' || token[0] == L'f')) {
+    if (token.size() >= 2 && token.size() <= 3 && (token[0] == L'F' || token[0] == L'f') &&
+        std::all_of(token.begin() + 1, token.end(), [](wchar_t ch) { return iswdigit(ch) != 0; })) {
         int fnIndex = std::stoi(token.substr(1));
         if (fnIndex >= 1 && fnIndex <= 24) {
-            return VK_F1 + fnIndex - 1;
+            vk = VK_F1 + fnIndex - 1;
+            return true;
         }
     }
-    return VK_RSHIFT;
+    return false;
+}
+
+UINT VkFromString(const std::wstring& token) {
+    UINT vk = 0;
+    return TryVkFromString(token, vk) ? vk : VK_RSHIFT;
 }
 
 std::wstring StringFromVk(UINT vk) {
@@ -119,8 +132,134 @@ std::wstring ShiftModeToString(HotkeyConfig::ShiftMode mode) {
     }
 }
 
+// Parses "Win+Ctrl+Alt+Shift+F9" style chords; LShift / RShift pin the Shift side.
+// The last token is the primary key. Anything unparsable disables the binding.
+HotkeyConfig ChordFromString(const std::wstring& value) {
+    HotkeyConfig chord{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+    std::vector<std::wstring> tokens;
+    std::wstringstream ss(value);
+    std::wstring token;
+    while (std::getline(ss, token, L'+')) {
+        const auto first = token.find_first_not_of(L" \t");
+        const auto last = token.find_last_not_of(L" \t");
+        if (first != std::wstring::npos) {
+            tokens.push_back(token.substr(first, last - first + 1));
+        }
+    }
+    if (tokens.empty()) {
+        return chord;
+    }
+
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+        const auto lower = util::ToLower(tokens[i]);
+        if (lower == L"win") {
+            chord.requireWin = true;
+        } else if (lower == L"ctrl") {
+            chord.requireCtrl = true;
+        } else if (lower == L"alt") {
+            chord.requireAlt = true;
+        } else if (lower == L"shift") {
+            chord.requireShift = true;
+        } else if (lower == L"lshift") {
+            chord.shiftMode = HotkeyConfig::ShiftMode::LeftOnly;
+        } else if (lower == L"rshift") {
+            chord.shiftMode = HotkeyConfig::ShiftMode::RightOnly;
+        } else {
+            return HotkeyConfig{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+        }
+    }
+    UINT vk = 0;
+    if (TryVkFromString(tokens.back(), vk)) {
+        chord.primaryKey = vk;
+    } else {
+        chord = HotkeyConfig{ 0, false, false, false, false, HotkeyConfig::ShiftMode::Any };
+    }
+    return chord;
+}
+
+std::wstring ChordToString(const HotkeyConfig& chord) {
+    if (chord.primaryKey == 0) {
+        return L"";
+    }
+    std::wstring result;
+    if (chord.requireWin) {
+        result += L"Win+";
+    }
+    if (chord.requireCtrl) {
+        result += L"Ctrl+";
+    }
+    if (chord.requireAlt) {
+        result += L"Alt+";
+    }
+    if (chord.shiftMode == HotkeyConfig::ShiftMode::LeftOnly) {
+        result += L"LShift+";
+    } else if (chord.shiftMode == HotkeyConfig::ShiftMode::RightOnly) {
+        result += L"RShift+";
+    } else if (chord.requireShift) {
+        result += L"Shift+";
+    }
+    result += StringFromVk(chord.primaryKey);
+    return result;
+}
+
+AppConfig::ClipboardMode ClipboardModeFromString(const std::wstring& value) {
+    if (util::ToLower(value) == L"allframes") {
+        return AppConfig::ClipboardMode::AllFrames;
+    }
+    return AppConfig::ClipboardMode::LastFrame;
+}
+
+std::wstring ClipboardModeToString(AppConfig::ClipboardMode mode) {
+    return mode == AppConfig::ClipboardMode::AllFrames ? L"AllFrames" : L"LastFrame";
+}
+
+bool SameChord(const HotkeyConfig& a, const HotkeyConfig& b) {
+    return a.primaryKey == b.primaryKey && a.requireWin == b.requireWin && a.requireCtrl == b.requireCtrl &&
+           a.requireAlt == b.requireAlt && a.requireShift == b.requireShift && a.shiftMode == b.shiftMode;
+}
+
+// For config.ini files saved by Notepad's "ANSI" mode or other legacy editors.
+std::string AnsiToUtf8(const std::string& text) {
+    const int length = MultiByteToWideChar(CP_ACP, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    if (length <= 0) {
+        return std::string();
+    }
+    std::wstring wide(static_cast<size_t>(length), L'\0');
+    MultiByteToWideChar(CP_ACP, 0, text.data(), static_cast<int>(text.size()), wide.data(), length);
+    return util::WideToUtf8(wide);
+}
+
 } // namespace
 
+ConfigDiff DiffConfig(const AppConfig& before, const AppConfig& after) {
+    ConfigDiff diff;
+    diff.hotkey = !SameChord(before.hotkey, after.hotkey);
+    diff.bindings = !SameChord(before.bindings.captureNow, after.bindings.captureNow) ||
+                    !SameChord(before.bindings.cancelSession, after.bindings.cancelSession) ||
+                    !SameChord(before.bindings.dropLastFrame, after.bindings.dropLastFrame) ||
+                    !SameChord(before.bindings.republish, after.bindings.republish);
+    diff.paths = before.paths.outputDirectory != after.paths.outputDirectory ||
+                 before.paths.sessionDirectory != after.paths.sessionDirectory;
+    diff.objectDirectory = before.paths.objectDirectory != after.paths.objectDirectory;
+    diff.scrollsPerCapture = before.scrollsPerCapture != after.scrollsPerCapture;
+    diff.scrollPacing = before.scrollPacing != after.scrollPacing || before.maxPendingCaptures != after.maxPendingCaptures;
+    diff.publishing = before.maxPublishedSets != after.maxPublishedSets ||
+                      before.memoryBudgetMegabytes != after.memoryBudgetMegabytes;
+    diff.recordInput = before.recordInput != after.recordInput;
+    diff.retention = before.paths.maxSessionBytes != after.paths.maxSessionBytes ||
+                     before.paths.maxSessionAgeSeconds != after.paths.maxSessionAgeSeconds ||
+                     before.paths.keepLastN != after.paths.keepLastN;
+    diff.deferred = before.adaptiveCadence != after.adaptiveCadence ||
+                    before.targetOverlapPercent != after.targetOverlapPercent ||
+                    before.autoScroll != after.autoScroll ||
+                    before.endOfListFrames != after.endOfListFrames ||
+                    before.endOfListTolerance != after.endOfListTolerance ||
+                    before.maxInFlightSessions != after.maxInFlightSessions ||
+                    before.dedupeFrames != after.dedupeFrames ||
+                    before.clipboardMode != after.clipboardMode;
+    return diff;
+}
+
 ConfigManager::ConfigManager(const std::wstring& baseDirectory)
     : baseDirectory_(baseDirectory) {
     configPath_ = util::JoinPath(baseDirectory_, L"config.ini");
@@ -129,74 +268,115 @@ ConfigManager::ConfigManager(const std::wstring& baseDirectory)
 bool ConfigManager::Load(AppConfig& outConfig) {
     // Use defaults
     AppConfig config = outConfig;
+    document_.Load(std::filesystem::path(configPath_), AnsiToUtf8);
 
-    wchar_t buffer[128] = {};
-    GetPrivateProfileStringW(L"hotkey", L"primaryKey", StringFromVk(config.hotkey.primaryKey).c_str(), buffer, 128, configPath_.c_str());
-    config.hotkey.primaryKey = VkFromString(buffer);
+    const auto getString = [&](const char* section, const char* key, const std::wstring& fallback) {
+        const auto value = document_.Get(section, key);
+        return value ? util::Utf8ToWide(*value) : fallback;
+    };
+    const auto getUint = [&](const char* section, const char* key, UINT fallback, long long minimum, long long maximum) {
+        const auto value = document_.GetInt(section, key, fallback);
+        return static_cast<UINT>(std::clamp(value, minimum, maximum));
+    };
 
-    const auto requireWin = GetPrivateProfileIntW(L"hotkey", L"requireWin", config.hotkey.requireWin ? 1 : 0, configPath_.c_str());
-    const auto requireCtrl = GetPrivateProfileIntW(L"hotkey", L"requireCtrl", config.hotkey.requireCtrl ? 1 : 0, configPath_.c_str());
-    const auto requireAlt = GetPrivateProfileIntW(L"hotkey", L"requireAlt", config.hotkey.requireAlt ? 1 : 0, configPath_.c_str());
-    const auto requireShift = GetPrivateProfileIntW(L"hotkey", L"requireShift", config.hotkey.requireShift ? 1 : 0, configPath_.c_str());
-    GetPrivateProfileStringW(L"hotkey", L"shiftMode", ShiftModeToString(config.hotkey.shiftMode).c_str(), buffer, 128, configPath_.c_str());
+    config.hotkey.primaryKey = VkFromString(getString("hotkey", "primaryKey", StringFromVk(config.hotkey.primaryKey)));
+    config.hotkey.requireWin = document_.GetBool("hotkey", "requireWin", config.hotkey.requireWin);
+    config.hotkey.requireCtrl = document_.GetBool("hotkey", "requireCtrl", config.hotkey.requireCtrl);
+    config.hotkey.requireAlt = document_.GetBool("hotkey", "requireAlt", config.hotkey.requireAlt);
+    config.hotkey.requireShift = document_.GetBool("hotkey", "requireShift", config.hotkey.requireShift);
+    config.hotkey.shiftMode = ShiftModeFromString(getString("hotkey", "shiftMode", ShiftModeToString(config.hotkey.shiftMode)));
 
-    config.hotkey.requireWin = (requireWin != 0);
-    config.hotkey.requireCtrl = (requireCtrl != 0);
-    config.hotkey.requireAlt = (requireAlt != 0);
-    config.hotkey.requireShift = (requireShift != 0);
-    config.hotkey.shiftMode = ShiftModeFromString(buffer);
-
-    GetPrivateProfileStringW(L"paths", L"outputDirectory", config.paths.outputDirectory.c_str(), buffer, 128, configPath_.c_str());
-    if (buffer[0] != L'\0') {
-        config.paths.outputDirectory = buffer;
+    const auto outputDirectory = getString("paths", "outputDirectory", config.paths.outputDirectory);
+    if (!outputDirectory.empty()) {
+        config.paths.outputDirectory = outputDirectory;
     }
-    GetPrivateProfileStringW(L"paths", L"sessionDirectory", config.paths.sessionDirectory.c_str(), buffer, 128, configPath_.c_str());
-    if (buffer[0] != L'\0') {
-        config.paths.sessionDirectory = buffer;
+    const auto sessionDirectory = getString("paths", "sessionDirectory", config.paths.sessionDirectory);
+    if (!sessionDirectory.empty()) {
+        config.paths.sessionDirectory = sessionDirectory;
     }
-
-    int scrollsPerCapture = GetPrivateProfileIntW(L"capture", L"scrollsPerCapture", static_cast<int>(config.scrollsPerCapture), configPath_.c_str());
-    if (scrollsPerCapture <= 0) {
-        scrollsPerCapture = 1;
+    const auto objectDirectory = getString("paths", "objectDirectory", config.paths.objectDirectory);
+    if (!objectDirectory.empty()) {
+        config.paths.objectDirectory = objectDirectory;
+    }
+    if (const auto value = document_.Get("paths", "maxSessionBytes")) {
+        retention::ParseByteSize(*value, config.paths.maxSessionBytes);
     }
-    config.scrollsPerCapture = static_cast<UINT>(scrollsPerCapture);
+    if (const auto value = document_.Get("paths", "maxSessionAge")) {
+        retention::ParseDuration(*value, config.paths.maxSessionAgeSeconds);
+    }
+
+    constexpr long long kMaxUint = 0x7FFFFFFF;
+    config.paths.keepLastN = getUint("paths", "keepLastN", config.paths.keepLastN, 0, kMaxUint);
+    config.scrollsPerCapture = getUint("capture", "scrollsPerCapture", config.scrollsPerCapture, 1, kMaxUint);
+    config.adaptiveCadence = document_.GetBool("capture", "adaptiveCadence", config.adaptiveCadence);
+    config.targetOverlapPercent = getUint("capture", "targetOverlapPercent", config.targetOverlapPercent, 5, 90);
+    config.scrollPacing = document_.GetBool("capture", "scrollPacing", config.scrollPacing);
+    config.maxPendingCaptures = getUint("capture", "maxPendingCaptures", config.maxPendingCaptures, 1, kMaxUint);
+    config.autoScroll = document_.GetBool("capture", "autoScroll", config.autoScroll);
+    config.endOfListFrames = getUint("capture", "endOfListFrames", config.endOfListFrames, 0, kMaxUint);
+    config.endOfListTolerance = getUint("capture", "endOfListTolerance", config.endOfListTolerance, 0, kMaxUint);
+    config.maxInFlightSessions = getUint("capture", "maxInFlightSessions", config.maxInFlightSessions, 0, kMaxUint);
+    config.maxPublishedSets = getUint("capture", "maxPublishedSets", config.maxPublishedSets, 1, kMaxUint);
+    // Zero or less leaves the budget at its default rather than at 1 MB.
+    const auto memoryBudgetMegabytes = document_.GetInt("capture", "memoryBudgetMegabytes", config.memoryBudgetMegabytes);
+    config.memoryBudgetMegabytes = memoryBudgetMegabytes <= 0 ? AppConfig{}.memoryBudgetMegabytes
+                                                              : static_cast<UINT>((std::min)(memoryBudgetMegabytes, kMaxUint));
+    config.dedupeFrames = document_.GetBool("capture", "dedupeFrames", config.dedupeFrames);
+    config.clipboardMode = ClipboardModeFromString(getString("capture", "clipboardMode", ClipboardModeToString(config.clipboardMode)));
+
+    const auto loadChord = [&](const char* key, HotkeyConfig& chord) {
+        chord = ChordFromString(getString("bindings", key, ChordToString(chord)));
+    };
+    loadChord("captureNow", config.bindings.captureNow);
+    loadChord("cancelSession", config.bindings.cancelSession);
+    loadChord("dropLastFrame", config.bindings.dropLastFrame);
+    loadChord("republish", config.bindings.republish);
+
+    config.recordInput = document_.GetBool("debug", "recordInput", config.recordInput);
 
     outConfig = config;
     return true;
 }
 
 bool ConfigManager::Save(const AppConfig& config) {
-    const std::wstring primaryKey = StringFromVk(config.hotkey.primaryKey);
-    if (!WritePrivateProfileStringW(L"hotkey", L"primaryKey", primaryKey.c_str(), configPath_.c_str())) {
-        return false;
-    }
-    if (!WritePrivateProfileStringW(L"hotkey", L"requireWin", config.hotkey.requireWin ? L"1" : L"0", configPath_.c_str())) {
-        return false;
-    }
-    if (!WritePrivateProfileStringW(L"hotkey", L"requireCtrl", config.hotkey.requireCtrl ? L"1" : L"0", configPath_.c_str())) {
-        return false;
-    }
-    if (!WritePrivateProfileStringW(L"hotkey", L"requireAlt", config.hotkey.requireAlt ? L"1" : L"0", configPath_.c_str())) {
-        return false;
-    }
-    if (!WritePrivateProfileStringW(L"hotkey", L"requireShift", config.hotkey.requireShift ? L"1" : L"0", configPath_.c_str())) {
-        return false;
-    }
-    const auto shiftMode = ShiftModeToString(config.hotkey.shiftMode);
-    if (!WritePrivateProfileStringW(L"hotkey", L"shiftMode", shiftMode.c_str(), configPath_.c_str())) {
-        return false;
-    }
-    if (!WritePrivateProfileStringW(L"paths", L"outputDirectory", config.paths.outputDirectory.c_str(), configPath_.c_str())) {
-        return false;
-    }
-    if (!WritePrivateProfileStringW(L"paths", L"sessionDirectory", config.paths.sessionDirectory.c_str(), configPath_.c_str())) {
-        return false;
-    }
-    wchar_t scrollBuffer[16] = {};
-    const UINT clampedScrolls = config.scrollsPerCapture == 0 ? 1u : config.scrollsPerCapture;
-    swprintf_s(scrollBuffer, L"%u", static_cast<unsigned int>(clampedScrolls));
-    if (!WritePrivateProfileStringW(L"capture", L"scrollsPerCapture", scrollBuffer, configPath_.c_str())) {
-        return false;
+    const auto setString = [&](const char* section, const char* key, const std::wstring& value) {
+        document_.Set(section, key, util::WideToUtf8(value));
+    };
+
+    setString("hotkey", "primaryKey", StringFromVk(config.hotkey.primaryKey));
+    document_.SetBool("hotkey", "requireWin", config.hotkey.requireWin);
+    document_.SetBool("hotkey", "requireCtrl", config.hotkey.requireCtrl);
+    document_.SetBool("hotkey", "requireAlt", config.hotkey.requireAlt);
+    document_.SetBool("hotkey", "requireShift", config.hotkey.requireShift);
+    setString("hotkey", "shiftMode", ShiftModeToString(config.hotkey.shiftMode));
+    setString("paths", "outputDirectory", config.paths.outputDirectory);
+    setString("paths", "sessionDirectory", config.paths.sessionDirectory);
+    setString("paths", "objectDirectory", config.paths.objectDirectory);
+    document_.Set("paths", "maxSessionBytes", retention::FormatByteSize(config.paths.maxSessionBytes));
+    document_.Set("paths", "maxSessionAge", retention::FormatDuration(config.paths.maxSessionAgeSeconds));
+    document_.SetInt("paths", "keepLastN", config.paths.keepLastN);
+    document_.SetInt("capture", "scrollsPerCapture", config.scrollsPerCapture == 0 ? 1u : config.scrollsPerCapture);
+    document_.SetBool("capture", "adaptiveCadence", config.adaptiveCadence);
+    document_.SetInt("capture", "targetOverlapPercent", config.targetOverlapPercent);
+    document_.SetBool("capture", "scrollPacing", config.scrollPacing);
+    document_.SetInt("capture", "maxPendingCaptures", config.maxPendingCaptures == 0 ? 1u : config.maxPendingCaptures);
+    document_.SetBool("capture", "autoScroll", config.autoScroll);
+    document_.SetInt("capture", "endOfListFrames", config.endOfListFrames);
+    document_.SetInt("capture", "endOfListTolerance", config.endOfListTolerance);
+    document_.SetInt("capture", "maxInFlightSessions", config.maxInFlightSessions);
+    document_.SetInt("capture", "maxPublishedSets", config.maxPublishedSets);
+    document_.SetInt("capture", "memoryBudgetMegabytes", config.memoryBudgetMegabytes);
+    document_.SetBool("capture", "dedupeFrames", config.dedupeFrames);
+    setString("capture", "clipboardMode", ClipboardModeToString(config.clipboardMode));
+    setString("bindings", "captureNow", ChordToString(config.bindings.captureNow));
+    setString("bindings", "cancelSession", ChordToString(config.bindings.cancelSession));
+    setString("bindings", "dropLastFrame", ChordToString(config.bindings.dropLastFrame));
+    setString("bindings", "republish", ChordToString(config.bindings.republish));
+    document_.SetBool("debug", "recordInput", config.recordInput);
+
+    // Startup calls Save() with what Load() just read, which normally changes nothing.
+    if (!document_.Dirty()) {
+        return true;
     }
-    return true;
+    return document_.Save(std::filesystem::path(configPath_));
 }
@@ -0,0 +1,190 @@
+#include "Digest.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::array<uint32_t, 64> kRoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Slicing-by-8 tables: table[0] is the classic byte table, table[k] advances
+// a byte that sits k positions further back, so eight bytes fold per step.
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr Crc32Tables MakeCrc32Tables() {
+    Crc32Tables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+        }
+        tables[0][i] = value;
+    }
+    for (size_t k = 1; k < tables.size(); ++k) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables kCrc32Tables = MakeCrc32Tables();
+
+inline uint32_t RotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+} // namespace
+
+namespace digest {
+
+Sha256::Sha256() {
+    state_ = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+}
+
+void Sha256::Update(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    totalBytes_ += size;
+
+    if (bufferSize_ > 0) {
+        const size_t take = (std::min)(size, buffer_.size() - bufferSize_);
+        std::memcpy(buffer_.data() + bufferSize_, bytes, take);
+        bufferSize_ += take;
+        bytes += take;
+        size -= take;
+        if (bufferSize_ < buffer_.size()) {
+            return;
+        }
+        ProcessBlock(buffer_.data());
+        bufferSize_ = 0;
+    }
+
+    while (size >= buffer_.size()) {
+        ProcessBlock(bytes);
+        bytes += buffer_.size();
+        size -= buffer_.size();
+    }
+
+    if (size > 0) {
+        std::memcpy(buffer_.data(), bytes, size);
+        bufferSize_ = size;
+    }
+}
+
+Sha256Digest Sha256::Finish() {
+    const uint64_t bitLength = totalBytes_ * 8;
+    const uint8_t terminator = 0x80;
+    Update(&terminator, 1);
+    const uint8_t zero = 0;
+    while (bufferSize_ != 56) {
+        Update(&zero, 1);
+    }
+    uint8_t lengthBytes[8] = {};
+    for (int i = 0; i < 8; ++i) {
+        lengthBytes[i] = static_cast<uint8_t>(bitLength >> (56 - i * 8));
+    }
+    Update(lengthBytes, sizeof(lengthBytes));
+
+    Sha256Digest result = {};
+    for (size_t i = 0; i < state_.size(); ++i) {
+        result[i * 4 + 0] = static_cast<uint8_t>(state_[i] >> 24);
+        result[i * 4 + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        result[i * 4 + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        result[i * 4 + 3] = static_cast<uint8_t>(state_[i]);
+    }
+    return result;
+}
+
+void Sha256::ProcessBlock(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+               (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+               static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state_[0];
+    uint32_t b = state_[1];
+    uint32_t c = state_[2];
+    uint32_t d = state_[3];
+    uint32_t e = state_[4];
+    uint32_t f = state_[5];
+    uint32_t g = state_[6];
+    uint32_t h = state_[7];
+
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+        const uint32_t choice = (e & f) ^ (~e & g);
+        const uint32_t temp1 = h + s1 + choice + kRoundConstants[i] + w[i];
+        const uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+        const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t temp2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
+
+Sha256Digest ComputeSha256(const void* data, size_t size) {
+    Sha256 hasher;
+    hasher.Update(data, size);
+    return hasher.Finish();
+}
+
+std::string ToHex(const Sha256Digest& digest) {
+    static const char kHexDigits[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(digest.size() * 2);
+    for (auto byte : digest) {
+        result.push_back(kHexDigits[byte >> 4]);
+        result.push_back(kHexDigits[byte & 0x0F]);
+    }
+    return result;
+}
+
+uint32_t Crc32(const void* data, size_t size, uint32_t crc) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    const auto& t = kCrc32Tables;
+    crc = ~crc;
+    for (; size >= 8; size -= 8, bytes += 8) {
+        const uint32_t low = crc ^ (static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+                                    (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24));
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][bytes[4]] ^ t[2][bytes[5]] ^ t[1][bytes[6]] ^ t[0][bytes[7]];
+    }
+    for (; size > 0; --size, ++bytes) {
+        crc = t[0][(crc ^ *bytes) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+} // namespace digest
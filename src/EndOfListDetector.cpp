@@ -0,0 +1,27 @@
+#include "EndOfListDetector.h"
+
+EndOfListDetector::EndOfListDetector(const EndOfListSettings& settings)
+    : settings_(settings) {}
+
+void EndOfListDetector::Reset() {
+    stillFrames_ = 0;
+    reached_ = false;
+}
+
+bool EndOfListDetector::Observe(const std::optional<motion::ShiftEstimate>& sincePrevious) {
+    if (settings_.stillFrames == 0 || reached_) {
+        return reached_;
+    }
+    // An unmeasurable frame proves nothing either way, but usually means the view changed.
+    const bool still = sincePrevious && sincePrevious->valid &&
+                       sincePrevious->shift <= settings_.tolerancePx;
+    stillFrames_ = still ? stillFrames_ + 1 : 0;
+    reached_ = stillFrames_ >= settings_.stillFrames;
+    return reached_;
+}
+
+uint32_t EndOfListDetector::TakeTrailingDuplicates() {
+    const uint32_t count = stillFrames_;
+    stillFrames_ = 0;
+    return count;
+}
@@ -0,0 +1,103 @@
+#ifdef __linux__
+
+#include "FileWatcher.h"
+
+#include <array>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+// Quiet period before a burst of change events is reported.
+constexpr int kSettleMs = 150;
+
+class InotifyFileWatcher : public FileWatcher {
+public:
+    ~InotifyFileWatcher() override {
+        Stop();
+    }
+
+    bool Start(const std::filesystem::path& file, Callback onChanged) override {
+        Stop();
+        fileName_ = file.filename().string();
+        callback_ = std::move(onChanged);
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        stop_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        auto directory = file.parent_path();
+        if (directory.empty()) {
+            directory = ".";
+        }
+        if (inotify_ < 0 || stop_ < 0 ||
+            inotify_add_watch(inotify_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) < 0) {
+            Close();
+            return false;
+        }
+        thread_ = std::thread([this]() { Run(); });
+        return true;
+    }
+
+    void Stop() override {
+        if (thread_.joinable()) {
+            const uint64_t one = 1;
+            (void)write(stop_, &one, sizeof(one));
+            thread_.join();
+        }
+        Close();
+    }
+
+private:
+    void Run() {
+        alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+        bool pending = false;
+        while (true) {
+            pollfd fds[2] = { { stop_, POLLIN, 0 }, { inotify_, POLLIN, 0 } };
+            const int ready = poll(fds, 2, pending ? kSettleMs : -1);
+            if (ready < 0 || (fds[0].revents & POLLIN)) {
+                break;
+            }
+            if (ready == 0) {
+                pending = false;
+                callback_();
+                continue;
+            }
+            const ssize_t length = read(inotify_, buffer.data(), buffer.size());
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && fileName_ == event->name)) {
+                    pending = true;
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+    }
+
+    void Close() {
+        if (inotify_ >= 0) {
+            close(inotify_);
+            inotify_ = -1;
+        }
+        if (stop_ >= 0) {
+            close(stop_);
+            stop_ = -1;
+        }
+    }
+
+    std::string fileName_;
+    Callback callback_;
+    int inotify_ = -1;
+    int stop_ = -1;
+    std::thread thread_;
+};
+
+} // namespace
+
+std::unique_ptr<FileWatcher> FileWatcher::Create() {
+    return std::make_unique<InotifyFileWatcher>();
+}
+
+#endif
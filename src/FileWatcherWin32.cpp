@@ -0,0 +1,139 @@
+#ifdef _WIN32
+
+#include "FileWatcher.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <windows.h>
+
+namespace {
+
+// Quiet period before a burst of change events is reported.
+constexpr DWORD kSettleMs = 150;
+
+class Win32FileWatcher : public FileWatcher {
+public:
+    ~Win32FileWatcher() override {
+        Stop();
+    }
+
+    bool Start(const std::filesystem::path& file, Callback onChanged) override {
+        Stop();
+        fileName_ = file.filename().wstring();
+        callback_ = std::move(onChanged);
+        directory_ = CreateFileW(file.parent_path().c_str(), FILE_LIST_DIRECTORY,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                 FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (directory_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        stopEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        changeEvent_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!stopEvent_ || !changeEvent_) {
+            Close();
+            return false;
+        }
+        thread_ = std::thread([this]() { Run(); });
+        return true;
+    }
+
+    void Stop() override {
+        if (thread_.joinable()) {
+            SetEvent(stopEvent_);
+            thread_.join();
+        }
+        Close();
+    }
+
+private:
+    void Run() {
+        std::vector<BYTE> buffer(16 * 1024);
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = changeEvent_;
+        bool pending = false;
+        bool reading = false;
+
+        while (true) {
+            if (!reading) {
+                ResetEvent(changeEvent_);
+                reading = ReadDirectoryChangesW(directory_, buffer.data(), static_cast<DWORD>(buffer.size()), FALSE,
+                                                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                                                nullptr, &overlapped, nullptr) != FALSE;
+                if (!reading) {
+                    break;
+                }
+            }
+
+            const HANDLE handles[] = { stopEvent_, changeEvent_ };
+            const DWORD wait = WaitForMultipleObjects(2, handles, FALSE, pending ? kSettleMs : INFINITE);
+            if (wait == WAIT_OBJECT_0) {
+                break;
+            }
+            if (wait == WAIT_TIMEOUT) {
+                pending = false;
+                callback_();
+                continue;
+            }
+
+            reading = false;
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(directory_, &overlapped, &bytes, FALSE)) {
+                break;
+            }
+            // A zero-byte result means the buffer overflowed; assume the file changed.
+            pending = pending || bytes == 0 || Matches(buffer.data());
+        }
+
+        if (reading) {
+            CancelIoEx(directory_, &overlapped);
+            DWORD bytes = 0;
+            GetOverlappedResult(directory_, &overlapped, &bytes, TRUE);
+        }
+    }
+
+    bool Matches(const BYTE* data) const {
+        while (true) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data);
+            const std::wstring name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+            if (CompareStringOrdinal(name.c_str(), static_cast<int>(name.size()), fileName_.c_str(),
+                                     static_cast<int>(fileName_.size()), TRUE) == CSTR_EQUAL) {
+                return true;
+            }
+            if (info->NextEntryOffset == 0) {
+                return false;
+            }
+            data += info->NextEntryOffset;
+        }
+    }
+
+    void Close() {
+        if (directory_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(directory_);
+            directory_ = INVALID_HANDLE_VALUE;
+        }
+        if (stopEvent_) {
+            CloseHandle(stopEvent_);
+            stopEvent_ = nullptr;
+        }
+        if (changeEvent_) {
+            CloseHandle(changeEvent_);
+            changeEvent_ = nullptr;
+        }
+    }
+
+    std::wstring fileName_;
+    Callback callback_;
+    HANDLE directory_ = INVALID_HANDLE_VALUE;
+    HANDLE stopEvent_ = nullptr;
+    HANDLE changeEvent_ = nullptr;
+    std::thread thread_;
+};
+
+} // namespace
+
+std::unique_ptr<FileWatcher> FileWatcher::Create() {
+    return std::make_unique<Win32FileWatcher>();
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "FrameStore.h"
+
+#include <memory>
+
+namespace {
+// Members are destroyed in reverse order, so the bytes go back to the
+// resource before the resource itself is released.
+struct SessionBuffer {
+    explicit SessionBuffer(std::shared_ptr<std::pmr::memory_resource> owner)
+        : resource(std::move(owner)), bytes(resource.get()) {
+    }
+
+    std::shared_ptr<std::pmr::memory_resource> resource;
+    ByteBuffer bytes;
+};
+
+// Allocates from an arena it keeps alive, so a shared_ptr control block
+// placed in the arena can still be handed back after its last owner is gone.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<SessionArena> owner)
+        : arena(std::move(owner)) {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : arena(other.arena) {
+    }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t count) {
+        arena->deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    std::shared_ptr<SessionArena> arena;
+};
+} // namespace
+
+std::shared_ptr<ByteBuffer> MakeSessionBuffer(const std::shared_ptr<std::pmr::memory_resource>& resource) {
+    if (!resource) {
+        return std::make_shared<ByteBuffer>();
+    }
+    auto holder = std::make_shared<SessionBuffer>(resource);
+    return std::shared_ptr<ByteBuffer>(holder, &holder->bytes);
+}
+
+std::shared_ptr<ByteBuffer> MakeSessionBuffer(const std::shared_ptr<SessionArena>& arena) {
+    if (!arena) {
+        return std::make_shared<ByteBuffer>();
+    }
+    return std::allocate_shared<ByteBuffer>(ArenaAllocator<ByteBuffer>(arena), arena.get());
+}
+
+void FrameStore::Clear() {
+    frames_.clear();
+}
+
+void FrameStore::Reset(std::shared_ptr<SessionArena> arena) {
+    // A pmr container keeps its resource for life, so the list is rebuilt on the new one.
+    std::destroy_at(&frames_);
+    arena_ = std::move(arena);
+    std::construct_at(&frames_, arena_ ? static_cast<std::pmr::memory_resource*>(arena_.get()) : std::pmr::get_default_resource());
+}
+
+Frame FrameStore::NewFrame() const {
+    return Frame(arena_ ? static_cast<std::pmr::memory_resource*>(arena_.get()) : std::pmr::get_default_resource());
+}
+
+const Frame& FrameStore::Add(Frame frame) {
+    if (!frames_.empty()) {
+        frames_.back().pixels.reset();
+    }
+    frames_.push_back(std::move(frame));
+    return frames_.back();
+}
+
+bool FrameStore::DropLast(bool restorePixels) {
+    if (frames_.empty()) {
+        return false;
+    }
+    frames_.pop_back();
+    if (restorePixels) {
+        RestoreLastPixels();
+    }
+    return true;
+}
+
+bool FrameStore::RestoreLastPixels() {
+    if (frames_.empty()) {
+        return false;
+    }
+    Frame& last = frames_.back();
+    if (last.pixels) {
+        return true;
+    }
+    if (!last.png || !decoder_) {
+        return false;
+    }
+    auto pixels = decoder_(last);
+    if (!pixels) {
+        return false;
+    }
+    last.stride = last.width * 4;
+    last.pixels = std::move(pixels);
+    return true;
+}
+
+const Frame& FrameStore::ReplaceLast(Frame frame) {
+    frames_.back() = std::move(frame);
+    return frames_.back();
+}
+
+size_t FrameStore::Bytes() const {
+    size_t bytes = 0;
+    for (const auto& frame : frames_) {
+        bytes += frame.png ? frame.png->size() : 0;
+        bytes += frame.pixels ? frame.pixels->size() : 0;
+    }
+    return bytes;
+}
@@ -1,29 +1,95 @@
 #include "HotkeyManager.h"
 
+#include <algorithm>
 #include <chrono>
-#include <unordered_set>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+#include "Log.h"
 
 HotkeyManager* HotkeyManager::instance_ = nullptr;
 
 namespace {
-bool IsModifierKey(UINT vk) {
-    switch (vk) {
-        case VK_SHIFT:
-        case VK_LSHIFT:
-        case VK_RSHIFT:
-        case VK_CONTROL:
-        case VK_LCONTROL:
-        case VK_RCONTROL:
-        case VK_MENU:
-        case VK_LMENU:
-        case VK_RMENU:
-        case VK_LWIN:
-        case VK_RWIN:
-            return true;
+const wchar_t kNotifyWindowClass[] = L"ChronosHotkeyNotify";
+const UINT kInputMessage = WM_APP + 1;
+// Thread messages for the input thread.
+const UINT kPacerResetMessage = WM_APP + 2;
+const UINT kCaptureDoneMessage = WM_APP + 3;
+const UINT kPacerConfigMessage = WM_APP + 4;
+// Windows' default when HKCU\Control Panel\Desktop\LowLevelHooksTimeout is unset.
+const DWORD kDefaultHookTimeoutMs = 300;
+
+DWORD ReadLowLevelHooksTimeout() {
+    DWORD value = 0;
+    DWORD size = sizeof(value);
+    if (RegGetValueW(HKEY_CURRENT_USER, L"Control Panel\\Desktop", L"LowLevelHooksTimeout", RRF_RT_REG_DWORD, nullptr, &value, &size) == ERROR_SUCCESS && value > 0) {
+        return value;
+    }
+    wchar_t text[16] = {};
+    size = sizeof(text);
+    if (RegGetValueW(HKEY_CURRENT_USER, L"Control Panel\\Desktop", L"LowLevelHooksTimeout", RRF_RT_REG_SZ, nullptr, text, &size) == ERROR_SUCCESS) {
+        value = static_cast<DWORD>(wcstoul(text, nullptr, 10));
+        if (value > 0) {
+            return value;
+        }
+    }
+    return kDefaultHookTimeoutMs;
+}
+
+LONGLONG QueryTicks() {
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+}
+
+// Virtual-key code of the button behind a low-level mouse button message.
+uint32_t MouseButton(WPARAM message, DWORD mouseData) {
+    switch (message) {
+        case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+            return VK_LBUTTON;
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
+            return VK_RBUTTON;
+        case WM_MBUTTONDOWN:
+        case WM_MBUTTONUP:
+            return VK_MBUTTON;
         default:
-            return false;
+            return HIWORD(mouseData) == XBUTTON1 ? VK_XBUTTON1 : VK_XBUTTON2;
     }
 }
+
+std::wstring Microseconds(uint64_t nanoseconds) {
+    wchar_t buffer[32] = {};
+    swprintf_s(buffer, L"%.1f us", static_cast<double>(nanoseconds) / 1000.0);
+    return buffer;
+}
+
+hotkey::KeySet KeysFromConfig(const HotkeyConfig& config) {
+    hotkey::KeySet keys;
+    if (config.primaryKey == 0 || config.primaryKey > 0xFF) {
+        return keys;
+    }
+    keys.Set(static_cast<uint8_t>(config.primaryKey));
+    if (config.requireWin) {
+        keys.Set(hotkey::kKeyAnyWin);
+    }
+    if (config.requireCtrl) {
+        keys.Set(VK_CONTROL);
+    }
+    if (config.requireAlt) {
+        keys.Set(VK_MENU);
+    }
+    if (config.shiftMode == HotkeyConfig::ShiftMode::LeftOnly) {
+        keys.Set(VK_LSHIFT);
+    } else if (config.shiftMode == HotkeyConfig::ShiftMode::RightOnly) {
+        keys.Set(VK_RSHIFT);
+    } else if (config.requireShift) {
+        keys.Set(VK_SHIFT);
+    }
+    return keys;
+}
 }
 
 HotkeyManager::HotkeyManager() = default;
@@ -31,171 +97,425 @@ HotkeyManager::~HotkeyManager() {
     Shutdown();
 }
 
-bool HotkeyManager::Initialize(const HotkeyConfig& config, UINT scrollsPerCapture, ToggleCallback onToggle, CaptureRequest onCaptureRequest) {
+bool HotkeyManager::Initialize(const HotkeyConfig& config, const HotkeyBindings& bindings, UINT scrollsPerCapture, ActionCallback onAction, CaptureRequest onCaptureRequest) {
     if (instance_ != nullptr) {
         return false;
     }
     config_ = config;
-    onToggle_ = std::move(onToggle);
+    bindings_ = bindings;
+    ApplyBindings();
+    onAction_ = std::move(onAction);
     onCaptureRequest_ = std::move(onCaptureRequest);
     SetScrollsPerCapture(scrollsPerCapture);
 
-    keyboardHook_ = SetWindowsHookExW(WH_KEYBOARD_LL, KeyboardProc, nullptr, 0);
-    mouseHook_ = SetWindowsHookExW(WH_MOUSE_LL, MouseProc, nullptr, 0);
-    if (!keyboardHook_ || !mouseHook_) {
-        Shutdown();
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    qpcFrequency_ = frequency.QuadPart > 0 ? frequency.QuadPart : 1;
+    hookTimeoutMs_ = ReadLowLevelHooksTimeout();
+    slowHookThresholdNs_ = static_cast<uint64_t>(hookTimeoutMs_) * 1000000 / 2;
+    ResetHookLatency();
+
+    if (!CreateNotifyWindow()) {
         return false;
     }
     instance_ = this;
+
+    std::promise<bool> started;
+    auto startResult = started.get_future();
+    inputThread_ = std::thread([this, &started]() {
+        InputThreadMain(started);
+    });
+    if (!startResult.get()) {
+        Shutdown();
+        return false;
+    }
     return true;
 }
 
-void HotkeyManager::UpdateConfig(const HotkeyConfig& config) {
+void HotkeyManager::UpdateConfig(const HotkeyConfig& config, const HotkeyBindings& bindings) {
     config_ = config;
-    ResetCombinationLatch();
-    keysDown_.clear();
+    bindings_ = bindings;
+    ApplyBindings();
+}
+
+void HotkeyManager::ApplyBindings() {
+    auto& matcher = processor_.Matcher();
+    matcher.Bind(hotkey::Action::Toggle, KeysFromConfig(config_));
+    matcher.Bind(hotkey::Action::CaptureNow, KeysFromConfig(bindings_.captureNow));
+    matcher.Bind(hotkey::Action::CancelSession, KeysFromConfig(bindings_.cancelSession));
+    matcher.Bind(hotkey::Action::DropLastFrame, KeysFromConfig(bindings_.dropLastFrame));
+    matcher.Bind(hotkey::Action::Republish, KeysFromConfig(bindings_.republish));
+    matcher.ResetState();
 }
 
 void HotkeyManager::Shutdown() {
-    if (keyboardHook_) {
-        UnhookWindowsHookEx(keyboardHook_);
-        keyboardHook_ = nullptr;
+    if (inputThread_.joinable()) {
+        PostThreadMessageW(inputThreadId_, WM_QUIT, 0, 0);
+        inputThread_.join();
     }
-    if (mouseHook_) {
-        UnhookWindowsHookEx(mouseHook_);
-        mouseHook_ = nullptr;
+    inputThreadId_ = 0;
+    if (notifyWindow_) {
+        DestroyWindow(notifyWindow_);
+        notifyWindow_ = nullptr;
     }
-    instance_ = nullptr;
-    keysDown_.clear();
+    if (instance_ == this) {
+        instance_ = nullptr;
+    }
+    StopRecording();
+    processor_.Matcher().ResetState();
 }
 
 void HotkeyManager::SetCaptureMode(bool enabled) {
     captureMode_.store(enabled);
-    pendingScrolls_ = 0;
+    if (inputThreadId_ != 0) {
+        PostThreadMessageW(inputThreadId_, kPacerResetMessage, enabled ? 1 : 0, 0);
+    }
+    InputEvent marker;
+    marker.kind = InputEvent::Kind::CaptureMode;
+    marker.flags = enabled ? 1u : 0u;
+    marker.time = GetTickCount();
+    ProcessEvent(marker);
 }
 
 void HotkeyManager::SetScrollsPerCapture(UINT count) {
-    if (count == 0) {
-        count = 1;
+    processor_.SetScrollsPerCapture(count);
+    pacerNotches_.store(processor_.ScrollsPerCapture());
+    if (inputThreadId_ != 0) {
+        PostThreadMessageW(inputThreadId_, kPacerConfigMessage, processor_.ScrollsPerCapture(), 0);
     }
-    scrollsPerCapture_ = count;
-    pendingScrolls_ = 0;
 }
 
-LRESULT CALLBACK HotkeyManager::KeyboardProc(int code, WPARAM wParam, LPARAM lParam) {
-    if (code < 0) {
-        return CallNextHookEx(nullptr, code, wParam, lParam);
+void HotkeyManager::SetScrollPacing(bool enabled, UINT maxPendingCaptures) {
+    pacingEnabled_.store(enabled);
+    maxPendingCaptures_.store(maxPendingCaptures == 0 ? 1 : maxPendingCaptures);
+}
+
+void HotkeyManager::NotifyCaptureCompleted() {
+    if (pacingEnabled_.load() && inputThreadId_ != 0) {
+        PostThreadMessageW(inputThreadId_, kCaptureDoneMessage, 0, 0);
     }
-    if (instance_) {
-        instance_->HandleKeyboardEvent(wParam, reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam));
+    if (recorder_) {
+        InputEvent marker;
+        marker.kind = InputEvent::Kind::CaptureDone;
+        marker.time = GetTickCount();
+        recorder_->Append(marker);
     }
-    return CallNextHookEx(nullptr, code, wParam, lParam);
 }
 
-LRESULT CALLBACK HotkeyManager::MouseProc(int code, WPARAM wParam, LPARAM lParam) {
-    if (code < 0) {
-        return CallNextHookEx(nullptr, code, wParam, lParam);
+HotkeyManager::PacingReport HotkeyManager::Pacing() const {
+    PacingReport report;
+    report.stats = pacer_.Snapshot();
+    report.releaseLatency = pacer_.ReleaseLatency().Summarize();
+    report.droppedEvents = queue_.Dropped();
+    return report;
+}
+
+bool HotkeyManager::StartRecording(const std::wstring& path) {
+    auto writer = std::make_unique<inputlog::Writer>();
+    if (!writer->Open(std::filesystem::path(path))) {
+        return false;
     }
-    if (instance_) {
-        instance_->HandleMouseEvent(wParam, reinterpret_cast<MSLLHOOKSTRUCT*>(lParam));
+    recorder_ = std::move(writer);
+    recording_.store(true);
+    return true;
+}
+
+void HotkeyManager::StopRecording() {
+    recording_.store(false);
+    if (recorder_) {
+        recorder_->Close();
+        recorder_.reset();
     }
-    return CallNextHookEx(nullptr, code, wParam, lParam);
 }
 
-void HotkeyManager::HandleKeyboardEvent(WPARAM wParam, const KBDLLHOOKSTRUCT* data) {
-    if (!data) {
-        return;
+HotkeyManager::HookLatencyReport HotkeyManager::HookLatency() const {
+    HookLatencyReport report;
+    report.keyboard = keyboardLatency_.Summarize();
+    report.mouse = mouseLatency_.Summarize();
+    report.slowHooks = slowHooks_.load(std::memory_order_relaxed);
+    report.timeoutMs = hookTimeoutMs_;
+    return report;
+}
+
+void HotkeyManager::ResetHookLatency() {
+    keyboardLatency_.Reset();
+    mouseLatency_.Reset();
+    slowHooks_.store(0, std::memory_order_relaxed);
+    reportedSlowHooks_ = 0;
+}
+
+uint64_t HotkeyManager::NowNanoseconds() const {
+    const auto ticks = static_cast<uint64_t>(QueryTicks());
+    const auto frequency = static_cast<uint64_t>(qpcFrequency_);
+    return ticks / frequency * 1000000000ull + ticks % frequency * 1000000000ull / frequency;
+}
+
+void HotkeyManager::RecordHookLatency(LatencyHistogram& histogram, LONGLONG startTicks) {
+    const auto elapsed = static_cast<uint64_t>(QueryTicks() - startTicks);
+    const uint64_t nanoseconds = elapsed * 1000000000ull / static_cast<uint64_t>(qpcFrequency_);
+    histogram.Record(nanoseconds);
+    if (nanoseconds >= slowHookThresholdNs_) {
+        slowHooks_.fetch_add(1, std::memory_order_relaxed);
     }
+}
 
-    const bool isKeyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
-    const bool isKeyUp = (wParam == WM_KEYUP || wParam == WM_SYSKEYUP);
+bool HotkeyManager::CreateNotifyWindow() {
+    const HINSTANCE module = GetModuleHandleW(nullptr);
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = &HotkeyManager::NotifyWindowProc;
+    wc.hInstance = module;
+    wc.lpszClassName = kNotifyWindowClass;
+    if (!RegisterClassW(&wc) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+        return false;
+    }
+    notifyWindow_ = CreateWindowExW(0, kNotifyWindowClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, module, nullptr);
+    if (!notifyWindow_) {
+        return false;
+    }
+    SetWindowLongPtrW(notifyWindow_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+    return true;
+}
 
-    if (isKeyDown) {
-        keysDown_.insert(data->vkCode);
-        if (data->vkCode == VK_LSHIFT || data->vkCode == VK_RSHIFT) {
-            keysDown_.insert(VK_SHIFT);
-        }
-        if (data->vkCode == VK_LCONTROL || data->vkCode == VK_RCONTROL) {
-            keysDown_.insert(VK_CONTROL);
-        }
-        if (data->vkCode == VK_LMENU || data->vkCode == VK_RMENU) {
-            keysDown_.insert(VK_MENU);
-        }
-        if (CheckToggleCondition(data->vkCode, true)) {
-            if (onToggle_) {
-                onToggle_();
+void HotkeyManager::InputThreadMain(std::promise<bool>& started) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+    // Force creation of the thread's message queue so Shutdown can post WM_QUIT.
+    MSG msg;
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    inputThreadId_ = GetCurrentThreadId();
+
+    keyboardHook_ = SetWindowsHookExW(WH_KEYBOARD_LL, KeyboardProc, nullptr, 0);
+    mouseHook_ = SetWindowsHookExW(WH_MOUSE_LL, MouseProc, nullptr, 0);
+    const bool hooked = keyboardHook_ && mouseHook_;
+    started.set_value(hooked);
+
+    if (hooked) {
+        while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+            if (msg.hwnd == nullptr && HandleInputThreadMessage(msg)) {
+                continue;
             }
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
         }
-    } else if (isKeyUp) {
-        keysDown_.erase(data->vkCode);
-        if (data->vkCode == VK_LSHIFT || data->vkCode == VK_RSHIFT) {
-            keysDown_.erase(VK_SHIFT);
-        }
-        if (data->vkCode == VK_LCONTROL || data->vkCode == VK_RCONTROL) {
-            keysDown_.erase(VK_CONTROL);
-        }
-        if (data->vkCode == VK_LMENU || data->vkCode == VK_RMENU) {
-            keysDown_.erase(VK_MENU);
-        }
-        if (IsModifierKey(data->vkCode) || data->vkCode == config_.primaryKey) {
-            ResetCombinationLatch();
-        }
+    }
+    if (pacerTimer_) {
+        KillTimer(nullptr, pacerTimer_);
+        pacerTimer_ = 0;
+    }
+
+    if (keyboardHook_) {
+        UnhookWindowsHookEx(keyboardHook_);
+        keyboardHook_ = nullptr;
+    }
+    if (mouseHook_) {
+        UnhookWindowsHookEx(mouseHook_);
+        mouseHook_ = nullptr;
     }
 }
 
-void HotkeyManager::HandleMouseEvent(WPARAM wParam, const MSLLHOOKSTRUCT* data) {
-    if (!data) {
+bool HotkeyManager::HandleInputThreadMessage(const MSG& msg) {
+    int16_t release[ScrollPacer::kMaxHeld];
+    size_t count = 0;
+    switch (msg.message) {
+        case kPacerResetMessage:
+            count = pacer_.ReleaseAll(NowNanoseconds(), release, ScrollPacer::kMaxHeld);
+            if (pacerTimer_) {
+                KillTimer(nullptr, pacerTimer_);
+                pacerTimer_ = 0;
+            }
+            if (msg.wParam != 0 && pacingEnabled_.load()) {
+                pacer_.Configure(pacerNotches_.load(), maxPendingCaptures_.load());
+                pacer_.Reset();
+                pacerTimer_ = SetTimer(nullptr, 0, ScrollPacer::kTickMs, &HotkeyManager::PacerTimerProc);
+            }
+            break;
+        case kPacerConfigMessage:
+            pacer_.SetNotchesPerCapture(static_cast<uint32_t>(msg.wParam));
+            break;
+        case kCaptureDoneMessage:
+            count = pacer_.OnCaptureCompleted(NowNanoseconds(), release, ScrollPacer::kMaxHeld);
+            break;
+        default:
+            return false;
+    }
+    InjectWheel(release, count);
+    return true;
+}
+
+void CALLBACK HotkeyManager::PacerTimerProc(HWND, UINT, UINT_PTR, DWORD) {
+    if (!instance_) {
         return;
     }
-    if (!captureMode_.load()) {
+    int16_t release[ScrollPacer::kMaxHeld];
+    const size_t count = instance_->pacer_.OnTick(instance_->NowNanoseconds(), ScrollPacer::kLostCaptureNs, release, ScrollPacer::kMaxHeld);
+    instance_->InjectWheel(release, count);
+}
+
+void HotkeyManager::InjectWheel(const int16_t* deltas, size_t count) {
+    if (count == 0) {
         return;
     }
-    if (wParam == WM_MOUSEWHEEL) {
-        const auto delta = static_cast<SHORT>(HIWORD(data->mouseData));
-        if (delta < 0) {
-            pendingScrolls_ += 1;
-            if (pendingScrolls_ >= scrollsPerCapture_) {
-                pendingScrolls_ = 0;
-                if (onCaptureRequest_) {
-                    onCaptureRequest_();
-                }
-            }
-        } else if (delta > 0) {
-            pendingScrolls_ = 0;
+    std::vector<INPUT> inputs(count);
+    for (size_t i = 0; i < count; ++i) {
+        inputs[i].type = INPUT_MOUSE;
+        inputs[i].mi.dwFlags = MOUSEEVENTF_WHEEL;
+        inputs[i].mi.mouseData = static_cast<DWORD>(static_cast<LONG>(deltas[i]));
+        inputs[i].mi.dwExtraInfo = kSyntheticInputTag;
+    }
+    SendInput(static_cast<UINT>(count), inputs.data(), sizeof(INPUT));
+}
+
+LRESULT CALLBACK HotkeyManager::KeyboardProc(int code, WPARAM wParam, LPARAM lParam) {
+    if (code < 0) {
+        return CallNextHookEx(nullptr, code, wParam, lParam);
+    }
+    const auto startTicks = QueryTicks();
+    const auto* data = reinterpret_cast<const KBDLLHOOKSTRUCT*>(lParam);
+    if (instance_ && data) {
+        InputEvent event;
+        event.vkCode = data->vkCode;
+        event.flags = data->flags;
+        event.time = data->time;
+        if (data->flags & LLKHF_INJECTED) {
+            event.marks |= InputEvent::kInjected;
         }
+        if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN) {
+            event.kind = InputEvent::Kind::KeyDown;
+            instance_->PushEvent(event);
+        } else if (wParam == WM_KEYUP || wParam == WM_SYSKEYUP) {
+            event.kind = InputEvent::Kind::KeyUp;
+            instance_->PushEvent(event);
+        }
+        instance_->RecordHookLatency(instance_->keyboardLatency_, startTicks);
     }
+    return CallNextHookEx(nullptr, code, wParam, lParam);
 }
 
-bool HotkeyManager::CheckToggleCondition(UINT vkCode, bool isKeyDown) {
-    if (!isKeyDown) {
-        return false;
+LRESULT CALLBACK HotkeyManager::MouseProc(int code, WPARAM wParam, LPARAM lParam) {
+    if (code < 0) {
+        return CallNextHookEx(nullptr, code, wParam, lParam);
     }
-    if (consumedCombination_.load()) {
-        return false;
+    const auto startTicks = QueryTicks();
+    const auto* data = reinterpret_cast<const MSLLHOOKSTRUCT*>(lParam);
+    if (instance_ && data) {
+        // Outside capture mode only a recording needs mouse events; the
+        // processor ignores them anyway.
+        const bool recording = instance_->recording_.load(std::memory_order_relaxed);
+        InputEvent event;
+        event.flags = data->flags;
+        event.time = data->time;
+        if (data->flags & LLMHF_INJECTED) {
+            event.marks |= InputEvent::kInjected;
+        }
+        if (data->dwExtraInfo == kSyntheticInputTag) {
+            event.marks |= InputEvent::kReinjected;
+        }
+        const auto delta = static_cast<int16_t>(HIWORD(data->mouseData));
+        if (wParam == WM_MOUSEWHEEL) {
+            event.kind = InputEvent::Kind::Wheel;
+            event.wheelDelta = delta;
+            const bool captureMode = instance_->captureMode_.load();
+            if (captureMode && instance_->pacingEnabled_.load(std::memory_order_relaxed)) {
+                const bool reinjected = (event.marks & InputEvent::kReinjected) != 0;
+                if (instance_->pacer_.OnWheel(delta, reinjected, instance_->NowNanoseconds()) == ScrollPacer::Decision::Hold) {
+                    if (recording) {
+                        event.marks |= InputEvent::kHeld;
+                        instance_->PushEvent(event);
+                    }
+                    instance_->RecordHookLatency(instance_->mouseLatency_, startTicks);
+                    return 1;
+                }
+            }
+            if (captureMode || recording) {
+                instance_->PushEvent(event);
+            }
+        } else if (recording) {
+            bool known = true;
+            switch (wParam) {
+                case WM_MOUSEMOVE:
+                    event.kind = InputEvent::Kind::MouseMove;
+                    event.vkCode = static_cast<uint32_t>(data->pt.x);
+                    event.flags = static_cast<uint32_t>(data->pt.y);
+                    break;
+                case WM_MOUSEHWHEEL:
+                    event.kind = InputEvent::Kind::HorizontalWheel;
+                    event.wheelDelta = delta;
+                    break;
+                case WM_LBUTTONDOWN:
+                case WM_RBUTTONDOWN:
+                case WM_MBUTTONDOWN:
+                case WM_XBUTTONDOWN:
+                    event.kind = InputEvent::Kind::MouseDown;
+                    event.vkCode = MouseButton(wParam, data->mouseData);
+                    break;
+                case WM_LBUTTONUP:
+                case WM_RBUTTONUP:
+                case WM_MBUTTONUP:
+                case WM_XBUTTONUP:
+                    event.kind = InputEvent::Kind::MouseUp;
+                    event.vkCode = MouseButton(wParam, data->mouseData);
+                    break;
+                default:
+                    known = false;
+                    break;
+            }
+            if (known) {
+                instance_->PushEvent(event);
+            }
+        }
+        instance_->RecordHookLatency(instance_->mouseLatency_, startTicks);
     }
+    return CallNextHookEx(nullptr, code, wParam, lParam);
+}
 
-    const bool mainPressed = keysDown_.count(config_.primaryKey) > 0;
-    bool winOk = !config_.requireWin || keysDown_.count(VK_LWIN) > 0 || keysDown_.count(VK_RWIN) > 0;
-    bool ctrlOk = !config_.requireCtrl || keysDown_.count(VK_CONTROL) > 0 || keysDown_.count(VK_LCONTROL) > 0 || keysDown_.count(VK_RCONTROL) > 0;
-    bool altOk = !config_.requireAlt || keysDown_.count(VK_MENU) > 0 || keysDown_.count(VK_LMENU) > 0 || keysDown_.count(VK_RMENU) > 0;
-    bool shiftOk = true;
+LRESULT CALLBACK HotkeyManager::NotifyWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
+    if (message == kInputMessage) {
+        auto that = reinterpret_cast<HotkeyManager*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+        if (that) {
+            that->DrainInput();
+        }
+        return 0;
+    }
+    return DefWindowProcW(hwnd, message, wParam, lParam);
+}
 
-    if (config_.requireShift) {
-        shiftOk = keysDown_.count(VK_SHIFT) > 0 || keysDown_.count(VK_LSHIFT) > 0 || keysDown_.count(VK_RSHIFT) > 0;
+void HotkeyManager::PushEvent(const InputEvent& event) {
+    if (queue_.Push(event)) {
+        PostMessageW(notifyWindow_, kInputMessage, 0, 0);
     }
-    if (config_.shiftMode == HotkeyConfig::ShiftMode::LeftOnly) {
-        shiftOk = keysDown_.count(VK_LSHIFT) > 0;
-    } else if (config_.shiftMode == HotkeyConfig::ShiftMode::RightOnly) {
-        shiftOk = keysDown_.count(VK_RSHIFT) > 0;
+}
+
+void HotkeyManager::DrainInput() {
+    queue_.Drain([this](const InputEvent& event) {
+        ProcessEvent(event);
+    });
+    if (recorder_) {
+        recorder_->Flush();
     }
 
-    const bool triggered = mainPressed && winOk && ctrlOk && altOk && shiftOk;
-    if (triggered) {
-        consumedCombination_.store(true);
+    const auto slowHooks = slowHooks_.load(std::memory_order_relaxed);
+    if (slowHooks > reportedSlowHooks_) {
+        reportedSlowHooks_ = slowHooks;
+        const auto worst = (std::max)(keyboardLatency_.Max(), mouseLatency_.Max());
+        logging::Warning(L"Input hook is close to LowLevelHooksTimeout (" + std::to_wstring(hookTimeoutMs_) +
+                         L" ms); Windows silently removes hooks that exceed it. Slowest run " + Microseconds(worst) +
+                         L", slow runs " + std::to_wstring(slowHooks) + L".");
     }
-    return triggered;
 }
 
-void HotkeyManager::ResetCombinationLatch() {
-    consumedCombination_.store(false);
+void HotkeyManager::ProcessEvent(const InputEvent& event) {
+    if (recorder_) {
+        recorder_->Append(event);
+    }
+    // The pacer swallowed it; it is only here for the recording.
+    if (event.marks & InputEvent::kHeld) {
+        return;
+    }
+    const auto result = processor_.Process(event);
+    if (result.action && onAction_) {
+        onAction_(*result.action);
+    }
+    if (result.captureRequested && onCaptureRequest_) {
+        onCaptureRequest_(result.notches);
+    }
 }
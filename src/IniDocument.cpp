@@ -0,0 +1,323 @@
+#include "IniDocument.h"
+
+#include "Utf.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+std::atomic<unsigned> g_tempCounter{ 0 };
+
+std::string TrimAscii(const std::string& value) {
+    const auto first = value.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return std::string();
+    }
+    const auto last = value.find_last_not_of(" \t");
+    return value.substr(first, last - first + 1);
+}
+
+bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+        return std::tolower(x) == std::tolower(y);
+    });
+}
+
+bool StartsWith(const std::string& bytes, const char* prefix, size_t length) {
+    return bytes.size() >= length && bytes.compare(0, length, prefix, length) == 0;
+}
+
+std::string Utf16BytesToUtf8(const std::string& bytes, size_t offset, bool bigEndian) {
+    std::u16string units((bytes.size() - offset) / 2, u'\0');
+    for (size_t i = 0; i < units.size(); ++i) {
+        const auto first = static_cast<uint8_t>(bytes[offset + i * 2]);
+        const auto second = static_cast<uint8_t>(bytes[offset + i * 2 + 1]);
+        units[i] = static_cast<char16_t>(bigEndian ? (first << 8) | second : (second << 8) | first);
+    }
+    std::string text(util::MaxUtf8Length(units.size()), '\0');
+    text.resize(util::Utf16ToUtf8(units.data(), units.size(), text.data(), text.size()).written);
+    return text;
+}
+
+std::string Utf8ToUtf16Bytes(const std::string& text, bool bigEndian) {
+    std::u16string units(util::MaxUtf16Length(text.size()), u'\0');
+    units.resize(util::Utf8ToUtf16(text.data(), text.size(), units.data(), units.size()).written);
+    std::string bytes = bigEndian ? "\xFE\xFF" : "\xFF\xFE";
+    bytes.reserve(2 + units.size() * 2);
+    for (const char16_t unit : units) {
+        const auto high = static_cast<char>(unit >> 8);
+        const auto low = static_cast<char>(unit & 0xFF);
+        bytes.push_back(bigEndian ? high : low);
+        bytes.push_back(bigEndian ? low : high);
+    }
+    return bytes;
+}
+
+std::string Latin1ToUtf8(const std::string& bytes) {
+    std::string text;
+    text.reserve(bytes.size() * 2);
+    for (const char ch : bytes) {
+        const auto byte = static_cast<uint8_t>(ch);
+        if (byte < 0x80) {
+            text.push_back(ch);
+        } else {
+            text.push_back(static_cast<char>(0xC0 | (byte >> 6)));
+            text.push_back(static_cast<char>(0x80 | (byte & 0x3F)));
+        }
+    }
+    return text;
+}
+
+} // namespace
+
+bool IniDocument::Load(const std::filesystem::path& path, const LegacyDecoder& legacy) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        Parse(std::string());
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (StartsWith(bytes, "\xFF\xFE", 2)) {
+        Parse(Utf16BytesToUtf8(bytes, 2, false));
+        encoding_ = Encoding::Utf16Le;
+    } else if (StartsWith(bytes, "\xFE\xFF", 2)) {
+        Parse(Utf16BytesToUtf8(bytes, 2, true));
+        encoding_ = Encoding::Utf16Be;
+    } else if (util::IsValidUtf8(bytes.data(), bytes.size())) {
+        Parse(bytes);
+    } else {
+        Parse(legacy ? legacy(bytes) : Latin1ToUtf8(bytes));
+        encoding_ = Encoding::Legacy;
+    }
+    return true;
+}
+
+void IniDocument::Parse(const std::string& text) {
+    sections_.clear();
+    sections_.push_back(Section{});
+    dirty_ = false;
+
+    size_t start = 0;
+    encoding_ = Encoding::Utf8;
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        start = 3;
+        encoding_ = Encoding::Utf8Bom;
+    }
+    const auto firstBreak = text.find('\n', start);
+    newline_ = (firstBreak == std::string::npos || (firstBreak > 0 && text[firstBreak - 1] == '\r')) ? "\r\n" : "\n";
+
+    while (start < text.size()) {
+        auto end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string raw = text.substr(start, end - start);
+        if (!raw.empty() && raw.back() == '\r') {
+            raw.pop_back();
+        }
+        start = end + 1;
+
+        const std::string trimmed = TrimAscii(raw);
+        if (trimmed.size() >= 2 && trimmed.front() == '[' && trimmed.back() == ']') {
+            Section section;
+            section.name = TrimAscii(trimmed.substr(1, trimmed.size() - 2));
+            section.header = raw;
+            sections_.push_back(std::move(section));
+            continue;
+        }
+
+        Line line;
+        line.raw = raw;
+        const auto equals = trimmed.find('=');
+        if (!trimmed.empty() && trimmed[0] != ';' && trimmed[0] != '#' && equals != std::string::npos && equals > 0) {
+            line.isEntry = true;
+            line.key = TrimAscii(trimmed.substr(0, equals));
+            line.value = TrimAscii(trimmed.substr(equals + 1));
+        }
+        sections_.back().lines.push_back(std::move(line));
+    }
+}
+
+std::string IniDocument::Serialize() const {
+    std::string text;
+    for (const auto& section : sections_) {
+        if (!section.header.empty()) {
+            text += section.header;
+            text += newline_;
+        }
+        for (const auto& line : section.lines) {
+            text += line.raw;
+            text += newline_;
+        }
+    }
+    return text;
+}
+
+bool IniDocument::Save(const std::filesystem::path& path) {
+    auto tempPath = path;
+    tempPath += ".tmp" + std::to_string(++g_tempCounter);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        std::string text = Serialize();
+        switch (encoding_) {
+            case Encoding::Utf8:
+                break;
+            case Encoding::Utf8Bom:
+            case Encoding::Legacy:
+                text.insert(0, "\xEF\xBB\xBF");
+                break;
+            case Encoding::Utf16Le:
+            case Encoding::Utf16Be:
+                text = Utf8ToUtf16Bytes(text, encoding_ == Encoding::Utf16Be);
+                break;
+        }
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    if (encoding_ == Encoding::Legacy) {
+        encoding_ = Encoding::Utf8Bom;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool IniDocument::Has(const std::string& section, const std::string& key) const {
+    return Find(section, key) != nullptr;
+}
+
+std::optional<std::string> IniDocument::Get(const std::string& section, const std::string& key) const {
+    const auto* line = Find(section, key);
+    if (!line) {
+        return std::nullopt;
+    }
+    return line->value;
+}
+
+std::string IniDocument::GetString(const std::string& section, const std::string& key, const std::string& fallback) const {
+    const auto* line = Find(section, key);
+    return line ? line->value : fallback;
+}
+
+long long IniDocument::GetInt(const std::string& section, const std::string& key, long long fallback) const {
+    const auto* line = Find(section, key);
+    if (!line) {
+        return fallback;
+    }
+    const auto& value = line->value;
+    size_t i = 0;
+    const bool negative = !value.empty() && value[0] == '-';
+    if (!value.empty() && (value[0] == '-' || value[0] == '+')) {
+        ++i;
+    }
+    if (i >= value.size() || !std::isdigit(static_cast<unsigned char>(value[i]))) {
+        return fallback;
+    }
+    long long result = 0;
+    for (; i < value.size() && std::isdigit(static_cast<unsigned char>(value[i])); ++i) {
+        const int digit = value[i] - '0';
+        if (result > (std::numeric_limits<long long>::max() - digit) / 10) {
+            return fallback;
+        }
+        result = result * 10 + digit;
+    }
+    return negative ? -result : result;
+}
+
+bool IniDocument::GetBool(const std::string& section, const std::string& key, bool fallback) const {
+    return GetInt(section, key, fallback ? 1 : 0) != 0;
+}
+
+void IniDocument::Set(const std::string& section, const std::string& key, const std::string& value) {
+    if (auto* existing = Find(section, key)) {
+        if (existing->value != value) {
+            existing->value = value;
+            existing->raw = existing->key + "=" + value;
+            dirty_ = true;
+        }
+        return;
+    }
+
+    Line line;
+    line.isEntry = true;
+    line.key = key;
+    line.value = value;
+    line.raw = key + "=" + value;
+    auto& target = EnsureSection(section);
+    auto insertAt = target.lines.end();
+    for (auto it = target.lines.begin(); it != target.lines.end(); ++it) {
+        if (it->isEntry) {
+            insertAt = it + 1;
+        }
+    }
+    if (insertAt == target.lines.end()) {
+        // No keys yet: go before any trailing blank lines that separate sections.
+        while (insertAt != target.lines.begin() && TrimAscii((insertAt - 1)->raw).empty()) {
+            --insertAt;
+        }
+    }
+    target.lines.insert(insertAt, std::move(line));
+    dirty_ = true;
+}
+
+void IniDocument::SetInt(const std::string& section, const std::string& key, long long value) {
+    Set(section, key, std::to_string(value));
+}
+
+void IniDocument::SetBool(const std::string& section, const std::string& key, bool value) {
+    Set(section, key, value ? "1" : "0");
+}
+
+const IniDocument::Line* IniDocument::Find(const std::string& section, const std::string& key) const {
+    for (const auto& candidate : sections_) {
+        if (candidate.header.empty() || !EqualsIgnoreCase(candidate.name, section)) {
+            continue;
+        }
+        // Like GetPrivateProfileString, the first match wins.
+        for (const auto& line : candidate.lines) {
+            if (line.isEntry && EqualsIgnoreCase(line.key, key)) {
+                return &line;
+            }
+        }
+    }
+    return nullptr;
+}
+
+IniDocument::Line* IniDocument::Find(const std::string& section, const std::string& key) {
+    return const_cast<Line*>(static_cast<const IniDocument&>(*this).Find(section, key));
+}
+
+IniDocument::Section& IniDocument::EnsureSection(const std::string& section) {
+    for (auto& candidate : sections_) {
+        if (!candidate.header.empty() && EqualsIgnoreCase(candidate.name, section)) {
+            return candidate;
+        }
+    }
+    if (sections_.empty()) {
+        sections_.push_back(Section{});
+    }
+    Section created;
+    created.name = section;
+    created.header = "[" + section + "]";
+    sections_.push_back(std::move(created));
+    return sections_.back();
+}
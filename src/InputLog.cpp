@@ -0,0 +1,322 @@
+#include "InputLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <thread>
+
+namespace {
+
+const char kMagic[8] = { 'C', 'H', 'R', 'N', 'I', 'N', 'P', 'T' };
+
+void PutU16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void PutU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+uint16_t GetU16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t GetU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Hook timestamps are 32-bit milliseconds; unsigned subtraction handles wrap.
+uint64_t OffsetMs(const InputEvent& event, uint32_t firstTime) {
+    return static_cast<uint32_t>(event.time - firstTime);
+}
+
+// Sleeps until `offsetMs` of log time, scaled by `speed`, has passed since `start`.
+void WaitUntil(Clock::time_point start, uint64_t offsetMs, double speed) {
+    if (speed <= 0.0) {
+        return;
+    }
+    const double scaledMs = static_cast<double>(offsetMs) / speed;
+    std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(scaledMs)));
+}
+
+// Timeline for ReplayPaced. Offsets are log milliseconds since the first event;
+// the pacer sees them as nanoseconds.
+class PacedReplay {
+public:
+    PacedReplay(InputProcessor& processor, ScrollPacer& pacer, const inputlog::PacedReplayOptions& options,
+                const inputlog::ReplayHandler& handler, uint32_t firstTime)
+        : processor_(processor),
+          pacer_(pacer),
+          options_(options),
+          handler_(handler),
+          firstTime_(firstTime),
+          tickMs_((std::max)(1u, options.tickMs)),
+          nextTick_(tickMs_),
+          start_(Clock::now()) {}
+
+    void Recorded(const InputEvent& event) {
+        const uint64_t offsetMs = OffsetMs(event, firstTime_);
+        AdvanceTo(offsetMs);
+        WaitUntil(start_, offsetMs, options_.speed);
+        ++stats_.events;
+        if (event.marks & (InputEvent::kHeld | InputEvent::kReinjected)) {
+            return;
+        }
+        if (event.kind == InputEvent::Kind::CaptureDone) {
+            if (options_.captureMs < 0) {
+                Complete(event, offsetMs);
+            }
+            return;
+        }
+        Feed(event, offsetMs);
+    }
+
+    // Keeps the clock running after the last record until no notch is left
+    // waiting on a capture or the timeout.
+    void Drain() {
+        while (!completions_.empty() || (pacer_.HeldCount() > 0 && pacer_.Outstanding() > 0)) {
+            AdvanceTo(completions_.empty() ? nextTick_ : (std::min)(completions_.front(), nextTick_));
+        }
+    }
+
+    const inputlog::ReplayStats& Stats() const { return stats_; }
+
+private:
+    // Runs the completions and timer ticks due by `offsetMs`, completions first on a tie.
+    void AdvanceTo(uint64_t offsetMs) {
+        while (true) {
+            const bool completionDue = !completions_.empty() && completions_.front() <= offsetMs;
+            const bool tickDue = nextTick_ <= offsetMs;
+            if (completionDue && (!tickDue || completions_.front() <= nextTick_)) {
+                const uint64_t at = completions_.front();
+                completions_.pop_front();
+                WaitUntil(start_, at, options_.speed);
+                InputEvent marker;
+                marker.kind = InputEvent::Kind::CaptureDone;
+                marker.time = firstTime_ + static_cast<uint32_t>(at);
+                Complete(marker, at);
+            } else if (tickDue) {
+                const uint64_t at = nextTick_;
+                nextTick_ += tickMs_;
+                WaitUntil(start_, at, options_.speed);
+                int16_t release[ScrollPacer::kMaxHeld];
+                Reinject(release, pacer_.OnTick(at * 1000000, options_.timeoutNs, release, ScrollPacer::kMaxHeld), at);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void Complete(const InputEvent& marker, uint64_t offsetMs) {
+        Emit(marker, InputProcessor::Result{});
+        int16_t release[ScrollPacer::kMaxHeld];
+        Reinject(release, pacer_.OnCaptureCompleted(offsetMs * 1000000, release, ScrollPacer::kMaxHeld), offsetMs);
+    }
+
+    void Reinject(const int16_t* release, size_t count, uint64_t offsetMs) {
+        for (size_t i = 0; i < count; ++i) {
+            InputEvent event;
+            event.kind = InputEvent::Kind::Wheel;
+            event.marks = InputEvent::kReinjected;
+            event.wheelDelta = release[i];
+            event.time = firstTime_ + static_cast<uint32_t>(offsetMs);
+            ++stats_.released;
+            Feed(event, offsetMs);
+        }
+    }
+
+    // One event as the hooks and then the app thread would handle it.
+    void Feed(InputEvent event, uint64_t offsetMs) {
+        if (event.kind == InputEvent::Kind::Wheel && processor_.CaptureMode()) {
+            const bool reinjected = (event.marks & InputEvent::kReinjected) != 0;
+            if (pacer_.OnWheel(event.wheelDelta, reinjected, offsetMs * 1000000) == ScrollPacer::Decision::Hold) {
+                event.marks |= InputEvent::kHeld;
+                ++stats_.held;
+                Emit(event, InputProcessor::Result{});
+                return;
+            }
+        }
+        const auto result = processor_.Process(event);
+        if (result.action) {
+            ++stats_.actions;
+        }
+        if (result.captureRequested) {
+            ++stats_.captureRequests;
+            if (options_.captureMs >= 0) {
+                completions_.push_back(offsetMs + static_cast<uint64_t>(options_.captureMs));
+            }
+        }
+        Emit(event, result);
+
+        if (event.kind == InputEvent::Kind::CaptureMode) {
+            // What the input thread does when capture mode changes.
+            int16_t release[ScrollPacer::kMaxHeld];
+            const size_t count = pacer_.ReleaseAll(offsetMs * 1000000, release, ScrollPacer::kMaxHeld);
+            if (event.flags != 0) {
+                pacer_.SetNotchesPerCapture(processor_.ScrollsPerCapture());
+                pacer_.Reset();
+            }
+            Reinject(release, count, offsetMs);
+        }
+    }
+
+    void Emit(const InputEvent& event, const InputProcessor::Result& result) {
+        if (handler_) {
+            handler_(event, result);
+        }
+    }
+
+    InputProcessor& processor_;
+    ScrollPacer& pacer_;
+    const inputlog::PacedReplayOptions& options_;
+    const inputlog::ReplayHandler& handler_;
+    const uint32_t firstTime_;
+    const uint64_t tickMs_;
+    uint64_t nextTick_;
+    const Clock::time_point start_;
+    // Due offsets of simulated capture completions, in request order.
+    std::deque<uint64_t> completions_;
+    inputlog::ReplayStats stats_;
+};
+
+} // namespace
+
+namespace inputlog {
+
+void EncodeRecord(const InputEvent& event, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(event.kind);
+    out[1] = event.marks;
+    PutU16(out + 2, static_cast<uint16_t>(event.wheelDelta));
+    PutU32(out + 4, event.vkCode);
+    PutU32(out + 8, event.flags);
+    PutU32(out + 12, event.time);
+}
+
+InputEvent DecodeRecord(const uint8_t* in) {
+    InputEvent event;
+    event.kind = static_cast<InputEvent::Kind>(in[0]);
+    event.marks = in[1];
+    event.wheelDelta = static_cast<int16_t>(GetU16(in + 2));
+    event.vkCode = GetU32(in + 4);
+    event.flags = GetU32(in + 8);
+    event.time = GetU32(in + 12);
+    return event;
+}
+
+Writer::~Writer() {
+    Close();
+}
+
+bool Writer::Open(const std::filesystem::path& path) {
+    Close();
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        return false;
+    }
+    uint8_t header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    PutU32(header + 8, kVersion);
+    PutU32(header + 12, static_cast<uint32_t>(kRecordSize));
+    out_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    count_ = 0;
+    return static_cast<bool>(out_);
+}
+
+bool Writer::Append(const InputEvent& event) {
+    if (!out_.is_open()) {
+        return false;
+    }
+    uint8_t record[kRecordSize];
+    EncodeRecord(event, record);
+    out_.write(reinterpret_cast<const char*>(record), sizeof(record));
+    ++count_;
+    return static_cast<bool>(out_);
+}
+
+bool Writer::Flush() {
+    if (!out_.is_open()) {
+        return false;
+    }
+    out_.flush();
+    return static_cast<bool>(out_);
+}
+
+void Writer::Close() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+bool ReadLog(const std::filesystem::path& path, std::vector<InputEvent>& events) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    // Version 1 logs hold the same records with fewer kinds and no marks.
+    const uint32_t version = GetU32(bytes.data() + 8);
+    if (version < 1 || version > kVersion || GetU32(bytes.data() + 12) != kRecordSize) {
+        return false;
+    }
+    const size_t count = (bytes.size() - kHeaderSize) / kRecordSize;
+    events.clear();
+    events.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        events.push_back(DecodeRecord(bytes.data() + kHeaderSize + i * kRecordSize));
+    }
+    return true;
+}
+
+ReplayStats Replay(const std::vector<InputEvent>& events, InputProcessor& processor, double speed, const ReplayHandler& handler) {
+    ReplayStats stats;
+    if (events.empty()) {
+        return stats;
+    }
+    const auto start = Clock::now();
+    const uint32_t firstTime = events.front().time;
+
+    for (const auto& event : events) {
+        WaitUntil(start, OffsetMs(event, firstTime), speed);
+        ++stats.events;
+        if (event.marks & InputEvent::kHeld) {
+            continue;
+        }
+        const auto result = processor.Process(event);
+        if (result.action) {
+            ++stats.actions;
+        }
+        if (result.captureRequested) {
+            ++stats.captureRequests;
+        }
+        if (handler) {
+            handler(event, result);
+        }
+    }
+    return stats;
+}
+
+ReplayStats ReplayPaced(const std::vector<InputEvent>& events, InputProcessor& processor, ScrollPacer& pacer,
+                        const PacedReplayOptions& options, const ReplayHandler& handler) {
+    if (events.empty()) {
+        return ReplayStats{};
+    }
+    PacedReplay replay(processor, pacer, options, handler, events.front().time);
+    for (const auto& event : events) {
+        replay.Recorded(event);
+    }
+    replay.Drain();
+    return replay.Stats();
+}
+
+} // namespace inputlog
@@ -0,0 +1,47 @@
+#include "InputProcessor.h"
+
+void InputProcessor::SetCaptureMode(bool enabled) {
+    captureMode_ = enabled;
+    pendingScrolls_ = 0;
+}
+
+void InputProcessor::SetScrollsPerCapture(uint32_t count) {
+    if (count == 0) {
+        count = 1;
+    }
+    scrollsPerCapture_ = count;
+    pendingScrolls_ = 0;
+}
+
+InputProcessor::Result InputProcessor::Process(const InputEvent& event) {
+    Result result;
+    switch (event.kind) {
+        case InputEvent::Kind::KeyDown:
+            result.action = matcher_.KeyDown(event.vkCode);
+            break;
+        case InputEvent::Kind::KeyUp:
+            matcher_.KeyUp(event.vkCode);
+            break;
+        case InputEvent::Kind::Wheel:
+            if (!captureMode_) {
+                break;
+            }
+            if (event.wheelDelta < 0) {
+                pendingScrolls_ += 1;
+                if (pendingScrolls_ >= scrollsPerCapture_) {
+                    result.captureRequested = true;
+                    result.notches = pendingScrolls_;
+                    pendingScrolls_ = 0;
+                }
+            } else if (event.wheelDelta > 0) {
+                pendingScrolls_ = 0;
+            }
+            break;
+        case InputEvent::Kind::CaptureMode:
+            SetCaptureMode(event.flags != 0);
+            break;
+        default:
+            break;
+    }
+    return result;
+}
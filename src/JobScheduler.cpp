@@ -0,0 +1,308 @@
+#include "JobScheduler.h"
+
+#include <algorithm>
+
+namespace jobs_detail {
+
+struct JobState {
+    uint64_t id = 0;
+    JobFunction work;
+    JobPriority priority = JobPriority::Normal;
+    std::function<void(JobStatus)> onComplete;
+    std::function<void(float)> onProgress;
+    CancellationToken token;
+    JobStatus antecedent = JobStatus::Succeeded;
+    std::atomic<JobStatus> status{ JobStatus::Pending };
+    std::atomic<float> progress{ 0.0f };
+    std::atomic<int> reportedPercent{ -1 };
+
+    // Guards finished and continuations.
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;
+    std::vector<std::shared_ptr<JobState>> continuations;
+};
+
+} // namespace jobs_detail
+
+namespace {
+
+using jobs_detail::JobState;
+
+thread_local const JobScheduler* t_owner = nullptr;
+thread_local size_t t_workerIndex = 0;
+
+// Marks a job that will never run as cancelled, along with everything chained to it.
+void Abandon(const std::shared_ptr<JobState>& state) {
+    std::vector<std::shared_ptr<JobState>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->status = JobStatus::Cancelled;
+        state->finished = true;
+        state->work = nullptr;
+        continuations.swap(state->continuations);
+    }
+    state->done.notify_all();
+    for (const auto& continuation : continuations) {
+        Abandon(continuation);
+    }
+}
+
+} // namespace
+
+CancellationToken::CancellationToken()
+    : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+void CancellationToken::Cancel() const {
+    flag_->store(true, std::memory_order_release);
+}
+
+bool CancellationToken::IsCancelled() const {
+    return flag_->load(std::memory_order_acquire);
+}
+
+JobContext::JobContext(JobScheduler& scheduler, jobs_detail::JobState& state, JobStatus antecedent)
+    : scheduler_(scheduler),
+      state_(state),
+      token_(state.token),
+      antecedent_(antecedent) {}
+
+void JobContext::ReportProgress(float fraction) {
+    fraction = std::clamp(fraction, 0.0f, 1.0f);
+    state_.progress.store(fraction, std::memory_order_relaxed);
+    if (!state_.onProgress) {
+        return;
+    }
+    const int percent = static_cast<int>(fraction * 100.0f);
+    int previous = state_.reportedPercent.load(std::memory_order_relaxed);
+    while (percent > previous) {
+        if (state_.reportedPercent.compare_exchange_weak(previous, percent, std::memory_order_relaxed)) {
+            scheduler_.Dispatch([callback = state_.onProgress, fraction]() { callback(fraction); });
+            return;
+        }
+    }
+}
+
+uint64_t JobHandle::Id() const {
+    return state_ ? state_->id : 0;
+}
+
+JobStatus JobHandle::Status() const {
+    return state_ ? state_->status.load() : JobStatus::Cancelled;
+}
+
+float JobHandle::Progress() const {
+    return state_ ? state_->progress.load(std::memory_order_relaxed) : 0.0f;
+}
+
+bool JobHandle::Active() const {
+    const auto status = Status();
+    return state_ && (status == JobStatus::Pending || status == JobStatus::Running);
+}
+
+void JobHandle::Cancel() const {
+    if (state_) {
+        state_->token.Cancel();
+    }
+}
+
+void JobHandle::Wait() const {
+    if (!state_) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->done.wait(lock, [this]() { return state_->finished; });
+}
+
+JobScheduler::JobScheduler(unsigned threads, Dispatcher dispatcher)
+    : dispatcher_(std::move(dispatcher)) {
+    if (threads == 0) {
+        const unsigned hardware = std::thread::hardware_concurrency();
+        threads = hardware > 1 ? hardware - 1 : 1;
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+JobScheduler::~JobScheduler() {
+    Shutdown();
+}
+
+JobHandle JobScheduler::Submit(JobFunction work, JobOptions options) {
+    auto state = std::make_shared<JobState>();
+    state->id = ++nextId_;
+    state->work = std::move(work);
+    state->priority = options.priority;
+    state->onComplete = std::move(options.onComplete);
+    state->onProgress = std::move(options.onProgress);
+    state->token = options.token;
+    JobHandle handle(state);
+    Enqueue(std::move(state));
+    return handle;
+}
+
+JobHandle JobScheduler::ContinueWith(const JobHandle& parent, JobFunction work, JobOptions options) {
+    if (!parent.Valid()) {
+        return Submit(std::move(work), std::move(options));
+    }
+    auto state = std::make_shared<JobState>();
+    state->id = ++nextId_;
+    state->work = std::move(work);
+    state->priority = options.priority;
+    state->onComplete = std::move(options.onComplete);
+    state->onProgress = std::move(options.onProgress);
+    state->token = options.token;
+    JobHandle handle(state);
+    {
+        std::lock_guard<std::mutex> lock(parent.state_->mutex);
+        if (!parent.state_->finished) {
+            parent.state_->continuations.push_back(std::move(state));
+            return handle;
+        }
+        state->antecedent = parent.state_->status.load();
+    }
+    Enqueue(std::move(state));
+    return handle;
+}
+
+void JobScheduler::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        for (auto& jobs : queue->jobs) {
+            for (const auto& state : jobs) {
+                Abandon(state);
+            }
+            jobs.clear();
+        }
+    }
+}
+
+void JobScheduler::Enqueue(std::shared_ptr<JobState> state) {
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        if (!stopping_ && !queues_.empty()) {
+            // Jobs spawned by a worker stay on that worker's queue, where they are still warm.
+            const size_t index = t_owner == this ? t_workerIndex : nextQueue_++ % queues_.size();
+            auto& queue = *queues_[index];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.jobs[static_cast<size_t>(state->priority)].push_back(state);
+            ++queued_;
+            queued = true;
+        }
+    }
+    if (!queued) {
+        Abandon(state);
+        return;
+    }
+    wake_.notify_one();
+}
+
+std::shared_ptr<JobState> JobScheduler::Dequeue(size_t self) {
+    const size_t count = queues_.size();
+    for (size_t priority = 0; priority < kPriorityCount; ++priority) {
+        {
+            auto& own = *queues_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            auto& jobs = own.jobs[priority];
+            if (!jobs.empty()) {
+                auto state = std::move(jobs.back());
+                jobs.pop_back();
+                return state;
+            }
+        }
+        for (size_t offset = 1; offset < count; ++offset) {
+            auto& victim = *queues_[(self + offset) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto& jobs = victim.jobs[priority];
+            if (!jobs.empty()) {
+                auto state = std::move(jobs.front());
+                jobs.pop_front();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return state;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void JobScheduler::WorkerLoop(size_t index) {
+    t_owner = this;
+    t_workerIndex = index;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait(lock, [this]() { return stopping_ || queued_ > 0; });
+            if (stopping_) {
+                return;
+            }
+        }
+        auto state = Dequeue(index);
+        if (!state) {
+            // Another worker took it between the wake-up and the scan.
+            continue;
+        }
+        --queued_;
+        Run(state);
+    }
+}
+
+void JobScheduler::Run(const std::shared_ptr<JobState>& state) {
+    if (state->token.IsCancelled()) {
+        Complete(state, JobStatus::Cancelled);
+        return;
+    }
+    state->status = JobStatus::Running;
+    JobContext context(*this, *state, state->antecedent);
+    const bool ok = state->work(context);
+    if (state->token.IsCancelled()) {
+        Complete(state, JobStatus::Cancelled);
+    } else {
+        Complete(state, ok ? JobStatus::Succeeded : JobStatus::Failed);
+    }
+}
+
+void JobScheduler::Complete(const std::shared_ptr<JobState>& state, JobStatus status) {
+    std::vector<std::shared_ptr<JobState>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->status = status;
+        state->finished = true;
+        // Drop whatever the job captured as soon as it is done.
+        state->work = nullptr;
+        continuations.swap(state->continuations);
+    }
+    state->done.notify_all();
+    if (state->onComplete) {
+        Dispatch([callback = std::move(state->onComplete), status]() { callback(status); });
+    }
+    for (auto& continuation : continuations) {
+        continuation->antecedent = status;
+        Enqueue(std::move(continuation));
+    }
+}
+
+void JobScheduler::Dispatch(std::function<void()> callback) {
+    if (dispatcher_) {
+        dispatcher_(std::move(callback));
+    } else {
+        callback();
+    }
+}
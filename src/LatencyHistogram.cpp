@@ -0,0 +1,94 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < kLinearBuckets) {
+        return static_cast<size_t>(value);
+    }
+    const int exponent = std::bit_width(value) - 1;
+    const size_t sub = static_cast<size_t>((value >> (exponent - 4)) & (kSubBuckets - 1));
+    return kLinearBuckets + static_cast<size_t>(exponent - 5) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(size_t index) {
+    if (index < kLinearBuckets) {
+        return index;
+    }
+    const size_t exponent = 5 + (index - kLinearBuckets) / kSubBuckets;
+    const uint64_t sub = (index - kLinearBuckets) % kSubBuckets;
+    return (uint64_t{ 1 } << exponent) | (sub << (exponent - 4));
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    if (index < kLinearBuckets) {
+        return index;
+    }
+    const size_t exponent = 5 + (index - kLinearBuckets) / kSubBuckets;
+    return BucketLowerBound(index) + ((uint64_t{ 1 } << (exponent - 4)) - 1);
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current = max_.load(std::memory_order_relaxed);
+    while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = min_.load(std::memory_order_relaxed);
+    while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::ValueAtQuantile(double quantile) const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    quantile = std::clamp(quantile, 0.0, 1.0);
+    const uint64_t rank = (std::max<uint64_t>)(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return (std::min)(BucketUpperBound(i), Max());
+        }
+    }
+    return Max();
+}
+
+LatencyHistogram::Summary LatencyHistogram::Summarize() const {
+    Summary summary;
+    summary.count = Count();
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.min = min_.load(std::memory_order_relaxed);
+    summary.max = Max();
+    summary.mean = sum_.load(std::memory_order_relaxed) / summary.count;
+    summary.p50 = ValueAtQuantile(0.50);
+    summary.p90 = ValueAtQuantile(0.90);
+    summary.p99 = ValueAtQuantile(0.99);
+    summary.p999 = ValueAtQuantile(0.999);
+    return summary;
+}
@@ -0,0 +1,64 @@
+#include "Log.h"
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <windows.h>
+
+#include "Utility.h"
+
+namespace {
+
+std::mutex g_logMutex;
+std::ofstream g_logFile;
+
+const wchar_t* LevelName(logging::Level level) {
+    switch (level) {
+        case logging::Level::Warning:
+            return L"WARN";
+        case logging::Level::Error:
+            return L"ERROR";
+        default:
+            return L"INFO";
+    }
+}
+
+} // namespace
+
+namespace logging {
+
+bool Open(const std::wstring& path) {
+    std::lock_guard<std::mutex> lock(g_logMutex);
+    if (g_logFile.is_open()) {
+        g_logFile.close();
+    }
+    g_logFile.open(std::filesystem::path(path), std::ios::binary | std::ios::app);
+    return g_logFile.is_open();
+}
+
+void Close() {
+    std::lock_guard<std::mutex> lock(g_logMutex);
+    if (g_logFile.is_open()) {
+        g_logFile.close();
+    }
+}
+
+void Write(Level level, const std::wstring& message) {
+    std::wstring line = util::TimestampString();
+    line += L" [";
+    line += LevelName(level);
+    line += L"] ";
+    line += message;
+    line += L"\r\n";
+
+    OutputDebugStringW(line.c_str());
+
+    std::lock_guard<std::mutex> lock(g_logMutex);
+    if (g_logFile.is_open()) {
+        const auto utf8 = util::WideToUtf8(line);
+        g_logFile.write(utf8.data(), static_cast<std::streamsize>(utf8.size()));
+        g_logFile.flush();
+    }
+}
+
+} // namespace logging
@@ -0,0 +1,202 @@
+#include "MemoryAccounting.h"
+
+#include <atomic>
+#include <cwchar>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+struct Counter {
+    std::atomic<size_t> current{ 0 };
+    std::atomic<size_t> peak{ 0 };
+};
+
+std::array<Counter, memory::kTagCount> g_counters;
+
+Counter& CounterFor(memory::Tag tag) {
+    return g_counters[static_cast<size_t>(tag)];
+}
+
+void RaisePeak(std::atomic<size_t>& peak, size_t current) {
+    size_t seen = peak.load(std::memory_order_relaxed);
+    while (current > seen && !peak.compare_exchange_weak(seen, current, std::memory_order_relaxed)) {
+    }
+}
+
+class TaggedResource : public std::pmr::memory_resource {
+public:
+    explicit TaggedResource(memory::Tag tag, memory::Ledger* ledger = nullptr)
+        : tag_(tag), ledger_(ledger) {
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* pointer = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        memory::Add(tag_, bytes);
+        if (ledger_) {
+            ledger_->Add(tag_, bytes);
+        }
+        return pointer;
+    }
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        memory::Subtract(tag_, bytes);
+        if (ledger_) {
+            ledger_->Subtract(tag_, bytes);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    memory::Tag tag_;
+    memory::Ledger* ledger_;
+};
+
+} // namespace
+
+namespace memory {
+
+void Add(Tag tag, size_t bytes) {
+    auto& counter = CounterFor(tag);
+    RaisePeak(counter.peak, counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void Subtract(Tag tag, size_t bytes) {
+    CounterFor(tag).current.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+Usage Get(Tag tag) {
+    const auto& counter = CounterFor(tag);
+    return Usage{ counter.current.load(std::memory_order_relaxed), counter.peak.load(std::memory_order_relaxed) };
+}
+
+Snapshot Take() {
+    Snapshot usage;
+    for (size_t i = 0; i < kTagCount; ++i) {
+        usage[i] = Get(static_cast<Tag>(i));
+    }
+    return usage;
+}
+
+const wchar_t* TagName(Tag tag) {
+    switch (tag) {
+        case Tag::Capture:
+            return L"capture";
+        case Tag::FrameStore:
+            return L"frames";
+        case Tag::Bridge:
+            return L"bridge";
+        case Tag::Clipboard:
+            return L"clipboard";
+    }
+    return L"";
+}
+
+std::wstring FormatSummary(const Snapshot& usage, const wchar_t* heading) {
+    std::wstring summary = heading;
+    wchar_t part[64] = {};
+    for (size_t i = 0; i < kTagCount; ++i) {
+        std::swprintf(part, std::size(part), L"%ls %ls %.0f/%.0f MB", i == 0 ? L"" : L",", TagName(static_cast<Tag>(i)),
+                      usage[i].current / (1024.0 * 1024.0), usage[i].peak / (1024.0 * 1024.0));
+        summary += part;
+    }
+    return summary;
+}
+
+std::pmr::memory_resource* Resource(Tag tag) {
+    static TaggedResource resources[kTagCount] = {
+        TaggedResource(Tag::Capture),
+        TaggedResource(Tag::FrameStore),
+        TaggedResource(Tag::Bridge),
+        TaggedResource(Tag::Clipboard),
+    };
+    return &resources[static_cast<size_t>(tag)];
+}
+
+Ledger::Ledger() {
+    for (size_t i = 0; i < kTagCount; ++i) {
+        resources_[i] = std::make_unique<TaggedResource>(static_cast<Tag>(i), this);
+    }
+}
+
+Ledger::~Ledger() = default;
+
+void Ledger::Add(Tag tag, size_t bytes) {
+    const size_t i = static_cast<size_t>(tag);
+    RaisePeak(peak_[i], current_[i].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void Ledger::Subtract(Tag tag, size_t bytes) {
+    current_[static_cast<size_t>(tag)].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+Usage Ledger::Get(Tag tag) const {
+    const size_t i = static_cast<size_t>(tag);
+    return Usage{ current_[i].load(std::memory_order_relaxed), peak_[i].load(std::memory_order_relaxed) };
+}
+
+Snapshot Ledger::Take() const {
+    Snapshot usage;
+    for (size_t i = 0; i < kTagCount; ++i) {
+        usage[i] = Get(static_cast<Tag>(i));
+    }
+    return usage;
+}
+
+std::shared_ptr<std::pmr::memory_resource> Ledger::Resource(Tag tag) {
+    return std::shared_ptr<std::pmr::memory_resource>(shared_from_this(), resources_[static_cast<size_t>(tag)].get());
+}
+
+Charge::Charge(Tag tag, size_t bytes)
+    : tag_(tag) {
+    Add(bytes);
+}
+
+Charge::Charge(Tag tag, std::shared_ptr<Ledger> ledger, size_t bytes)
+    : tag_(tag), ledger_(std::move(ledger)) {
+    Add(bytes);
+}
+
+Charge::~Charge() {
+    Reset();
+}
+
+Charge::Charge(Charge&& other) noexcept
+    : tag_(other.tag_), ledger_(std::move(other.ledger_)), bytes_(std::exchange(other.bytes_, 0)) {
+}
+
+Charge& Charge::operator=(Charge&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        tag_ = other.tag_;
+        ledger_ = std::move(other.ledger_);
+        bytes_ = std::exchange(other.bytes_, 0);
+    }
+    return *this;
+}
+
+void Charge::Add(size_t bytes) {
+    if (bytes > 0) {
+        memory::Add(tag_, bytes);
+        if (ledger_) {
+            ledger_->Add(tag_, bytes);
+        }
+        bytes_ += bytes;
+    }
+}
+
+void Charge::Reset() {
+    if (bytes_ > 0) {
+        Subtract(tag_, bytes_);
+        if (ledger_) {
+            ledger_->Subtract(tag_, bytes_);
+        }
+        bytes_ = 0;
+    }
+}
+
+} // namespace memory
@@ -0,0 +1,280 @@
+#include "ObjectStore.h"
+
+#include <cstring>
+#include <iterator>
+#include <map>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const char kMagic[8] = { 'C', 'H', 'R', 'N', 'O', 'B', 'J', 'X' };
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kRecordSize = 48;
+
+void PutU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+void PutU64(uint8_t* out, uint64_t value) {
+    PutU32(out, static_cast<uint32_t>(value));
+    PutU32(out + 4, static_cast<uint32_t>(value >> 32));
+}
+
+uint32_t GetU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint64_t GetU64(const uint8_t* in) {
+    return static_cast<uint64_t>(GetU32(in)) | (static_cast<uint64_t>(GetU32(in + 4)) << 32);
+}
+
+void EncodeHeader(uint8_t* out) {
+    std::memset(out, 0, kHeaderSize);
+    std::memcpy(out, kMagic, sizeof(kMagic));
+    PutU32(out + 8, kVersion);
+    PutU32(out + 12, static_cast<uint32_t>(kRecordSize));
+}
+
+void EncodeRecord(const digest::Sha256Digest& sha256, uint64_t size, uint32_t refs, uint8_t* out) {
+    std::memset(out, 0, kRecordSize);
+    std::memcpy(out, sha256.data(), sha256.size());
+    PutU64(out + 32, size);
+    PutU32(out + 40, refs);
+}
+
+bool WriteFile(const fs::path& path, const void* data, size_t size) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+size_t ObjectStore::DigestHash::operator()(const digest::Sha256Digest& sha256) const {
+    // The digest is already uniformly distributed.
+    size_t value = 0;
+    std::memcpy(&value, sha256.data(), sizeof(value));
+    return value;
+}
+
+ObjectStore::~ObjectStore() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.is_open()) {
+        index_.close();
+    }
+}
+
+std::shared_ptr<ObjectStore> ObjectStore::ForDirectory(const fs::path& root, bool* indexLoaded) {
+    static std::mutex registryMutex;
+    static std::map<fs::path, std::weak_ptr<ObjectStore>> registry;
+
+    std::error_code ec;
+    auto key = fs::weakly_canonical(fs::absolute(root, ec), ec);
+    if (ec) {
+        key = root.lexically_normal();
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::erase_if(registry, [](const auto& item) { return item.second.expired(); });
+    if (auto existing = registry[key].lock()) {
+        if (indexLoaded) {
+            *indexLoaded = true;
+        }
+        return existing;
+    }
+    auto store = std::make_shared<ObjectStore>();
+    const bool loaded = store->Open(key);
+    if (indexLoaded) {
+        *indexLoaded = loaded;
+    }
+    registry[key] = store;
+    return store;
+}
+
+bool ObjectStore::Open(const fs::path& root) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.is_open()) {
+        index_.close();
+    }
+    root_ = root;
+    entries_.clear();
+    slots_ = 0;
+
+    std::ifstream in(root_ / "index.bin", std::ios::binary);
+    if (!in) {
+        return true;
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < kHeaderSize || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0 ||
+        GetU32(bytes.data() + 8) != kVersion || GetU32(bytes.data() + 12) != kRecordSize) {
+        // Start a fresh index; untracked objects are simply written again when needed.
+        in.close();
+        std::error_code ec;
+        fs::remove(root_ / "index.bin", ec);
+        return false;
+    }
+    slots_ = (bytes.size() - kHeaderSize) / kRecordSize;
+    for (size_t slot = 0; slot < slots_; ++slot) {
+        const uint8_t* record = bytes.data() + kHeaderSize + slot * kRecordSize;
+        digest::Sha256Digest sha256;
+        std::memcpy(sha256.data(), record, sha256.size());
+        entries_[sha256] = Entry{ GetU64(record + 32), GetU32(record + 40), slot };
+    }
+    return true;
+}
+
+bool ObjectStore::Put(const digest::Sha256Digest& sha256, const void* data, size_t size, const fs::path& target) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (root_.empty() || !EnsureIndex()) {
+        return false;
+    }
+    const auto objectPath = ObjectPath(sha256);
+    std::error_code ec;
+    auto it = entries_.find(sha256);
+    // The index may outlive an object deleted by hand; the file is what counts.
+    const bool stored = it != entries_.end() && fs::exists(objectPath, ec);
+    if (stored) {
+        ++hits_;
+    } else {
+        ++misses_;
+        fs::create_directories(objectPath.parent_path(), ec);
+        // Written under a temporary name so a torn write never looks like an object.
+        const auto temporary = fs::path(objectPath).concat(".tmp");
+        if (!WriteFile(temporary, data, size)) {
+            fs::remove(temporary, ec);
+            return false;
+        }
+        fs::rename(temporary, objectPath, ec);
+        if (ec) {
+            fs::remove(temporary, ec);
+            return false;
+        }
+        if (it == entries_.end()) {
+            it = entries_.emplace(sha256, Entry{ size, 0, slots_++ }).first;
+        }
+    }
+
+    fs::remove(target, ec);
+    fs::create_hard_link(objectPath, target, ec);
+    if (ec && !WriteFile(target, data, size)) {
+        // Volumes without hard links (FAT, network shares) fall back to a copy.
+        return false;
+    }
+    ++it->second.refs;
+    WriteSlot(sha256, it->second);
+    return true;
+}
+
+void ObjectStore::Release(const digest::Sha256Digest& sha256) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(sha256);
+    if (it == entries_.end() || it->second.refs == 0 || !EnsureIndex()) {
+        return;
+    }
+    --it->second.refs;
+    WriteSlot(sha256, it->second);
+}
+
+uint32_t ObjectStore::References(const digest::Sha256Digest& sha256) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(sha256);
+    return it == entries_.end() ? 0 : it->second.refs;
+}
+
+uint64_t ObjectStore::Collect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (root_.empty() || entries_.empty()) {
+        return 0;
+    }
+    uint64_t reclaimed = 0;
+    std::error_code ec;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.refs > 0) {
+            ++it;
+            continue;
+        }
+        if (fs::remove(ObjectPath(it->first), ec)) {
+            reclaimed += it->second.size;
+        }
+        it = entries_.erase(it);
+    }
+
+    // Rewrite the index without the holes, then swap it in. Entries keep their
+    // old slots until the swap has succeeded; otherwise the old index.bin, with
+    // the removed objects' records at zero references, stays authoritative.
+    std::vector<uint8_t> bytes(kHeaderSize + entries_.size() * kRecordSize);
+    EncodeHeader(bytes.data());
+    size_t slot = 0;
+    for (const auto& [sha256, entry] : entries_) {
+        EncodeRecord(sha256, entry.size, entry.refs, bytes.data() + kHeaderSize + slot++ * kRecordSize);
+    }
+    if (index_.is_open()) {
+        index_.close();
+    }
+    const auto indexPath = root_ / "index.bin";
+    const auto temporary = root_ / "index.bin.tmp";
+    if (!WriteFile(temporary, bytes.data(), bytes.size())) {
+        fs::remove(temporary, ec);
+        return reclaimed;
+    }
+    fs::rename(temporary, indexPath, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return reclaimed;
+    }
+    slots_ = 0;
+    for (auto& [sha256, entry] : entries_) {
+        entry.slot = slots_++;
+    }
+    return reclaimed;
+}
+
+ObjectStore::Stats ObjectStore::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.objects = entries_.size();
+    for (const auto& [sha256, entry] : entries_) {
+        stats.bytes += entry.size;
+    }
+    stats.hits = hits_;
+    stats.misses = misses_;
+    return stats;
+}
+
+fs::path ObjectStore::ObjectPath(const digest::Sha256Digest& sha256) const {
+    const auto hex = digest::ToHex(sha256);
+    return root_ / hex.substr(0, 2) / (hex.substr(2) + ".png");
+}
+
+bool ObjectStore::EnsureIndex() {
+    if (index_.is_open()) {
+        return true;
+    }
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+    const auto indexPath = root_ / "index.bin";
+    if (!fs::exists(indexPath, ec)) {
+        uint8_t header[kHeaderSize];
+        EncodeHeader(header);
+        std::ofstream out(indexPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        if (!out) {
+            return false;
+        }
+    }
+    index_.open(indexPath, std::ios::binary | std::ios::in | std::ios::out);
+    return index_.is_open();
+}
+
+bool ObjectStore::WriteSlot(const digest::Sha256Digest& sha256, const Entry& entry) {
+    uint8_t record[kRecordSize];
+    EncodeRecord(sha256, entry.size, entry.refs, record);
+    index_.seekp(static_cast<std::streamoff>(kHeaderSize + entry.slot * kRecordSize));
+    index_.write(reinterpret_cast<const char*>(record), sizeof(record));
+    index_.flush();
+    return static_cast<bool>(index_);
+}
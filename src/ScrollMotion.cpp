@@ -0,0 +1,115 @@
+#include "ScrollMotion.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Per-band tolerance in average intensity units (0..765) for two rows to match.
+constexpr int kRowTolerance = 2;
+// Below this share of matching rows a shift is not trusted.
+constexpr double kMinMatchRatio = 0.6;
+// Minimum number of moving rows that must overlap for an estimate.
+constexpr size_t kMinComparedRows = 16;
+// Pixels sampled per band and row; keeps signature cost independent of width.
+constexpr uint32_t kSamplesPerBand = 64;
+// Moving rows are listed in a stack buffer of this many before the heap is used.
+constexpr size_t kScratchRows = 4096;
+
+bool RowsMatch(const motion::RowSignature& a, const motion::RowSignature& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])) > kRowTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FillRowSignatures(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride, motion::RowSignature* signatures) {
+    if (!pixels || width == 0) {
+        return;
+    }
+    const uint32_t bandWidth = (std::max)(1u, width / static_cast<uint32_t>(motion::kSignatureBands));
+    const uint32_t step = (std::max)(1u, bandWidth / kSamplesPerBand);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * stride;
+        for (size_t band = 0; band < motion::kSignatureBands; ++band) {
+            const uint32_t begin = static_cast<uint32_t>(band) * bandWidth;
+            const uint32_t end = band + 1 == motion::kSignatureBands ? width : (std::min)(width, begin + bandWidth);
+            uint32_t sum = 0;
+            uint32_t samples = 0;
+            for (uint32_t x = begin; x < end; x += step) {
+                const uint8_t* px = row + static_cast<size_t>(x) * 4;
+                sum += static_cast<uint32_t>(px[0]) + px[1] + px[2];
+                ++samples;
+            }
+            signatures[y][band] = static_cast<uint16_t>(samples ? sum / samples : 0);
+        }
+    }
+}
+
+} // namespace
+
+namespace motion {
+
+std::vector<RowSignature> ComputeRowSignatures(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride) {
+    std::vector<RowSignature> signatures(height);
+    FillRowSignatures(pixels, width, height, stride, signatures.data());
+    return signatures;
+}
+
+void ComputeRowSignatures(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t stride,
+                          std::pmr::vector<RowSignature>& signatures) {
+    signatures.assign(height, RowSignature{});
+    FillRowSignatures(pixels, width, height, stride, signatures.data());
+}
+
+ShiftEstimate EstimateShift(std::span<const RowSignature> previous, std::span<const RowSignature> current) {
+    ShiftEstimate estimate;
+    const size_t height = (std::min)(previous.size(), current.size());
+    if (height == 0) {
+        return estimate;
+    }
+
+    uint32_t scratch[kScratchRows];
+    std::pmr::monotonic_buffer_resource rows(scratch, sizeof(scratch));
+    std::pmr::vector<uint32_t> moving(&rows);
+    moving.reserve(height);
+    for (size_t y = 0; y < height; ++y) {
+        if (!RowsMatch(previous[y], current[y])) {
+            moving.push_back(static_cast<uint32_t>(y));
+        }
+    }
+    if (moving.empty()) {
+        estimate.valid = true;
+        estimate.matchRatio = 1.0;
+        return estimate;
+    }
+
+    for (size_t shift = 1; shift + kMinComparedRows <= height; ++shift) {
+        size_t compared = 0;
+        size_t matched = 0;
+        for (auto y : moving) {
+            if (y + shift >= height) {
+                break;
+            }
+            ++compared;
+            if (RowsMatch(previous[y + shift], current[y])) {
+                ++matched;
+            }
+        }
+        if (compared < kMinComparedRows) {
+            break;
+        }
+        const double ratio = static_cast<double>(matched) / static_cast<double>(compared);
+        // Ties go to the larger shift: assuming less overlap never hides a gap.
+        if (ratio >= estimate.matchRatio) {
+            estimate.matchRatio = ratio;
+            estimate.shift = static_cast<uint32_t>(shift);
+        }
+    }
+    estimate.valid = estimate.matchRatio >= kMinMatchRatio;
+    return estimate;
+}
+
+} // namespace motion
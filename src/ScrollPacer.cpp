@@ -0,0 +1,112 @@
+#include "ScrollPacer.h"
+
+#include <algorithm>
+
+void ScrollPacer::Configure(uint32_t notchesPerCapture, uint32_t maxOutstanding) {
+    maxOutstanding_ = (std::max)(1u, maxOutstanding);
+    SetNotchesPerCapture(notchesPerCapture);
+}
+
+void ScrollPacer::SetNotchesPerCapture(uint32_t notches) {
+    notchesPerCapture_ = (std::max)(1u, notches);
+    passedSinceCapture_ = 0;
+}
+
+void ScrollPacer::Reset() {
+    passedSinceCapture_ = 0;
+    outstanding_ = 0;
+    outstandingSince_ = 0;
+    heldHead_ = 0;
+    heldCount_ = 0;
+    heldTotal_.store(0, std::memory_order_relaxed);
+    releasedTotal_.store(0, std::memory_order_relaxed);
+    discardedTotal_.store(0, std::memory_order_relaxed);
+    overflowedTotal_.store(0, std::memory_order_relaxed);
+    maxOutstandingSeen_.store(0, std::memory_order_relaxed);
+    releaseLatency_.Reset();
+}
+
+ScrollPacer::Decision ScrollPacer::OnWheel(int16_t delta, bool reinjected, uint64_t nowNs) {
+    if (delta > 0) {
+        // Scrolling back up: the held downward notches are no longer wanted.
+        discardedTotal_.fetch_add(heldCount_, std::memory_order_relaxed);
+        heldHead_ = 0;
+        heldCount_ = 0;
+        passedSinceCapture_ = 0;
+        return Decision::Pass;
+    }
+    if (delta == 0) {
+        return Decision::Pass;
+    }
+
+    if (!reinjected && (outstanding_ >= maxOutstanding_ || heldCount_ > 0)) {
+        if (heldCount_ < kMaxHeld) {
+            held_[(heldHead_ + heldCount_) % kMaxHeld] = HeldNotch{ delta, nowNs };
+            ++heldCount_;
+            heldTotal_.fetch_add(1, std::memory_order_relaxed);
+            return Decision::Hold;
+        }
+        overflowedTotal_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (++passedSinceCapture_ >= notchesPerCapture_) {
+        passedSinceCapture_ = 0;
+        if (outstanding_ == 0) {
+            outstandingSince_ = nowNs;
+        }
+        ++outstanding_;
+        if (outstanding_ > maxOutstandingSeen_.load(std::memory_order_relaxed)) {
+            maxOutstandingSeen_.store(outstanding_, std::memory_order_relaxed);
+        }
+    }
+    return Decision::Pass;
+}
+
+size_t ScrollPacer::OnCaptureCompleted(uint64_t nowNs, int16_t* release, size_t capacity) {
+    if (outstanding_ > 0) {
+        --outstanding_;
+        outstandingSince_ = nowNs;
+    }
+    if (outstanding_ >= maxOutstanding_) {
+        return 0;
+    }
+    // Release only up to the next capture point; the re-injected notches come
+    // back through OnWheel and trigger that capture themselves.
+    return Release(nowNs, notchesPerCapture_ - passedSinceCapture_, release, capacity);
+}
+
+size_t ScrollPacer::OnTick(uint64_t nowNs, uint64_t timeoutNs, int16_t* release, size_t capacity) {
+    if (outstanding_ == 0 || nowNs - outstandingSince_ < timeoutNs) {
+        return 0;
+    }
+    outstanding_ = 0;
+    return Release(nowNs, notchesPerCapture_ - passedSinceCapture_, release, capacity);
+}
+
+size_t ScrollPacer::ReleaseAll(uint64_t nowNs, int16_t* release, size_t capacity) {
+    outstanding_ = 0;
+    return Release(nowNs, heldCount_, release, capacity);
+}
+
+size_t ScrollPacer::Release(uint64_t nowNs, size_t count, int16_t* release, size_t capacity) {
+    count = (std::min)({ count, heldCount_, capacity });
+    for (size_t i = 0; i < count; ++i) {
+        const auto& notch = held_[heldHead_];
+        release[i] = notch.delta;
+        releaseLatency_.Record(nowNs - notch.heldAt);
+        heldHead_ = (heldHead_ + 1) % kMaxHeld;
+        --heldCount_;
+    }
+    releasedTotal_.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+ScrollPacer::Stats ScrollPacer::Snapshot() const {
+    Stats stats;
+    stats.held = heldTotal_.load(std::memory_order_relaxed);
+    stats.released = releasedTotal_.load(std::memory_order_relaxed);
+    stats.discarded = discardedTotal_.load(std::memory_order_relaxed);
+    stats.overflowed = overflowedTotal_.load(std::memory_order_relaxed);
+    stats.maxOutstanding = maxOutstandingSeen_.load(std::memory_order_relaxed);
+    return stats;
+}
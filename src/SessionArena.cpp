@@ -0,0 +1,79 @@
+#include "SessionArena.h"
+
+#include <memory>
+#include <new>
+
+CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    void* pointer = upstream_->allocate(bytes, alignment);
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    const size_t inUse = bytesInUse_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peakBytes_.load(std::memory_order_relaxed);
+    while (inUse > peak && !peakBytes_.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+    }
+    return pointer;
+}
+
+void CountingResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream_->deallocate(pointer, bytes, alignment);
+    deallocations_.fetch_add(1, std::memory_order_relaxed);
+    bytesInUse_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+SessionArena::SessionArena(size_t chunkBytes, std::pmr::memory_resource* upstream)
+    : counter_(upstream), chunkBytes_(chunkBytes) {
+}
+
+SessionArena::SessionArena(size_t chunkBytes, std::shared_ptr<std::pmr::memory_resource> upstream)
+    : upstreamOwner_(std::move(upstream)), counter_(upstreamOwner_.get()), chunkBytes_(chunkBytes) {
+}
+
+SessionArena::~SessionArena() {
+    // Newest first: a large block's record sits in an older chunk, and a
+    // chunk's record in the chunk itself, so it is read before it goes.
+    for (Block* block = blocks_; block;) {
+        const Block current = *block;
+        counter_.deallocate(current.pointer, current.bytes, current.alignment);
+        block = current.next;
+    }
+}
+
+void* SessionArena::do_allocate(size_t bytes, size_t alignment) {
+    bytesAllocated_ += bytes;
+    if (bytes <= chunkBytes_ / 4) {
+        return Bump(bytes, alignment);
+    }
+    void* record = Bump(sizeof(Block), alignof(Block));
+    void* pointer = counter_.allocate(bytes, alignment);
+    blocks_ = ::new (record) Block{ blocks_, pointer, bytes, alignment };
+    return pointer;
+}
+
+void SessionArena::do_deallocate(void*, size_t, size_t) {
+}
+
+bool SessionArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void* SessionArena::Bump(size_t bytes, size_t alignment) {
+    void* pointer = cursor_;
+    if (!cursor_ || !std::align(alignment, bytes, pointer, remaining_)) {
+        auto* chunk = static_cast<std::byte*>(counter_.allocate(chunkBytes_, alignof(std::max_align_t)));
+        blocks_ = ::new (chunk) Block{ blocks_, chunk, chunkBytes_, alignof(std::max_align_t) };
+        cursor_ = chunk + sizeof(Block);
+        remaining_ = chunkBytes_ - sizeof(Block);
+        pointer = cursor_;
+        std::align(alignment, bytes, pointer, remaining_);
+    }
+    cursor_ = static_cast<std::byte*>(pointer) + bytes;
+    remaining_ -= bytes;
+    return pointer;
+}
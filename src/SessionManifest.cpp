@@ -0,0 +1,195 @@
+#include "SessionManifest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+const char kMagic[8] = { 'C', 'H', 'R', 'N', 'M', 'N', 'F', 'T' };
+
+// Record layout (offsets in bytes):
+//   0 kind  1 flags  2 reserved(2)  4 index  8 capturedAtMs(8)  16 width
+//  20 height  24 roiLeft  28 roiTop  32 shiftRows  36 matchRatio(f32 bits)
+//  40 pngBytes(8)  48 encodeMicros  52 reserved(12)  64 sha256(32)
+// Memory records keep the kind byte and put (current, peak) u64 pairs for
+// each subsystem at 8, 24, 40 and 56.
+constexpr uint8_t kShiftValid = 0x01;
+constexpr uint8_t kShared = 0x02;
+
+void PutU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+void PutU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+}
+
+uint32_t GetU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint64_t GetU64(const uint8_t* in) {
+    return static_cast<uint64_t>(GetU32(in)) | (static_cast<uint64_t>(GetU32(in + 4)) << 32);
+}
+
+} // namespace
+
+namespace manifest {
+
+void EncodeRecord(const FrameRecord& record, uint8_t* out) {
+    std::memset(out, 0, kRecordSize);
+    out[0] = static_cast<uint8_t>(record.kind);
+    if (record.kind == RecordKind::Memory) {
+        for (size_t i = 0; i < kMemoryTags; ++i) {
+            PutU64(out + 8 + i * 16, record.memory[i].current);
+            PutU64(out + 16 + i * 16, record.memory[i].peak);
+        }
+        return;
+    }
+    out[1] = static_cast<uint8_t>((record.shiftValid ? kShiftValid : 0) | (record.shared ? kShared : 0));
+    PutU32(out + 4, record.index);
+    PutU64(out + 8, record.capturedAtMs);
+    PutU32(out + 16, record.width);
+    PutU32(out + 20, record.height);
+    PutU32(out + 24, static_cast<uint32_t>(record.roiLeft));
+    PutU32(out + 28, static_cast<uint32_t>(record.roiTop));
+    PutU32(out + 32, record.shiftRows);
+    uint32_t ratioBits = 0;
+    std::memcpy(&ratioBits, &record.matchRatio, sizeof(ratioBits));
+    PutU32(out + 36, ratioBits);
+    PutU64(out + 40, record.pngBytes);
+    PutU32(out + 48, record.encodeMicros);
+    std::memcpy(out + 64, record.sha256.data(), record.sha256.size());
+}
+
+FrameRecord DecodeRecord(const uint8_t* in) {
+    FrameRecord record;
+    record.kind = static_cast<RecordKind>(in[0]);
+    if (record.kind == RecordKind::Memory) {
+        for (size_t i = 0; i < kMemoryTags; ++i) {
+            record.memory[i].current = GetU64(in + 8 + i * 16);
+            record.memory[i].peak = GetU64(in + 16 + i * 16);
+        }
+        return record;
+    }
+    record.shiftValid = (in[1] & kShiftValid) != 0;
+    record.shared = (in[1] & kShared) != 0;
+    record.index = GetU32(in + 4);
+    record.capturedAtMs = GetU64(in + 8);
+    record.width = GetU32(in + 16);
+    record.height = GetU32(in + 20);
+    record.roiLeft = static_cast<int32_t>(GetU32(in + 24));
+    record.roiTop = static_cast<int32_t>(GetU32(in + 28));
+    record.shiftRows = GetU32(in + 32);
+    const uint32_t ratioBits = GetU32(in + 36);
+    std::memcpy(&record.matchRatio, &ratioBits, sizeof(ratioBits));
+    record.pngBytes = GetU64(in + 40);
+    record.encodeMicros = GetU32(in + 48);
+    std::memcpy(record.sha256.data(), in + 64, record.sha256.size());
+    return record;
+}
+
+bool ValidHeader(const uint8_t* in, size_t size) {
+    return size >= kHeaderSize && std::memcmp(in, kMagic, sizeof(kMagic)) == 0 &&
+           GetU32(in + 8) == kVersion && GetU32(in + 12) == kRecordSize;
+}
+
+Writer::~Writer() {
+    Close();
+}
+
+bool Writer::Open(const std::filesystem::path& path, bool append) {
+    Close();
+    if (append) {
+        std::ifstream in(path, std::ios::binary);
+        uint8_t header[kHeaderSize] = {};
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        if (in.read(reinterpret_cast<char*>(header), sizeof(header)) && !ec && ValidHeader(header, sizeof(header))) {
+            in.close();
+            count_ = (size - kHeaderSize) / kRecordSize;
+            std::filesystem::resize_file(path, kHeaderSize + count_ * kRecordSize, ec);
+            out_.open(path, std::ios::binary | std::ios::app);
+            return !ec && static_cast<bool>(out_);
+        }
+    }
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        return false;
+    }
+    uint8_t header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    PutU32(header + 8, kVersion);
+    PutU32(header + 12, static_cast<uint32_t>(kRecordSize));
+    out_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out_.flush();
+    count_ = 0;
+    return static_cast<bool>(out_);
+}
+
+bool Writer::Append(const FrameRecord& record) {
+    if (!out_.is_open()) {
+        return false;
+    }
+    uint8_t bytes[kRecordSize];
+    EncodeRecord(record, bytes);
+    out_.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    out_.flush();
+    ++count_;
+    return static_cast<bool>(out_);
+}
+
+void Writer::Close() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+bool ReadManifest(const std::filesystem::path& path, std::vector<FrameRecord>& records) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!ValidHeader(bytes.data(), bytes.size())) {
+        return false;
+    }
+    const size_t count = (bytes.size() - kHeaderSize) / kRecordSize;
+    records.clear();
+    records.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        records.push_back(DecodeRecord(bytes.data() + kHeaderSize + i * kRecordSize));
+    }
+    return true;
+}
+
+std::vector<FrameRecord> LiveFrames(const std::vector<FrameRecord>& records) {
+    std::vector<FrameRecord> live;
+    for (const auto& record : records) {
+        const auto existing = std::find_if(live.begin(), live.end(), [&](const FrameRecord& frame) {
+            return frame.index == record.index;
+        });
+        if (record.kind == RecordKind::Drop) {
+            if (existing != live.end()) {
+                live.erase(existing);
+            }
+        } else if (record.kind == RecordKind::Frame) {
+            // A re-shot frame reuses the dropped index; the newest record wins.
+            if (existing != live.end()) {
+                *existing = record;
+            } else {
+                live.push_back(record);
+            }
+        }
+    }
+    std::sort(live.begin(), live.end(), [](const FrameRecord& a, const FrameRecord& b) { return a.index < b.index; });
+    return live;
+}
+
+} // namespace manifest
@@ -0,0 +1,52 @@
+#include "SessionQueue.h"
+
+namespace sessions {
+
+bool CanStartCapture(size_t inFlight, size_t inFlightBytes, size_t maxInFlight, size_t budgetBytes) {
+    // Earlier sessions may still be encoding; only refuse once they hold too much.
+    return inFlight == 0 || (inFlight < maxInFlight && inFlightBytes < budgetBytes);
+}
+
+} // namespace sessions
+
+bool PublishedSets::Publish(const std::wstring& label, DataUrls dataUrls) {
+    if (dataUrls.urls.empty()) {
+        return false;
+    }
+    // Constructed in place so the URLs stay in their arena.
+    Set set{ label, std::move(dataUrls) };
+    for (const auto& dataUrl : set.dataUrls.urls) {
+        set.bytes += dataUrl.size() * sizeof(wchar_t);
+    }
+    set.charge.Add(set.bytes);
+    bytes_ += set.bytes;
+    sets_.push_back(std::move(set));
+    selected_ = sets_.size() - 1;
+    Trim();
+    return true;
+}
+
+void PublishedSets::SetLimits(size_t maxSets, size_t maxBytes) {
+    maxSets_ = maxSets == 0 ? 1 : maxSets;
+    maxBytes_ = maxBytes;
+    Trim();
+}
+
+void PublishedSets::Select(long long delta) {
+    if (sets_.empty()) {
+        return;
+    }
+    const long long last = static_cast<long long>(sets_.size()) - 1;
+    const long long target = static_cast<long long>(selected_) + delta;
+    selected_ = static_cast<size_t>(target < 0 ? 0 : (target > last ? last : target));
+}
+
+void PublishedSets::Trim() {
+    while (sets_.size() > 1 && (sets_.size() > maxSets_ || bytes_ > maxBytes_)) {
+        bytes_ -= sets_.front().bytes;
+        sets_.pop_front();
+        if (selected_ > 0) {
+            --selected_;
+        }
+    }
+}
@@ -0,0 +1,239 @@
+#include "SessionRetention.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr const wchar_t* kManifestFileName = L"session.manifest";
+
+bool IsProtected(const fs::path& path, const std::vector<fs::path>& protectedPaths) {
+    std::error_code ec;
+    for (const auto& candidate : protectedPaths) {
+        if (candidate.empty()) {
+            continue;
+        }
+        if (path.lexically_normal() == candidate.lexically_normal() || fs::equivalent(path, candidate, ec)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Splits "512K" into 512 and 'k'. The suffix is 0 when absent.
+bool SplitNumber(const std::string& text, uint64_t& value, char& suffix) {
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+        ++i;
+    }
+    if (i >= text.size() || !std::isdigit(static_cast<unsigned char>(text[i]))) {
+        return false;
+    }
+    value = 0;
+    for (; i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])); ++i) {
+        value = value * 10 + static_cast<uint64_t>(text[i] - '0');
+    }
+    suffix = 0;
+    if (i < text.size()) {
+        suffix = static_cast<char>(std::tolower(static_cast<unsigned char>(text[i])));
+        ++i;
+    }
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+        ++i;
+    }
+    return i == text.size();
+}
+
+} // namespace
+
+namespace retention {
+
+std::vector<SessionInfo> ScanSessions(const fs::path& root) {
+    std::vector<SessionInfo> sessions;
+    std::error_code ec;
+    for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_directory(ec)) {
+            continue;
+        }
+        SessionInfo info;
+        info.path = it->path();
+        info.modified = fs::last_write_time(info.path, ec);
+        std::error_code walk;
+        for (fs::recursive_directory_iterator file(info.path, walk), fileEnd; !walk && file != fileEnd; file.increment(walk)) {
+            std::error_code entry;
+            if (!file->is_regular_file(entry)) {
+                continue;
+            }
+            info.bytes += file->file_size(entry);
+            const auto written = file->last_write_time(entry);
+            if (!entry && written > info.modified) {
+                info.modified = written;
+            }
+        }
+        sessions.push_back(std::move(info));
+    }
+    return sessions;
+}
+
+std::vector<SessionInfo> SelectForDeletion(std::vector<SessionInfo> sessions, const RetentionPolicy& policy,
+                                           fs::file_time_type now, const std::vector<fs::path>& protectedPaths) {
+    // Oldest first; session folders are named by timestamp, which breaks ties.
+    std::sort(sessions.begin(), sessions.end(), [](const SessionInfo& a, const SessionInfo& b) {
+        return a.modified != b.modified ? a.modified < b.modified : a.path < b.path;
+    });
+
+    uint64_t total = 0;
+    for (const auto& session : sessions) {
+        total += session.bytes;
+    }
+
+    const size_t keepFrom = sessions.size() > policy.keepLastN ? sessions.size() - policy.keepLastN : 0;
+    std::vector<SessionInfo> selected;
+    for (size_t i = 0; i < keepFrom; ++i) {
+        const auto& session = sessions[i];
+        if (IsProtected(session.path, protectedPaths)) {
+            continue;
+        }
+        const bool expired = policy.maxSessionAgeSeconds > 0 &&
+                             now - session.modified > std::chrono::seconds(policy.maxSessionAgeSeconds);
+        const bool overBudget = policy.maxSessionBytes > 0 && total > policy.maxSessionBytes;
+        if (expired || overBudget) {
+            total -= session.bytes;
+            selected.push_back(session);
+        }
+    }
+    return selected;
+}
+
+CollectResult Collect(const std::vector<SessionInfo>& sessions, const std::function<bool()>& cancelled) {
+    CollectResult result;
+    for (const auto& session : sessions) {
+        // Never between the files of one session: a half-deleted session has
+        // lost frames whose object references the caller only releases for
+        // sessions reported removed.
+        if (cancelled && cancelled()) {
+            result.cancelled = true;
+            return result;
+        }
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(session.path, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code entry;
+            if (!it->is_directory(entry)) {
+                files.push_back(it->path());
+            }
+        }
+        // The manifest goes last, and only once everything else is gone, so a
+        // session that could not be fully deleted still lists its shared frames.
+        std::stable_partition(files.begin(), files.end(),
+                              [&session](const fs::path& file) { return file != session.path / kManifestFileName; });
+        bool removedAll = true;
+        for (const auto& file : files) {
+            if (!removedAll && file == session.path / kManifestFileName) {
+                break;
+            }
+            std::error_code entry;
+            // A hard link into the object store frees nothing by itself.
+            uint64_t size = 0;
+            if (fs::hard_link_count(file, entry) <= 1 && !entry) {
+                size = fs::file_size(file, entry);
+                size = entry ? 0 : size;
+            }
+            if (fs::remove(file, entry)) {
+                result.bytesReclaimed += size;
+            } else {
+                removedAll = false;
+                result.ok = false;
+            }
+        }
+        if (!removedAll) {
+            continue;
+        }
+        // Only empty directories are left.
+        fs::remove_all(session.path, ec);
+        if (ec) {
+            result.ok = false;
+        } else {
+            ++result.sessionsRemoved;
+        }
+    }
+    return result;
+}
+
+bool ParseByteSize(const std::string& text, uint64_t& bytes) {
+    uint64_t value = 0;
+    char suffix = 0;
+    if (!SplitNumber(text, value, suffix)) {
+        return false;
+    }
+    switch (suffix) {
+        case 0:
+            bytes = value;
+            return true;
+        case 'k':
+            bytes = value << 10;
+            return true;
+        case 'm':
+            bytes = value << 20;
+            return true;
+        case 'g':
+            bytes = value << 30;
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string FormatByteSize(uint64_t bytes) {
+    const char* suffixes[] = { "G", "M", "K" };
+    const int shifts[] = { 30, 20, 10 };
+    for (int i = 0; i < 3; ++i) {
+        const uint64_t unit = 1ull << shifts[i];
+        if (bytes >= unit && bytes % unit == 0) {
+            return std::to_string(bytes >> shifts[i]) + suffixes[i];
+        }
+    }
+    return std::to_string(bytes);
+}
+
+bool ParseDuration(const std::string& text, int64_t& seconds) {
+    uint64_t value = 0;
+    char suffix = 0;
+    if (!SplitNumber(text, value, suffix)) {
+        return false;
+    }
+    switch (suffix) {
+        case 's':
+            seconds = static_cast<int64_t>(value);
+            return true;
+        case 'm':
+            seconds = static_cast<int64_t>(value) * 60;
+            return true;
+        case 'h':
+            seconds = static_cast<int64_t>(value) * 3600;
+            return true;
+        case 0:
+        case 'd':
+            seconds = static_cast<int64_t>(value) * 86400;
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string FormatDuration(int64_t seconds) {
+    if (seconds % 86400 == 0) {
+        return std::to_string(seconds / 86400) + "d";
+    }
+    if (seconds % 3600 == 0) {
+        return std::to_string(seconds / 3600) + "h";
+    }
+    if (seconds % 60 == 0) {
+        return std::to_string(seconds / 60) + "m";
+    }
+    return std::to_string(seconds) + "s";
+}
+
+} // namespace retention
@@ -0,0 +1,70 @@
+#include "StartupTimeline.h"
+
+#include <algorithm>
+#include <cwchar>
+
+StartupTimeline::StartupTimeline(Clock::time_point origin)
+    : origin_(origin) {
+}
+
+StartupTimeline::Phase::Phase(StartupTimeline& timeline, std::wstring name)
+    : timeline_(timeline),
+      name_(std::move(name)),
+      start_(Clock::now()) {
+}
+
+StartupTimeline::Phase::~Phase() {
+    timeline_.Record(name_, start_, Clock::now());
+}
+
+void StartupTimeline::Record(const std::wstring& name, Clock::time_point start, Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({ name, ToMs(start), ToMs(end), false });
+}
+
+void StartupTimeline::Mark(const std::wstring& name) {
+    const double now = ToMs(Clock::now());
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool marked = std::any_of(entries_.begin(), entries_.end(), [&](const Entry& entry) {
+        return entry.milestone && entry.name == name;
+    });
+    if (!marked) {
+        entries_.push_back({ name, now, now, true });
+    }
+}
+
+std::optional<double> StartupTimeline::MilestoneMs(const std::wstring& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+        if (entry.milestone && entry.name == name) {
+            return entry.startMs;
+        }
+    }
+    return std::nullopt;
+}
+
+std::wstring StartupTimeline::Report() const {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries = entries_;
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.startMs < b.startMs; });
+
+    std::wstring report = L"Startup timeline (ms since launch):";
+    wchar_t line[64] = {};
+    for (const auto& entry : entries) {
+        if (entry.milestone) {
+            std::swprintf(line, std::size(line), L"\n  %9.1f            * ", entry.startMs);
+        } else {
+            std::swprintf(line, std::size(line), L"\n  %9.1f  %8.1f  ", entry.startMs, entry.endMs - entry.startMs);
+        }
+        report += line;
+        report += entry.name;
+    }
+    return report;
+}
+
+double StartupTimeline::ToMs(Clock::time_point time) const {
+    return std::chrono::duration<double, std::milli>(time - origin_).count();
+}
@@ -0,0 +1,231 @@
+#include "Utf.h"
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF_USE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UTF_USE_NEON 1
+#endif
+
+namespace {
+
+constexpr char16_t kReplacement = 0xFFFD;
+
+// Copies the leading run of ASCII bytes as UTF-16, 16 bytes per step. Returns the
+// number of bytes consumed (== units written).
+size_t WidenAscii(const uint8_t* src, size_t length, char16_t* dst, size_t capacity) {
+    const size_t limit = length < capacity ? length : capacity;
+    size_t i = 0;
+#if defined(UTF_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= limit; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(chunk, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(chunk, zero));
+    }
+#elif defined(UTF_USE_NEON)
+    for (; i + 16 <= limit; i += 16) {
+        const uint8x16_t chunk = vld1q_u8(src + i);
+        if (vmaxvq_u8(chunk) >= 0x80) {
+            break;
+        }
+        vst1q_u16(reinterpret_cast<uint16_t*>(dst + i), vmovl_u8(vget_low_u8(chunk)));
+        vst1q_u16(reinterpret_cast<uint16_t*>(dst + i + 8), vmovl_u8(vget_high_u8(chunk)));
+    }
+#endif
+    for (; i < limit && src[i] < 0x80; ++i) {
+        dst[i] = static_cast<char16_t>(src[i]);
+    }
+    return i;
+}
+
+// Narrows the leading run of ASCII units to bytes, 16 units per step.
+size_t NarrowAscii(const char16_t* src, size_t length, uint8_t* dst, size_t capacity) {
+    const size_t limit = length < capacity ? length : capacity;
+    size_t i = 0;
+#if defined(UTF_USE_SSE2)
+    const __m128i highMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= limit; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        const __m128i high = _mm_and_si128(_mm_or_si128(a, b), highMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+    }
+#elif defined(UTF_USE_NEON)
+    for (; i + 16 <= limit; i += 16) {
+        const uint16x8_t a = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i));
+        const uint16x8_t b = vld1q_u16(reinterpret_cast<const uint16_t*>(src + i + 8));
+        if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80) {
+            break;
+        }
+        vst1q_u8(dst + i, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+    }
+#endif
+    for (; i < limit && src[i] < 0x80; ++i) {
+        dst[i] = static_cast<uint8_t>(src[i]);
+    }
+    return i;
+}
+
+// Decodes one non-ASCII sequence starting at src[0]. Follows the Unicode "maximal
+// subpart" rule: an ill-formed prefix is consumed as a single U+FFFD.
+size_t DecodeSequence(const uint8_t* src, size_t available, char32_t& codePoint) {
+    const uint8_t lead = src[0];
+    size_t needed = 0;
+    uint8_t lower = 0x80;
+    uint8_t upper = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        needed = 1;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        needed = 2;
+        codePoint = lead & 0x0F;
+        if (lead == 0xE0) {
+            lower = 0xA0;
+        } else if (lead == 0xED) {
+            upper = 0x9F;
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        needed = 3;
+        codePoint = lead & 0x07;
+        if (lead == 0xF0) {
+            lower = 0x90;
+        } else if (lead == 0xF4) {
+            upper = 0x8F;
+        }
+    } else {
+        codePoint = kReplacement;
+        return 1;
+    }
+
+    for (size_t k = 1; k <= needed; ++k) {
+        if (k >= available) {
+            codePoint = kReplacement;
+            return k;
+        }
+        const uint8_t byte = src[k];
+        const uint8_t low = k == 1 ? lower : 0x80;
+        const uint8_t high = k == 1 ? upper : 0xBF;
+        if (byte < low || byte > high) {
+            codePoint = kReplacement;
+            return k;
+        }
+        codePoint = (codePoint << 6) | (byte & 0x3F);
+    }
+    return needed + 1;
+}
+
+} // namespace
+
+namespace util {
+
+TranscodeResult Utf8ToUtf16(const char* src, size_t length, char16_t* dst, size_t capacity) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(src);
+    TranscodeResult result;
+    size_t& i = result.read;
+    size_t& o = result.written;
+
+    while (i < length) {
+        const size_t run = WidenAscii(bytes + i, length - i, dst + o, capacity - o);
+        i += run;
+        o += run;
+        if (i >= length || o >= capacity) {
+            break;
+        }
+        if (bytes[i] < 0x80) {
+            continue;
+        }
+
+        char32_t codePoint = 0;
+        const size_t consumed = DecodeSequence(bytes + i, length - i, codePoint);
+        if (codePoint >= 0x10000) {
+            if (capacity - o < 2) {
+                break;
+            }
+            const char32_t offset = codePoint - 0x10000;
+            dst[o++] = static_cast<char16_t>(0xD800 + (offset >> 10));
+            dst[o++] = static_cast<char16_t>(0xDC00 + (offset & 0x3FF));
+        } else {
+            dst[o++] = static_cast<char16_t>(codePoint);
+        }
+        i += consumed;
+    }
+    return result;
+}
+
+TranscodeResult Utf16ToUtf8(const char16_t* src, size_t length, char* dst, size_t capacity) {
+    auto* out = reinterpret_cast<uint8_t*>(dst);
+    TranscodeResult result;
+    size_t& i = result.read;
+    size_t& o = result.written;
+
+    while (i < length) {
+        const size_t run = NarrowAscii(src + i, length - i, out + o, capacity - o);
+        i += run;
+        o += run;
+        if (i >= length || o >= capacity) {
+            break;
+        }
+        const char32_t unit = src[i];
+        if (unit < 0x80) {
+            continue;
+        }
+
+        char32_t codePoint = unit;
+        size_t consumed = 1;
+        if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < length && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF) {
+            codePoint = 0x10000 + ((unit - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+            consumed = 2;
+        } else if (unit >= 0xD800 && unit <= 0xDFFF) {
+            codePoint = kReplacement;
+        }
+
+        const size_t needed = codePoint < 0x800 ? 2 : (codePoint < 0x10000 ? 3 : 4);
+        if (capacity - o < needed) {
+            break;
+        }
+        if (needed == 2) {
+            out[o++] = static_cast<uint8_t>(0xC0 | (codePoint >> 6));
+        } else if (needed == 3) {
+            out[o++] = static_cast<uint8_t>(0xE0 | (codePoint >> 12));
+            out[o++] = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+        } else {
+            out[o++] = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+            out[o++] = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+            out[o++] = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+        }
+        out[o++] = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        i += consumed;
+    }
+    return result;
+}
+
+bool IsValidUtf8(const char* src, size_t length) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(src);
+    size_t i = 0;
+    while (i < length) {
+        if (bytes[i] < 0x80) {
+            ++i;
+            continue;
+        }
+        char32_t codePoint = 0;
+        const size_t consumed = DecodeSequence(bytes + i, length - i, codePoint);
+        if (codePoint == kReplacement && !(consumed == 3 && bytes[i] == 0xEF && bytes[i + 1] == 0xBF && bytes[i + 2] == 0xBD)) {
+            return false;
+        }
+        i += consumed;
+    }
+    return true;
+}
+
+} // namespace util
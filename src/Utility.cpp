@@ -1,5 +1,7 @@
 #include "Utility.h"
 
+#include "Utf.h"
+
 #include <algorithm>
 #include <chrono>
 #include <codecvt>
@@ -11,6 +13,31 @@
 #pragma comment(lib, "Shlwapi.lib")
 #pragma comment(lib, "Crypt32.lib")
 
+namespace {
+
+template <typename String>
+bool EncodeBase64(const uint8_t* data, size_t size, std::wstring_view prefix, String& out) {
+    out.clear();
+    if (size == 0) {
+        return false;
+    }
+    DWORD required = 0;
+    if (!CryptBinaryToStringW(data, static_cast<DWORD>(size), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, nullptr, &required)) {
+        return false;
+    }
+    out.resize(prefix.size() + required);
+    std::copy(prefix.begin(), prefix.end(), out.begin());
+    if (!CryptBinaryToStringW(data, static_cast<DWORD>(size), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, out.data() + prefix.size(), &required)) {
+        out.clear();
+        return false;
+    }
+    // The second call reports the length without the terminator.
+    out.resize(prefix.size() + required);
+    return true;
+}
+
+} // namespace
+
 namespace util {
 
 std::wstring Trim(const std::wstring& input) {
@@ -65,16 +92,16 @@ std::wstring TimestampString() {
     return buffer;
 }
 
+static_assert(sizeof(wchar_t) == sizeof(char16_t), "UTF-16 wchar_t expected");
+
 std::wstring Utf8ToWide(const std::string& str) {
     if (str.empty()) {
         return L"";
     }
-    int required = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.size()), nullptr, 0);
-    if (required <= 0) {
-        return L"";
-    }
-    std::wstring result(static_cast<size_t>(required), L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.size()), result.data(), required);
+    // UTF-16 never needs more units than the UTF-8 input has bytes.
+    std::wstring result(MaxUtf16Length(str.size()), L'\0');
+    const auto converted = Utf8ToUtf16(str.data(), str.size(), reinterpret_cast<char16_t*>(result.data()), result.size());
+    result.resize(converted.written);
     return result;
 }
 
@@ -82,12 +109,17 @@ std::string WideToUtf8(const std::wstring& wstr) {
     if (wstr.empty()) {
         return std::string();
     }
-    int required = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), static_cast<int>(wstr.size()), nullptr, 0, nullptr, nullptr);
-    if (required <= 0) {
-        return std::string();
+    // Size for the all-ASCII case first; only grow if a multi-byte code point shows up.
+    const auto* src = reinterpret_cast<const char16_t*>(wstr.data());
+    std::string result(wstr.size(), '\0');
+    auto converted = Utf16ToUtf8(src, wstr.size(), result.data(), result.size());
+    if (converted.read < wstr.size()) {
+        const size_t written = converted.written;
+        result.resize(written + MaxUtf8Length(wstr.size() - converted.read));
+        const auto rest = Utf16ToUtf8(src + converted.read, wstr.size() - converted.read, result.data() + written, result.size() - written);
+        converted.written = written + rest.written;
     }
-    std::string result(static_cast<size_t>(required), '\0');
-    WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), static_cast<int>(wstr.size()), result.data(), required, nullptr, nullptr);
+    result.resize(converted.written);
     return result;
 }
 
@@ -120,23 +152,19 @@ std::vector<std::wstring> Split(const std::wstring& input, wchar_t delimiter) {
 }
 
 std::wstring Base64FromBytes(const std::vector<uint8_t>& data) {
-    if (data.empty()) {
-        return L"";
-    }
-    DWORD required = 0;
-    if (!CryptBinaryToStringW(data.data(), static_cast<DWORD>(data.size()), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, nullptr, &required)) {
-        return L"";
-    }
-    std::wstring result(required, L'\0');
-    if (!CryptBinaryToStringW(data.data(), static_cast<DWORD>(data.size()), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, result.data(), &required)) {
-        return L"";
-    }
-    if (!result.empty() && result.back() == L'\0') {
-        result.pop_back();
-    }
+    return Base64FromBytes(data.data(), data.size());
+}
+
+std::wstring Base64FromBytes(const uint8_t* data, size_t size, std::wstring_view prefix) {
+    std::wstring result;
+    EncodeBase64(data, size, prefix, result);
     return result;
 }
 
+bool Base64FromBytes(const uint8_t* data, size_t size, std::wstring_view prefix, std::pmr::wstring& out) {
+    return EncodeBase64(data, size, prefix, out);
+}
+
 std::vector<uint8_t> Base64ToBytes(const std::wstring& base64) {
     if (base64.empty()) {
         return {};
@@ -1,13 +1,152 @@
 #include "WebProcessor.h"
 
+#include <algorithm>
+#include <chrono>
 #include <sstream>
 
 #include <combaseapi.h>
+#include <shlwapi.h>
+#include <winhttp.h>
 #include <wrl.h>
 #include <wrl/event.h>
 
+#include "Utility.h"
+
+#pragma comment(lib, "Winhttp.lib")
+
 namespace {
 
+const wchar_t kDispatchWindowClass[] = L"ChronosWebProcessorDispatch";
+const wchar_t kSiteUrl[] = L"https://lt900ed.github.io/receipt_factor/";
+const wchar_t kSiteFilter[] = L"https://lt900ed.github.io/receipt_factor/*";
+const UINT kAssetResolvedMessage = WM_APP + 1;
+
+int64_t UnixNow() {
+    using namespace std::chrono;
+    return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+}
+
+class InternetHandle {
+public:
+    explicit InternetHandle(HINTERNET handle = nullptr) : handle_(handle) {}
+    ~InternetHandle() {
+        if (handle_) {
+            WinHttpCloseHandle(handle_);
+        }
+    }
+    InternetHandle(const InternetHandle&) = delete;
+    InternetHandle& operator=(const InternetHandle&) = delete;
+
+    HINTERNET Get() const { return handle_; }
+
+private:
+    HINTERNET handle_ = nullptr;
+};
+
+std::string QueryHeader(HINTERNET request, DWORD infoLevel) {
+    DWORD size = 0;
+    WinHttpQueryHeaders(request, infoLevel, WINHTTP_HEADER_NAME_BY_INDEX, WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || size == 0) {
+        return std::string();
+    }
+    std::wstring value(size / sizeof(wchar_t), L'\0');
+    if (!WinHttpQueryHeaders(request, infoLevel, WINHTTP_HEADER_NAME_BY_INDEX, value.data(), &size, WINHTTP_NO_HEADER_INDEX)) {
+        return std::string();
+    }
+    value.resize(size / sizeof(wchar_t));
+    return util::WideToUtf8(value);
+}
+
+// Synchronous WinHTTP transport for AssetCache. Runs on scheduler workers only.
+class WinHttpFetcher : public AssetFetcher {
+public:
+    WinHttpFetcher()
+        : session_(WinHttpOpen(L"ChronosCamera/1.0", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0)) {
+        if (session_.Get()) {
+            WinHttpSetTimeouts(session_.Get(), 5000, 5000, 10000, 15000);
+        }
+    }
+
+    bool Fetch(const AssetRequest& request, AssetResponse& response) override {
+        if (!session_.Get()) {
+            return false;
+        }
+        const std::wstring url = util::Utf8ToWide(request.url);
+        URL_COMPONENTS parts = {};
+        parts.dwStructSize = sizeof(parts);
+        parts.dwHostNameLength = static_cast<DWORD>(-1);
+        parts.dwUrlPathLength = static_cast<DWORD>(-1);
+        parts.dwExtraInfoLength = static_cast<DWORD>(-1);
+        if (!WinHttpCrackUrl(url.c_str(), static_cast<DWORD>(url.size()), 0, &parts)) {
+            return false;
+        }
+        const std::wstring host(parts.lpszHostName, parts.dwHostNameLength);
+        std::wstring path(parts.lpszUrlPath, parts.dwUrlPathLength);
+        if (parts.lpszExtraInfo) {
+            path.append(parts.lpszExtraInfo, parts.dwExtraInfoLength);
+        }
+
+        InternetHandle connection(WinHttpConnect(session_.Get(), host.c_str(), parts.nPort, 0));
+        if (!connection.Get()) {
+            return false;
+        }
+        const DWORD flags = parts.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0;
+        InternetHandle httpRequest(WinHttpOpenRequest(connection.Get(), L"GET", path.c_str(), nullptr, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags));
+        if (!httpRequest.Get()) {
+            return false;
+        }
+
+        std::wstring headers;
+        if (!request.ifNoneMatch.empty()) {
+            headers += L"If-None-Match: " + util::Utf8ToWide(request.ifNoneMatch) + L"\r\n";
+        }
+        if (!request.ifModifiedSince.empty()) {
+            headers += L"If-Modified-Since: " + util::Utf8ToWide(request.ifModifiedSince) + L"\r\n";
+        }
+        const BOOL sent = WinHttpSendRequest(httpRequest.Get(),
+                                             headers.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : headers.c_str(),
+                                             headers.empty() ? 0 : static_cast<DWORD>(-1L),
+                                             WINHTTP_NO_REQUEST_DATA, 0, 0, 0);
+        if (!sent || !WinHttpReceiveResponse(httpRequest.Get(), nullptr)) {
+            return false;
+        }
+
+        DWORD status = 0;
+        DWORD statusSize = sizeof(status);
+        if (!WinHttpQueryHeaders(httpRequest.Get(), WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                 WINHTTP_HEADER_NAME_BY_INDEX, &status, &statusSize, WINHTTP_NO_HEADER_INDEX)) {
+            return false;
+        }
+        response.status = static_cast<int>(status);
+        response.etag = QueryHeader(httpRequest.Get(), WINHTTP_QUERY_ETAG);
+        response.lastModified = QueryHeader(httpRequest.Get(), WINHTTP_QUERY_LAST_MODIFIED);
+        response.contentType = QueryHeader(httpRequest.Get(), WINHTTP_QUERY_CONTENT_TYPE);
+        response.cacheControl = QueryHeader(httpRequest.Get(), WINHTTP_QUERY_CACHE_CONTROL);
+        response.body.clear();
+
+        while (true) {
+            DWORD available = 0;
+            if (!WinHttpQueryDataAvailable(httpRequest.Get(), &available)) {
+                return false;
+            }
+            if (available == 0) {
+                break;
+            }
+            const size_t offset = response.body.size();
+            response.body.resize(offset + available);
+            DWORD read = 0;
+            if (!WinHttpReadData(httpRequest.Get(), response.body.data() + offset, available, &read)) {
+                return false;
+            }
+            response.body.resize(offset + read);
+        }
+        return true;
+    }
+
+private:
+    InternetHandle session_;
+};
+
 std::wstring DecodeJsonString(const std::wstring& json) {
     size_t start = 0;
     size_t end = json.size();
@@ -69,12 +208,33 @@ std::wstring DecodeJsonString(const std::wstring& json) {
 } // namespace
 
 WebProcessor::WebProcessor() = default;
-WebProcessor::~WebProcessor() = default;
 
-bool WebProcessor::Initialize(HWND parentWindow) {
-    parentWindow_ = parentWindow;
-    bridgeReady_ = false;
+WebProcessor::~WebProcessor() {
+    // Jobs still queued never run. Results already posted own a heap payload
+    // that DestroyWindow would flush from the queue unfreed, so they are
+    // drained first; a job still running after that posts to a window that is
+    // gone, and keeps (and frees) its result when PostMessageW fails.
+    // Outstanding requests fall back to WebView2's own handling.
+    assetJobs_.Cancel();
+    for (auto& [id, pending] : pendingAssets_) {
+        pending.deferral->Complete();
+    }
+    pendingAssets_.clear();
+    if (dispatchWindow_) {
+        MSG message = {};
+        while (PeekMessageW(&message, dispatchWindow_, kAssetResolvedMessage, kAssetResolvedMessage, PM_REMOVE)) {
+            delete reinterpret_cast<AssetCache::Result*>(message.lParam);
+        }
+        DestroyWindow(dispatchWindow_);
+        dispatchWindow_ = nullptr;
+    }
+}
 
+bool WebProcessor::Prepare() {
+    if (environmentRequested_) {
+        return true;
+    }
+    environmentRequested_ = true;
     auto environmentHandler = Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
         [this](HRESULT result, ICoreWebView2Environment* environment) -> HRESULT {
             if (FAILED(result)) {
@@ -86,153 +246,201 @@ bool WebProcessor::Initialize(HWND parentWindow) {
                 return result;
             }
             environment_ = environment;
+            Milestone(L"WebView2 environment ready");
+            // Before the window exists, Initialize() creates the controller instead.
+            if (parentWindow_) {
+                CreateController();
+            }
+            return S_OK;
+        });
 
-            auto controllerHandler = Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
-                [this](HRESULT result, ICoreWebView2Controller* controller) -> HRESULT {
-                    if (FAILED(result)) {
-                        if (errorCallback_) {
-                            std::wstringstream ss;
-                            ss << L"WebView2 controller creation failed (0x" << std::hex << result << L")";
-                            errorCallback_(ss.str());
-                        }
-                        return result;
+    const HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(nullptr, nullptr, nullptr, environmentHandler.Get());
+    if (FAILED(hr)) {
+        environmentRequested_ = false;
+        if (errorCallback_) {
+            std::wstringstream ss;
+            ss << L"CreateCoreWebView2EnvironmentWithOptions failed (0x" << std::hex << hr << L")";
+            errorCallback_(ss.str());
+        }
+        return false;
+    }
+    return true;
+}
+
+bool WebProcessor::Initialize(HWND parentWindow) {
+    parentWindow_ = parentWindow;
+    bridgeReady_ = false;
+
+    if (jobs_ && !assetCacheDirectory_.empty() && CreateDispatchWindow()) {
+        auto cache = std::make_shared<AssetCache>(assetCacheDirectory_);
+        if (cache->Open()) {
+            assetCache_ = std::move(cache);
+        }
+    }
+
+    if (environment_) {
+        CreateController();
+        return true;
+    }
+    return Prepare();
+}
+
+void WebProcessor::CreateController() {
+    auto controllerHandler = Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
+        [this](HRESULT result, ICoreWebView2Controller* controller) -> HRESULT {
+            if (FAILED(result)) {
+                if (errorCallback_) {
+                    std::wstringstream ss;
+                    ss << L"WebView2 controller creation failed (0x" << std::hex << result << L")";
+                    errorCallback_(ss.str());
+                }
+                return result;
+            }
+            controller_ = controller;
+            controller_->get_CoreWebView2(&webView_);
+            Milestone(L"WebView2 controller ready");
+            if (hasPendingBounds_) {
+                controller_->put_Bounds(pendingBounds_);
+            } else {
+                RECT bounds = {};
+                GetClientRect(parentWindow_, &bounds);
+                controller_->put_Bounds(bounds);
+            }
+
+            SetupEventHandlers();
+
+            const std::wstring script = LR"JS((() => {
+                const pending = new Map();
+                let requestId = 0;
+                const requestTimeout = 4000;
+
+                const ensureBannerElement = () => {
+                    let element = document.getElementById('nativeClipboardStatus');
+                    if (!element) {
+                        element = document.createElement('div');
+                        element.id = 'nativeClipboardStatus';
+                        element.style.position = 'fixed';
+                        element.style.bottom = '16px';
+                        element.style.right = '16px';
+                        element.style.padding = '8px 12px';
+                        element.style.background = 'rgba(30, 32, 36, 0.85)';
+                        element.style.color = '#fff';
+                        element.style.fontSize = '14px';
+                        element.style.borderRadius = '4px';
+                        element.style.zIndex = '9999';
+                        element.style.boxShadow = '0 2px 6px rgba(0,0,0,0.25)';
+                        const makeButton = (text, delta) => {
+                            const button = document.createElement('button');
+                            button.textContent = text;
+                            button.style.margin = '0 4px';
+                            button.addEventListener('click', () => {
+                                window.chrome.webview.postMessage('clipboardPage|' + delta);
+                            });
+                            return button;
+                        };
+                        const label = document.createElement('span');
+                        label.textContent = 'Captured images not ready.';
+                        element.appendChild(makeButton('<', -1));
+                        element.appendChild(label);
+                        element.appendChild(makeButton('>', 1));
+                        document.body.appendChild(element);
                     }
-                    controller_ = controller;
-                    controller_->get_CoreWebView2(&webView_);
-                    if (hasPendingBounds_) {
-                        controller_->put_Bounds(pendingBounds_);
+                    return element;
+                };
+
+                const updateBanner = (count, page, pages, name) => {
+                    const element = ensureBannerElement();
+                    const label = element.querySelector('span');
+                    for (const button of element.querySelectorAll('button')) {
+                        button.style.display = pages > 1 ? 'inline' : 'none';
+                    }
+                    if (count && count > 0) {
+                        let text = 'Captured images ready: ' + count;
+                        if (pages > 1) {
+                            text += ' (set ' + page + '/' + pages + (name ? ', ' + name : '') + ')';
+                        }
+                        label.textContent = text;
+                        element.style.opacity = '1';
                     } else {
-                        RECT bounds = {};
-                        GetClientRect(parentWindow_, &bounds);
-                        controller_->put_Bounds(bounds);
+                        label.textContent = 'Captured images not ready.';
+                        element.style.opacity = '0.6';
                     }
+                };
 
-                    SetupEventHandlers();
-
-                    const std::wstring script = LR"JS((() => {
-                        const pending = new Map();
-                        let requestId = 0;
-                        const requestTimeout = 4000;
-
-                        const ensureBannerElement = () => {
-                            let element = document.getElementById('nativeClipboardStatus');
-                            if (!element) {
-                                element = document.createElement('div');
-                                element.id = 'nativeClipboardStatus';
-                                element.style.position = 'fixed';
-                                element.style.bottom = '16px';
-                                element.style.right = '16px';
-                                element.style.padding = '8px 12px';
-                                element.style.background = 'rgba(30, 32, 36, 0.85)';
-                                element.style.color = '#fff';
-                                element.style.fontSize = '14px';
-                                element.style.borderRadius = '4px';
-                                element.style.zIndex = '9999';
-                                element.style.pointerEvents = 'none';
-                                element.style.boxShadow = '0 2px 6px rgba(0,0,0,0.25)';
-                                element.textContent = 'Captured images not ready.';
-                                document.body.appendChild(element);
-                            }
-                            return element;
-                        };
+                const requestNativeClipboard = () => new Promise((resolve) => {
+                    const id = String(++requestId);
+                    pending.set(id, resolve);
+                    window.chrome.webview.postMessage('clipboardRequest|' + id);
+                    setTimeout(() => {
+                        if (pending.has(id)) {
+                            pending.delete(id);
+                            resolve([]);
+                        }
+                    }, requestTimeout);
+                });
 
-                        const updateBanner = (count) => {
-                            const element = ensureBannerElement();
-                            if (count && count > 0) {
-                                element.textContent = 'Captured images ready: ' + count;
-                                element.style.opacity = '1';
-                            } else {
-                                element.textContent = 'Captured images not ready.';
-                                element.style.opacity = '0.6';
+                window.chrome.webview.addEventListener('message', async (event) => {
+                    const data = String(event.data);
+                    if (data.startsWith('clipboardResponse|')) {
+                        const parts = data.split('|');
+                        const id = parts[1] || '';
+                        const resolver = pending.get(id);
+                        if (!resolver) {
+                            return;
+                        }
+                        pending.delete(id);
+                        const count = parseInt(parts[2] || '0', 10);
+                        const items = [];
+                        for (let i = 0; i < count; ++i) {
+                            const dataUrl = parts[3 + i];
+                            if (!dataUrl) {
+                                continue;
                             }
-                        };
-
-                        const requestNativeClipboard = () => new Promise((resolve) => {
-                            const id = String(++requestId);
-                            pending.set(id, resolve);
-                            window.chrome.webview.postMessage('clipboardRequest|' + id);
-                            setTimeout(() => {
-                                if (pending.has(id)) {
-                                    pending.delete(id);
-                                    resolve([]);
-                                }
-                            }, requestTimeout);
-                        });
-
-                        window.chrome.webview.addEventListener('message', async (event) => {
-                            const data = String(event.data);
-                            if (data.startsWith('clipboardResponse|')) {
-                                const parts = data.split('|');
-                                const id = parts[1] || '';
-                                const resolver = pending.get(id);
-                                if (!resolver) {
-                                    return;
-                                }
-                                pending.delete(id);
-                                const count = parseInt(parts[2] || '0', 10);
-                                const items = [];
-                                for (let i = 0; i < count; ++i) {
-                                    const dataUrl = parts[3 + i];
-                                    if (!dataUrl) {
-                                        continue;
+                            const item = {
+                                types: ['image/png'],
+                                getType: async (type) => {
+                                    if (type !== 'image/png') {
+                                        throw new Error('Unsupported type');
                                     }
-                                    const item = {
-                                        types: ['image/png'],
-                                        getType: async (type) => {
-                                            if (type !== 'image/png') {
-                                                throw new Error('Unsupported type');
-                                            }
-                                            const response = await fetch(dataUrl);
-                                            return await response.blob();
-                                        }
-                                    };
-                                    items.push(item);
-                                }
-                                resolver(items);
-                            } else if (data.startsWith('clipboardInventory|')) {
-                                const count = parseInt(data.split('|')[1] || '0', 10);
-                                updateBanner(count);
-                            }
-                        });
-
-                        const originalRead = navigator.clipboard && navigator.clipboard.read ? navigator.clipboard.read.bind(navigator.clipboard) : null;
-
-                        if (navigator.clipboard) {
-                            navigator.clipboard.read = async () => {
-                                const nativeItems = await requestNativeClipboard();
-                                if (nativeItems && nativeItems.length) {
-                                    return nativeItems;
-                                }
-                                if (originalRead) {
-                                    return originalRead();
+                                    const response = await fetch(dataUrl);
+                                    return await response.blob();
                                 }
-                                return [];
                             };
+                            items.push(item);
                         }
+                        resolver(items);
+                    } else if (data.startsWith('clipboardInventory|')) {
+                        const parts = data.split('|');
+                        updateBanner(parseInt(parts[1] || '0', 10), parseInt(parts[2] || '0', 10),
+                                     parseInt(parts[3] || '0', 10), parts[4] || '');
+                    }
+                });
 
-                        updateBanner(0);
-                        window.chrome.webview.postMessage('bridgeReady');
-                    })();)JS";
+                const originalRead = navigator.clipboard && navigator.clipboard.read ? navigator.clipboard.read.bind(navigator.clipboard) : null;
 
-                    webView_->AddScriptToExecuteOnDocumentCreated(script.c_str(), nullptr);
-                    webView_->Navigate(L"https://lt900ed.github.io/receipt_factor/");
-                    return S_OK;
-                });
+                if (navigator.clipboard) {
+                    navigator.clipboard.read = async () => {
+                        const nativeItems = await requestNativeClipboard();
+                        if (nativeItems && nativeItems.length) {
+                            return nativeItems;
+                        }
+                        if (originalRead) {
+                            return originalRead();
+                        }
+                        return [];
+                    };
+                }
+
+                updateBanner(0, 0, 0, '');
+                window.chrome.webview.postMessage('bridgeReady');
+            })();)JS";
 
-            environment_->CreateCoreWebView2Controller(parentWindow_, controllerHandler.Get());
+            webView_->AddScriptToExecuteOnDocumentCreated(script.c_str(), nullptr);
+            webView_->Navigate(kSiteUrl);
             return S_OK;
         });
 
-    const HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(nullptr, nullptr, nullptr, environmentHandler.Get());
-    if (FAILED(hr)) {
-        if (errorCallback_) {
-            std::wstringstream ss;
-            ss << L"CreateCoreWebView2EnvironmentWithOptions failed (0x" << std::hex << hr << L")";
-            errorCallback_(ss.str());
-        }
-        return false;
-    }
-    return true;
+    environment_->CreateCoreWebView2Controller(parentWindow_, controllerHandler.Get());
 }
 
 void WebProcessor::Resize(const RECT& bounds) {
@@ -243,8 +451,22 @@ void WebProcessor::Resize(const RECT& bounds) {
     }
 }
 
-void WebProcessor::UpdateClipboardImages(const std::vector<std::wstring>& dataUrls) {
-    clipboardImages_ = dataUrls;
+void WebProcessor::PublishImages(const std::wstring& label, DataUrls dataUrls) {
+    if (publishedSets_.Publish(label, std::move(dataUrls))) {
+        NotifyClipboardInventory();
+    }
+}
+
+void WebProcessor::SetPublishLimits(size_t maxSets, size_t maxBytes) {
+    publishedSets_.SetLimits(maxSets, maxBytes);
+    NotifyClipboardInventory();
+}
+
+void WebProcessor::SelectPage(long long delta) {
+    if (publishedSets_.Empty()) {
+        return;
+    }
+    publishedSets_.Select(delta);
     NotifyClipboardInventory();
 }
 
@@ -263,6 +485,148 @@ void WebProcessor::SetupEventHandlers() {
             }
             return S_OK;
         }).Get(), nullptr);
+
+    if (assetCache_) {
+        webView_->AddWebResourceRequestedFilter(kSiteFilter, COREWEBVIEW2_WEB_RESOURCE_CONTEXT_ALL);
+        webView_->add_WebResourceRequested(Microsoft::WRL::Callback<ICoreWebView2WebResourceRequestedEventHandler>(
+            [this](ICoreWebView2*, ICoreWebView2WebResourceRequestedEventArgs* args) -> HRESULT {
+                HandleAssetRequest(args);
+                return S_OK;
+            }).Get(), nullptr);
+    }
+}
+
+bool WebProcessor::CreateDispatchWindow() {
+    if (dispatchWindow_) {
+        return true;
+    }
+    const HINSTANCE instance = GetModuleHandleW(nullptr);
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = &WebProcessor::DispatchWindowProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = kDispatchWindowClass;
+    if (!RegisterClassW(&wc) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+        return false;
+    }
+    dispatchWindow_ = CreateWindowExW(0, kDispatchWindowClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, instance, nullptr);
+    if (!dispatchWindow_) {
+        return false;
+    }
+    SetWindowLongPtrW(dispatchWindow_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+    return true;
+}
+
+void WebProcessor::HandleAssetRequest(ICoreWebView2WebResourceRequestedEventArgs* args) {
+    Microsoft::WRL::ComPtr<ICoreWebView2WebResourceRequest> request;
+    if (FAILED(args->get_Request(&request))) {
+        return;
+    }
+    LPWSTR method = nullptr;
+    LPWSTR uri = nullptr;
+    if (FAILED(request->get_Method(&method)) || FAILED(request->get_Uri(&uri))) {
+        CoTaskMemFree(method);
+        return;
+    }
+    const bool isGet = method && _wcsicmp(method, L"GET") == 0;
+    const std::string url = util::WideToUtf8(uri ? uri : L"");
+    CoTaskMemFree(method);
+    CoTaskMemFree(uri);
+    if (!isGet || url.empty()) {
+        return;
+    }
+
+    PendingAsset pending;
+    pending.args = args;
+    if (FAILED(args->GetDeferral(&pending.deferral))) {
+        return;
+    }
+    const uint64_t id = ++nextAssetRequestId_;
+    pendingAssets_.emplace(id, std::move(pending));
+
+    // Disk reads and network fetches stay off the UI thread, behind capture
+    // work; the WebView2 objects are only touched again once the result is
+    // marshaled back to dispatchWindow_.
+    JobOptions options;
+    options.priority = JobPriority::Low;
+    options.token = assetJobs_;
+    jobs_->Submit([cache = assetCache_, target = dispatchWindow_, url, id](JobContext& context) {
+        WinHttpFetcher fetcher;
+        auto result = std::make_unique<AssetCache::Result>(cache->Resolve(url, fetcher, UnixNow()));
+        const bool revalidate = result->needsRevalidation;
+        if (context.IsCancelled()) {
+            return false;
+        }
+        if (PostMessageW(target, kAssetResolvedMessage, static_cast<WPARAM>(id), reinterpret_cast<LPARAM>(result.get()))) {
+            result.release();
+        }
+        if (revalidate && !context.IsCancelled()) {
+            cache->Revalidate(url, fetcher, UnixNow());
+        }
+        return true;
+    }, std::move(options));
+}
+
+void WebProcessor::CompleteAssetRequest(uint64_t id, std::unique_ptr<AssetCache::Result> result) {
+    auto it = pendingAssets_.find(id);
+    if (it == pendingAssets_.end()) {
+        return;
+    }
+    PendingAsset pending = std::move(it->second);
+    pendingAssets_.erase(it);
+
+    // Anything short of a complete response (miss, failed fetch, stream or
+    // response creation failing) releases the request untouched, and WebView2
+    // goes to the network itself.
+    if (result && result->source != AssetCache::Source::Miss && environment_) {
+        ServeAsset(pending.args.Get(), *result);
+    }
+    pending.deferral->Complete();
+}
+
+bool WebProcessor::ServeAsset(ICoreWebView2WebResourceRequestedEventArgs* args, const AssetCache::Result& result) const {
+    const CachedAsset& asset = result.asset;
+    std::wstring headers;
+    const auto addHeader = [&headers](const wchar_t* name, const std::string& value) {
+        if (value.empty()) {
+            return;
+        }
+        if (!headers.empty()) {
+            headers += L"\r\n";
+        }
+        headers += name;
+        headers += L": ";
+        headers += util::Utf8ToWide(value);
+    };
+    addHeader(L"Content-Type", asset.contentType);
+    addHeader(L"ETag", asset.etag);
+    addHeader(L"Last-Modified", asset.lastModified);
+    // What is left of the stored lifetime, so WebView2's own cache does not
+    // hold the asset past the point this cache would revalidate it.
+    const int64_t age = UnixNow() - asset.storedAt;
+    const int64_t remaining = result.needsRevalidation || age < 0 ? 0 : (std::max<int64_t>)(0, asset.maxAge - age);
+    addHeader(L"Cache-Control", remaining > 0 ? "max-age=" + std::to_string(remaining) : std::string("no-cache"));
+
+    IStream* stream = SHCreateMemStream(result.body.data(), static_cast<UINT>(result.body.size()));
+    if (!stream) {
+        return false;
+    }
+    Microsoft::WRL::ComPtr<ICoreWebView2WebResourceResponse> response;
+    const bool served = SUCCEEDED(environment_->CreateWebResourceResponse(stream, 200, L"OK", headers.c_str(), &response)) &&
+        SUCCEEDED(args->put_Response(response.Get()));
+    stream->Release();
+    return served;
+}
+
+LRESULT CALLBACK WebProcessor::DispatchWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
+    if (message == kAssetResolvedMessage) {
+        std::unique_ptr<AssetCache::Result> result(reinterpret_cast<AssetCache::Result*>(lParam));
+        auto that = reinterpret_cast<WebProcessor*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+        if (that) {
+            that->CompleteAssetRequest(static_cast<uint64_t>(wParam), std::move(result));
+        }
+        return 0;
+    }
+    return DefWindowProcW(hwnd, message, wParam, lParam);
 }
 
 void WebProcessor::HandleWebMessage(const std::wstring& message) {
@@ -274,7 +638,16 @@ void WebProcessor::HandleWebMessage(const std::wstring& message) {
         SendClipboardResponse(payload);
     } else if (type == L"bridgeReady") {
         bridgeReady_ = true;
+        Milestone(L"page ready");
         NotifyClipboardInventory();
+    } else if (type == L"clipboardPage") {
+        SelectPage(_wtoi64(payload.c_str()));
+    }
+}
+
+void WebProcessor::Milestone(const wchar_t* name) const {
+    if (milestoneCallback_) {
+        milestoneCallback_(name);
     }
 }
 
@@ -285,12 +658,24 @@ void WebProcessor::PostStringMessage(const std::wstring& message) const {
 }
 
 void WebProcessor::SendClipboardResponse(const std::wstring& requestId) const {
-    std::wstringstream ss;
-    ss << L"clipboardResponse|" << requestId << L"|" << static_cast<unsigned long long>(clipboardImages_.size());
-    for (const auto& dataUrl : clipboardImages_) {
-        ss << L"|" << dataUrl;
+    static const DataUrls kNoImages;
+    const auto& images = publishedSets_.Empty() ? kNoImages.urls : publishedSets_.Selected().dataUrls.urls;
+    const std::wstring count = std::to_wstring(images.size());
+    // The response carries every data URL, often tens of megabytes, so it is
+    // sized once and filled in place instead of grown through a stream.
+    size_t length = std::size(L"clipboardResponse|") - 1 + requestId.size() + 1 + count.size();
+    for (const auto& dataUrl : images) {
+        length += 1 + dataUrl.size();
     }
-    PostStringMessage(ss.str());
+    std::wstring response;
+    response.reserve(length);
+    // Briefly a second copy of every image in the set.
+    const memory::Charge charge(memory::Tag::Bridge, length * sizeof(wchar_t));
+    response.append(L"clipboardResponse|").append(requestId).append(L"|").append(count);
+    for (const auto& dataUrl : images) {
+        response.append(L"|").append(dataUrl);
+    }
+    PostStringMessage(response);
 }
 
 void WebProcessor::NotifyClipboardInventory() const {
@@ -298,6 +683,13 @@ void WebProcessor::NotifyClipboardInventory() const {
         return;
     }
     std::wstringstream ss;
-    ss << L"clipboardInventory|" << static_cast<unsigned long long>(clipboardImages_.size());
+    if (publishedSets_.Empty()) {
+        ss << L"clipboardInventory|0|0|0|";
+    } else {
+        const auto& set = publishedSets_.Selected();
+        ss << L"clipboardInventory|" << static_cast<unsigned long long>(set.dataUrls.urls.size()) << L"|"
+           << static_cast<unsigned long long>(publishedSets_.SelectedIndex() + 1) << L"|"
+           << static_cast<unsigned long long>(publishedSets_.Size()) << L"|" << set.label;
+    }
     PostStringMessage(ss.str());
 }
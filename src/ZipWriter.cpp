@@ -0,0 +1,242 @@
+#include "ZipWriter.h"
+
+#include "Digest.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+constexpr uint32_t kEndSignature = 0x06054b50;
+constexpr uint32_t kZip64EndSignature = 0x06064b50;
+constexpr uint32_t kZip64LocatorSignature = 0x07064b50;
+constexpr uint16_t kZip64ExtraId = 0x0001;
+constexpr uint16_t kVersionDefault = 20;
+constexpr uint16_t kVersionZip64 = 45;
+// General purpose flag bit 11: names are UTF-8.
+constexpr uint16_t kFlagUtf8 = 0x0800;
+constexpr uint32_t kMax32 = 0xFFFFFFFFu;
+constexpr uint16_t kMax16 = 0xFFFF;
+constexpr size_t kCrcOffset = 14;
+constexpr size_t kCopyBufferSize = 1 << 20;
+
+void PutU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void PutU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+void PutU64(std::vector<uint8_t>& out, uint64_t value) {
+    PutU32(out, static_cast<uint32_t>(value));
+    PutU32(out, static_cast<uint32_t>(value >> 32));
+}
+
+uint32_t Clamp32(uint64_t value) {
+    return value >= kMax32 ? kMax32 : static_cast<uint32_t>(value);
+}
+
+void ToDosTime(std::time_t time, uint16_t& dosTime, uint16_t& dosDate) {
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    // DOS dates start in 1980.
+    const int year = local.tm_year + 1900 < 1980 ? 0 : local.tm_year + 1900 - 1980;
+    dosTime = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+    dosDate = static_cast<uint16_t>((year << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+}
+
+} // namespace
+
+ZipWriter::~ZipWriter() {
+    if (out_.is_open()) {
+        Abort();
+    }
+}
+
+bool ZipWriter::Open(const std::filesystem::path& path, std::time_t modified) {
+    if (out_.is_open()) {
+        Abort();
+    }
+    path_ = path;
+    entries_.clear();
+    offset_ = 0;
+    ToDosTime(modified == 0 ? std::time(nullptr) : modified, dosTime_, dosDate_);
+    out_.open(path_, std::ios::binary | std::ios::trunc);
+    return out_.is_open();
+}
+
+bool ZipWriter::AddBytes(const std::string& name, const void* data, size_t size) {
+    return BeginEntry(name, size) && Write(data, size) && EndEntry(digest::Crc32(data, size));
+}
+
+bool ZipWriter::AddFile(const std::string& name, const std::filesystem::path& source) {
+    std::error_code ec;
+    const uint64_t size = std::filesystem::file_size(source, ec);
+    std::ifstream in(source, std::ios::binary);
+    if (ec || !in || !BeginEntry(name, size)) {
+        return false;
+    }
+    buffer_.resize(kCopyBufferSize);
+    uint32_t crc = 0;
+    uint64_t remaining = size;
+    while (remaining > 0) {
+        const auto chunk = static_cast<size_t>(std::min<uint64_t>(remaining, buffer_.size()));
+        if (!in.read(buffer_.data(), static_cast<std::streamsize>(chunk))) {
+            // The file shrank while it was being read; the archive can't be completed.
+            return false;
+        }
+        crc = digest::Crc32(buffer_.data(), chunk, crc);
+        if (!Write(buffer_.data(), chunk)) {
+            return false;
+        }
+        remaining -= chunk;
+    }
+    return EndEntry(crc);
+}
+
+bool ZipWriter::BeginEntry(const std::string& name, uint64_t size) {
+    if (!out_.is_open() || name.empty() || name.size() > kMax16) {
+        return false;
+    }
+    const bool zip64 = size >= kMax32;
+    std::vector<uint8_t> header;
+    header.reserve(30 + name.size() + 20);
+    PutU32(header, kLocalHeaderSignature);
+    PutU16(header, zip64 ? kVersionZip64 : kVersionDefault);
+    PutU16(header, kFlagUtf8);
+    PutU16(header, 0);
+    PutU16(header, dosTime_);
+    PutU16(header, dosDate_);
+    PutU32(header, 0);
+    PutU32(header, Clamp32(size));
+    PutU32(header, Clamp32(size));
+    PutU16(header, static_cast<uint16_t>(name.size()));
+    PutU16(header, static_cast<uint16_t>(zip64 ? 20 : 0));
+    header.insert(header.end(), name.begin(), name.end());
+    if (zip64) {
+        PutU16(header, kZip64ExtraId);
+        PutU16(header, 16);
+        PutU64(header, size);
+        PutU64(header, size);
+    }
+    Entry entry;
+    entry.name = name;
+    entry.size = size;
+    entry.offset = offset_;
+    entries_.push_back(std::move(entry));
+    return Write(header.data(), header.size());
+}
+
+bool ZipWriter::EndEntry(uint32_t crc) {
+    Entry& entry = entries_.back();
+    entry.crc = crc;
+    if (offset_ != entry.offset + 30 + entry.name.size() + (entry.size >= kMax32 ? 20 : 0) + entry.size) {
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    PutU32(bytes, crc);
+    out_.seekp(static_cast<std::streamoff>(entry.offset + kCrcOffset));
+    out_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    out_.seekp(static_cast<std::streamoff>(offset_));
+    return static_cast<bool>(out_);
+}
+
+bool ZipWriter::Write(const void* data, size_t size) {
+    out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    offset_ += size;
+    return static_cast<bool>(out_);
+}
+
+bool ZipWriter::Finish() {
+    if (!out_.is_open()) {
+        return false;
+    }
+    const uint64_t directoryOffset = offset_;
+    std::vector<uint8_t> record;
+    for (const auto& entry : entries_) {
+        const bool bigSize = entry.size >= kMax32;
+        const bool bigOffset = entry.offset >= kMax32;
+        const uint16_t extraSize = static_cast<uint16_t>((bigSize ? 16 : 0) + (bigOffset ? 8 : 0));
+        record.clear();
+        PutU32(record, kCentralHeaderSignature);
+        PutU16(record, kVersionZip64);
+        PutU16(record, bigSize || bigOffset ? kVersionZip64 : kVersionDefault);
+        PutU16(record, kFlagUtf8);
+        PutU16(record, 0);
+        PutU16(record, dosTime_);
+        PutU16(record, dosDate_);
+        PutU32(record, entry.crc);
+        PutU32(record, Clamp32(entry.size));
+        PutU32(record, Clamp32(entry.size));
+        PutU16(record, static_cast<uint16_t>(entry.name.size()));
+        PutU16(record, static_cast<uint16_t>(extraSize > 0 ? extraSize + 4 : 0));
+        PutU16(record, 0);
+        PutU16(record, 0);
+        PutU16(record, 0);
+        PutU32(record, 0);
+        PutU32(record, Clamp32(entry.offset));
+        record.insert(record.end(), entry.name.begin(), entry.name.end());
+        if (extraSize > 0) {
+            PutU16(record, kZip64ExtraId);
+            PutU16(record, extraSize);
+            if (bigSize) {
+                PutU64(record, entry.size);
+                PutU64(record, entry.size);
+            }
+            if (bigOffset) {
+                PutU64(record, entry.offset);
+            }
+        }
+        if (!Write(record.data(), record.size())) {
+            return false;
+        }
+    }
+    const uint64_t directorySize = offset_ - directoryOffset;
+    const uint64_t count = entries_.size();
+
+    record.clear();
+    if (count >= kMax16 || directoryOffset >= kMax32 || directorySize >= kMax32) {
+        const uint64_t zip64EndOffset = offset_;
+        PutU32(record, kZip64EndSignature);
+        PutU64(record, 44);
+        PutU16(record, kVersionZip64);
+        PutU16(record, kVersionZip64);
+        PutU32(record, 0);
+        PutU32(record, 0);
+        PutU64(record, count);
+        PutU64(record, count);
+        PutU64(record, directorySize);
+        PutU64(record, directoryOffset);
+        PutU32(record, kZip64LocatorSignature);
+        PutU32(record, 0);
+        PutU64(record, zip64EndOffset);
+        PutU32(record, 1);
+    }
+    PutU32(record, kEndSignature);
+    PutU16(record, 0);
+    PutU16(record, 0);
+    PutU16(record, static_cast<uint16_t>(count >= kMax16 ? kMax16 : count));
+    PutU16(record, static_cast<uint16_t>(count >= kMax16 ? kMax16 : count));
+    PutU32(record, Clamp32(directorySize));
+    PutU32(record, Clamp32(directoryOffset));
+    PutU16(record, 0);
+    const bool ok = Write(record.data(), record.size());
+    out_.close();
+    return ok && !out_.fail();
+}
+
+void ZipWriter::Abort() {
+    out_.close();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+    entries_.clear();
+}
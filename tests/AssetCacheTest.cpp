@@ -0,0 +1,359 @@
+#include "AssetCache.h"
+
+#include "Check.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> Bytes(const std::string& text) {
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+std::string Lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return text;
+}
+
+// Header value by case-insensitive name from a raw header block.
+std::string HeaderValue(const std::string& head, const std::string& name) {
+    const std::string lowerHead = Lower(head);
+    const auto pos = lowerHead.find("\r\n" + Lower(name) + ":");
+    if (pos == std::string::npos) {
+        return std::string();
+    }
+    auto start = pos + name.size() + 3;
+    while (start < head.size() && head[start] == ' ') {
+        ++start;
+    }
+    return head.substr(start, head.find("\r\n", start) - start);
+}
+
+bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// HTTP/1.0 stand-in for the site on 127.0.0.1: one request per connection,
+// 304 when If-None-Match matches the resource's ETag.
+class LoopbackServer {
+public:
+    struct Resource {
+        std::string body;
+        std::string etag;
+        std::string cacheControl;
+        std::string contentType = "text/plain";
+    };
+
+    LoopbackServer() {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (listener_ < 0 || bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listener_, 16) != 0 || getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return;
+        }
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread([this]() { Serve(); });
+    }
+
+    ~LoopbackServer() {
+        stopping_ = true;
+        if (listener_ >= 0) {
+            shutdown(listener_, SHUT_RDWR);
+            close(listener_);
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::string Url(const std::string& path) const {
+        return "http://127.0.0.1:" + std::to_string(port_) + path;
+    }
+
+    void Set(const std::string& path, Resource resource) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resources_[path] = std::move(resource);
+    }
+
+    int Requests() const { return requests_.load(); }
+    std::string LastIfNoneMatch() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastIfNoneMatch_;
+    }
+
+private:
+    void Serve() {
+        while (!stopping_) {
+            const int client = accept(listener_, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            std::string request;
+            char buffer[1024];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                const ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    break;
+                }
+                request.append(buffer, static_cast<size_t>(n));
+            }
+            SendAll(client, Respond(request));
+            close(client);
+        }
+    }
+
+    std::string Respond(const std::string& request) {
+        ++requests_;
+        const auto pathStart = request.find(' ') + 1;
+        const std::string path = request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+        const std::string ifNoneMatch = HeaderValue(request, "If-None-Match");
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastIfNoneMatch_ = ifNoneMatch;
+        const auto it = resources_.find(path);
+        if (it == resources_.end()) {
+            return "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        }
+        const Resource& resource = it->second;
+        std::string head;
+        if (!resource.etag.empty()) {
+            head += "ETag: " + resource.etag + "\r\n";
+        }
+        if (!resource.cacheControl.empty()) {
+            head += "Cache-Control: " + resource.cacheControl + "\r\n";
+        }
+        if (!ifNoneMatch.empty() && ifNoneMatch == resource.etag) {
+            return "HTTP/1.0 304 Not Modified\r\n" + head + "\r\n";
+        }
+        head += "Content-Type: " + resource.contentType + "\r\n";
+        head += "Last-Modified: Mon, 01 Jan 2024 00:00:00 GMT\r\n";
+        head += "Content-Length: " + std::to_string(resource.body.size()) + "\r\n";
+        return "HTTP/1.0 200 OK\r\n" + head + "\r\n" + resource.body;
+    }
+
+    int listener_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<int> requests_{ 0 };
+    mutable std::mutex mutex_;
+    std::map<std::string, Resource> resources_;
+    std::string lastIfNoneMatch_;
+};
+
+// Plain-socket counterpart of the app's WinHTTP fetcher, for http://127.0.0.1 URLs.
+class LoopbackFetcher : public AssetFetcher {
+public:
+    bool Fetch(const AssetRequest& request, AssetResponse& response) override {
+        const std::string prefix = "http://127.0.0.1:";
+        if (request.url.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        const auto slash = request.url.find('/', prefix.size());
+        const int port = std::stoi(request.url.substr(prefix.size(), slash - prefix.size()));
+        const std::string path = slash == std::string::npos ? "/" : request.url.substr(slash);
+
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+
+        std::string message = "GET " + path + " HTTP/1.0\r\n";
+        if (!request.ifNoneMatch.empty()) {
+            message += "If-None-Match: " + request.ifNoneMatch + "\r\n";
+        }
+        if (!request.ifModifiedSince.empty()) {
+            message += "If-Modified-Since: " + request.ifModifiedSince + "\r\n";
+        }
+        message += "\r\n";
+        std::string raw;
+        if (SendAll(fd, message)) {
+            char buffer[4096];
+            ssize_t n = 0;
+            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                raw.append(buffer, static_cast<size_t>(n));
+            }
+        }
+        close(fd);
+
+        const auto headEnd = raw.find("\r\n\r\n");
+        if (raw.compare(0, 9, "HTTP/1.0 ") != 0 || headEnd == std::string::npos) {
+            return false;
+        }
+        const std::string head = raw.substr(0, headEnd + 2);
+        response.status = std::stoi(raw.substr(9, 3));
+        response.etag = HeaderValue(head, "ETag");
+        response.lastModified = HeaderValue(head, "Last-Modified");
+        response.contentType = HeaderValue(head, "Content-Type");
+        response.cacheControl = HeaderValue(head, "Cache-Control");
+        response.body.assign(raw.begin() + static_cast<std::ptrdiff_t>(headEnd + 4), raw.end());
+        return true;
+    }
+};
+
+const int64_t kNow = 1700000000;
+
+TEST_CASE(ColdStartFetchesAndWarmStartServesFromDisk) {
+    check::TempDir dir;
+    LoopbackServer server;
+    server.Set("/receipt_factor/app.js", { "console.log(1);", "\"v1\"", "max-age=60", "text/javascript" });
+    LoopbackFetcher fetcher;
+    const auto url = server.Url("/receipt_factor/app.js");
+
+    {
+        AssetCache cache(dir.Path());
+        REQUIRE(cache.Open());
+        const auto cold = cache.Resolve(url, fetcher, kNow);
+        CHECK(cold.source == AssetCache::Source::Network);
+        CHECK(cold.body == Bytes("console.log(1);"));
+        CHECK(cold.asset.hash.size() == 64);
+        CHECK(cold.asset.maxAge == 60);
+        CHECK(cold.asset.etag == "\"v1\"");
+        CHECK(cold.asset.contentType == "text/javascript");
+        CHECK(server.Requests() == 1);
+    }
+
+    AssetCache reopened(dir.Path());
+    REQUIRE(reopened.Open());
+    const auto warm = reopened.Resolve(url, fetcher, kNow + 10);
+    CHECK(warm.source == AssetCache::Source::Cache);
+    CHECK(!warm.needsRevalidation);
+    CHECK(warm.body == Bytes("console.log(1);"));
+    CHECK(warm.asset.maxAge == 60);
+    CHECK(server.Requests() == 1);
+}
+
+TEST_CASE(StaleEntryIsServedAndRevalidatedWithItsETag) {
+    check::TempDir dir;
+    LoopbackServer server;
+    server.Set("/a.css", { "body{}", "\"css1\"", "max-age=60" });
+    LoopbackFetcher fetcher;
+    const auto url = server.Url("/a.css");
+
+    AssetCache cache(dir.Path());
+    REQUIRE(cache.Open());
+    cache.Resolve(url, fetcher, kNow);
+
+    const auto stale = cache.Resolve(url, fetcher, kNow + 120);
+    CHECK(stale.source == AssetCache::Source::Cache);
+    CHECK(stale.needsRevalidation);
+    CHECK(server.Requests() == 1);
+
+    CHECK(cache.Revalidate(url, fetcher, kNow + 120));
+    CHECK(server.LastIfNoneMatch() == "\"css1\"");
+    const auto refreshed = cache.Lookup(url);
+    REQUIRE(refreshed.has_value());
+    CHECK(refreshed->storedAt == kNow + 120);
+    CHECK(cache.IsFresh(*refreshed, kNow + 130));
+
+    server.Set("/a.css", { "body{color:red}", "\"css2\"", "max-age=60" });
+    CHECK(cache.Revalidate(url, fetcher, kNow + 200));
+    const auto changed = cache.Resolve(url, fetcher, kNow + 200);
+    CHECK(changed.body == Bytes("body{color:red}"));
+    CHECK(changed.asset.etag == "\"css2\"");
+}
+
+TEST_CASE(NoStoreResponseIsDescribedButNotKept) {
+    check::TempDir dir;
+    LoopbackServer server;
+    server.Set("/live.json", { "{}", "\"x\"", "no-store" });
+    LoopbackFetcher fetcher;
+
+    AssetCache cache(dir.Path());
+    REQUIRE(cache.Open());
+    const auto result = cache.Resolve(server.Url("/live.json"), fetcher, kNow);
+    CHECK(result.source == AssetCache::Source::Network);
+    CHECK(result.asset.hash.size() == 64);
+    CHECK(result.asset.maxAge == 0);
+    CHECK(!cache.Lookup(server.Url("/live.json")).has_value());
+}
+
+TEST_CASE(ErrorsAndUnreachableOriginAreMisses) {
+    check::TempDir dir;
+    LoopbackFetcher fetcher;
+    AssetCache cache(dir.Path());
+    REQUIRE(cache.Open());
+
+    std::string unreachable;
+    {
+        LoopbackServer server;
+        CHECK(cache.Resolve(server.Url("/missing"), fetcher, kNow).source == AssetCache::Source::Miss);
+        unreachable = server.Url("/gone");
+    }
+    const auto result = cache.Resolve(unreachable, fetcher, kNow);
+    CHECK(result.source == AssetCache::Source::Miss);
+    CHECK(result.body.empty());
+}
+
+TEST_CASE(ConcurrentStoresNeverDropASharedObject) {
+    check::TempDir dir;
+    AssetCache cache(dir.Path());
+    REQUIRE(cache.Open());
+
+    AssetResponse first;
+    first.status = 200;
+    first.cacheControl = "max-age=60";
+    first.body = Bytes(std::string(8 * 1024, 'x'));
+    AssetResponse second = first;
+    second.body = Bytes(std::string(8 * 1024, 'y'));
+
+    // Every URL flips between the same two bodies, so each thread keeps
+    // releasing objects another one is in the middle of storing. Only the
+    // owning thread changes its URL, so its entry must stay readable.
+    std::atomic<int> unreadable{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            const std::string url = "https://example.invalid/" + std::to_string(t);
+            std::vector<uint8_t> body;
+            for (int i = 0; i < 200; ++i) {
+                if (!cache.Store(url, (i + t) % 2 == 0 ? first : second, kNow)) {
+                    ++unreadable;
+                    continue;
+                }
+                const auto asset = cache.Lookup(url);
+                if (!asset || !cache.ReadBody(*asset, body)) {
+                    ++unreadable;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(unreadable.load() == 0);
+}
+
+} // namespace
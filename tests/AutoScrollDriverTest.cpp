@@ -0,0 +1,169 @@
+#include "AutoScrollDriver.h"
+
+#include "Check.h"
+#include "EndOfListDetector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// A list that starts moving `latencyMs` after a wheel step and then glides to
+// its new offset over `glideMs`, stopping at `endOffset`.
+struct SimulatedList {
+    uint64_t latencyMs = 100;
+    uint64_t glideMs = 120;
+    uint32_t pxPerNotch = 40;
+    uint32_t endOffset = 1000;
+    bool probesFail = false;
+    bool neverStops = false;
+
+    uint32_t from = 0;
+    uint32_t to = 0;
+    uint64_t scrolledAtMs = 0;
+
+    void Scroll(uint32_t notches, uint64_t nowMs) {
+        from = OffsetAt(nowMs);
+        to = (std::min)(endOffset, from + notches * pxPerNotch);
+        scrolledAtMs = nowMs;
+    }
+
+    uint32_t OffsetAt(uint64_t nowMs) const {
+        if (neverStops && scrolledAtMs > 0) {
+            return from + static_cast<uint32_t>(nowMs - scrolledAtMs);
+        }
+        if (nowMs < scrolledAtMs + latencyMs) {
+            return from;
+        }
+        const uint64_t t = nowMs - scrolledAtMs - latencyMs;
+        if (t >= glideMs) {
+            return to;
+        }
+        return from + static_cast<uint32_t>((to - from) * t / glideMs);
+    }
+};
+
+motion::ShiftEstimate Between(uint32_t previous, uint32_t current) {
+    motion::ShiftEstimate estimate;
+    estimate.valid = current >= previous;
+    estimate.shift = current - previous;
+    estimate.matchRatio = 1.0;
+    return estimate;
+}
+
+struct Run {
+    std::vector<uint32_t> captured;
+    AutoScrollDriver::FinishReason reason = AutoScrollDriver::FinishReason::None;
+    uint64_t elapsedMs = 0;
+};
+
+// Drives the driver the way Application::OnAutoScrollTick does, on a 15 ms timer.
+Run Drive(SimulatedList list, AutoScrollSettings settings, uint32_t endOfListFrames = 2) {
+    AutoScrollDriver driver(settings);
+    EndOfListDetector endOfList(EndOfListSettings{ endOfListFrames, 0 });
+    Run run;
+    uint32_t reference = 0;
+    uint64_t now = 0;
+    driver.Start(now);
+    while (driver.Active() && now < 120000) {
+        switch (driver.Poll(now)) {
+            case AutoScrollDriver::Command::Capture: {
+                const uint32_t offset = list.OffsetAt(now);
+                if (!run.captured.empty()) {
+                    endOfList.Observe(Between(run.captured.back(), offset));
+                }
+                run.captured.push_back(offset);
+                reference = offset;
+                driver.OnCaptured(true, endOfList.Reached(), now);
+                break;
+            }
+            case AutoScrollDriver::Command::Scroll:
+                list.Scroll(driver.Notches(), now);
+                driver.OnScrolled(now);
+                break;
+            case AutoScrollDriver::Command::Probe: {
+                motion::ShiftEstimate estimate;
+                if (!list.probesFail) {
+                    estimate = Between(reference, list.OffsetAt(now));
+                    reference = list.OffsetAt(now);
+                }
+                driver.OnProbe(estimate, now);
+                break;
+            }
+            default:
+                break;
+        }
+        now += 15;
+    }
+    run.reason = driver.Reason();
+    run.elapsedMs = now;
+    return run;
+}
+
+TEST_CASE(SlowStartingScrollIsNotMistakenForSettled) {
+    // The first probe (60 ms) lands before the list starts moving (100 ms).
+    const Run run = Drive(SimulatedList{}, AutoScrollSettings{});
+    CHECK(run.reason == AutoScrollDriver::FinishReason::EndOfList);
+    REQUIRE(run.captured.size() >= 2);
+    // Every capture before the end is at rest on a whole step, one step on.
+    size_t i = 1;
+    for (; i < run.captured.size() && run.captured[i] < 1000; ++i) {
+        CHECK(run.captured[i] == run.captured[i - 1] + 120);
+    }
+    CHECK(i == 9);
+    CHECK(run.captured.size() == 12);
+}
+
+TEST_CASE(ViewThatNeverMovesSettlesOnMatchingProbes) {
+    SimulatedList list;
+    list.endOffset = 0;
+    AutoScrollSettings settings;
+    settings.maxSettleMs = 5000;
+    const Run run = Drive(list, settings);
+    CHECK(run.reason == AutoScrollDriver::FinishReason::EndOfList);
+    CHECK(run.captured.size() == 3);
+    // Three probes per step rather than the settle timeout.
+    CHECK(run.elapsedMs < 1000);
+}
+
+TEST_CASE(ViewThatStopsEndsTheRunWithoutEndOfListDetection) {
+    // endOfListFrames=0 turns the session's detector off; the run must still
+    // end a few steps past the bottom instead of at maxCaptures.
+    const Run run = Drive(SimulatedList{}, AutoScrollSettings{}, 0);
+    CHECK(run.reason == AutoScrollDriver::FinishReason::ViewStopped);
+    REQUIRE(run.captured.size() == 13);
+    CHECK(run.captured[8] < 1000);
+    for (size_t i = 9; i < run.captured.size(); ++i) {
+        CHECK(run.captured[i] == 1000);
+    }
+}
+
+TEST_CASE(StricterEndOfListDetectionIsNotCutShort) {
+    AutoScrollSettings settings;
+    settings.maxStillSteps = 5;
+    const Run run = Drive(SimulatedList{}, settings, 5);
+    CHECK(run.reason == AutoScrollDriver::FinishReason::EndOfList);
+    CHECK(run.captured.size() == 15);
+}
+
+TEST_CASE(UnmeasurableViewFallsBackToMaxSettle) {
+    SimulatedList list;
+    list.probesFail = true;
+    AutoScrollSettings settings;
+    settings.maxCaptures = 3;
+    const Run run = Drive(list, settings);
+    CHECK(run.reason == AutoScrollDriver::FinishReason::CaptureLimit);
+    CHECK(run.captured.size() == 3);
+    CHECK(run.elapsedMs >= 2 * settings.maxSettleMs);
+}
+
+TEST_CASE(ViewThatKeepsMovingStopsTheRun) {
+    SimulatedList list;
+    list.neverStops = true;
+    const Run run = Drive(list, AutoScrollSettings{});
+    CHECK(run.reason == AutoScrollDriver::FinishReason::SettleTimeout);
+    CHECK(run.captured.size() == 1);
+}
+
+} // namespace
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+// Tiny timing loop for the hand-run benchmarks (chronos_add_bench targets).
+// Build in Release for meaningful numbers.
+namespace bench {
+
+// Calls `body` until `budget` has elapsed (at least once) and prints the mean
+// time per call, plus throughput when `bytes` per call is given. `body` returns
+// a value that is folded into a sink so the work cannot be optimized away.
+template <typename Body>
+double Run(const char* name, size_t bytes, Body&& body, std::chrono::milliseconds budget = std::chrono::milliseconds(500)) {
+    using Clock = std::chrono::steady_clock;
+    static volatile size_t sink = 0;
+    size_t runs = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    do {
+        sink = sink + static_cast<size_t>(body());
+        ++runs;
+        elapsed = Clock::now() - start;
+    } while (elapsed < budget);
+
+    const double seconds = std::chrono::duration<double>(elapsed).count() / static_cast<double>(runs);
+    if (bytes > 0) {
+        std::printf("%-40s %12.3f us  %10.1f MB/s\n", name, seconds * 1e6, static_cast<double>(bytes) / seconds / 1e6);
+    } else {
+        std::printf("%-40s %12.3f us\n", name, seconds * 1e6);
+    }
+    return seconds;
+}
+
+} // namespace bench
@@ -0,0 +1,145 @@
+#include "CadenceController.h"
+
+#include "Check.h"
+
+#include <cmath>
+#include <functional>
+#include <random>
+
+namespace {
+
+constexpr uint32_t kFrameHeight = 600;
+
+// A list that moves `pixelsPerNotch(captureIndex)` per wheel notch. A step
+// that moves a whole frame or more leaves no overlap to measure.
+motion::ShiftEstimate Scroll(uint32_t notches, double pixelsPerNotch) {
+    motion::ShiftEstimate estimate;
+    const auto shift = static_cast<uint32_t>(std::lround(notches * pixelsPerNotch));
+    estimate.valid = shift < kFrameHeight;
+    estimate.shift = estimate.valid ? shift : 0;
+    estimate.matchRatio = estimate.valid ? 1.0 : 0.0;
+    return estimate;
+}
+
+struct Run {
+    uint32_t captures = 0;
+    uint32_t gaps = 0;
+    // Smallest overlap seen once the controller had one measurement.
+    double minOverlap = 1.0;
+};
+
+// Scrolls `listHeight` pixels of content, capturing after every
+// controller-chosen number of notches.
+Run Simulate(CadenceController& controller, double listHeight, const std::function<double(uint32_t)>& pixelsPerNotch) {
+    Run run;
+    double position = 0.0;
+    while (position < listHeight) {
+        const uint32_t notches = controller.NotchesPerCapture();
+        const double rate = pixelsPerNotch(run.captures);
+        const auto estimate = Scroll(notches, rate);
+        position += notches * rate;
+        if (!estimate.valid) {
+            ++run.gaps;
+        } else if (run.captures > 0) {
+            run.minOverlap = (std::min)(run.minOverlap, 1.0 - static_cast<double>(estimate.shift) / kFrameHeight);
+        }
+        controller.Observe(notches, estimate, kFrameHeight);
+        ++run.captures;
+    }
+    return run;
+}
+
+TEST_CASE(ConvergesToTheLargestStepThatKeepsTheTargetOverlap) {
+    CadenceController controller(CadenceSettings{});
+    CHECK(controller.NotchesPerCapture() == 1);
+    const auto estimate = Scroll(1, 37.0);
+    // 600 * 0.75 / 37 = 12.16.
+    CHECK(controller.Observe(1, estimate, kFrameHeight) == 12);
+    CHECK(controller.Observe(12, Scroll(12, 37.0), kFrameHeight) == 12);
+    CHECK(controller.PixelsPerNotch() == 37.0);
+}
+
+TEST_CASE(LongListHasNoGapsAndFarFewerFrames) {
+    CadenceController adaptive(CadenceSettings{});
+    const auto run = Simulate(adaptive, 20000.0, [](uint32_t) { return 37.0; });
+    CHECK(run.gaps == 0);
+    CHECK(run.minOverlap >= 0.25);
+    // One capture per notch would take 541 frames; each adaptive step covers 444 px.
+    CHECK(run.captures <= 20000 / 444 + 3);
+}
+
+TEST_CASE(NoisyMeasurementsStayNearTheIdealAndNeverGap) {
+    std::mt19937 rng(35);
+    std::uniform_real_distribution<double> jitter(-3.0, 3.0);
+    CadenceController controller(CadenceSettings{});
+    const auto run = Simulate(controller, 30000.0, [&](uint32_t) { return 40.0 + jitter(rng); });
+    CHECK(run.gaps == 0);
+    CHECK(run.minOverlap >= 0.15);
+    const uint32_t notches = controller.NotchesPerCapture();
+    CHECK(notches >= 10 && notches <= 12);
+}
+
+TEST_CASE(TheOverlapMarginAbsorbsModestRateChanges) {
+    CadenceController controller(CadenceSettings{});
+    // Rows get 25% taller after the 10th capture: 18 notches still overlap.
+    const auto run = Simulate(controller, 20000.0, [](uint32_t capture) { return capture < 10 ? 25.0 : 31.25; });
+    CHECK(run.gaps == 0);
+    CHECK(run.minOverlap > 0.0);
+    CHECK(controller.NotchesPerCapture() == 14);
+}
+
+TEST_CASE(ALargeRateChangeCostsOneGapOnly) {
+    CadenceController controller(CadenceSettings{});
+    // Rows get twice as tall: 18 notches now move 900 px, more than a frame.
+    const auto run = Simulate(controller, 20000.0, [](uint32_t capture) { return capture < 10 ? 25.0 : 50.0; });
+    CHECK(run.gaps == 1);
+    CHECK(controller.NotchesPerCapture() == 9);
+}
+
+TEST_CASE(OvershootBacksOffHard) {
+    CadenceSettings settings;
+    settings.minNotches = 1;
+    settings.maxNotches = 30;
+    CadenceController controller(settings);
+    controller.Reset(30);
+    CHECK(controller.Observe(30, Scroll(30, 100.0), kFrameHeight) == 15);
+    CHECK(controller.Observe(15, Scroll(15, 100.0), kFrameHeight) == 7);
+    // 7 notches move 700 px: still no overlap.
+    CHECK(controller.Observe(7, Scroll(7, 100.0), kFrameHeight) == 3);
+    CHECK(controller.Observe(3, Scroll(3, 100.0), kFrameHeight) == 4);
+}
+
+TEST_CASE(StillFramesAndBadInputCarryNoInformation) {
+    CadenceController controller(CadenceSettings{});
+    controller.Reset(5);
+    motion::ShiftEstimate still;
+    still.valid = true;
+    still.shift = 0;
+    CHECK(controller.Observe(5, still, kFrameHeight) == 5);
+    CHECK(controller.Observe(0, Scroll(5, 10.0), kFrameHeight) == 5);
+    CHECK(controller.Observe(5, Scroll(5, 10.0), 0) == 5);
+    CHECK(controller.PixelsPerNotch() == 0.0);
+}
+
+TEST_CASE(SettingsAreSanitizedAndClamped) {
+    CadenceSettings settings;
+    settings.targetOverlap = 2.0;
+    settings.minNotches = 0;
+    settings.maxNotches = 0;
+    CadenceController degenerate(settings);
+    CHECK(degenerate.Settings().targetOverlap == 0.95);
+    CHECK(degenerate.Settings().minNotches == 1);
+    CHECK(degenerate.Settings().maxNotches == 1);
+
+    settings = CadenceSettings{};
+    settings.minNotches = 2;
+    settings.maxNotches = 6;
+    CadenceController bounded(settings);
+    CHECK(bounded.NotchesPerCapture() == 2);
+    // Tiny rows would want 450 notches.
+    CHECK(bounded.Observe(2, Scroll(2, 1.0), kFrameHeight) == 6);
+    bounded.Reset(0);
+    CHECK(bounded.NotchesPerCapture() == 2);
+}
+
+} // namespace
@@ -0,0 +1,287 @@
+#include "CaptureJournal.h"
+
+#include "Check.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <thread>
+
+namespace {
+
+std::vector<uint8_t> ReadBytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void WriteBytes(const std::filesystem::path& path, const std::vector<uint8_t>& bytes, size_t length) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(length));
+}
+
+journal::FrameEntry Frame(uint32_t index, uint32_t crc = 0) {
+    journal::FrameEntry frame;
+    frame.index = index;
+    frame.width = 1280;
+    frame.height = 720 + index;
+    frame.pngBytes = 1000 * index;
+    frame.pngCrc = crc ? crc : 0xC0DE0000u + index;
+    frame.file = "shot_" + std::to_string(10000 + index).substr(1) + ".png";
+    return frame;
+}
+
+bool operator==(const journal::FrameEntry& a, const journal::FrameEntry& b) {
+    return a.index == b.index && a.width == b.width && a.height == b.height && a.pngBytes == b.pngBytes &&
+           a.pngCrc == b.pngCrc && a.file == b.file;
+}
+
+// One step of a capture and the state a reader should see once it is on disk.
+struct Step {
+    enum Kind { Add, Drop, End } kind;
+    uint32_t index;
+};
+
+struct Expected {
+    bool complete = false;
+    // index -> pngCrc of the live frame
+    std::map<uint32_t, uint32_t> frames;
+};
+
+void Apply(const Step& step, Expected& expected, uint32_t crc) {
+    switch (step.kind) {
+        case Step::Add:
+            expected.frames[step.index] = crc;
+            expected.complete = false;
+            break;
+        case Step::Drop:
+            expected.frames.erase(step.index);
+            expected.complete = false;
+            break;
+        case Step::End:
+            expected.complete = true;
+            break;
+    }
+}
+
+bool Matches(const journal::JournalState& state, const Expected& expected) {
+    if (state.complete != expected.complete || state.frames.size() != expected.frames.size()) {
+        return false;
+    }
+    auto it = expected.frames.begin();
+    for (const auto& frame : state.frames) {
+        if (frame.index != it->first || frame.pngCrc != it->second || frame != Frame(frame.index, it->second)) {
+            return false;
+        }
+        ++it;
+    }
+    return true;
+}
+
+// A session with drops and a re-shot index, ending cleanly.
+const std::vector<Step> kSteps = {
+    { Step::Add, 1 }, { Step::Add, 2 }, { Step::Add, 3 }, { Step::Drop, 3 }, { Step::Add, 3 },
+    { Step::Add, 4 }, { Step::Drop, 4 }, { Step::Drop, 3 }, { Step::Add, 3 }, { Step::Add, 4 },
+    { Step::Add, 5 }, { Step::End, 0 },
+};
+
+// Writes kSteps and returns the file size after the header+Begin and after each step.
+std::vector<size_t> WriteSession(const std::filesystem::path& path) {
+    journal::Writer writer(journal::SyncPolicy{ 4, 60000 });
+    std::vector<size_t> boundaries;
+    if (!writer.Create(path)) {
+        return boundaries;
+    }
+    boundaries.push_back(static_cast<size_t>(std::filesystem::file_size(path)));
+    for (size_t i = 0; i < kSteps.size(); ++i) {
+        const auto& step = kSteps[i];
+        if (step.kind == Step::Add) {
+            writer.AppendFrame(Frame(step.index, static_cast<uint32_t>(i + 1)));
+        } else if (step.kind == Step::Drop) {
+            writer.AppendDrop(step.index);
+        } else {
+            writer.Finish();
+        }
+        boundaries.push_back(static_cast<size_t>(std::filesystem::file_size(path)));
+    }
+    return boundaries;
+}
+
+TEST_CASE(CrashAtEveryByteLeavesTheCompletedPrefix) {
+    check::TempDir dir;
+    const auto full = dir.Path() / "full.journal";
+    const auto boundaries = WriteSession(full);
+    REQUIRE(boundaries.size() == kSteps.size() + 1);
+    const auto bytes = ReadBytes(full);
+    REQUIRE(bytes.size() == boundaries.back());
+
+    const auto crashed = dir.Path() / "crashed.journal";
+    for (size_t length = 0; length <= bytes.size(); ++length) {
+        WriteBytes(crashed, bytes, length);
+        journal::JournalState state;
+        const bool read = journal::ReadJournal(crashed, state);
+        if (length < journal::kHeaderSize) {
+            CHECK(!read);
+            continue;
+        }
+        REQUIRE(read);
+        // Steps whose record is entirely on disk.
+        Expected expected;
+        size_t valid = journal::kHeaderSize;
+        for (size_t i = 0; i < boundaries.size(); ++i) {
+            if (boundaries[i] > length) {
+                break;
+            }
+            valid = boundaries[i];
+            if (i > 0) {
+                Apply(kSteps[i - 1], expected, static_cast<uint32_t>(i));
+            }
+        }
+        CHECK(state.validBytes == valid);
+        if (!Matches(state, expected)) {
+            check::Fail(__FILE__, __LINE__, ("state mismatch at length " + std::to_string(length)).c_str());
+        }
+    }
+}
+
+TEST_CASE(CorruptRecordEndsTheReplay) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "session.journal";
+    const auto boundaries = WriteSession(path);
+    const auto bytes = ReadBytes(path);
+    // Flip one byte inside each record in turn (length, CRC, type or payload).
+    for (size_t record = 1; record < boundaries.size(); ++record) {
+        for (const size_t at : { size_t{ 0 }, size_t{ 5 }, size_t{ 8 }, size_t{ 12 } }) {
+            const size_t offset = boundaries[record - 1] + at;
+            if (offset >= boundaries[record]) {
+                continue;
+            }
+            auto bad = bytes;
+            bad[offset] ^= 0x40;
+            WriteBytes(path, bad, bad.size());
+            journal::JournalState state;
+            REQUIRE(journal::ReadJournal(path, state));
+            Expected expected;
+            for (size_t i = 1; i < record; ++i) {
+                Apply(kSteps[i - 1], expected, static_cast<uint32_t>(i));
+            }
+            CHECK(state.validBytes == boundaries[record - 1]);
+            CHECK(Matches(state, expected));
+        }
+    }
+}
+
+TEST_CASE(ResumeAfterACrashContinuesTheJournal) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "session.journal";
+    const auto boundaries = WriteSession(path);
+    const auto bytes = ReadBytes(path);
+    // Crash half-way through the record for step 7 (drop 3).
+    WriteBytes(path, bytes, boundaries[7] + 3);
+
+    journal::JournalState state;
+    REQUIRE(journal::ReadJournal(path, state));
+    CHECK(!state.complete);
+    CHECK(state.validBytes == boundaries[7]);
+    REQUIRE(state.frames.size() == 3);
+    CHECK(state.frames.back().index == 3);
+
+    // Numbering continues after the last live frame.
+    journal::Writer writer;
+    REQUIRE(writer.Reopen(path, state));
+    const uint32_t next = state.frames.back().index + 1;
+    writer.AppendFrame(Frame(next, 77));
+    writer.Close();
+
+    REQUIRE(journal::ReadJournal(path, state));
+    CHECK(!state.complete);
+    REQUIRE(state.frames.size() == 4);
+    CHECK(state.frames.back() == Frame(next, 77));
+    CHECK(state.validBytes == std::filesystem::file_size(path));
+
+    REQUIRE(writer.Reopen(path, state));
+    CHECK(writer.Finish());
+    REQUIRE(journal::ReadJournal(path, state));
+    CHECK(state.complete);
+    CHECK(state.frames.size() == 4);
+}
+
+TEST_CASE(SyncsAreBatched) {
+    check::TempDir dir;
+    journal::Writer writer(journal::SyncPolicy{ 4, 60000 });
+    REQUIRE(writer.Create(dir.Path() / "session.journal"));
+    // Header and Begin are synced at once, then every fourth record.
+    CHECK(writer.Syncs() == 1);
+    for (uint32_t i = 1; i <= 8; ++i) {
+        writer.AppendFrame(Frame(i));
+    }
+    CHECK(writer.Syncs() == 3);
+    CHECK(writer.Finish());
+    CHECK(writer.Syncs() == 4);
+    CHECK(!writer.IsOpen());
+
+    // A zero delay syncs every record.
+    journal::Writer eager(journal::SyncPolicy{ 1000, 0 });
+    REQUIRE(eager.Create(dir.Path() / "eager.journal"));
+    for (uint32_t i = 1; i <= 5; ++i) {
+        eager.AppendFrame(Frame(i));
+    }
+    CHECK(eager.Syncs() >= 6);
+}
+
+TEST_CASE(PendingRecordsAreSyncedOnceTheDelayPasses) {
+    check::TempDir dir;
+    journal::Writer writer(journal::SyncPolicy{ 8, 200 });
+    REQUIRE(writer.Create(dir.Path() / "session.journal"));
+    // A single record then no more: the append alone reaches neither limit.
+    REQUIRE(writer.AppendFrame(Frame(1)));
+    CHECK(writer.PendingRecords() == 1);
+    CHECK(writer.SyncIfDue());
+    CHECK(writer.Syncs() == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    CHECK(writer.SyncIfDue());
+    CHECK(writer.Syncs() == 2);
+    CHECK(writer.PendingRecords() == 0);
+
+    // Nothing pending: the timer has nothing to do.
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    CHECK(writer.SyncIfDue());
+    CHECK(writer.Syncs() == 2);
+    CHECK(writer.Finish());
+}
+
+TEST_CASE(IncompleteSessionsAreFoundNewestFirst) {
+    check::TempDir dir;
+    const auto root = dir.Path();
+    const auto makeSession = [&root](const std::string& name, int frames, bool finish) {
+        std::filesystem::create_directories(root / name);
+        journal::Writer writer;
+        writer.Create(root / name / journal::kFileName);
+        for (int i = 1; i <= frames; ++i) {
+            writer.AppendFrame(Frame(static_cast<uint32_t>(i)));
+        }
+        if (finish) {
+            writer.Finish();
+        }
+    };
+    makeSession("20260101-080000", 3, false);
+    makeSession("20260101-090000", 2, true);
+    makeSession("20260101-100000", 0, false);
+    makeSession("20260101-110000", 5, false);
+    std::filesystem::create_directories(root / "no-journal");
+
+    auto sessions = journal::FindIncompleteSessions(root);
+    REQUIRE(sessions.size() == 2);
+    CHECK(sessions[0].root.filename() == "20260101-110000");
+    CHECK(sessions[0].frames == 5);
+    CHECK(sessions[1].root.filename() == "20260101-080000");
+    CHECK(sessions[1].frames == 3);
+
+    CHECK(journal::MarkAbandoned(sessions[0].root));
+    sessions = journal::FindIncompleteSessions(root);
+    REQUIRE(sessions.size() == 1);
+    CHECK(sessions[0].root.filename() == "20260101-080000");
+    CHECK(!journal::MarkAbandoned(root / "no-journal"));
+}
+
+} // namespace
@@ -0,0 +1,64 @@
+#include "Check.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace check {
+
+namespace {
+
+struct Case {
+    const char* name;
+    CaseFunction function;
+};
+
+std::vector<Case>& Cases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+std::atomic<int> g_failures{ 0 };
+std::atomic<uint64_t> g_tempCounter{ 0 };
+
+} // namespace
+
+Registrar::Registrar(const char* name, CaseFunction function) {
+    Cases().push_back({ name, function });
+}
+
+void Fail(const char* file, int line, const char* expression) {
+    ++g_failures;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+}
+
+TempDir::TempDir() {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    path_ = std::filesystem::temp_directory_path() /
+        ("chronos-test-" + std::to_string(stamp) + "-" + std::to_string(++g_tempCounter));
+    std::filesystem::create_directories(path_);
+}
+
+TempDir::~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path_, ec);
+}
+
+} // namespace check
+
+int main() {
+    int failedCases = 0;
+    for (const auto& testCase : check::Cases()) {
+        const int before = check::g_failures.load();
+        testCase.function();
+        const bool passed = check::g_failures.load() == before;
+        std::printf("[%s] %s\n", passed ? "PASS" : "FAIL", testCase.name);
+        if (!passed) {
+            ++failedCases;
+        }
+    }
+    std::printf("%d of %zu cases failed\n", failedCases, check::Cases().size());
+    return failedCases == 0 ? 0 : 1;
+}
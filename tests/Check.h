@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+// Minimal self-registering test cases. Each test executable links Check.cpp,
+// which provides main() and runs every TEST_CASE in the order it was defined.
+namespace check {
+
+using CaseFunction = void (*)();
+
+struct Registrar {
+    Registrar(const char* name, CaseFunction function);
+};
+
+void Fail(const char* file, int line, const char* expression);
+
+// Unique directory under the system temp path, removed with its contents.
+class TempDir {
+public:
+    TempDir();
+    ~TempDir();
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::filesystem::path& Path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+} // namespace check
+
+#define TEST_CASE(name)                                                   \
+    static void name();                                                   \
+    static const ::check::Registrar name##Registrar(#name, &name);        \
+    static void name()
+
+#define CHECK(expression)                                                 \
+    do {                                                                  \
+        if (!(expression)) {                                              \
+            ::check::Fail(__FILE__, __LINE__, #expression);               \
+        }                                                                 \
+    } while (0)
+
+// Like CHECK, but leaves the test case when it fails.
+#define REQUIRE(expression)                                               \
+    do {                                                                  \
+        if (!(expression)) {                                              \
+            ::check::Fail(__FILE__, __LINE__, #expression);               \
+            return;                                                       \
+        }                                                                 \
+    } while (0)
@@ -0,0 +1,98 @@
+#include "ChordMatcher.h"
+
+#include "Bench.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+
+namespace {
+
+// A typing-like stream: letters with a modifier now and then, and every so
+// often the toggle chord.
+std::array<std::pair<bool, uint8_t>, 64> MakeStream() {
+    std::array<std::pair<bool, uint8_t>, 64> stream{};
+    size_t i = 0;
+    for (uint8_t letter = 0; i + 6 <= stream.size(); ++letter) {
+        if (letter % 4 == 0) {
+            stream[i++] = { true, hotkey::kKeyLeftWin };
+            stream[i++] = { true, hotkey::kKeyRightShift };
+            stream[i++] = { false, hotkey::kKeyRightShift };
+            stream[i++] = { false, hotkey::kKeyLeftWin };
+        } else {
+            stream[i++] = { true, static_cast<uint8_t>(0x41 + letter % 26) };
+            stream[i++] = { false, static_cast<uint8_t>(0x41 + letter % 26) };
+        }
+    }
+    return stream;
+}
+
+// What HotkeyManager did before the matcher: a hash set of held keys and one
+// lookup per required key per binding.
+struct HashSetMatcher {
+    std::unordered_set<uint32_t> keysDown;
+    std::array<std::array<uint32_t, 3>, 5> chords{ { { hotkey::kKeyLeftWin, hotkey::kKeyRightShift, 0 },
+                                                     { hotkey::kKeyLeftControl, 0x78, 0 },
+                                                     { hotkey::kKeyLeftControl, 0x79, 0 },
+                                                     { hotkey::kKeyLeftControl, 0x7A, 0 },
+                                                     { hotkey::kKeyLeftControl, hotkey::kKeyLeftShift, 0x7B } } };
+
+    size_t Event(bool down, uint32_t key) {
+        if (!down) {
+            keysDown.erase(key);
+            return 0;
+        }
+        keysDown.insert(key);
+        size_t fired = 0;
+        for (const auto& chord : chords) {
+            bool all = true;
+            for (auto required : chord) {
+                all = all && (required == 0 || keysDown.count(required) > 0);
+            }
+            fired += all ? 1 : 0;
+        }
+        return fired;
+    }
+};
+
+hotkey::KeySet Keys(std::initializer_list<uint8_t> keys) {
+    hotkey::KeySet set;
+    for (auto key : keys) {
+        set.Set(key);
+    }
+    return set;
+}
+
+} // namespace
+
+int main() {
+    const auto stream = MakeStream();
+
+    hotkey::ChordMatcher matcher;
+    matcher.Bind(hotkey::Action::Toggle, Keys({ hotkey::kKeyAnyWin, hotkey::kKeyRightShift }));
+    matcher.Bind(hotkey::Action::CaptureNow, Keys({ hotkey::kKeyControl, 0x78 }));
+    matcher.Bind(hotkey::Action::CancelSession, Keys({ hotkey::kKeyControl, 0x79 }));
+    matcher.Bind(hotkey::Action::DropLastFrame, Keys({ hotkey::kKeyControl, 0x7A }));
+    matcher.Bind(hotkey::Action::Republish, Keys({ hotkey::kKeyControl, hotkey::kKeyShift, 0x7B }));
+    bench::Run("ChordMatcher, 64 events, 5 bindings", 0, [&] {
+        size_t fired = 0;
+        for (const auto& [down, key] : stream) {
+            if (down) {
+                fired += matcher.KeyDown(key) ? 1 : 0;
+            } else {
+                matcher.KeyUp(key);
+            }
+        }
+        return fired;
+    });
+
+    HashSetMatcher baseline;
+    bench::Run("unordered_set baseline, 64 events", 0, [&] {
+        size_t fired = 0;
+        for (const auto& [down, key] : stream) {
+            fired += baseline.Event(down, key);
+        }
+        return fired;
+    });
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include "ChordMatcher.h"
+
+#include "Check.h"
+
+#include <cstdio>
+#include <initializer_list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using hotkey::Action;
+
+const std::map<std::string, uint32_t> kKeys = {
+    { "LWin", hotkey::kKeyLeftWin },
+    { "RWin", hotkey::kKeyRightWin },
+    { "LShift", hotkey::kKeyLeftShift },
+    { "RShift", hotkey::kKeyRightShift },
+    { "LCtrl", hotkey::kKeyLeftControl },
+    { "RCtrl", hotkey::kKeyRightControl },
+    { "LAlt", hotkey::kKeyLeftMenu },
+    { "Back", 0x08 },
+    { "A", 0x41 },
+    { "F9", 0x78 },
+    { "Wide", 0x1FF },
+};
+
+const char* ActionName(Action action) {
+    switch (action) {
+        case Action::Toggle:
+            return "Toggle";
+        case Action::CaptureNow:
+            return "CaptureNow";
+        case Action::CancelSession:
+            return "CancelSession";
+        case Action::DropLastFrame:
+            return "DropLastFrame";
+        case Action::Republish:
+            return "Republish";
+        default:
+            return "?";
+    }
+}
+
+hotkey::KeySet Keys(std::initializer_list<uint8_t> keys) {
+    hotkey::KeySet set;
+    for (auto key : keys) {
+        set.Set(key);
+    }
+    return set;
+}
+
+// The default toggle: Win + right Shift (ShiftMode::RightOnly).
+const auto kWinRightShift = Keys({ hotkey::kKeyAnyWin, hotkey::kKeyRightShift });
+
+struct Row {
+    const char* name;
+    std::vector<std::pair<Action, hotkey::KeySet>> bindings;
+    // "+Key" presses, "-Key" releases.
+    const char* script;
+    // Actions fired, in order.
+    const char* expected;
+};
+
+const Row kRows[] = {
+    { "toggle fires on the last key down", { { Action::Toggle, kWinRightShift } },
+      "+LWin +RShift", "Toggle" },
+    { "order of presses does not matter", { { Action::Toggle, kWinRightShift } },
+      "+RShift +RWin", "Toggle" },
+    { "auto-repeat stays latched", { { Action::Toggle, kWinRightShift } },
+      "+LWin +RShift +RShift +RShift", "Toggle" },
+    { "releasing the key re-arms", { { Action::Toggle, kWinRightShift } },
+      "+LWin +RShift -RShift +RShift", "Toggle Toggle" },
+    { "right-only rejects left shift", { { Action::Toggle, kWinRightShift } },
+      "+LWin +LShift", "" },
+    { "any shift accepts either side", { { Action::Toggle, Keys({ hotkey::kKeyAnyWin, hotkey::kKeyShift }) } },
+      "+RWin +LShift -LShift +RShift", "Toggle Toggle" },
+    { "generic shift stays while one side is held", { { Action::Toggle, Keys({ hotkey::kKeyShift, 0x78 }) } },
+      "+LShift +RShift -LShift +F9", "Toggle" },
+    { "modifier release re-arms with the key still held", { { Action::CaptureNow, Keys({ hotkey::kKeyControl, 0x78 }) } },
+      "+LCtrl +F9 +F9 -LCtrl +RCtrl", "CaptureNow CaptureNow" },
+    { "most specific chord wins", { { Action::Toggle, Keys({ hotkey::kKeyControl, 0x78 }) }, { Action::Republish, Keys({ hotkey::kKeyControl, hotkey::kKeyShift, 0x78 }) } },
+      "+LCtrl +LShift +F9 -LShift +A", "Republish Toggle" },
+    { "subset fires when the superset is incomplete", { { Action::Toggle, Keys({ hotkey::kKeyControl, 0x78 }) }, { Action::Republish, Keys({ hotkey::kKeyControl, hotkey::kKeyShift, 0x78 }) } },
+      "+LCtrl +F9 +LShift", "Toggle Republish" },
+    { "disjoint bindings fire independently", { { Action::Toggle, kWinRightShift }, { Action::DropLastFrame, Keys({ hotkey::kKeyAnyWin, 0x08 }) } },
+      "+LWin +Back +RShift -Back +Back", "DropLastFrame Toggle DropLastFrame" },
+    { "unrelated keys neither fire nor re-arm", { { Action::Toggle, kWinRightShift } },
+      "+LWin +RShift +A -A +A", "Toggle" },
+    { "codes above 0xFF are ignored", { { Action::Toggle, kWinRightShift } },
+      "+LWin +Wide +RShift -Wide", "Toggle" },
+    { "alt chord", { { Action::CancelSession, Keys({ hotkey::kKeyMenu, 0x08 }) } },
+      "+LAlt +Back", "CancelSession" },
+    { "nothing bound", {}, "+LWin +RShift", "" },
+};
+
+std::string Run(hotkey::ChordMatcher& matcher, const char* script) {
+    std::istringstream tokens(script);
+    std::string token;
+    std::string fired;
+    while (tokens >> token) {
+        const auto key = kKeys.at(token.substr(1));
+        if (token[0] == '+') {
+            if (const auto action = matcher.KeyDown(key)) {
+                fired += fired.empty() ? "" : " ";
+                fired += ActionName(*action);
+            }
+        } else {
+            matcher.KeyUp(key);
+        }
+    }
+    return fired;
+}
+
+TEST_CASE(TableOfChords) {
+    for (const auto& row : kRows) {
+        hotkey::ChordMatcher matcher;
+        for (const auto& [action, keys] : row.bindings) {
+            matcher.Bind(action, keys);
+        }
+        const auto fired = Run(matcher, row.script);
+        if (fired != row.expected) {
+            std::printf("  %s: fired \"%s\", expected \"%s\"\n", row.name, fired.c_str(), row.expected);
+        }
+        CHECK(fired == row.expected);
+    }
+}
+
+TEST_CASE(RebindingAndReset) {
+    hotkey::ChordMatcher matcher;
+    matcher.Bind(Action::Toggle, kWinRightShift);
+    CHECK(Run(matcher, "+LWin +RShift") == "Toggle");
+
+    // Clearing a binding disables it; the held keys are kept.
+    matcher.Bind(Action::Toggle, hotkey::KeySet{});
+    CHECK(Run(matcher, "-RShift +RShift") == "");
+
+    matcher.Bind(Action::Toggle, kWinRightShift);
+    matcher.ResetState();
+    CHECK(matcher.Held().Empty());
+    CHECK(Run(matcher, "+RShift") == "");
+    CHECK(Run(matcher, "+LWin") == "Toggle");
+
+    matcher.ClearBindings();
+    CHECK(Run(matcher, "-LWin +LWin") == "");
+}
+
+TEST_CASE(KeySetBasics) {
+    auto keys = Keys({ 0, 63, 64, 255 });
+    CHECK(keys.Count() == 4);
+    CHECK(keys.Test(255));
+    CHECK(keys.Contains(Keys({ 63, 64 })));
+    CHECK(!keys.Contains(Keys({ 63, 65 })));
+    keys.Reset(255);
+    CHECK(!keys.Test(255));
+    keys.Clear();
+    CHECK(keys.Empty());
+}
+
+} // namespace
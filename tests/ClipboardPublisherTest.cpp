@@ -0,0 +1,222 @@
+#include "ClipboardPublisher.h"
+
+#include "Check.h"
+#include "EndOfListDetector.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Records what the publisher offers and renders instead of touching an OS clipboard.
+class FakeClipboard : public ClipboardBackend {
+public:
+    bool Open() override { return !open_ && (open_ = true); }
+    void Close() override { open_ = false; }
+    bool Empty() override {
+        offered.clear();
+        data.clear();
+        owner = true;
+        return open_;
+    }
+    bool IsOwner() const override { return owner; }
+    bool Offer(ClipboardFormat format) override {
+        offered.push_back(format);
+        return true;
+    }
+    bool Provide(ClipboardFormat format, size_t size, const Writer& write) override {
+        std::vector<uint8_t> block(size);
+        if (size == 0 || !write(block.data(), block.size())) {
+            return false;
+        }
+        data[format] = std::move(block);
+        return true;
+    }
+
+    bool Offers(ClipboardFormat format) const {
+        return std::find(offered.begin(), offered.end(), format) != offered.end();
+    }
+
+    std::vector<ClipboardFormat> offered;
+    std::map<ClipboardFormat, std::vector<uint8_t>> data;
+    bool owner = false;
+
+private:
+    bool open_ = false;
+};
+
+// A 4x2 frame whose "PNG" is its fill byte, so FakeDecode can rebuild it.
+Frame MakeFrame(size_t index, uint8_t fill) {
+    Frame frame;
+    frame.index = index;
+    frame.width = 4;
+    frame.height = 2;
+    frame.stride = frame.width * 4;
+    frame.pixels = std::make_shared<ByteBuffer>(static_cast<size_t>(frame.stride) * frame.height, fill);
+    frame.png = std::make_shared<ByteBuffer>(1, fill);
+    return frame;
+}
+
+std::shared_ptr<const ByteBuffer> FakeDecode(const Frame& frame) {
+    return std::make_shared<ByteBuffer>(static_cast<size_t>(frame.width) * 4 * frame.height, (*frame.png)[0]);
+}
+
+motion::ShiftEstimate Shift(uint32_t rows) {
+    motion::ShiftEstimate estimate;
+    estimate.valid = true;
+    estimate.shift = rows;
+    estimate.matchRatio = 1.0;
+    return estimate;
+}
+
+// Captures frames 1..5 where the last two did not move, then trims them the
+// way CaptureSession::DropTrailingDuplicates does.
+void CaptureAndTrim(FrameStore& store) {
+    EndOfListDetector detector(EndOfListSettings{ 2, 0 });
+    const uint32_t shifts[] = { 40, 40, 0, 0 };
+    store.Add(MakeFrame(1, 0x10));
+    for (uint8_t i = 0; i < 4; ++i) {
+        store.Add(MakeFrame(i + 2u, static_cast<uint8_t>(0x20 + 0x10 * i)));
+        detector.Observe(Shift(shifts[i]));
+    }
+    const uint32_t duplicates = detector.TakeTrailingDuplicates();
+    for (uint32_t i = 0; i < duplicates; ++i) {
+        store.DropLast(false);
+    }
+    store.RestoreLastPixels();
+}
+
+TEST_CASE(FramePublishedAfterTrimStillOffersDib) {
+    FrameStore store;
+    store.SetPixelDecoder(&FakeDecode);
+    CaptureAndTrim(store);
+    REQUIRE(store.Size() == 3);
+    CHECK(store.Last().index == 3);
+
+    FakeClipboard clipboard;
+    ClipboardPublisher publisher;
+    // Published from a copy of the list, as the processing job does.
+    const std::vector<Frame> frames(store.Frames().begin(), store.Frames().end());
+    REQUIRE(publisher.Publish(clipboard, frames, false));
+    CHECK(clipboard.Offers(ClipboardFormat::Dib));
+    CHECK(clipboard.Offers(ClipboardFormat::Png));
+
+    REQUIRE(publisher.Render(clipboard, ClipboardFormat::Dib));
+    const auto& dib = clipboard.data[ClipboardFormat::Dib];
+    REQUIRE(dib.size() > 32);
+    CHECK(dib.back() == 0x30);
+}
+
+TEST_CASE(TrimWithoutDecoderFallsBackToPngOnly) {
+    FrameStore store;
+    CaptureAndTrim(store);
+    FakeClipboard clipboard;
+    ClipboardPublisher publisher;
+    // Published from a copy of the list, as the processing job does.
+    const std::vector<Frame> frames(store.Frames().begin(), store.Frames().end());
+    REQUIRE(publisher.Publish(clipboard, frames, false));
+    CHECK(!clipboard.Offers(ClipboardFormat::Dib));
+    CHECK(clipboard.Offers(ClipboardFormat::Png));
+}
+
+uint32_t ReadU32(const std::vector<uint8_t>& data, size_t offset) {
+    return static_cast<uint32_t>(data[offset]) | (static_cast<uint32_t>(data[offset + 1]) << 8) |
+           (static_cast<uint32_t>(data[offset + 2]) << 16) | (static_cast<uint32_t>(data[offset + 3]) << 24);
+}
+
+TEST_CASE(PublishOffersFormatsWithoutConverting) {
+    auto frame = MakeFrame(1, 0x42);
+    frame.path = L"/tmp/shot_0001.png";
+    FakeClipboard clipboard;
+    ClipboardPublisher publisher;
+    REQUIRE(publisher.Publish(clipboard, { frame }, true));
+    CHECK(publisher.HasContent());
+    CHECK((clipboard.offered == std::vector<ClipboardFormat>{ ClipboardFormat::FileList, ClipboardFormat::Dib, ClipboardFormat::Png }));
+    CHECK(clipboard.data.empty());
+}
+
+TEST_CASE(RenderProducesEachFormatOnDemand) {
+    const size_t clipboardBefore = memory::Get(memory::Tag::Clipboard).current;
+    auto first = MakeFrame(1, 0x11);
+    first.path = L"C:\\s\\1.png";
+    auto last = MakeFrame(2, 0x22);
+    last.path = L"C:\\s\\2.png";
+    FakeClipboard clipboard;
+    ClipboardPublisher publisher;
+    REQUIRE(publisher.Publish(clipboard, { first, last }, true));
+
+    REQUIRE(publisher.Render(clipboard, ClipboardFormat::Dib));
+    CHECK(clipboard.data.size() == 1);
+    const auto& dib = clipboard.data[ClipboardFormat::Dib];
+    REQUIRE(dib.size() == 40 + 4 * 4 * 2);
+    CHECK(ReadU32(dib, 0) == 40);
+    CHECK(ReadU32(dib, 4) == 4);
+    // Negative height: top-down rows.
+    CHECK(static_cast<int32_t>(ReadU32(dib, 8)) == -2);
+    CHECK(dib[40] == 0x22);
+    CHECK(memory::Get(memory::Tag::Clipboard).current == clipboardBefore + dib.size());
+
+    // Rendering again replaces the data but is charged once.
+    REQUIRE(publisher.Render(clipboard, ClipboardFormat::Dib));
+    CHECK(memory::Get(memory::Tag::Clipboard).current == clipboardBefore + dib.size());
+
+    REQUIRE(publisher.Render(clipboard, ClipboardFormat::Png));
+    CHECK(clipboard.data[ClipboardFormat::Png] == std::vector<uint8_t>{ 0x22 });
+
+    REQUIRE(publisher.Render(clipboard, ClipboardFormat::FileList));
+    const auto& drop = clipboard.data[ClipboardFormat::FileList];
+    // DROPFILES (20 bytes, wide), two 10-unit paths with terminators, final null.
+    REQUIRE(drop.size() == 20 + (11 + 11 + 1) * 2);
+    CHECK(ReadU32(drop, 0) == 20);
+    CHECK(ReadU32(drop, 16) == 1);
+    CHECK(drop[20] == 'C');
+    CHECK(drop[20 + 11 * 2] == 'C');
+    CHECK(drop[20 + 11 * 2 + 5 * 2] == '2');
+    CHECK(drop[drop.size() - 2] == 0);
+
+    publisher.Release();
+    CHECK(!publisher.HasContent());
+    CHECK(memory::Get(memory::Tag::Clipboard).current == clipboardBefore);
+    CHECK(!publisher.Render(clipboard, ClipboardFormat::Png));
+}
+
+TEST_CASE(OnlyOfferedFormatsRender) {
+    FakeClipboard clipboard;
+    ClipboardPublisher publisher;
+    REQUIRE(publisher.Publish(clipboard, { MakeFrame(1, 0x42) }, false));
+    CHECK(!clipboard.Offers(ClipboardFormat::FileList));
+    CHECK(!publisher.Render(clipboard, ClipboardFormat::FileList));
+
+    // A file list is only offered when a frame has a path.
+    ClipboardPublisher withList;
+    REQUIRE(withList.Publish(clipboard, { MakeFrame(1, 0x42) }, true));
+    CHECK(!clipboard.Offers(ClipboardFormat::FileList));
+}
+
+TEST_CASE(RenderAllOnlyWhileStillOwner) {
+    FakeClipboard clipboard;
+    ClipboardPublisher publisher;
+    REQUIRE(publisher.Publish(clipboard, { MakeFrame(1, 0x42) }, false));
+    clipboard.owner = false;
+    CHECK(!publisher.RenderAll(clipboard));
+    CHECK(clipboard.data.empty());
+
+    clipboard.owner = true;
+    REQUIRE(publisher.RenderAll(clipboard));
+    CHECK(clipboard.data.count(ClipboardFormat::Dib) == 1);
+    CHECK(clipboard.data.count(ClipboardFormat::Png) == 1);
+}
+
+TEST_CASE(PublishFailsWhenTheClipboardIsBusy) {
+    FakeClipboard clipboard;
+    REQUIRE(clipboard.Open());
+    ClipboardPublisher publisher;
+    CHECK(!publisher.Publish(clipboard, { MakeFrame(1, 0x42) }, false));
+    CHECK(!publisher.HasContent());
+    clipboard.Close();
+    CHECK(!publisher.Publish(clipboard, {}, false));
+}
+
+} // namespace
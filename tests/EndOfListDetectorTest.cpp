@@ -0,0 +1,130 @@
+#include "EndOfListDetector.h"
+
+#include "Check.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace {
+
+// -1 stands for an unmeasurable frame (no estimate), -2 for an invalid one.
+std::optional<motion::ShiftEstimate> Shift(int value) {
+    if (value == -1) {
+        return std::nullopt;
+    }
+    motion::ShiftEstimate estimate;
+    estimate.valid = value >= 0;
+    estimate.shift = value >= 0 ? static_cast<uint32_t>(value) : 0;
+    estimate.matchRatio = estimate.valid ? 1.0 : 0.0;
+    return estimate;
+}
+
+struct Row {
+    EndOfListSettings settings;
+    std::vector<int> shifts;
+    // Index of the observation that reports the end, or -1.
+    int reachedAt;
+    uint32_t duplicates;
+};
+
+const Row kRows[] = {
+    { { 2, 0 }, { 40, 40, 0, 0 }, 3, 2 },
+    { { 2, 0 }, { 40, 0, 40, 0, 40 }, -1, 0 },
+    { { 3, 0 }, { 40, 0, 0, 0, 0 }, 3, 3 },
+    { { 1, 0 }, { 0 }, 0, 1 },
+    // Small jitter counts as still only within the tolerance.
+    { { 2, 2 }, { 40, 2, 1 }, 2, 2 },
+    { { 2, 1 }, { 40, 2, 1, 1 }, 3, 2 },
+    // Unmeasurable and invalid frames break a still run.
+    { { 2, 0 }, { 0, -1, 0, -2, 0, 0 }, 5, 2 },
+    // Disabled.
+    { { 0, 0 }, { 0, 0, 0, 0 }, -1, 0 },
+};
+
+TEST_CASE(SyntheticShiftSequences) {
+    for (const auto& row : kRows) {
+        EndOfListDetector detector(row.settings);
+        int reachedAt = -1;
+        for (size_t i = 0; i < row.shifts.size(); ++i) {
+            if (detector.Observe(Shift(row.shifts[i])) && reachedAt < 0) {
+                reachedAt = static_cast<int>(i);
+            }
+        }
+        CHECK(reachedAt == row.reachedAt);
+        CHECK(detector.Reached() == (row.reachedAt >= 0));
+        if (row.reachedAt >= 0) {
+            CHECK(detector.TrailingDuplicates() == row.duplicates);
+        }
+    }
+}
+
+TEST_CASE(ReachedLatchesUntilReset) {
+    EndOfListDetector detector(EndOfListSettings{ 2, 0 });
+    detector.Observe(Shift(0));
+    CHECK(detector.Observe(Shift(0)));
+    // Motion afterwards does not un-reach the end or change the count.
+    CHECK(detector.Observe(Shift(40)));
+    CHECK(detector.TakeTrailingDuplicates() == 2);
+    CHECK(detector.TakeTrailingDuplicates() == 0);
+    detector.Reset();
+    CHECK(!detector.Reached());
+    CHECK(!detector.Observe(Shift(0)));
+}
+
+// A 3000-row list seen through a 200-row window with a 20-row fixed header.
+constexpr uint32_t kWidth = 64;
+constexpr uint32_t kListRows = 3000;
+constexpr uint32_t kViewRows = 200;
+constexpr uint32_t kHeaderRows = 20;
+
+uint8_t RowByte(uint32_t y, uint32_t band, uint32_t channel) {
+    uint32_t h = y * 2654435761u + band * 40503u + channel * 977u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return static_cast<uint8_t>(h >> 24);
+}
+
+std::vector<uint8_t> RenderView(uint32_t offset) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(kWidth) * 4 * kViewRows);
+    for (uint32_t y = 0; y < kViewRows; ++y) {
+        const uint32_t source = y < kHeaderRows ? kListRows + y : offset + y;
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            const uint32_t band = x * 4 / kWidth;
+            uint8_t* px = &pixels[(static_cast<size_t>(y) * kWidth + x) * 4];
+            px[0] = RowByte(source, band, 0);
+            px[1] = RowByte(source, band, 1);
+            px[2] = RowByte(source, band, 2);
+            px[3] = 0;
+        }
+    }
+    return pixels;
+}
+
+TEST_CASE(DetectsTheBottomOfARenderedList) {
+    EndOfListDetector detector(EndOfListSettings{ 2, 0 });
+    const uint32_t bottom = kListRows - kViewRows;
+    std::vector<motion::RowSignature> previous;
+    uint32_t offset = 0;
+    uint32_t captures = 0;
+    uint32_t capturesAtBottom = 0;
+    while (!detector.Reached() && captures < 100) {
+        auto view = RenderView(offset);
+        auto signatures = motion::ComputeRowSignatures(view.data(), kWidth, kViewRows, kWidth * 4);
+        if (!previous.empty()) {
+            detector.Observe(motion::EstimateShift(previous, signatures));
+        }
+        previous = std::move(signatures);
+        ++captures;
+        capturesAtBottom += offset == bottom ? 1 : 0;
+        // Each scroll moves 70 rows until the list cannot go further.
+        offset = (std::min)(offset + 70, bottom);
+    }
+    REQUIRE(detector.Reached());
+    // The first frame at the bottom is new content; the two after it repeat it.
+    CHECK(capturesAtBottom == 3);
+    CHECK(detector.TakeTrailingDuplicates() == 2);
+}
+
+} // namespace
@@ -0,0 +1,132 @@
+#include "FileWatcher.h"
+
+#include "Check.h"
+#include "IniDocument.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+void WriteText(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+}
+
+// Waits up to `timeout` for `count` to reach `expected`.
+bool WaitFor(const std::atomic<int>& count, int expected, std::chrono::milliseconds timeout = 3s) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (count.load() < expected) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+TEST_CASE(AtomicSaveIsReportedOnce) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    WriteText(path, "[capture]\r\nscrollsPerCapture=3\r\n");
+    std::atomic<int> changes{ 0 };
+    auto watcher = FileWatcher::Create();
+    REQUIRE(watcher->Start(path, [&changes] { ++changes; }));
+
+    IniDocument document;
+    REQUIRE(document.Load(path));
+    document.SetInt("capture", "scrollsPerCapture", 5);
+    REQUIRE(document.Save(path));
+    CHECK(WaitFor(changes, 1));
+    std::this_thread::sleep_for(400ms);
+    CHECK(changes.load() == 1);
+    watcher->Stop();
+}
+
+TEST_CASE(BurstsAreCoalesced) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    WriteText(path, "a=0\n");
+    std::atomic<int> changes{ 0 };
+    auto watcher = FileWatcher::Create();
+    REQUIRE(watcher->Start(path, [&changes] { ++changes; }));
+
+    // In-place writes and replacements, faster than the settle period.
+    for (int i = 1; i <= 5; ++i) {
+        if (i % 2 == 0) {
+            WriteText(path, "a=" + std::to_string(i) + "\n");
+        } else {
+            const auto temp = dir.Path() / "config.ini.tmp";
+            WriteText(temp, "a=" + std::to_string(i) + "\n");
+            std::filesystem::rename(temp, path);
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    CHECK(WaitFor(changes, 1));
+    std::this_thread::sleep_for(400ms);
+    CHECK(changes.load() == 1);
+    watcher->Stop();
+}
+
+TEST_CASE(OtherFilesInTheDirectoryAreIgnored) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    WriteText(path, "a=0\n");
+    std::atomic<int> changes{ 0 };
+    auto watcher = FileWatcher::Create();
+    REQUIRE(watcher->Start(path, [&changes] { ++changes; }));
+
+    WriteText(dir.Path() / "other.ini", "b=1\n");
+    WriteText(dir.Path() / "config.ini.bak", "a=1\n");
+    std::filesystem::create_directories(dir.Path() / "sub");
+    WriteText(dir.Path() / "sub" / "config.ini", "a=2\n");
+    std::this_thread::sleep_for(400ms);
+    CHECK(changes.load() == 0);
+
+    // A file created after Start() is reported too.
+    std::filesystem::remove(path);
+    WriteText(path, "a=3\n");
+    CHECK(WaitFor(changes, 1));
+    watcher->Stop();
+}
+
+TEST_CASE(StopIsPromptAndFinal) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    std::atomic<int> changes{ 0 };
+    auto watcher = FileWatcher::Create();
+    REQUIRE(watcher->Start(path, [&changes] { ++changes; }));
+
+    // A change still settling when Stop() is called is dropped.
+    WriteText(path, "a=1\n");
+    const auto started = std::chrono::steady_clock::now();
+    watcher->Stop();
+    CHECK(std::chrono::steady_clock::now() - started < 1s);
+    WriteText(path, "a=2\n");
+    std::this_thread::sleep_for(400ms);
+    CHECK(changes.load() == 0);
+
+    // The watcher can be started again, also on another file.
+    const auto other = dir.Path() / "settings.ini";
+    REQUIRE(watcher->Start(other, [&changes] { ++changes; }));
+    WriteText(path, "a=3\n");
+    WriteText(other, "b=1\n");
+    CHECK(WaitFor(changes, 1));
+    std::this_thread::sleep_for(400ms);
+    CHECK(changes.load() == 1);
+    watcher.reset();
+}
+
+TEST_CASE(MissingDirectoryFailsToStart) {
+    check::TempDir dir;
+    auto watcher = FileWatcher::Create();
+    CHECK(!watcher->Start(dir.Path() / "missing" / "config.ini", [] {}));
+    watcher->Stop();
+}
+
+} // namespace
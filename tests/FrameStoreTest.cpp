@@ -0,0 +1,92 @@
+#include "FrameStore.h"
+
+#include "Check.h"
+#include "ClipboardData.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+// A 4x2 frame whose "PNG" is just its fill byte, so the fake decoder can
+// rebuild its pixels exactly.
+Frame MakeFrame(size_t index, uint8_t fill) {
+    Frame frame;
+    frame.index = index;
+    frame.width = 4;
+    frame.height = 2;
+    frame.stride = frame.width * 4;
+    frame.pixels = std::make_shared<ByteBuffer>(static_cast<size_t>(frame.stride) * frame.height, fill);
+    frame.png = std::make_shared<ByteBuffer>(1, fill);
+    return frame;
+}
+
+std::shared_ptr<const ByteBuffer> FakeDecode(const Frame& frame) {
+    return std::make_shared<ByteBuffer>(static_cast<size_t>(frame.width) * 4 * frame.height, (*frame.png)[0]);
+}
+
+bool OffersDib(const Frame& frame) {
+    std::vector<uint8_t> packet(clipboard::DibPacketSize(frame));
+    return !packet.empty() && clipboard::WriteDibPacket(frame, packet.data(), packet.size());
+}
+
+TEST_CASE(OnlyTheLastFrameKeepsPixels) {
+    FrameStore store;
+    store.Add(MakeFrame(1, 0x11));
+    store.Add(MakeFrame(2, 0x22));
+    REQUIRE(store.Size() == 2);
+    CHECK(!store.Frames()[0].pixels);
+    CHECK(store.Frames()[0].png);
+    CHECK(store.Last().pixels);
+    CHECK(OffersDib(store.Last()));
+}
+
+TEST_CASE(DropLastRestoresPixelsOfTheNewLastFrame) {
+    FrameStore store;
+    store.SetPixelDecoder(&FakeDecode);
+    store.Add(MakeFrame(1, 0x11));
+    store.Add(MakeFrame(2, 0x22));
+    store.Add(MakeFrame(3, 0x33));
+
+    CHECK(store.DropLast());
+    REQUIRE(store.Last().pixels);
+    CHECK(store.Last().index == 2);
+    CHECK(store.Last().stride == 16);
+    CHECK((*store.Last().pixels)[0] == 0x22);
+    CHECK(OffersDib(store.Last()));
+    CHECK(!store.Frames()[0].pixels);
+
+    CHECK(store.DropLast());
+    CHECK(OffersDib(store.Last()));
+    CHECK(store.DropLast());
+    CHECK(store.Empty());
+    CHECK(!store.DropLast());
+}
+
+TEST_CASE(DropLastWithoutPixelsWhenDecodingFails) {
+    FrameStore store;
+    store.SetPixelDecoder([](const Frame&) { return std::shared_ptr<const ByteBuffer>(); });
+    store.Add(MakeFrame(1, 0x11));
+    store.Add(MakeFrame(2, 0x22));
+    CHECK(store.DropLast());
+    CHECK(!store.Last().pixels);
+    CHECK(clipboard::DibPacketSize(store.Last()) == 0);
+}
+
+TEST_CASE(ReplaceLastLeavesEarlierFramesAlone) {
+    int decodes = 0;
+    FrameStore store;
+    store.SetPixelDecoder([&decodes](const Frame& frame) {
+        ++decodes;
+        return FakeDecode(frame);
+    });
+    store.Add(MakeFrame(1, 0x11));
+    store.Add(MakeFrame(2, 0x22));
+    store.ReplaceLast(MakeFrame(2, 0x44));
+    CHECK(decodes == 0);
+    CHECK(store.Size() == 2);
+    CHECK((*store.Last().pixels)[0] == 0x44);
+    CHECK(!store.Frames()[0].pixels);
+}
+
+} // namespace
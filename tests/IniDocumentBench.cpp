@@ -0,0 +1,112 @@
+#include "IniDocument.h"
+
+#include "Bench.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// The shipped config.ini.
+const char kConfig[] =
+    "[hotkey]\r\nprimaryKey=VK_RSHIFT\r\nrequireWin=1\r\nrequireCtrl=0\r\nrequireAlt=0\r\nrequireShift=0\r\nshiftMode=RightOnly\r\n"
+    "[paths]\r\noutputDirectory=output\r\nsessionDirectory=temp\\sessions\r\nobjectDirectory=temp\\objects\r\n"
+    "maxSessionBytes=2G\r\nmaxSessionAge=30d\r\nkeepLastN=20\r\n"
+    "[capture]\r\nscrollsPerCapture=3\r\nclipboardMode=LastFrame\r\nadaptiveCadence=0\r\ntargetOverlapPercent=25\r\n"
+    "scrollPacing=0\r\nmaxPendingCaptures=1\r\nautoScroll=0\r\nendOfListFrames=2\r\nendOfListTolerance=0\r\n"
+    "maxInFlightSessions=2\r\nmaxPublishedSets=5\r\nmemoryBudgetMegabytes=512\r\ndedupeFrames=0\r\n"
+    "[bindings]\r\ncaptureNow=\r\ncancelSession=\r\ndropLastFrame=\r\nrepublish=\r\n"
+    "[debug]\r\nrecordInput=0\r\n";
+
+// Every (section, key) in kConfig, in file order.
+std::vector<std::pair<std::string, std::string>> Keys() {
+    std::vector<std::pair<std::string, std::string>> keys;
+    std::string section;
+    const std::string text = kConfig;
+    size_t start = 0;
+    while (start < text.size()) {
+        const auto end = text.find("\r\n", start);
+        const auto line = text.substr(start, end - start);
+        start = end + 2;
+        if (line.front() == '[') {
+            section = line.substr(1, line.size() - 2);
+        } else {
+            keys.emplace_back(section, line.substr(0, line.find('=')));
+        }
+    }
+    return keys;
+}
+
+} // namespace
+
+int main() {
+    const auto dir = std::filesystem::temp_directory_path() / "chronos-ini-bench";
+    std::filesystem::create_directories(dir);
+    const auto path = dir / "config.ini";
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << kConfig;
+    }
+    const auto keys = Keys();
+    std::printf("%zu keys, %zu bytes\n", keys.size(), sizeof(kConfig) - 1);
+
+    bench::Run("Parse + Serialize in memory", sizeof(kConfig) - 1, [&] {
+        IniDocument document;
+        document.Parse(kConfig);
+        return document.Serialize().size();
+    });
+
+    // What ConfigManager does at startup now: one read, typed lookups, and a
+    // Save() that writes nothing because nothing changed.
+    bench::Run("startup: load once, read all, clean save", 0, [&] {
+        IniDocument document;
+        document.Load(path);
+        size_t found = 0;
+        for (const auto& [section, key] : keys) {
+            found += document.Has(section, key) ? 1 : 0;
+        }
+        for (const auto& [section, key] : keys) {
+            document.Set(section, key, document.GetString(section, key, ""));
+        }
+        if (document.Dirty()) {
+            document.Save(path);
+        }
+        return found;
+    });
+
+    // The profile API cost model: every read reopens and reparses the file and
+    // every write rewrites it (Load made one call per key, Save nine writes).
+    bench::Run("profile API model: reparse per key", 0, [&] {
+        size_t found = 0;
+        for (const auto& [section, key] : keys) {
+            IniDocument document;
+            document.Load(path);
+            found += document.Has(section, key) ? 1 : 0;
+        }
+        for (size_t i = 0; i < 9; ++i) {
+            // WritePrivateProfileString rewrites the file even for an unchanged value.
+            IniDocument document;
+            document.Load(path);
+            const auto& [section, key] = keys[i];
+            document.Set(section, key, document.GetString(section, key, ""));
+            document.Save(path);
+        }
+        return found;
+    });
+
+    bool toggle = false;
+    bench::Run("dirty save (temp + rename)", 0, [&] {
+        IniDocument document;
+        document.Load(path);
+        toggle = !toggle;
+        document.SetBool("debug", "recordInput", toggle);
+        return static_cast<size_t>(document.Save(path));
+    });
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "IniDocument.h"
+
+#include "Check.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+void WriteBytes(const std::filesystem::path& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+std::string ReadBytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// "[paths]\r\nroot=Caf\u00e9\r\n" as UTF-16 with a BOM.
+std::string Utf16Sample(bool bigEndian) {
+    const std::u16string units = u"[paths]\r\nroot=Caf\u00e9\r\n";
+    std::string bytes = bigEndian ? "\xFE\xFF" : "\xFF\xFE";
+    for (const char16_t unit : units) {
+        const auto high = static_cast<char>(unit >> 8);
+        const auto low = static_cast<char>(unit & 0xFF);
+        bytes.push_back(bigEndian ? high : low);
+        bytes.push_back(bigEndian ? low : high);
+    }
+    return bytes;
+}
+
+TEST_CASE(RoundTripKeepsUntouchedLinesVerbatim) {
+    const std::string text =
+        "; chronos settings\r\n"
+        "[Capture]\r\n"
+        "  interval = 250  \r\n"
+        "# unknown=kept\r\n"
+        "custom=1\r\n"
+        "\r\n"
+        "[extra]\r\n"
+        "name=value\r\n";
+    IniDocument document;
+    document.Parse(text);
+    CHECK(document.Serialize() == text);
+    CHECK(document.GetInt("capture", "INTERVAL", 0) == 250);
+    CHECK(!document.Has("capture", "unknown"));
+
+    document.SetInt("capture", "interval", 250);
+    CHECK(!document.Dirty());
+    document.SetInt("capture", "interval", 500);
+    document.SetBool("capture", "dedupeFrames", true);
+    document.Set("paths", "root", "C:\\out");
+    CHECK(document.Dirty());
+    CHECK(document.Serialize() ==
+          "; chronos settings\r\n"
+          "[Capture]\r\n"
+          "interval=500\r\n"
+          "# unknown=kept\r\n"
+          "custom=1\r\n"
+          "dedupeFrames=1\r\n"
+          "\r\n"
+          "[extra]\r\n"
+          "name=value\r\n"
+          "[paths]\r\n"
+          "root=C:\\out\r\n");
+}
+
+TEST_CASE(OutOfRangeIntegersFallBack) {
+    IniDocument document;
+    document.Parse(
+        "[capture]\r\n"
+        "max=9223372036854775807\r\n"
+        "min=-9223372036854775807\r\n"
+        "over=9223372036854775808\r\n"
+        "huge=-123456789012345678901234567890\r\n"
+        "suffix=42MB\r\n");
+    CHECK(document.GetInt("capture", "max", 0) == 9223372036854775807LL);
+    CHECK(document.GetInt("capture", "min", 0) == -9223372036854775807LL);
+    CHECK(document.GetInt("capture", "over", 7) == 7);
+    CHECK(document.GetInt("capture", "huge", 7) == 7);
+    CHECK(document.GetInt("capture", "suffix", 7) == 42);
+}
+
+TEST_CASE(SaveAndLoadAgree) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    IniDocument document;
+    CHECK(!document.Load(path));
+    document.Set("general", "name", "Caf\xC3\xA9");
+    document.SetInt("general", "count", -12);
+    REQUIRE(document.Save(path));
+    CHECK(!document.Dirty());
+
+    IniDocument reloaded;
+    REQUIRE(reloaded.Load(path));
+    CHECK(reloaded.FileEncoding() == IniDocument::Encoding::Utf8);
+    CHECK(reloaded.GetString("general", "name", "") == "Caf\xC3\xA9");
+    CHECK(reloaded.GetInt("general", "count", 0) == -12);
+    CHECK(reloaded.Serialize() == document.Serialize());
+}
+
+TEST_CASE(Utf8BomIsKeptOnSave) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    WriteBytes(path, "\xEF\xBB\xBF[paths]\r\nroot=a\r\n");
+    IniDocument document;
+    REQUIRE(document.Load(path));
+    CHECK(document.FileEncoding() == IniDocument::Encoding::Utf8Bom);
+    CHECK(document.GetString("paths", "root", "") == "a");
+    document.Set("paths", "root", "b");
+    REQUIRE(document.Save(path));
+    CHECK(ReadBytes(path) == "\xEF\xBB\xBF[paths]\r\nroot=b\r\n");
+}
+
+TEST_CASE(Utf16FilesAreConvertedAndWrittenBackAsUtf16) {
+    for (const bool bigEndian : { false, true }) {
+        check::TempDir dir;
+        const auto path = dir.Path() / "config.ini";
+        WriteBytes(path, Utf16Sample(bigEndian));
+        IniDocument document;
+        REQUIRE(document.Load(path));
+        CHECK(document.FileEncoding() == (bigEndian ? IniDocument::Encoding::Utf16Be : IniDocument::Encoding::Utf16Le));
+        CHECK(document.GetString("paths", "root", "") == "Caf\xC3\xA9");
+
+        // Saving unchanged content reproduces the original bytes.
+        REQUIRE(document.Save(path));
+        CHECK(ReadBytes(path) == Utf16Sample(bigEndian));
+    }
+}
+
+TEST_CASE(InvalidUtf8GoesThroughTheLegacyDecoder) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    // "Café" in Windows-1252.
+    WriteBytes(path, "[paths]\r\nroot=Caf\xE9\r\n");
+
+    std::string seen;
+    IniDocument document;
+    REQUIRE(document.Load(path, [&seen](const std::string& bytes) {
+        seen = bytes;
+        return std::string("[paths]\r\nroot=decoded\r\n");
+    }));
+    CHECK(seen == "[paths]\r\nroot=Caf\xE9\r\n");
+    CHECK(document.FileEncoding() == IniDocument::Encoding::Legacy);
+    CHECK(document.GetString("paths", "root", "") == "decoded");
+
+    IniDocument latin1;
+    REQUIRE(latin1.Load(path));
+    CHECK(latin1.GetString("paths", "root", "") == "Caf\xC3\xA9");
+
+    // A legacy file is rewritten as UTF-8 with a BOM.
+    latin1.Set("paths", "extra", "1");
+    REQUIRE(latin1.Save(path));
+    CHECK(latin1.FileEncoding() == IniDocument::Encoding::Utf8Bom);
+    CHECK(ReadBytes(path) == "\xEF\xBB\xBF[paths]\r\nroot=Caf\xC3\xA9\r\nextra=1\r\n");
+}
+
+TEST_CASE(ValidUtf8IsNotSentToTheLegacyDecoder) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "config.ini";
+    WriteBytes(path, "[paths]\nroot=Caf\xC3\xA9\n");
+    bool called = false;
+    IniDocument document;
+    REQUIRE(document.Load(path, [&called](const std::string& bytes) {
+        called = true;
+        return bytes;
+    }));
+    CHECK(!called);
+    CHECK(document.FileEncoding() == IniDocument::Encoding::Utf8);
+    CHECK(document.Serialize() == "[paths]\nroot=Caf\xC3\xA9\n");
+}
+
+} // namespace
@@ -0,0 +1,254 @@
+#include "InputLog.h"
+
+#include "Check.h"
+
+#include <fstream>
+#include <vector>
+
+namespace {
+
+InputEvent Marker(InputEvent::Kind kind, uint32_t time, uint32_t flags = 0) {
+    InputEvent event;
+    event.kind = kind;
+    event.flags = flags;
+    event.time = time;
+    return event;
+}
+
+InputEvent Notch(int16_t delta, uint32_t time) {
+    InputEvent event;
+    event.kind = InputEvent::Kind::Wheel;
+    event.wheelDelta = delta;
+    event.time = time;
+    return event;
+}
+
+// Writes `events` as a log and reads it back, so every case replays a file.
+std::vector<InputEvent> Record(const std::filesystem::path& path, const std::vector<InputEvent>& events) {
+    inputlog::Writer writer;
+    if (!writer.Open(path)) {
+        return {};
+    }
+    for (const auto& event : events) {
+        writer.Append(event);
+    }
+    writer.Close();
+    std::vector<InputEvent> read;
+    inputlog::ReadLog(path, read);
+    return read;
+}
+
+// What the handler saw, in order.
+struct Step {
+    InputEvent::Kind kind;
+    uint8_t marks;
+    int16_t delta;
+    uint32_t time;
+    bool capture;
+
+    bool operator==(const Step&) const = default;
+};
+
+struct Trace {
+    std::vector<Step> steps;
+
+    inputlog::ReplayHandler Handler() {
+        return [this](const InputEvent& event, const InputProcessor::Result& result) {
+            steps.push_back(Step{ event.kind, event.marks, event.wheelDelta, event.time, result.captureRequested });
+        };
+    }
+};
+
+constexpr auto kWheel = InputEvent::Kind::Wheel;
+constexpr auto kDone = InputEvent::Kind::CaptureDone;
+constexpr auto kMode = InputEvent::Kind::CaptureMode;
+
+TEST_CASE(RecordsRoundTripWithMarks) {
+    check::TempDir dir;
+    auto held = Notch(-120, 7);
+    held.marks = InputEvent::kHeld | InputEvent::kInjected;
+    auto move = Marker(InputEvent::Kind::MouseMove, 9, 480);
+    move.vkCode = 640;
+    const auto read = Record(dir.Path() / "input.bin", { held, move, Marker(kDone, 11) });
+    REQUIRE(read.size() == 3);
+    CHECK(read[0].kind == kWheel);
+    CHECK(read[0].marks == (InputEvent::kHeld | InputEvent::kInjected));
+    CHECK(read[0].wheelDelta == -120);
+    CHECK(read[1].kind == InputEvent::Kind::MouseMove);
+    CHECK(read[1].vkCode == 640);
+    CHECK(read[1].flags == 480);
+    CHECK(read[2].kind == kDone);
+    CHECK(read[2].time == 11);
+}
+
+TEST_CASE(ReadsVersionOneLogs) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "v1.bin";
+    uint8_t header[inputlog::kHeaderSize] = { 'C', 'H', 'R', 'N', 'I', 'N', 'P', 'T', 1, 0, 0, 0, 16, 0, 0, 0 };
+    uint8_t record[inputlog::kRecordSize];
+    inputlog::EncodeRecord(Notch(-120, 5), record);
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(record), sizeof(record));
+    }
+    std::vector<InputEvent> read;
+    REQUIRE(inputlog::ReadLog(path, read));
+    REQUIRE(read.size() == 1);
+    CHECK(read[0].wheelDelta == -120);
+
+    header[8] = 3;
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    }
+    CHECK(!inputlog::ReadLog(path, read));
+}
+
+TEST_CASE(PlainReplaySkipsHeldNotches) {
+    check::TempDir dir;
+    auto held = Notch(-120, 20);
+    held.marks = InputEvent::kHeld;
+    const auto events = Record(dir.Path() / "input.bin", { Marker(kMode, 0, 1), Notch(-120, 10), held });
+
+    InputProcessor processor;
+    Trace trace;
+    const auto stats = inputlog::Replay(events, processor, 0.0, trace.Handler());
+    CHECK(stats.events == 3);
+    CHECK(stats.captureRequests == 1);
+    CHECK(trace.steps.size() == 2);
+}
+
+TEST_CASE(RecordedCompletionsReleaseOneNotchEachThenTimeoutFreesTheRest) {
+    check::TempDir dir;
+    const auto events = Record(dir.Path() / "input.bin", {
+        Marker(kMode, 1000, 1),
+        Notch(-120, 1010),
+        Notch(-121, 1020),
+        Notch(-122, 1030),
+        Notch(-123, 1040),
+        Marker(kDone, 1100),
+        Marker(kDone, 1200),
+    });
+
+    InputProcessor processor;
+    ScrollPacer pacer;
+    pacer.Configure(1, 1);
+    Trace trace;
+    const auto stats = inputlog::ReplayPaced(events, processor, pacer, inputlog::PacedReplayOptions{}, trace.Handler());
+
+    const std::vector<Step> expected = {
+        { kMode, 0, 0, 1000, false },
+        { kWheel, 0, -120, 1010, true },
+        { kWheel, InputEvent::kHeld, -121, 1020, false },
+        { kWheel, InputEvent::kHeld, -122, 1030, false },
+        { kWheel, InputEvent::kHeld, -123, 1040, false },
+        { kDone, 0, 0, 1100, false },
+        { kWheel, InputEvent::kReinjected, -121, 1100, true },
+        { kDone, 0, 0, 1200, false },
+        { kWheel, InputEvent::kReinjected, -122, 1200, true },
+        // The capture for -122 is never reported done; the first tick at or
+        // past 750 ms frees the last notch.
+        { kWheel, InputEvent::kReinjected, -123, 2000, true },
+    };
+    CHECK(trace.steps == expected);
+    CHECK(stats.events == 7);
+    CHECK(stats.held == 3);
+    CHECK(stats.released == 3);
+    CHECK(stats.captureRequests == 4);
+    CHECK(pacer.HeldCount() == 0);
+}
+
+TEST_CASE(SimulatedCompletionsReleaseUpToTheNextCapturePoint) {
+    check::TempDir dir;
+    auto stale = Notch(-120, 16);
+    stale.marks = InputEvent::kReinjected;
+    const auto events = Record(dir.Path() / "input.bin", {
+        Marker(kMode, 0, 1),
+        Notch(-120, 10),
+        Notch(-120, 11),
+        Notch(-121, 12),
+        Notch(-122, 13),
+        Notch(-123, 14),
+        Notch(-124, 15),
+        stale,
+        // Logged completions are ignored when captures are simulated.
+        Marker(kDone, 17),
+    });
+
+    InputProcessor processor;
+    processor.SetScrollsPerCapture(2);
+    ScrollPacer pacer;
+    pacer.Configure(2, 1);
+    Trace trace;
+    inputlog::PacedReplayOptions options;
+    options.captureMs = 50;
+    const auto stats = inputlog::ReplayPaced(events, processor, pacer, options, trace.Handler());
+
+    std::vector<Step> releases;
+    std::vector<uint32_t> captures;
+    for (const auto& step : trace.steps) {
+        if (step.marks & InputEvent::kReinjected) {
+            releases.push_back(step);
+        }
+        if (step.capture) {
+            captures.push_back(step.time);
+        }
+    }
+    const std::vector<Step> expectedReleases = {
+        { kWheel, InputEvent::kReinjected, -121, 61, false },
+        { kWheel, InputEvent::kReinjected, -122, 61, true },
+        { kWheel, InputEvent::kReinjected, -123, 111, false },
+        { kWheel, InputEvent::kReinjected, -124, 111, true },
+    };
+    CHECK(releases == expectedReleases);
+    CHECK((captures == std::vector<uint32_t>{ 11, 61, 111 }));
+    CHECK(stats.held == 4);
+    CHECK(stats.released == 4);
+    CHECK(pacer.Snapshot().maxOutstanding == 1);
+    CHECK(pacer.Outstanding() == 0);
+}
+
+TEST_CASE(LeavingCaptureModeReleasesEverythingAfterTheMarker) {
+    check::TempDir dir;
+    const auto events = Record(dir.Path() / "input.bin", {
+        Marker(kMode, 0, 1),
+        Notch(-120, 10),
+        Notch(-121, 20),
+        Notch(-122, 30),
+        Marker(kMode, 40, 0),
+    });
+
+    InputProcessor processor;
+    ScrollPacer pacer;
+    pacer.Configure(1, 1);
+    Trace trace;
+    const auto stats = inputlog::ReplayPaced(events, processor, pacer, inputlog::PacedReplayOptions{}, trace.Handler());
+
+    REQUIRE(trace.steps.size() == 7);
+    CHECK((trace.steps[4] == Step{ kMode, 0, 0, 40, false }));
+    CHECK((trace.steps[5] == Step{ kWheel, InputEvent::kReinjected, -121, 40, false }));
+    CHECK((trace.steps[6] == Step{ kWheel, InputEvent::kReinjected, -122, 40, false }));
+    CHECK(stats.captureRequests == 1);
+}
+
+TEST_CASE(ScrollingUpDiscardsHeldNotches) {
+    check::TempDir dir;
+    const auto events = Record(dir.Path() / "input.bin", {
+        Marker(kMode, 0, 1),
+        Notch(-120, 10),
+        Notch(-120, 20),
+        Notch(120, 30),
+        Marker(kDone, 40),
+    });
+
+    InputProcessor processor;
+    ScrollPacer pacer;
+    pacer.Configure(1, 1);
+    const auto stats = inputlog::ReplayPaced(events, processor, pacer, inputlog::PacedReplayOptions{}, nullptr);
+    CHECK(stats.held == 1);
+    CHECK(stats.released == 0);
+    CHECK(pacer.Snapshot().discarded == 1);
+}
+
+} // namespace
@@ -0,0 +1,77 @@
+#include "InputQueue.h"
+
+#include "Bench.h"
+#include "LatencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+// Push-to-pop latency: the producer stamps each event, and the consumer polls,
+// yielding when empty, and records each event's age. On a single core the
+// tail is scheduler quanta rather than queue cost.
+void MeasureLatency(size_t events, std::chrono::microseconds gap) {
+    InputQueue queue;
+    LatencyHistogram latency;
+    std::atomic<bool> done{ false };
+    std::thread consumer([&] {
+        while (!done.load(std::memory_order_acquire) || queue.Depth() > 0) {
+            const size_t drained = queue.Drain([&](const InputEvent& event) {
+                const uint64_t sent = (static_cast<uint64_t>(event.flags) << 32) | event.time;
+                latency.Record(NowNs() - sent);
+            });
+            if (drained == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (size_t i = 0; i < events; ++i) {
+        InputEvent event;
+        const uint64_t now = NowNs();
+        event.flags = static_cast<uint32_t>(now >> 32);
+        event.time = static_cast<uint32_t>(now);
+        queue.Push(event);
+        const auto until = Clock::now() + gap;
+        while (Clock::now() < until) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    const auto summary = latency.Summarize();
+    std::printf("push->pop latency, %zu events %lld us apart: p50 %llu ns  p99 %llu ns  p99.9 %llu ns  max %llu ns\n",
+                events, static_cast<long long>(gap.count()), static_cast<unsigned long long>(summary.p50),
+                static_cast<unsigned long long>(summary.p99), static_cast<unsigned long long>(summary.p999),
+                static_cast<unsigned long long>(summary.max));
+}
+
+} // namespace
+
+int main() {
+    // Push + drain on one thread: the cost the hook and app thread each pay.
+    InputQueue queue;
+    bench::Run("push + drain, 1 event", 0, [&queue] {
+        queue.Push(InputEvent{});
+        return queue.Drain([](const InputEvent&) {});
+    });
+    bench::Run("push 64 + drain", 0, [&queue] {
+        for (int i = 0; i < 64; ++i) {
+            queue.Push(InputEvent{});
+        }
+        return queue.Drain([](const InputEvent&) {});
+    });
+
+    MeasureLatency(200'000, std::chrono::microseconds(5));
+    MeasureLatency(20'000, std::chrono::microseconds(100));
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "InputQueue.h"
+
+#include "Check.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+InputEvent Numbered(uint32_t sequence) {
+    InputEvent event;
+    event.kind = InputEvent::Kind::KeyDown;
+    event.vkCode = sequence;
+    return event;
+}
+
+TEST_CASE(RingIsFifoAndBounded) {
+    SpscRing<uint32_t, 8> ring;
+    uint32_t value = 0;
+    CHECK(!ring.TryPop(value));
+    // Several laps so the indices wrap.
+    for (uint32_t lap = 0; lap < 5; ++lap) {
+        for (uint32_t i = 0; i < 8; ++i) {
+            CHECK(ring.TryPush(lap * 8 + i));
+        }
+        CHECK(!ring.TryPush(99));
+        CHECK(ring.SizeApprox() == 8);
+        for (uint32_t i = 0; i < 8; ++i) {
+            REQUIRE(ring.TryPop(value));
+            CHECK(value == lap * 8 + i);
+        }
+        CHECK(!ring.TryPop(value));
+    }
+}
+
+TEST_CASE(RingKeepsOrderUnderConcurrency) {
+    constexpr uint64_t kCount = 2'000'000;
+    SpscRing<uint64_t, 64> ring;
+    std::thread producer([&ring] {
+        for (uint64_t i = 0; i < kCount; ++i) {
+            while (!ring.TryPush(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < kCount) {
+        uint64_t value = 0;
+        if (!ring.TryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && value == expected;
+        ++expected;
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(ring.SizeApprox() == 0);
+}
+
+TEST_CASE(OverflowIsCountedAndWakesCoalesce) {
+    InputQueue queue;
+    CHECK(queue.Push(Numbered(0)));
+    CHECK(!queue.Push(Numbered(1)));
+    for (uint32_t i = 2; i < InputQueue::kCapacity + 10; ++i) {
+        queue.Push(Numbered(i));
+    }
+    CHECK(queue.Depth() == InputQueue::kCapacity);
+    CHECK(queue.Dropped() == 10);
+
+    uint32_t next = 0;
+    bool ordered = true;
+    CHECK(queue.Drain([&](const InputEvent& event) { ordered = ordered && event.vkCode == next++; }) == InputQueue::kCapacity);
+    CHECK(ordered);
+    // The first push after a drain asks for a wake-up again.
+    CHECK(queue.Push(Numbered(0)));
+}
+
+// The consumer only drains when woken, the way the app thread waits for
+// kInputMessage. A lost wake-up leaves events stranded and times the test out.
+TEST_CASE(NoEventIsStrandedWithoutAWakeUp) {
+    constexpr uint32_t kCount = 500'000;
+    InputQueue queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint64_t wakes = 0;
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < kCount; ++i) {
+            // Single producer: the depth can only shrink while we wait.
+            while (queue.Depth() >= InputQueue::kCapacity) {
+                std::this_thread::yield();
+            }
+            if (queue.Push(Numbered(i))) {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++wakes;
+                wake.notify_one();
+            }
+        }
+    });
+
+    uint32_t received = 0;
+    bool ordered = true;
+    uint64_t seenWakes = 0;
+    bool stranded = false;
+    while (received < kCount) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!wake.wait_for(lock, std::chrono::seconds(5), [&] { return wakes != seenWakes; })) {
+                stranded = true;
+                break;
+            }
+            seenWakes = wakes;
+        }
+        queue.Drain([&](const InputEvent& event) {
+            ordered = ordered && event.vkCode == received;
+            ++received;
+        });
+    }
+    producer.join();
+    CHECK(!stranded);
+    CHECK(received == kCount);
+    CHECK(ordered);
+    CHECK(queue.Dropped() == 0);
+}
+
+} // namespace
@@ -0,0 +1,74 @@
+#include "JobScheduler.h"
+
+#include "Bench.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// Stand-in for an encode or hash step: a few hundred microseconds of work.
+uint64_t Churn(uint64_t seed, int rounds) {
+    uint64_t x = seed | 1;
+    for (int i = 0; i < rounds; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+} // namespace
+
+int main() {
+    JobScheduler scheduler;
+    std::printf("%u worker(s)\n", scheduler.ThreadCount());
+
+    bench::Run("submit + wait, 1000 empty jobs", 0, [&] {
+        std::vector<JobHandle> handles;
+        handles.reserve(1000);
+        for (int i = 0; i < 1000; ++i) {
+            handles.push_back(scheduler.Submit([](JobContext&) { return true; }));
+        }
+        for (const auto& handle : handles) {
+            handle.Wait();
+        }
+        return handles.size();
+    });
+
+    bench::Run("chain of 1000 continuations", 0, [&] {
+        JobHandle previous;
+        for (int i = 0; i < 1000; ++i) {
+            previous = scheduler.ContinueWith(previous, [](JobContext&) { return true; });
+        }
+        previous.Wait();
+        return size_t{ 1 };
+    });
+
+    constexpr int kTasks = 64;
+    constexpr int kRounds = 200000;
+    bench::Run("64 churn tasks, inline", 0, [&] {
+        uint64_t sum = 0;
+        for (int i = 0; i < kTasks; ++i) {
+            sum += Churn(static_cast<uint64_t>(i), kRounds);
+        }
+        return static_cast<size_t>(sum);
+    });
+    bench::Run("64 churn tasks, scheduled", 0, [&] {
+        std::atomic<uint64_t> sum{ 0 };
+        std::vector<JobHandle> handles;
+        for (int i = 0; i < kTasks; ++i) {
+            handles.push_back(scheduler.Submit([&sum, i](JobContext&) {
+                sum.fetch_add(Churn(static_cast<uint64_t>(i), kRounds));
+                return true;
+            }));
+        }
+        for (const auto& handle : handles) {
+            handle.Wait();
+        }
+        return static_cast<size_t>(sum.load());
+    });
+    std::printf("steals: %llu\n", static_cast<unsigned long long>(scheduler.Steals()));
+    return 0;
+}
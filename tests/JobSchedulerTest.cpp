@@ -0,0 +1,320 @@
+#include "JobScheduler.h"
+
+#include "Check.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Holds a worker until Open() so queued jobs can be ordered deterministically.
+class Gate {
+public:
+    void Open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+        }
+        changed_.notify_all();
+    }
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return open_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool open_ = false;
+};
+
+// Stands in for the UI thread: callbacks queue up until Pump() runs them.
+class FakeUiThread {
+public:
+    JobScheduler::Dispatcher Dispatcher() {
+        return [this](std::function<void()> callback) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(std::move(callback));
+        };
+    }
+    size_t Pump() {
+        std::vector<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.swap(pending_);
+        }
+        for (auto& callback : batch) {
+            callback();
+        }
+        return batch.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::function<void()>> pending_;
+};
+
+TEST_CASE(RunsEveryJobAndReportsOutcome) {
+    JobScheduler scheduler(4);
+    std::atomic<int> ran{ 0 };
+    std::vector<JobHandle> handles;
+    for (int i = 0; i < 5000; ++i) {
+        handles.push_back(scheduler.Submit([&ran, i](JobContext&) {
+            ran.fetch_add(1);
+            return i % 10 != 0;
+        }));
+    }
+    int failed = 0;
+    for (const auto& handle : handles) {
+        handle.Wait();
+        failed += handle.Status() == JobStatus::Failed ? 1 : 0;
+        CHECK(!handle.Active());
+    }
+    CHECK(ran.load() == 5000);
+    CHECK(failed == 500);
+}
+
+TEST_CASE(HigherPrioritiesRunFirst) {
+    JobScheduler scheduler(1);
+    Gate gate;
+    auto blocker = scheduler.Submit([&gate](JobContext&) {
+        gate.Wait();
+        return true;
+    });
+    std::mutex mutex;
+    std::string order;
+    const auto record = [&](char tag) {
+        return [&, tag](JobContext&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(tag);
+            return true;
+        };
+    };
+    // Wait for the worker to pick up the blocker so the rest queue behind it.
+    while (blocker.Status() != JobStatus::Running) {
+        std::this_thread::yield();
+    }
+    const auto at = [](JobPriority priority) {
+        JobOptions options;
+        options.priority = priority;
+        return options;
+    };
+    auto low = scheduler.Submit(record('L'), at(JobPriority::Low));
+    auto normal = scheduler.Submit(record('N'), at(JobPriority::Normal));
+    auto high = scheduler.Submit(record('H'), at(JobPriority::High));
+    gate.Open();
+    low.Wait();
+    normal.Wait();
+    high.Wait();
+    CHECK(order == "HNL");
+}
+
+TEST_CASE(CancellationBeforeAndDuringRun) {
+    JobScheduler scheduler(1);
+    Gate gate;
+    auto blocker = scheduler.Submit([&gate](JobContext&) {
+        gate.Wait();
+        return true;
+    });
+
+    std::atomic<bool> queuedRan{ false };
+    auto queued = scheduler.Submit([&queuedRan](JobContext&) {
+        queuedRan = true;
+        return true;
+    });
+    queued.Cancel();
+
+    // A group token cancels every job that shares it.
+    JobOptions group;
+    auto first = scheduler.Submit([](JobContext&) { return true; }, group);
+    auto second = scheduler.Submit([](JobContext&) { return true; }, group);
+    group.token.Cancel();
+
+    gate.Open();
+    queued.Wait();
+    first.Wait();
+    second.Wait();
+    CHECK(!queuedRan.load());
+    CHECK(queued.Status() == JobStatus::Cancelled);
+    CHECK(first.Status() == JobStatus::Cancelled);
+    CHECK(second.Status() == JobStatus::Cancelled);
+    CHECK(blocker.Status() == JobStatus::Succeeded);
+
+    // Cancelled while running: the job notices and its result is ignored.
+    std::atomic<bool> started{ false };
+    auto running = scheduler.Submit([&started](JobContext& context) {
+        started = true;
+        while (!context.IsCancelled()) {
+            std::this_thread::yield();
+        }
+        return true;
+    });
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    running.Cancel();
+    running.Wait();
+    CHECK(running.Status() == JobStatus::Cancelled);
+}
+
+TEST_CASE(CallbacksGoThroughTheDispatcher) {
+    FakeUiThread ui;
+    JobScheduler scheduler(2, ui.Dispatcher());
+    const auto uiThread = std::this_thread::get_id();
+    std::vector<float> progress;
+    JobStatus completed = JobStatus::Pending;
+    bool onUiThread = true;
+
+    JobOptions options;
+    options.onProgress = [&](float fraction) {
+        onUiThread = onUiThread && std::this_thread::get_id() == uiThread;
+        progress.push_back(fraction);
+    };
+    options.onComplete = [&](JobStatus status) {
+        onUiThread = onUiThread && std::this_thread::get_id() == uiThread;
+        completed = status;
+    };
+    auto job = scheduler.Submit([](JobContext& context) {
+        for (int i = 0; i <= 1000; ++i) {
+            context.ReportProgress(i / 1000.0f);
+        }
+        context.ReportProgress(2.0f);
+        return true;
+    }, options);
+    job.Wait();
+    CHECK(completed == JobStatus::Pending);
+    // Progress and completion are both queued by the time Wait() returns.
+    while (completed == JobStatus::Pending) {
+        ui.Pump();
+    }
+    CHECK(onUiThread);
+    CHECK(completed == JobStatus::Succeeded);
+    // At most one report per percent, in order.
+    CHECK(progress.size() <= 101);
+    CHECK(progress.size() >= 2);
+    for (size_t i = 1; i < progress.size(); ++i) {
+        CHECK(progress[i] > progress[i - 1]);
+    }
+    CHECK(progress.back() == 1.0f);
+    CHECK(job.Progress() == 1.0f);
+}
+
+TEST_CASE(ContinuationsSeeTheirAntecedent) {
+    JobScheduler scheduler(2);
+    Gate gate;
+    auto parent = scheduler.Submit([&gate](JobContext&) {
+        gate.Wait();
+        return false;
+    });
+    JobStatus seen = JobStatus::Pending;
+    auto child = scheduler.ContinueWith(parent, [&seen](JobContext& context) {
+        seen = context.Antecedent();
+        return true;
+    });
+    CHECK(child.Status() == JobStatus::Pending);
+    gate.Open();
+    child.Wait();
+    CHECK(seen == JobStatus::Failed);
+
+    // Continuing from a finished job runs right away with its outcome.
+    JobStatus late = JobStatus::Pending;
+    scheduler.ContinueWith(child, [&late](JobContext& context) {
+        late = context.Antecedent();
+        return true;
+    }).Wait();
+    CHECK(late == JobStatus::Succeeded);
+
+    // A cancelled parent still runs its continuation.
+    JobOptions cancelled;
+    cancelled.token.Cancel();
+    auto skipped = scheduler.Submit([](JobContext&) { return true; }, cancelled);
+    JobStatus afterCancel = JobStatus::Pending;
+    scheduler.ContinueWith(skipped, [&afterCancel](JobContext& context) {
+        afterCancel = context.Antecedent();
+        return true;
+    }).Wait();
+    CHECK(afterCancel == JobStatus::Cancelled);
+}
+
+TEST_CASE(LongChainsRunInOrder) {
+    JobScheduler scheduler(3);
+    std::vector<int> order;
+    JobHandle previous;
+    for (int i = 0; i < 200; ++i) {
+        previous = scheduler.ContinueWith(previous, [&order, i](JobContext&) {
+            order.push_back(i);
+            return true;
+        });
+    }
+    previous.Wait();
+    REQUIRE(order.size() == 200);
+    for (int i = 0; i < 200; ++i) {
+        CHECK(order[static_cast<size_t>(i)] == i);
+    }
+}
+
+TEST_CASE(RecursiveFanOutFromWorkers) {
+    JobScheduler scheduler(4);
+    std::atomic<int> leaves{ 0 };
+    std::atomic<int> outstanding{ 1 };
+    std::function<bool(int, JobContext&)> split;
+    split = [&](int depth, JobContext&) {
+        if (depth == 0) {
+            leaves.fetch_add(1);
+        } else {
+            outstanding.fetch_add(2);
+            for (int i = 0; i < 2; ++i) {
+                scheduler.Submit([&split, depth](JobContext& context) { return split(depth - 1, context); });
+            }
+        }
+        outstanding.fetch_sub(1);
+        return true;
+    };
+    scheduler.Submit([&split](JobContext& context) { return split(12, context); });
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (outstanding.load() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(outstanding.load() == 0);
+    CHECK(leaves.load() == 1 << 12);
+}
+
+TEST_CASE(ShutdownAbandonsPendingWork) {
+    auto scheduler = std::make_unique<JobScheduler>(1);
+    Gate gate;
+    auto blocker = scheduler->Submit([&gate](JobContext&) {
+        gate.Wait();
+        return true;
+    });
+    while (blocker.Status() != JobStatus::Running) {
+        std::this_thread::yield();
+    }
+    bool callbackRan = false;
+    JobOptions options;
+    options.onComplete = [&callbackRan](JobStatus) { callbackRan = true; };
+    auto pending = scheduler->Submit([](JobContext&) { return true; }, options);
+    auto chained = scheduler->ContinueWith(pending, [](JobContext&) { return true; });
+
+    std::thread opener([&gate] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate.Open();
+    });
+    scheduler->Shutdown();
+    opener.join();
+    CHECK(blocker.Status() == JobStatus::Succeeded);
+    CHECK(pending.Status() == JobStatus::Cancelled);
+    CHECK(chained.Status() == JobStatus::Cancelled);
+    CHECK(!callbackRan);
+
+    auto late = scheduler->Submit([](JobContext&) { return true; });
+    CHECK(late.Status() == JobStatus::Cancelled);
+    late.Wait();
+    scheduler.reset();
+}
+
+} // namespace
@@ -0,0 +1,117 @@
+#include "LatencyHistogram.h"
+
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST_CASE(BucketsTileTheWholeRange) {
+    CHECK(LatencyHistogram::BucketLowerBound(0) == 0);
+    for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+        const auto lower = LatencyHistogram::BucketLowerBound(i);
+        const auto upper = LatencyHistogram::BucketUpperBound(i);
+        REQUIRE(lower <= upper);
+        CHECK(LatencyHistogram::BucketIndex(lower) == i);
+        CHECK(LatencyHistogram::BucketIndex(upper) == i);
+        if (i + 1 < LatencyHistogram::kBucketCount) {
+            CHECK(LatencyHistogram::BucketLowerBound(i + 1) == upper + 1);
+        }
+    }
+    CHECK(LatencyHistogram::BucketUpperBound(LatencyHistogram::kBucketCount - 1) == UINT64_MAX);
+}
+
+TEST_CASE(SmallValuesAreExactAndLargeOnesWithinOneSixteenth) {
+    for (uint64_t value = 0; value < LatencyHistogram::kLinearBuckets; ++value) {
+        CHECK(LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(value)) == value);
+    }
+    std::mt19937_64 rng(34);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t value = rng() >> (rng() % 60);
+        const auto index = LatencyHistogram::BucketIndex(value);
+        const auto lower = LatencyHistogram::BucketLowerBound(index);
+        const auto upper = LatencyHistogram::BucketUpperBound(index);
+        REQUIRE(lower <= value && value <= upper);
+        CHECK(static_cast<double>(upper - lower) <= static_cast<double>(lower) / 16.0);
+    }
+}
+
+TEST_CASE(QuantilesTrackTheExactOnes) {
+    // Hook-like latencies in nanoseconds: mostly a few microseconds, a long tail.
+    std::mt19937_64 rng(7);
+    std::lognormal_distribution<double> distribution(8.5, 1.0);
+    std::vector<uint64_t> values(50000);
+    LatencyHistogram histogram;
+    for (auto& value : values) {
+        value = static_cast<uint64_t>(distribution(rng));
+        histogram.Record(value);
+    }
+    std::sort(values.begin(), values.end());
+    for (const double quantile : { 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+        const auto rank = static_cast<size_t>(std::ceil(quantile * static_cast<double>(values.size())));
+        const uint64_t exact = values[rank - 1];
+        const uint64_t estimate = histogram.ValueAtQuantile(quantile);
+        // Reported as the bucket's upper bound, capped at the maximum.
+        CHECK(estimate >= exact);
+        CHECK(static_cast<double>(estimate - exact) <= static_cast<double>(exact) / 16.0 + 1.0);
+    }
+
+    const auto summary = histogram.Summarize();
+    CHECK(summary.count == values.size());
+    CHECK(summary.min == values.front());
+    CHECK(summary.max == values.back());
+    CHECK(summary.p50 <= summary.p90);
+    CHECK(summary.p90 <= summary.p99);
+    CHECK(summary.p99 <= summary.p999);
+    CHECK(summary.p999 <= summary.max);
+    CHECK(histogram.ValueAtQuantile(1.0) == values.back());
+}
+
+TEST_CASE(EmptyAndReset) {
+    LatencyHistogram histogram;
+    CHECK(histogram.Summarize().count == 0);
+    CHECK(histogram.Summarize().max == 0);
+    CHECK(histogram.ValueAtQuantile(0.99) == 0);
+
+    histogram.Record(10);
+    histogram.Record(30);
+    const auto summary = histogram.Summarize();
+    CHECK(summary.min == 10);
+    CHECK(summary.max == 30);
+    CHECK(summary.mean == 20);
+    CHECK(summary.p50 == 10);
+
+    histogram.Reset();
+    CHECK(histogram.Count() == 0);
+    CHECK(histogram.Max() == 0);
+    histogram.Record(5);
+    CHECK(histogram.Summarize().min == 5);
+}
+
+TEST_CASE(ConcurrentRecordersLoseNothing) {
+    constexpr int kThreads = 4;
+    constexpr uint64_t kPerThread = 100000;
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&histogram, t] {
+            for (uint64_t i = 0; i < kPerThread; ++i) {
+                histogram.Record(i * kThreads + static_cast<uint64_t>(t));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto summary = histogram.Summarize();
+    CHECK(summary.count == kThreads * kPerThread);
+    CHECK(summary.min == 0);
+    CHECK(summary.max == kThreads * kPerThread - 1);
+    CHECK(summary.mean == (kThreads * kPerThread - 1) / 2);
+}
+
+} // namespace
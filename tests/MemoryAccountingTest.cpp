@@ -0,0 +1,72 @@
+#include "MemoryAccounting.h"
+
+#include "Check.h"
+#include "FrameStore.h"
+#include "SessionArena.h"
+
+#include <memory>
+
+namespace {
+
+TEST_CASE(OverlappingSessionsKeepSeparatePeaks) {
+    const auto processBefore = memory::Get(memory::Tag::Capture);
+    auto first = std::make_shared<memory::Ledger>();
+    auto second = std::make_shared<memory::Ledger>();
+
+    auto big = MakeSessionBuffer(first->Resource(memory::Tag::Capture));
+    big->resize(4096);
+    auto small = MakeSessionBuffer(second->Resource(memory::Tag::Capture));
+    small->resize(1024);
+    CHECK(first->Get(memory::Tag::Capture).current == 4096);
+    CHECK(second->Get(memory::Tag::Capture).current == 1024);
+    CHECK(memory::Get(memory::Tag::Capture).current == processBefore.current + 5120);
+
+    big.reset();
+    small->resize(2048);
+    CHECK(first->Get(memory::Tag::Capture).current == 0);
+    CHECK(first->Get(memory::Tag::Capture).peak == 4096);
+    // Growing allocates the new block before freeing the old one.
+    CHECK(second->Get(memory::Tag::Capture).peak == 1024 + 2048);
+    CHECK(memory::Get(memory::Tag::Capture).peak >= processBefore.current + 5120);
+}
+
+TEST_CASE(ChargesCountAgainstTheirLedger) {
+    auto ledger = std::make_shared<memory::Ledger>();
+    const size_t processBefore = memory::Get(memory::Tag::Bridge).current;
+    {
+        memory::Charge charge(memory::Tag::Bridge, ledger, 100);
+        charge.Add(50);
+        memory::Charge moved = std::move(charge);
+        CHECK(ledger->Get(memory::Tag::Bridge).current == 150);
+        CHECK(memory::Get(memory::Tag::Bridge).current == processBefore + 150);
+    }
+    CHECK(ledger->Get(memory::Tag::Bridge).current == 0);
+    CHECK(ledger->Get(memory::Tag::Bridge).peak == 150);
+    CHECK(memory::Get(memory::Tag::Bridge).current == processBefore);
+
+    memory::Charge unowned(memory::Tag::Bridge, 10);
+    CHECK(ledger->Get(memory::Tag::Bridge).current == 0);
+}
+
+TEST_CASE(BuffersKeepTheirLedgerAlive) {
+    auto ledger = std::make_shared<memory::Ledger>();
+    std::weak_ptr<memory::Ledger> watch = ledger;
+    auto arena = std::make_shared<SessionArena>(SessionArena::kDefaultChunkBytes, ledger->Resource(memory::Tag::FrameStore));
+    auto png = MakeSessionBuffer(arena);
+    png->resize(1000);
+    auto pixels = MakeSessionBuffer(ledger->Resource(memory::Tag::Capture));
+    pixels->resize(64);
+    CHECK(ledger->Get(memory::Tag::FrameStore).current == SessionArena::kDefaultChunkBytes);
+
+    // The session lets go first, as when its frames are still on the clipboard.
+    ledger.reset();
+    arena.reset();
+    CHECK(!watch.expired());
+    png.reset();
+    CHECK(!watch.expired());
+    CHECK(watch.lock()->Get(memory::Tag::FrameStore).current == 0);
+    pixels.reset();
+    CHECK(watch.expired());
+}
+
+} // namespace
@@ -0,0 +1,101 @@
+#include "ObjectStore.h"
+
+#include "Bench.h"
+
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Incompressible stand-ins for PNGs of one list page.
+std::vector<std::vector<uint8_t>> MakeFrames(size_t count, size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::vector<uint8_t>> frames(count, std::vector<uint8_t>(size));
+    for (auto& frame : frames) {
+        for (auto& byte : frame) {
+            byte = static_cast<uint8_t>(rng());
+        }
+    }
+    return frames;
+}
+
+} // namespace
+
+int main() {
+    // Repeat captures of one trainee's list: each session re-shoots the same
+    // 40 pages, of which a few changed since the last time.
+    constexpr size_t kFrames = 40;
+    constexpr size_t kFrameBytes = 256 * 1024;
+    constexpr size_t kChangedPerSession = 4;
+    constexpr int kSessions = 8;
+
+    auto pages = MakeFrames(kFrames, kFrameBytes, 1);
+    std::vector<std::vector<std::vector<uint8_t>>> sessions;
+    for (int s = 0; s < kSessions; ++s) {
+        const auto changed = MakeFrames(kChangedPerSession, kFrameBytes, static_cast<uint32_t>(100 + s));
+        for (size_t i = 0; i < kChangedPerSession; ++i) {
+            pages[(static_cast<size_t>(s) * 7 + i * 11) % kFrames] = changed[i];
+        }
+        sessions.push_back(pages);
+    }
+
+    const auto root = fs::temp_directory_path() / "chronos-object-bench";
+    fs::remove_all(root);
+    const uint64_t logical = static_cast<uint64_t>(kSessions) * kFrames * kFrameBytes;
+
+    int run = 0;
+    bench::Run("8 sessions, plain files", logical, [&] {
+        const auto base = root / ("plain" + std::to_string(run++));
+        for (int s = 0; s < kSessions; ++s) {
+            const auto folder = base / std::to_string(s);
+            fs::create_directories(folder);
+            for (size_t i = 0; i < kFrames; ++i) {
+                const auto& frame = sessions[static_cast<size_t>(s)][i];
+                std::ofstream(folder / ("shot_" + std::to_string(i) + ".png"), std::ios::binary)
+                    .write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+            }
+        }
+        fs::remove_all(base);
+        return size_t{ 1 };
+    }, std::chrono::milliseconds(2000));
+
+    // The capture path hashes every PNG for the manifest anyway, so the store
+    // is timed both with and without that cost.
+    std::vector<std::vector<digest::Sha256Digest>> digests(kSessions);
+    for (int s = 0; s < kSessions; ++s) {
+        for (const auto& frame : sessions[static_cast<size_t>(s)]) {
+            digests[static_cast<size_t>(s)].push_back(digest::ComputeSha256(frame.data(), frame.size()));
+        }
+    }
+    ObjectStore::Stats stats;
+    for (const bool hash : { true, false }) {
+        bench::Run(hash ? "8 sessions, hash + object store" : "8 sessions, object store", logical, [&] {
+            const auto base = root / ("store" + std::to_string(run++));
+            ObjectStore store;
+            store.Open(base / "objects");
+            for (int s = 0; s < kSessions; ++s) {
+                const auto folder = base / std::to_string(s);
+                fs::create_directories(folder);
+                for (size_t i = 0; i < kFrames; ++i) {
+                    const auto& frame = sessions[static_cast<size_t>(s)][i];
+                    const auto sha256 = hash ? digest::ComputeSha256(frame.data(), frame.size()) : digests[static_cast<size_t>(s)][i];
+                    store.Put(sha256, frame.data(), frame.size(), folder / ("shot_" + std::to_string(i) + ".png"));
+                }
+            }
+            stats = store.GetStats();
+            fs::remove_all(base);
+            return static_cast<size_t>(stats.objects);
+        }, std::chrono::milliseconds(2000));
+    }
+
+    std::printf("logical %.1f MB, stored %.1f MB, dedup ratio %.2fx, %llu hits / %llu misses\n",
+                static_cast<double>(logical) / 1e6, static_cast<double>(stats.bytes) / 1e6,
+                static_cast<double>(logical) / static_cast<double>(stats.bytes),
+                static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses));
+    fs::remove_all(root);
+    return 0;
+}
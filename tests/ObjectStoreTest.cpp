@@ -0,0 +1,211 @@
+#include "ObjectStore.h"
+
+#include "Check.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Blob {
+    std::string bytes;
+    digest::Sha256Digest sha256;
+};
+
+Blob MakeBlob(const std::string& text) {
+    return Blob{ text, digest::ComputeSha256(text.data(), text.size()) };
+}
+
+bool Put(ObjectStore& store, const Blob& blob, const fs::path& target) {
+    return store.Put(blob.sha256, blob.bytes.data(), blob.bytes.size(), target);
+}
+
+std::string ReadText(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE(IdenticalFramesAreStoredOnce) {
+    check::TempDir dir;
+    const auto sessions = dir.Path() / "sessions";
+    fs::create_directories(sessions / "a");
+    fs::create_directories(sessions / "b");
+    ObjectStore store;
+    REQUIRE(store.Open(dir.Path() / "objects"));
+
+    const auto frame = MakeBlob(std::string(5000, 'f'));
+    const auto other = MakeBlob("other frame");
+    REQUIRE(Put(store, frame, sessions / "a" / "shot_0001.png"));
+    REQUIRE(Put(store, other, sessions / "a" / "shot_0002.png"));
+    REQUIRE(Put(store, frame, sessions / "b" / "shot_0001.png"));
+
+    const auto stats = store.GetStats();
+    CHECK(stats.objects == 2);
+    CHECK(stats.bytes == 5000 + 11);
+    CHECK(stats.misses == 2);
+    CHECK(stats.hits == 1);
+    CHECK(store.References(frame.sha256) == 2);
+    CHECK(store.References(other.sha256) == 1);
+
+    // Sessions see ordinary files that share the object's storage.
+    const auto object = store.ObjectPath(frame.sha256);
+    CHECK(object.parent_path().filename().string() == digest::ToHex(frame.sha256).substr(0, 2));
+    CHECK(ReadText(sessions / "b" / "shot_0001.png") == frame.bytes);
+    CHECK(fs::hard_link_count(object) == 3);
+    CHECK(fs::equivalent(object, sessions / "a" / "shot_0001.png"));
+
+    // Putting over an existing target replaces it.
+    REQUIRE(Put(store, other, sessions / "b" / "shot_0001.png"));
+    CHECK(ReadText(sessions / "b" / "shot_0001.png") == other.bytes);
+    CHECK(fs::hard_link_count(object) == 2);
+}
+
+TEST_CASE(ReferenceCountsPersistAndCollectReclaims) {
+    check::TempDir dir;
+    const auto root = dir.Path() / "objects";
+    fs::create_directories(dir.Path() / "raw");
+    const auto kept = MakeBlob("kept");
+    const auto dropped = MakeBlob(std::string(3000, 'd'));
+    {
+        ObjectStore store;
+        REQUIRE(store.Open(root));
+        REQUIRE(Put(store, kept, dir.Path() / "raw" / "1.png"));
+        REQUIRE(Put(store, kept, dir.Path() / "raw" / "2.png"));
+        REQUIRE(Put(store, dropped, dir.Path() / "raw" / "3.png"));
+        store.Release(kept.sha256);
+        store.Release(dropped.sha256);
+        // Counts never go below zero.
+        store.Release(dropped.sha256);
+    }
+    CHECK(fs::file_size(root / "index.bin") == 16 + 2 * 48);
+
+    ObjectStore store;
+    REQUIRE(store.Open(root));
+    CHECK(store.References(kept.sha256) == 1);
+    CHECK(store.References(dropped.sha256) == 0);
+    CHECK(store.GetStats().objects == 2);
+
+    // The session's own link keeps its bytes even once the object is gone.
+    CHECK(store.Collect() == 3000);
+    CHECK(!fs::exists(store.ObjectPath(dropped.sha256)));
+    CHECK(fs::exists(store.ObjectPath(kept.sha256)));
+    CHECK(ReadText(dir.Path() / "raw" / "3.png") == dropped.bytes);
+    CHECK(fs::file_size(root / "index.bin") == 16 + 1 * 48);
+    CHECK(store.Collect() == 0);
+
+    // The compacted index reopens, and the store keeps updating it.
+    REQUIRE(Put(store, dropped, dir.Path() / "raw" / "4.png"));
+    ObjectStore reopened;
+    REQUIRE(reopened.Open(root));
+    CHECK(reopened.References(kept.sha256) == 1);
+    CHECK(reopened.References(dropped.sha256) == 1);
+}
+
+TEST_CASE(FailedIndexSwapKeepsTheOldSlots) {
+    check::TempDir dir;
+    const auto root = dir.Path() / "objects";
+    fs::create_directories(dir.Path() / "raw");
+    const auto first = MakeBlob("first");
+    const auto second = MakeBlob("second");
+    const auto third = MakeBlob("third");
+    ObjectStore store;
+    REQUIRE(store.Open(root));
+    REQUIRE(Put(store, first, dir.Path() / "raw" / "1.png"));
+    REQUIRE(Put(store, second, dir.Path() / "raw" / "2.png"));
+    REQUIRE(Put(store, third, dir.Path() / "raw" / "3.png"));
+    store.Release(first.sha256);
+
+    // A directory in the way of the temporary index makes the swap fail.
+    fs::create_directories(root / "index.bin.tmp" / "blocker");
+    CHECK(store.Collect() == 5);
+    CHECK(fs::file_size(root / "index.bin") == 16 + 3 * 48);
+
+    // Updates still land in the slots the old index has for them, so none
+    // overwrites another object's record.
+    store.Release(third.sha256);
+    ObjectStore reopened;
+    REQUIRE(reopened.Open(root));
+    CHECK(reopened.References(first.sha256) == 0);
+    CHECK(reopened.References(second.sha256) == 1);
+    CHECK(reopened.References(third.sha256) == 0);
+}
+
+TEST_CASE(MissingObjectIsWrittenAgain) {
+    check::TempDir dir;
+    fs::create_directories(dir.Path() / "raw");
+    ObjectStore store;
+    REQUIRE(store.Open(dir.Path() / "objects"));
+    const auto blob = MakeBlob("frame");
+    REQUIRE(Put(store, blob, dir.Path() / "raw" / "1.png"));
+    fs::remove(store.ObjectPath(blob.sha256));
+    REQUIRE(Put(store, blob, dir.Path() / "raw" / "2.png"));
+    CHECK(store.GetStats().misses == 2);
+    CHECK(store.References(blob.sha256) == 2);
+    CHECK(ReadText(store.ObjectPath(blob.sha256)) == "frame");
+}
+
+TEST_CASE(UnreadableIndexStartsOver) {
+    check::TempDir dir;
+    const auto root = dir.Path() / "objects";
+    fs::create_directories(root);
+    std::ofstream(root / "index.bin", std::ios::binary) << "not an index at all";
+    ObjectStore store;
+    CHECK(!store.Open(root));
+    CHECK(store.GetStats().objects == 0);
+    CHECK(!fs::exists(root / "index.bin"));
+    fs::create_directories(dir.Path() / "raw");
+    REQUIRE(Put(store, MakeBlob("x"), dir.Path() / "raw" / "1.png"));
+    CHECK(fs::file_size(root / "index.bin") == 16 + 48);
+}
+
+TEST_CASE(OneStorePerDirectory) {
+    check::TempDir dir;
+    fs::create_directories(dir.Path() / "objects");
+    bool loaded = false;
+    const auto first = ObjectStore::ForDirectory(dir.Path() / "objects", &loaded);
+    CHECK(loaded);
+    const auto second = ObjectStore::ForDirectory(dir.Path() / "." / "objects" / "");
+    CHECK(first == second);
+    const auto other = ObjectStore::ForDirectory(dir.Path() / "elsewhere");
+    CHECK(first != other);
+}
+
+TEST_CASE(ConcurrentPutsKeepCountsExact) {
+    check::TempDir dir;
+    ObjectStore store;
+    REQUIRE(store.Open(dir.Path() / "objects"));
+    std::vector<Blob> blobs;
+    for (int i = 0; i < 4; ++i) {
+        blobs.push_back(MakeBlob(std::string(1000 + i, static_cast<char>('a' + i))));
+    }
+    constexpr int kThreads = 4;
+    constexpr int kPuts = 25;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        fs::create_directories(dir.Path() / std::to_string(t));
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kPuts; ++i) {
+                Put(store, blobs[static_cast<size_t>(i) % blobs.size()], dir.Path() / std::to_string(t) / (std::to_string(i) + ".png"));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    uint32_t total = 0;
+    for (const auto& blob : blobs) {
+        total += store.References(blob.sha256);
+    }
+    CHECK(total == kThreads * kPuts);
+    const auto stats = store.GetStats();
+    CHECK(stats.objects == blobs.size());
+    CHECK(stats.misses == blobs.size());
+    CHECK(stats.hits == kThreads * kPuts - blobs.size());
+}
+
+} // namespace
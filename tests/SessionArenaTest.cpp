@@ -0,0 +1,220 @@
+#include "SessionArena.h"
+
+#include "Check.h"
+#include "FrameStore.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Every global operator new in this test binary is counted, aligned ones
+// included, so a test can compare what reached the heap with what the arena
+// asked its upstream for.
+namespace {
+std::atomic<uint64_t> g_heapAllocations{ 0 };
+}
+
+void* operator new(size_t size) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<size_t>(alignment);
+    if (void* pointer = std::aligned_alloc(align, (size + align - 1) / align * align + (size ? 0 : align))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+
+uint64_t HeapAllocations() {
+    return g_heapAllocations.load(std::memory_order_relaxed);
+}
+
+TEST_CASE(SmallAllocationsShareChunks) {
+    CountingResource upstream;
+    {
+        SessionArena arena(4096, &upstream);
+        CHECK(arena.UpstreamAllocations() == 0);
+        for (int i = 0; i < 30; ++i) {
+            CHECK(arena.allocate(100, 8) != nullptr);
+        }
+        // 30 x 100 bytes fit one 4 KB chunk.
+        CHECK(arena.UpstreamAllocations() == 1);
+        CHECK(arena.BytesAllocated() == 3000);
+        CHECK(arena.BytesReserved() == 4096);
+        for (int i = 0; i < 20; ++i) {
+            CHECK(arena.allocate(100, 8) != nullptr);
+        }
+        CHECK(arena.UpstreamAllocations() == 2);
+        CHECK(upstream.BytesInUse() == 8192);
+    }
+    // Everything goes back at once.
+    CHECK(upstream.BytesInUse() == 0);
+    CHECK(upstream.Allocations() == upstream.Deallocations());
+}
+
+TEST_CASE(AlignmentIsHonoured) {
+    SessionArena arena(4096);
+    for (const size_t alignment : { size_t{ 1 }, size_t{ 2 }, size_t{ 8 }, size_t{ 16 }, size_t{ 64 } }) {
+        CHECK(arena.allocate(3, 1) != nullptr);
+        void* pointer = arena.allocate(24, alignment);
+        CHECK(reinterpret_cast<uintptr_t>(pointer) % alignment == 0);
+    }
+}
+
+TEST_CASE(LargeRequestsGetTheirOwnBlock) {
+    CountingResource upstream;
+    SessionArena arena(4096, &upstream);
+    auto* first = static_cast<std::byte*>(arena.allocate(64, 8));
+    CHECK(arena.allocate(2000, 8) != nullptr);
+    CHECK(arena.UpstreamAllocations() == 2);
+    // The current chunk keeps serving small requests after a large one.
+    auto* next = static_cast<std::byte*>(arena.allocate(64, 8));
+    CHECK(next > first && next < first + 4096);
+    CHECK(arena.UpstreamAllocations() == 2);
+    CHECK(upstream.BytesInUse() == 4096 + 2000);
+    // Deallocation is a no-op until the arena goes.
+    arena.deallocate(next, 64, 8);
+    CHECK(upstream.BytesInUse() == 4096 + 2000);
+}
+
+// CaptureSession::CaptureNext's bookkeeping for a scrolled view, with the
+// session's chunk size: a PNG buffer, the frame's path, its row signatures and
+// measured shift, then FrameStore::Add. Pixel grabbing, encoding and file
+// writes are left out; they allocate through Win32, WIC and the CRT.
+TEST_CASE(FrameBookkeepingAllocatesOnlyThroughTheArena) {
+    constexpr uint32_t kWidth = 1280;
+    constexpr uint32_t kHeight = 1024;
+    constexpr uint32_t kStride = kWidth * 4;
+    constexpr uint32_t kScrollRows = 8;
+    constexpr size_t kFrames = 120;
+    constexpr size_t kLargeRequest = SessionArena::kDefaultChunkBytes / 4;
+
+    // A page taller than the view whose rows all differ; each frame looks
+    // kScrollRows further down it.
+    std::vector<uint8_t> page(static_cast<size_t>(kStride) * (kHeight + kFrames * kScrollRows));
+    for (size_t i = 0; i < page.size(); ++i) {
+        const uint32_t cell = static_cast<uint32_t>((i / kStride) * 4 + (i % kStride) / (kStride / 4));
+        page[i] = static_cast<uint8_t>((cell * 2654435761u) >> 24);
+    }
+    const std::wstring rawDirectory = L"C:\\Users\\trainer\\Chronos\\20261019_120000_000\\raw";
+
+    CountingResource upstream;
+    auto arena = std::make_shared<SessionArena>(SessionArena::kDefaultChunkBytes,
+                                                std::shared_ptr<std::pmr::memory_resource>(&upstream, [](auto*) {}));
+    {
+        FrameStore store;
+        store.Reset(arena);
+        size_t largePngs = 0;
+        size_t largeBytes = 0;
+        size_t validShifts = 0;
+
+        const auto heapBefore = HeapAllocations();
+        for (size_t i = 0; i < kFrames; ++i) {
+            wchar_t fileName[32] = {};
+            std::swprintf(fileName, std::size(fileName), L"shot_%04zu.png", i + 1);
+            Frame frame = store.NewFrame();
+            // Encoded sizes vary with the content; some take a block of their own.
+            const size_t pngBytes = 24 * 1024 + (i * 7919) % (160 * 1024);
+            if (pngBytes > kLargeRequest) {
+                ++largePngs;
+                largeBytes += pngBytes;
+            }
+            auto png = store.NewBuffer();
+            png->resize(pngBytes);
+            frame.png = std::move(png);
+            frame.path.assign(rawDirectory).append(L"\\").append(fileName);
+            frame.index = i + 1;
+            frame.width = kWidth;
+            frame.height = kHeight;
+            frame.stride = kStride;
+            const uint8_t* view = page.data() + i * kScrollRows * kStride;
+            motion::ComputeRowSignatures(view, kWidth, kHeight, kStride, frame.signatures);
+            if (!store.Empty()) {
+                frame.shift = motion::EstimateShift(store.Last().signatures, frame.signatures);
+                validShifts += frame.shift->valid && frame.shift->shift == kScrollRows;
+            }
+            store.Add(std::move(frame));
+        }
+        const auto heapAllocations = HeapAllocations() - heapBefore;
+
+        // Everything on the heap was a block the arena asked its upstream for...
+        CHECK(heapAllocations == upstream.Allocations());
+        // ...and apart from the large PNGs those were whole chunks, each at
+        // least three quarters used, shared by every small allocation.
+        const size_t smallBytes = arena->BytesAllocated() - largeBytes;
+        CHECK(upstream.Allocations() - largePngs <= smallBytes / (SessionArena::kDefaultChunkBytes * 3 / 4) + 1);
+        CHECK(upstream.Allocations() - largePngs < kFrames / 8);
+        CHECK(validShifts == kFrames - 1);
+        CHECK(store.Size() == kFrames);
+        CHECK(std::wstring_view(store.Last().path) == rawDirectory + L"\\shot_0120.png");
+
+        // The generic overload still goes to the heap for its shared holder.
+        const std::shared_ptr<std::pmr::memory_resource> resource = arena;
+        const auto heapAfter = HeapAllocations();
+        auto generic = MakeSessionBuffer(resource);
+        CHECK(HeapAllocations() > heapAfter);
+    }
+
+    // End(): the last holder lets go and the session goes back in one pass.
+    arena.reset();
+    CHECK(upstream.BytesInUse() == 0);
+    CHECK(upstream.Allocations() == upstream.Deallocations());
+}
+
+TEST_CASE(BuffersKeepTheArenaAlive) {
+    CountingResource upstream;
+    auto arena = std::make_shared<SessionArena>(4096, std::shared_ptr<std::pmr::memory_resource>(&upstream, [](auto*) {}));
+    auto png = MakeSessionBuffer(arena);
+    png->resize(100);
+    std::weak_ptr<SessionArena> watch = arena;
+
+    // The session ends while a frame is still published.
+    arena.reset();
+    CHECK(!watch.expired());
+    CHECK(upstream.BytesInUse() == 4096);
+    auto copy = png;
+    png.reset();
+    CHECK(!watch.expired());
+    copy.reset();
+    CHECK(watch.expired());
+    CHECK(upstream.BytesInUse() == 0);
+    CHECK(upstream.Allocations() == upstream.Deallocations());
+
+    // No arena: a plain heap buffer.
+    std::shared_ptr<SessionArena> none;
+    auto heap = MakeSessionBuffer(none);
+    heap->resize(10);
+    CHECK(heap->get_allocator().resource() == std::pmr::get_default_resource());
+}
+
+} // namespace
@@ -0,0 +1,193 @@
+#include "SessionManifest.h"
+
+#include "Check.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+std::vector<uint8_t> ReadBytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+manifest::FrameRecord MakeFrame(uint32_t index, uint8_t seed) {
+    manifest::FrameRecord record;
+    record.index = index;
+    record.capturedAtMs = 1'760'000'000'000ull + index;
+    record.width = 1920;
+    record.height = 1080 + seed;
+    record.roiLeft = -1920 + seed;
+    record.roiTop = -8;
+    record.shiftValid = seed % 2 == 0;
+    record.shiftRows = 311u * seed;
+    record.matchRatio = 0.875f + seed / 1024.0f;
+    record.pngBytes = 5'000'000'000ull + seed;
+    record.encodeMicros = 40000u + seed;
+    for (size_t i = 0; i < record.sha256.size(); ++i) {
+        record.sha256[i] = static_cast<uint8_t>(seed * 31 + i);
+    }
+    record.shared = seed % 3 == 0;
+    return record;
+}
+
+void CheckSame(const manifest::FrameRecord& a, const manifest::FrameRecord& b) {
+    CHECK(a.kind == b.kind);
+    CHECK(a.index == b.index);
+    CHECK(a.capturedAtMs == b.capturedAtMs);
+    CHECK(a.width == b.width);
+    CHECK(a.height == b.height);
+    CHECK(a.roiLeft == b.roiLeft);
+    CHECK(a.roiTop == b.roiTop);
+    CHECK(a.shiftValid == b.shiftValid);
+    CHECK(a.shiftRows == b.shiftRows);
+    CHECK(a.matchRatio == b.matchRatio);
+    CHECK(a.pngBytes == b.pngBytes);
+    CHECK(a.encodeMicros == b.encodeMicros);
+    CHECK(a.sha256 == b.sha256);
+    CHECK(a.shared == b.shared);
+}
+
+TEST_CASE(RecordsRoundTripThroughTheFile) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "session.manifest";
+    std::vector<manifest::FrameRecord> written;
+    manifest::Writer writer;
+    REQUIRE(writer.Open(path));
+    for (uint32_t i = 1; i <= 6; ++i) {
+        written.push_back(MakeFrame(i, static_cast<uint8_t>(i)));
+        CHECK(writer.Append(written.back()));
+    }
+    manifest::FrameRecord memory;
+    memory.kind = manifest::RecordKind::Memory;
+    for (size_t i = 0; i < manifest::kMemoryTags; ++i) {
+        memory.memory[i] = { (1ull << 40) + i, (1ull << 41) + i };
+    }
+    CHECK(writer.Append(memory));
+    CHECK(writer.Count() == 7);
+    writer.Close();
+
+    std::vector<manifest::FrameRecord> read;
+    REQUIRE(manifest::ReadManifest(path, read));
+    REQUIRE(read.size() == 7);
+    for (size_t i = 0; i < written.size(); ++i) {
+        CheckSame(read[i], written[i]);
+    }
+    CHECK(read[6].kind == manifest::RecordKind::Memory);
+    for (size_t i = 0; i < manifest::kMemoryTags; ++i) {
+        CHECK(read[6].memory[i].current == (1ull << 40) + i);
+        CHECK(read[6].memory[i].peak == (1ull << 41) + i);
+    }
+}
+
+TEST_CASE(FixedLayoutCanBeIndexedInPlace) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "session.manifest";
+    manifest::Writer writer;
+    REQUIRE(writer.Open(path));
+    for (uint32_t i = 1; i <= 3; ++i) {
+        // The file tracks every append without waiting for Close().
+        writer.Append(MakeFrame(i, static_cast<uint8_t>(10 * i)));
+        CHECK(std::filesystem::file_size(path) == manifest::kHeaderSize + i * manifest::kRecordSize);
+    }
+
+    // What a reader that maps the file sees.
+    const auto bytes = ReadBytes(path);
+    REQUIRE(manifest::ValidHeader(bytes.data(), bytes.size()));
+    CHECK(std::string(bytes.begin(), bytes.begin() + 8) == "CHRNMNFT");
+    CHECK(bytes[8] == manifest::kVersion);
+    CHECK(bytes[12] == manifest::kRecordSize);
+    const auto second = manifest::DecodeRecord(bytes.data() + manifest::kHeaderSize + 1 * manifest::kRecordSize);
+    CheckSame(second, MakeFrame(2, 20));
+    // Little-endian index at offset 4 of each record.
+    CHECK(bytes[manifest::kHeaderSize + 2 * manifest::kRecordSize + 4] == 3);
+}
+
+TEST_CASE(TornTailIsDroppedAndAppendContinues) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "session.manifest";
+    {
+        manifest::Writer writer;
+        REQUIRE(writer.Open(path));
+        for (uint32_t i = 1; i <= 4; ++i) {
+            writer.Append(MakeFrame(i, static_cast<uint8_t>(i)));
+        }
+    }
+    // A crash in the middle of the fourth record.
+    std::filesystem::resize_file(path, manifest::kHeaderSize + 3 * manifest::kRecordSize + 40);
+    std::vector<manifest::FrameRecord> read;
+    REQUIRE(manifest::ReadManifest(path, read));
+    CHECK(read.size() == 3);
+
+    // Resuming cuts the torn bytes before appending.
+    manifest::Writer resumed;
+    REQUIRE(resumed.Open(path, true));
+    CHECK(resumed.Count() == 3);
+    resumed.Append(MakeFrame(4, 44));
+    resumed.Close();
+    REQUIRE(manifest::ReadManifest(path, read));
+    REQUIRE(read.size() == 4);
+    CheckSame(read[2], MakeFrame(3, 3));
+    CheckSame(read[3], MakeFrame(4, 44));
+}
+
+TEST_CASE(BadHeadersAreRejected) {
+    check::TempDir dir;
+    const auto path = dir.Path() / "session.manifest";
+    std::vector<manifest::FrameRecord> read;
+    CHECK(!manifest::ReadManifest(path, read));
+    {
+        manifest::Writer writer;
+        REQUIRE(writer.Open(path));
+        writer.Append(MakeFrame(1, 1));
+    }
+    const auto good = ReadBytes(path);
+    for (const size_t offset : { size_t{ 0 }, size_t{ 8 }, size_t{ 12 } }) {
+        auto bad = good;
+        bad[offset] ^= 0x01;
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(bad.data()), static_cast<std::streamsize>(bad.size()));
+        }
+        CHECK(!manifest::ReadManifest(path, read));
+    }
+    CHECK(!manifest::ValidHeader(good.data(), manifest::kHeaderSize - 1));
+
+    // Appending to something that is not a manifest starts a new one.
+    manifest::Writer writer;
+    REQUIRE(writer.Open(path, true));
+    CHECK(writer.Count() == 0);
+    writer.Append(MakeFrame(9, 9));
+    writer.Close();
+    REQUIRE(manifest::ReadManifest(path, read));
+    REQUIRE(read.size() == 1);
+    CHECK(read[0].index == 9);
+}
+
+TEST_CASE(LiveFramesReplaysDropsAndReshots) {
+    using manifest::RecordKind;
+    const auto drop = [](uint32_t index) {
+        manifest::FrameRecord record;
+        record.kind = RecordKind::Drop;
+        record.index = index;
+        return record;
+    };
+    manifest::FrameRecord memory;
+    memory.kind = RecordKind::Memory;
+    const std::vector<manifest::FrameRecord> records = {
+        MakeFrame(1, 1), MakeFrame(2, 2), MakeFrame(3, 3),
+        drop(3), drop(2),
+        MakeFrame(2, 22),
+        drop(7),
+        MakeFrame(4, 4),
+        memory,
+    };
+    const auto live = manifest::LiveFrames(records);
+    REQUIRE(live.size() == 3);
+    CHECK(live[0].index == 1);
+    CheckSame(live[1], MakeFrame(2, 22));
+    CHECK(live[2].index == 4);
+}
+
+} // namespace
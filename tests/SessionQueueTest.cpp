@@ -0,0 +1,257 @@
+#include "SessionQueue.h"
+
+#include "Check.h"
+#include "FrameStore.h"
+#include "JobScheduler.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Stands in for the UI thread: job callbacks queue up until Pump() runs them.
+class FakeUiThread {
+public:
+    JobScheduler::Dispatcher Dispatcher() {
+        return [this](std::function<void()> callback) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(std::move(callback));
+        };
+    }
+    void Pump() {
+        std::vector<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.swap(pending_);
+        }
+        for (auto& callback : batch) {
+            callback();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::function<void()>> pending_;
+};
+
+DataUrls Urls(size_t count, size_t length) {
+    DataUrls dataUrls(std::make_shared<SessionArena>());
+    for (size_t i = 0; i < count; ++i) {
+        dataUrls.urls.emplace_back(length, L'A');
+    }
+    return dataUrls;
+}
+
+TEST_CASE(CaptureAdmission) {
+    struct Row {
+        size_t inFlight;
+        size_t bytes;
+        size_t maxInFlight;
+        size_t budget;
+        bool allowed;
+    };
+    const Row rows[] = {
+        { 0, 0, 0, 0, true },       // nothing pending: always allowed
+        { 0, 900, 2, 100, true },   // ...even with a stale byte count
+        { 1, 10, 0, 100, false },   // maxInFlight 0 waits for every session
+        { 1, 10, 2, 100, true },
+        { 2, 10, 2, 100, false },   // at the session limit
+        { 1, 100, 2, 100, false },  // at the byte budget
+        { 1, 99, 2, 100, true },
+    };
+    for (const auto& row : rows) {
+        CHECK(sessions::CanStartCapture(row.inFlight, row.bytes, row.maxInFlight, row.budget) == row.allowed);
+    }
+}
+
+TEST_CASE(PublishedSetsTrimOldestAndPage) {
+    const auto bridgeBefore = memory::Get(memory::Tag::Bridge).current;
+    PublishedSets sets;
+    CHECK(!sets.Publish(L"empty", {}));
+    CHECK(sets.Empty());
+    sets.Select(-1);
+
+    sets.SetLimits(3, 1000);
+    for (int i = 0; i < 5; ++i) {
+        CHECK(sets.Publish(L"s" + std::to_wstring(i), Urls(1, 10)));
+    }
+    REQUIRE(sets.Size() == 3);
+    CHECK(sets.Selected().label == L"s4");
+    CHECK(sets.SelectedIndex() == 2);
+    CHECK(sets.Bytes() == 3 * 10 * sizeof(wchar_t));
+    CHECK(memory::Get(memory::Tag::Bridge).current == bridgeBefore + sets.Bytes());
+
+    sets.Select(-1);
+    CHECK(sets.Selected().label == L"s3");
+    sets.Select(-10);
+    CHECK(sets.Selected().label == L"s2");
+    sets.Select(10);
+    CHECK(sets.Selected().label == L"s4");
+
+    // Trimming keeps the selection on the same set while it survives.
+    sets.Select(-1);
+    sets.Publish(L"s5", Urls(1, 10));
+    CHECK(sets.Selected().label == L"s5");
+    sets.Select(-1);
+    sets.SetLimits(2, 1000);
+    CHECK(sets.Size() == 2);
+    CHECK(sets.Selected().label == L"s4");
+
+    // A set over the byte budget on its own still stays, alone.
+    sets.Publish(L"big", Urls(4, 200));
+    CHECK(sets.Size() == 1);
+    CHECK(sets.Selected().label == L"big");
+    CHECK(sets.Bytes() == 4 * 200 * sizeof(wchar_t));
+
+    sets.SetLimits(0, 1 << 20);
+    sets.Publish(L"next", Urls(1, 10));
+    CHECK(sets.Size() == 1);
+    CHECK(sets.Selected().label == L"next");
+    CHECK(memory::Get(memory::Tag::Bridge).current == bridgeBefore + sets.Bytes());
+}
+
+TEST_CASE(PublishedUrlsStayInTheirArena) {
+    auto urls = Urls(3, 100);
+    const SessionArena* arena = urls.arena.get();
+    PublishedSets sets;
+    REQUIRE(sets.Publish(L"s", std::move(urls)));
+    REQUIRE(sets.Publish(L"t", Urls(1, 10)));
+    sets.Select(-1);
+
+    // Moved through, never copied onto the heap.
+    const auto& published = sets.Selected().dataUrls;
+    CHECK(published.arena.get() == arena);
+    CHECK(published.urls.get_allocator().resource() == arena);
+    REQUIRE(published.urls.size() == 3);
+    for (const auto& url : published.urls) {
+        CHECK(url.get_allocator().resource() == arena);
+        CHECK(url.size() == 100);
+    }
+}
+
+// A trainer capturing several trainees in a row: captures end in bursts while
+// earlier ones are still being prepared in the background, as
+// Application::StartProcessing / FinishProcessing do it.
+TEST_CASE(RapidBackToBackSessions) {
+    constexpr size_t kMaxInFlight = 2;
+    constexpr size_t kFrames = 8;
+    constexpr size_t kPngBytes = 16 * 1024;
+    constexpr size_t kBudget = 3 * kFrames * kPngBytes;
+    constexpr int kBursts = 10;
+    constexpr int kPressesPerBurst = 4;
+    constexpr int kPresses = kBursts * kPressesPerBurst;
+
+    struct Session {
+        int number = 0;
+        std::shared_ptr<memory::Ledger> ledger = std::make_shared<memory::Ledger>();
+        FrameStore frames;
+    };
+
+    const auto framesBefore = memory::Get(memory::Tag::FrameStore).current;
+    FakeUiThread ui;
+    JobScheduler jobs(2, ui.Dispatcher());
+    std::vector<std::unique_ptr<Session>> inFlight;
+    PublishedSets published;
+    published.SetLimits(4, kBudget);
+    std::vector<int> publishOrder;
+    size_t refused = 0;
+    size_t maxInFlight = 0;
+    size_t maxInFlightBytes = 0;
+    JobHandle processing;
+
+    const auto inFlightBytes = [&inFlight] {
+        size_t bytes = 0;
+        for (const auto& session : inFlight) {
+            bytes += session->frames.Bytes();
+        }
+        return bytes;
+    };
+
+    for (int press = 0; press < kPresses; ++press) {
+        // Completions are only seen between bursts, so every burst outruns the limit.
+        if (press % kPressesPerBurst == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            ui.Pump();
+        }
+        if (!sessions::CanStartCapture(inFlight.size(), inFlightBytes(), kMaxInFlight, kBudget)) {
+            ++refused;
+            continue;
+        }
+        auto session = std::make_unique<Session>();
+        session->number = press;
+        const auto resource = session->ledger->Resource(memory::Tag::FrameStore);
+        for (size_t i = 0; i < kFrames; ++i) {
+            Frame frame;
+            frame.index = i;
+            auto png = MakeSessionBuffer(resource);
+            png->assign(kPngBytes, static_cast<uint8_t>(press));
+            frame.png = std::move(png);
+            session->frames.Add(std::move(frame));
+        }
+
+        // Capture ends: the session joins the in-flight queue and is prepared in capture order.
+        auto frames = std::make_shared<const std::vector<Frame>>(session->frames.Frames().begin(), session->frames.Frames().end());
+        auto urls = std::make_shared<DataUrls>(std::make_shared<SessionArena>());
+        const Session* owner = session.get();
+        inFlight.push_back(std::move(session));
+        maxInFlight = (std::max)(maxInFlight, inFlight.size());
+        maxInFlightBytes = (std::max)(maxInFlightBytes, inFlightBytes());
+
+        JobOptions options;
+        options.onComplete = [&, owner, urls](JobStatus) {
+            for (auto it = inFlight.begin(); it != inFlight.end(); ++it) {
+                if (it->get() == owner) {
+                    publishOrder.push_back(owner->number);
+                    published.Publish(std::to_wstring(owner->number), std::move(*urls));
+                    inFlight.erase(it);
+                    break;
+                }
+            }
+        };
+        // Longer than a burst, so captures pile up; earlier sessions take longer,
+    // so only the chaining keeps them in order.
+        const auto work = std::chrono::milliseconds(3 + (kPresses - press) / 8);
+        processing = jobs.ContinueWith(processing, [frames, urls, work](JobContext&) {
+            std::this_thread::sleep_for(work);
+            for (const auto& frame : *frames) {
+                urls->urls.emplace_back(frame.png->size() / 64, L'A');
+            }
+            return true;
+        }, std::move(options));
+    }
+
+    processing.Wait();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!inFlight.empty() && std::chrono::steady_clock::now() < deadline) {
+        ui.Pump();
+        std::this_thread::yield();
+    }
+    CHECK(inFlight.empty());
+
+    // Bounded: never more sessions than allowed, and admission stopped once the
+    // budget was reached (the last session admitted may take it over).
+    CHECK(maxInFlight <= kMaxInFlight);
+    CHECK(maxInFlightBytes < kBudget + kFrames * kPngBytes);
+    CHECK(refused > 0);
+    REQUIRE(publishOrder.size() == kPresses - refused);
+    for (size_t i = 1; i < publishOrder.size(); ++i) {
+        CHECK(publishOrder[i] > publishOrder[i - 1]);
+    }
+
+    // The page bridge holds the newest sets only, newest selected.
+    const size_t kept = (std::min)(publishOrder.size(), size_t{ 4 });
+    CHECK(published.Size() == kept);
+    CHECK(published.Selected().label == std::to_wstring(publishOrder.back()));
+    published.Select(-3);
+    CHECK(published.Selected().label == std::to_wstring(publishOrder[publishOrder.size() - kept]));
+
+    // Released sessions give their frame bytes back.
+    CHECK(memory::Get(memory::Tag::FrameStore).current == framesBefore);
+}
+
+} // namespace
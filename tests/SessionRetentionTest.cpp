@@ -0,0 +1,178 @@
+#include "SessionRetention.h"
+
+#include "Check.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+// A session folder holding raw/shot_NNNN.png files of the given sizes, all
+// last written `age` before `now`.
+fs::path MakeSession(const fs::path& root, const std::string& name, std::initializer_list<size_t> sizes,
+                     fs::file_time_type now, std::chrono::seconds age) {
+    const auto session = root / name;
+    fs::create_directories(session / "raw");
+    int index = 0;
+    for (const size_t size : sizes) {
+        const auto file = session / "raw" / ("shot_" + std::to_string(index++) + ".png");
+        std::ofstream(file, std::ios::binary) << std::string(size, 'x');
+        fs::last_write_time(file, now - age);
+    }
+    fs::last_write_time(session / "raw", now - age);
+    fs::last_write_time(session, now - age);
+    return session;
+}
+
+SessionInfo Info(const std::string& name, uint64_t bytes, fs::file_time_type modified) {
+    return SessionInfo{ fs::path("/sessions") / name, bytes, modified };
+}
+
+std::vector<std::string> Names(const std::vector<SessionInfo>& sessions) {
+    std::vector<std::string> names;
+    for (const auto& session : sessions) {
+        names.push_back(session.path.filename().string());
+    }
+    return names;
+}
+
+TEST_CASE(ByteSizesAndDurations) {
+    uint64_t bytes = 0;
+    CHECK(retention::ParseByteSize("1536", bytes) && bytes == 1536);
+    CHECK(retention::ParseByteSize("512K", bytes) && bytes == 512ull << 10);
+    CHECK(retention::ParseByteSize(" 2g ", bytes) && bytes == 2ull << 30);
+    CHECK(retention::ParseByteSize("3m", bytes) && bytes == 3ull << 20);
+    CHECK(!retention::ParseByteSize("", bytes));
+    CHECK(!retention::ParseByteSize("2T", bytes));
+    CHECK(!retention::ParseByteSize("2GB", bytes));
+    CHECK(!retention::ParseByteSize("-1", bytes));
+    CHECK(retention::FormatByteSize(2ull << 30) == "2G");
+    CHECK(retention::FormatByteSize(1536) == "1536");
+    CHECK(retention::FormatByteSize(1536ull << 10) == "1536K");
+
+    int64_t seconds = 0;
+    CHECK(retention::ParseDuration("90s", seconds) && seconds == 90);
+    CHECK(retention::ParseDuration("30m", seconds) && seconds == 1800);
+    CHECK(retention::ParseDuration("12H", seconds) && seconds == 43200);
+    CHECK(retention::ParseDuration("7", seconds) && seconds == 7 * 86400);
+    CHECK(!retention::ParseDuration("7w", seconds));
+    CHECK(!retention::ParseDuration("d", seconds));
+    for (const int64_t value : { int64_t{ 90 }, int64_t{ 1800 }, int64_t{ 43200 }, int64_t{ 30 * 86400 } }) {
+        REQUIRE(retention::ParseDuration(retention::FormatDuration(value), seconds));
+        CHECK(seconds == value);
+    }
+}
+
+TEST_CASE(ScanSumsFilesAndTakesTheNewestWrite) {
+    check::TempDir dir;
+    const auto now = fs::file_time_type::clock::now();
+    MakeSession(dir.Path(), "20260101-090000", { 100, 200 }, now, 3600s);
+    const auto fresh = MakeSession(dir.Path(), "20260101-100000", { 50 }, now, 7200s);
+    // A late write inside an old folder makes the whole session recent.
+    std::ofstream(fresh / "manifest.bin", std::ios::binary) << std::string(10, 'm');
+    fs::last_write_time(fresh / "manifest.bin", now - 60s);
+    fs::last_write_time(fresh, now - 7200s);
+    std::ofstream(dir.Path() / "stray.txt") << "not a session";
+
+    auto sessions = retention::ScanSessions(dir.Path());
+    std::sort(sessions.begin(), sessions.end(), [](const auto& a, const auto& b) { return a.path < b.path; });
+    REQUIRE(sessions.size() == 2);
+    CHECK(sessions[0].bytes == 300);
+    CHECK(sessions[0].modified == now - 3600s);
+    CHECK(sessions[1].bytes == 60);
+    CHECK(sessions[1].modified == now - 60s);
+    CHECK(retention::ScanSessions(dir.Path() / "missing").empty());
+}
+
+TEST_CASE(SelectionPolicies) {
+    const auto now = fs::file_time_type::clock::now();
+    const std::vector<SessionInfo> sessions = {
+        Info("d", 400, now - 1h),
+        Info("a", 100, now - 40 * 24h),
+        Info("c", 300, now - 2h),
+        Info("b", 200, now - 10 * 24h),
+    };
+
+    RetentionPolicy none;
+    CHECK(retention::SelectForDeletion(sessions, none, now, {}).empty());
+
+    RetentionPolicy age;
+    age.maxSessionAgeSeconds = 7 * 86400;
+    CHECK((Names(retention::SelectForDeletion(sessions, age, now, {})) == std::vector<std::string>{ "a", "b" }));
+
+    // Oldest first until the rest fit: 1000 -> 900 -> 700.
+    RetentionPolicy size;
+    size.maxSessionBytes = 750;
+    CHECK((Names(retention::SelectForDeletion(sessions, size, now, {})) == std::vector<std::string>{ "a", "b" }));
+    size.maxSessionBytes = 1000;
+    CHECK(retention::SelectForDeletion(sessions, size, now, {}).empty());
+
+    // The newest N survive both limits.
+    RetentionPolicy keep = age;
+    keep.maxSessionBytes = 1;
+    keep.keepLastN = 3;
+    CHECK((Names(retention::SelectForDeletion(sessions, keep, now, {})) == std::vector<std::string>{ "a" }));
+    keep.keepLastN = 10;
+    CHECK(retention::SelectForDeletion(sessions, keep, now, {}).empty());
+
+    // A protected session is never selected but still counts against the
+    // budget, so the next oldest goes instead.
+    size.maxSessionBytes = 750;
+    const std::vector<fs::path> active = { "/sessions/./a" };
+    CHECK((Names(retention::SelectForDeletion(sessions, size, now, active)) == std::vector<std::string>{ "b", "c" }));
+
+    // Equal times fall back to the (timestamped) folder name.
+    const std::vector<SessionInfo> tied = { Info("2", 10, now), Info("1", 10, now), Info("3", 10, now) };
+    size.maxSessionBytes = 15;
+    CHECK((Names(retention::SelectForDeletion(tied, size, now, {})) == std::vector<std::string>{ "1", "2" }));
+}
+
+TEST_CASE(CollectDeletesIncrementallyAndReportsBytes) {
+    check::TempDir dir;
+    const auto now = fs::file_time_type::clock::now();
+    const auto root = dir.Path() / "sessions";
+    MakeSession(root, "old1", { 1000, 2000, 3000 }, now, 48h);
+    MakeSession(root, "old2", { 500 }, now, 24h);
+    const auto active = MakeSession(root, "active", { 700 }, now, 72h);
+    // A frame shared with the object store is a hard link; deleting it frees nothing.
+    fs::create_directories(dir.Path() / "objects");
+    std::ofstream(dir.Path() / "objects" / "blob", std::ios::binary) << std::string(4000, 'o');
+    fs::last_write_time(dir.Path() / "objects" / "blob", now - 24h);
+    fs::create_hard_link(dir.Path() / "objects" / "blob", root / "old2" / "raw" / "shared.png");
+
+    RetentionPolicy policy;
+    policy.maxSessionAgeSeconds = 3600;
+    const auto doomed = retention::SelectForDeletion(retention::ScanSessions(root), policy, now, { active });
+    REQUIRE((Names(doomed) == std::vector<std::string>{ "old1", "old2" }));
+
+    // Cancelled after the first session: it is gone whole, the next untouched.
+    std::ofstream(root / "old2" / "session.manifest", std::ios::binary) << std::string(100, 'm');
+    fs::last_write_time(root / "old2" / "session.manifest", now - 24h);
+    fs::last_write_time(root / "old2", now - 24h);
+    int checks = 0;
+    auto partial = retention::Collect(doomed, [&checks] { return ++checks > 1; });
+    CHECK(partial.cancelled);
+    CHECK(partial.sessionsRemoved == 1);
+    CHECK(partial.bytesReclaimed == 6000);
+    CHECK(!fs::exists(root / "old1"));
+    CHECK(fs::exists(root / "old2" / "session.manifest"));
+    CHECK(fs::exists(root / "old2" / "raw" / "shared.png"));
+
+    // A later pass picks up where it stopped.
+    const auto remaining = retention::SelectForDeletion(retention::ScanSessions(root), policy, now, { active });
+    const auto result = retention::Collect(remaining, [] { return false; });
+    CHECK(result.ok);
+    CHECK(!result.cancelled);
+    CHECK(result.sessionsRemoved == 1);
+    CHECK(partial.bytesReclaimed + result.bytesReclaimed == 6600);
+    CHECK(!fs::exists(root / "old1"));
+    CHECK(!fs::exists(root / "old2"));
+    CHECK(fs::exists(active / "raw" / "shot_0.png"));
+    CHECK(fs::file_size(dir.Path() / "objects" / "blob") == 4000);
+}
+
+} // namespace
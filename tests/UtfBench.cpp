@@ -0,0 +1,58 @@
+#include "Utf.h"
+
+#include "Bench.h"
+
+#include <random>
+#include <string>
+
+namespace {
+
+// Base64 payloads are what the bridge mostly carries; the mixed text is the
+// worst case the fast path has to fall out of.
+std::string MakeAscii(size_t length) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text(length, '\0');
+    std::mt19937 rng(1);
+    for (auto& ch : text) {
+        ch = kAlphabet[rng() % 64];
+    }
+    return text;
+}
+
+std::string MakeMixed(size_t length) {
+    std::string text;
+    std::mt19937 rng(2);
+    while (text.size() < length) {
+        text.append(static_cast<size_t>(rng() % 24), 'a');
+        text.append("\xC3\xA9\xE2\x82\xAC");
+    }
+    return text;
+}
+
+void RunPair(const char* label, const std::string& text) {
+    std::u16string wide(util::MaxUtf16Length(text.size()), u'\0');
+    std::string narrow(util::MaxUtf8Length(text.size()), '\0');
+    const size_t units = util::Utf8ToUtf16(text.data(), text.size(), wide.data(), wide.size()).written;
+
+    std::string name = std::string("Utf8ToUtf16 ") + label;
+    bench::Run(name.c_str(), text.size(), [&] {
+        return util::Utf8ToUtf16(text.data(), text.size(), wide.data(), wide.size()).written;
+    });
+    name = std::string("Utf16ToUtf8 ") + label;
+    bench::Run(name.c_str(), text.size(), [&] {
+        return util::Utf16ToUtf8(wide.data(), units, narrow.data(), narrow.size()).written;
+    });
+    name = std::string("IsValidUtf8 ") + label;
+    bench::Run(name.c_str(), text.size(), [&] {
+        return static_cast<size_t>(util::IsValidUtf8(text.data(), text.size()));
+    });
+}
+
+} // namespace
+
+int main() {
+    RunPair("base64 8 MB", MakeAscii(8u << 20));
+    RunPair("mixed 8 MB", MakeMixed(8u << 20));
+    RunPair("base64 4 KB", MakeAscii(4u << 10));
+    return 0;
+}
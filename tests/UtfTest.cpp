@@ -0,0 +1,244 @@
+#include "Utf.h"
+
+#include "Check.h"
+
+#include <random>
+#include <string>
+
+namespace {
+
+// Straightforward scalar converters with the Win32 CP_UTF8 semantics, one code
+// point at a time, to check the vectorized ones against.
+std::u16string ReferenceUtf8ToUtf16(const std::string& text) {
+    std::u16string out;
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    size_t i = 0;
+    while (i < n) {
+        const unsigned lead = s[i];
+        if (lead < 0x80) {
+            out.push_back(static_cast<char16_t>(lead));
+            ++i;
+            continue;
+        }
+        size_t length = 0;
+        unsigned lower = 0x80;
+        unsigned upper = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            lower = lead == 0xE0 ? 0xA0 : 0x80;
+            upper = lead == 0xED ? 0x9F : 0xBF;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            lower = lead == 0xF0 ? 0x90 : 0x80;
+            upper = lead == 0xF4 ? 0x8F : 0xBF;
+        } else {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        char32_t codePoint = lead & (0x7F >> length);
+        size_t k = 1;
+        for (; k < length && i + k < n; ++k) {
+            const unsigned byte = s[i + k];
+            const unsigned low = k == 1 ? lower : 0x80;
+            const unsigned high = k == 1 ? upper : 0xBF;
+            if (byte < low || byte > high) {
+                break;
+            }
+            codePoint = (codePoint << 6) | (byte & 0x3F);
+        }
+        if (k < length) {
+            // Maximal subpart: the valid prefix becomes one replacement character.
+            out.push_back(0xFFFD);
+            i += k;
+            continue;
+        }
+        if (codePoint >= 0x10000) {
+            out.push_back(static_cast<char16_t>(0xD800 + ((codePoint - 0x10000) >> 10)));
+            out.push_back(static_cast<char16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+        } else {
+            out.push_back(static_cast<char16_t>(codePoint));
+        }
+        i += length;
+    }
+    return out;
+}
+
+void AppendUtf8(std::string& out, char32_t codePoint) {
+    if (codePoint < 0x80) {
+        out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+std::string ReferenceUtf16ToUtf8(const std::u16string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char32_t unit = text[i];
+        if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+            AppendUtf8(out, 0x10000 + ((unit - 0xD800) << 10) + (text[i + 1] - 0xDC00));
+            ++i;
+        } else if (unit >= 0xD800 && unit <= 0xDFFF) {
+            AppendUtf8(out, 0xFFFD);
+        } else {
+            AppendUtf8(out, unit);
+        }
+    }
+    return out;
+}
+
+std::u16string ToUtf16(const std::string& text) {
+    std::u16string out(util::MaxUtf16Length(text.size()), u'\0');
+    const auto result = util::Utf8ToUtf16(text.data(), text.size(), out.data(), out.size());
+    out.resize(result.written);
+    return out;
+}
+
+std::string ToUtf8(const std::u16string& text) {
+    std::string out(util::MaxUtf8Length(text.size()), '\0');
+    const auto result = util::Utf16ToUtf8(text.data(), text.size(), out.data(), out.size());
+    out.resize(result.written);
+    return out;
+}
+
+// Mostly ASCII with runs long enough for the vector paths, salted with
+// multi-byte sequences and, when `broken`, arbitrary bytes.
+std::string RandomUtf8(std::mt19937& rng, size_t length, bool broken) {
+    std::string text;
+    std::uniform_int_distribution<int> pick(0, 99);
+    while (text.size() < length) {
+        const int roll = pick(rng);
+        if (roll < 70) {
+            text.push_back(static_cast<char>('A' + roll % 26));
+        } else if (roll < 80) {
+            AppendUtf8(text, 0x80 + static_cast<char32_t>(rng() % 0x780));
+        } else if (roll < 88) {
+            char32_t codePoint = 0x800 + static_cast<char32_t>(rng() % 0xF800);
+            if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                codePoint = 0xFFFD;
+            }
+            AppendUtf8(text, codePoint);
+        } else if (roll < 94) {
+            AppendUtf8(text, 0x10000 + static_cast<char32_t>(rng() % 0x100000));
+        } else if (broken) {
+            text.push_back(static_cast<char>(0x80 + rng() % 0x80));
+        } else {
+            text.append(static_cast<size_t>(17 + rng() % 40), 'x');
+        }
+    }
+    return text;
+}
+
+TEST_CASE(MatchesReferenceOnEdgeCases) {
+    const std::string cases[] = {
+        "",
+        "plain ascii that is longer than sixteen bytes, twice over",
+        "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80",
+        "\xC0\xAF",                 // overlong
+        "\xE0\x80\xAF",             // overlong three-byte form
+        "\xED\xA0\x80",             // encoded surrogate
+        "\xF4\x90\x80\x80",         // above U+10FFFF
+        "\xF5\x80",                 // invalid lead
+        "\xE2\x82",                 // truncated at end
+        "\xF0\x9F\x98",             // truncated four-byte
+        "\xE2\x82" "A\xF0\x9F" "B", // truncated in the middle
+        "\xEF\xBF\xBD",             // a literal U+FFFD
+        "\x80\x80\x80",
+    };
+    for (const auto& text : cases) {
+        CHECK(ToUtf16(text) == ReferenceUtf8ToUtf16(text));
+    }
+
+    const std::u16string wide[] = {
+        u"",
+        u"plain ascii that is longer than sixteen units, twice over",
+        std::u16string{ 0xD83D, 0xDE00, u'a' },
+        std::u16string{ 0xD83D },
+        std::u16string{ 0xDE00, 0xD83D },
+        std::u16string{ u'a', 0xDC00, u'b', 0xD800, 0xD800, 0xDC00 },
+        std::u16string{ 0x7F, 0x80, 0x7FF, 0x800, 0xFFFF },
+    };
+    for (const auto& text : wide) {
+        CHECK(ToUtf8(text) == ReferenceUtf16ToUtf8(text));
+    }
+}
+
+TEST_CASE(MatchesReferenceOnRandomText) {
+    std::mt19937 rng(27);
+    for (int round = 0; round < 400; ++round) {
+        const bool broken = round % 2 == 1;
+        const auto text = RandomUtf8(rng, 1 + rng() % 600, broken);
+        const auto expected = ReferenceUtf8ToUtf16(text);
+        REQUIRE(ToUtf16(text) == expected);
+        CHECK(ToUtf8(expected) == ReferenceUtf16ToUtf8(expected));
+        if (!broken) {
+            CHECK(util::IsValidUtf8(text.data(), text.size()));
+            CHECK(ToUtf8(expected) == text);
+        }
+    }
+}
+
+TEST_CASE(RandomUtf16IncludingLoneSurrogates) {
+    std::mt19937 rng(16);
+    for (int round = 0; round < 400; ++round) {
+        std::u16string text(1 + rng() % 300, u'\0');
+        for (auto& unit : text) {
+            const auto roll = rng() % 10;
+            unit = static_cast<char16_t>(roll < 6 ? 0x20 + rng() % 0x5F : (roll < 8 ? rng() % 0x10000 : 0xD800 + rng() % 0x800));
+        }
+        CHECK(ToUtf8(text) == ReferenceUtf16ToUtf8(text));
+    }
+}
+
+TEST_CASE(IsValidUtf8RejectsEveryReplacement) {
+    CHECK(util::IsValidUtf8("", 0));
+    CHECK(util::IsValidUtf8("\xEF\xBF\xBD", 3));
+    CHECK(!util::IsValidUtf8("abc\xC0\xAF", 5));
+    CHECK(!util::IsValidUtf8("\xED\xA0\x80", 3));
+    CHECK(!util::IsValidUtf8("\xE2\x82", 2));
+    CHECK(!util::IsValidUtf8("\xF4\x90\x80\x80", 4));
+}
+
+TEST_CASE(StopsBeforeACodePointThatDoesNotFit) {
+    // "ab" then U+1F600 (a surrogate pair): room for three units stops after "ab".
+    const std::string text = "ab\xF0\x9F\x98\x80" "c";
+    char16_t small[3] = {};
+    auto result = util::Utf8ToUtf16(text.data(), text.size(), small, 3);
+    CHECK(result.read == 2);
+    CHECK(result.written == 2);
+
+    char16_t exact[5] = {};
+    result = util::Utf8ToUtf16(text.data(), text.size(), exact, 5);
+    CHECK(result.read == text.size());
+    CHECK(result.written == 5);
+
+    // U+20AC needs three bytes.
+    const std::u16string wide = u"x€";
+    char narrow[3] = {};
+    const auto back = util::Utf16ToUtf8(wide.data(), wide.size(), narrow, 3);
+    CHECK(back.read == 1);
+    CHECK(back.written == 1);
+
+    // A long ASCII run is cut exactly at the capacity.
+    const std::string ascii(100, 'q');
+    char16_t partial[37] = {};
+    result = util::Utf8ToUtf16(ascii.data(), ascii.size(), partial, 37);
+    CHECK(result.read == 37);
+    CHECK(result.written == 37);
+}
+
+} // namespace
@@ -0,0 +1,190 @@
+#include "ZipWriter.h"
+
+#include "Check.h"
+#include "Digest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+std::string ReadText(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+uint32_t U16(const std::string& bytes, size_t at) {
+    return static_cast<uint8_t>(bytes[at]) | (static_cast<uint32_t>(static_cast<uint8_t>(bytes[at + 1])) << 8);
+}
+
+uint32_t U32(const std::string& bytes, size_t at) {
+    return U16(bytes, at) | (U16(bytes, at + 2) << 16);
+}
+
+uint64_t U64(const std::string& bytes, size_t at) {
+    return U32(bytes, at) | (static_cast<uint64_t>(U32(bytes, at + 4)) << 32);
+}
+
+struct Listed {
+    uint32_t crc = 0;
+    std::string data;
+    bool stored = false;
+};
+
+// Minimal reader: follows the end record (and its ZIP64 form) to the central
+// directory and pulls each entry's data through its local header. Enough to
+// check what the writer produced without an unzip tool.
+bool ReadArchive(const fs::path& path, std::map<std::string, Listed>& entries, uint64_t& count) {
+    const auto bytes = ReadText(path);
+    if (bytes.size() < 22 || U32(bytes, bytes.size() - 22) != 0x06054b50) {
+        return false;
+    }
+    const size_t end = bytes.size() - 22;
+    count = U16(bytes, end + 10);
+    uint64_t directory = U32(bytes, end + 16);
+    if (count == 0xFFFF) {
+        if (end < 20 || U32(bytes, end - 20) != 0x07064b50) {
+            return false;
+        }
+        const auto zip64End = static_cast<size_t>(U64(bytes, end - 20 + 8));
+        if (U32(bytes, zip64End) != 0x06064b50) {
+            return false;
+        }
+        count = U64(bytes, zip64End + 32);
+        directory = U64(bytes, zip64End + 48);
+    }
+    auto at = static_cast<size_t>(directory);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (U32(bytes, at) != 0x02014b50) {
+            return false;
+        }
+        Listed entry;
+        entry.stored = U16(bytes, at + 10) == 0;
+        entry.crc = U32(bytes, at + 16);
+        const uint32_t size = U32(bytes, at + 24);
+        const uint32_t nameLength = U16(bytes, at + 28);
+        const uint32_t extra = U16(bytes, at + 30);
+        const uint32_t comment = U16(bytes, at + 32);
+        const uint32_t local = U32(bytes, at + 42);
+        const auto name = bytes.substr(at + 46, nameLength);
+        if (U32(bytes, local) != 0x04034b50 || U32(bytes, local + 14) != entry.crc) {
+            return false;
+        }
+        const size_t data = local + 30 + U16(bytes, local + 26) + U16(bytes, local + 28);
+        entry.data = bytes.substr(data, size);
+        entries[name] = std::move(entry);
+        at += 46 + nameLength + extra + comment;
+    }
+    return at == bytes.size() - 22 - (count >= 0xFFFF ? 76 : 0);
+}
+
+uint32_t Crc(const std::string& text) {
+    return digest::Crc32(text.data(), text.size());
+}
+
+// `unzip -t` where it is installed; true when it is not.
+bool StandardToolAccepts(const fs::path& archive) {
+#ifdef _WIN32
+    (void)archive;
+    return true;
+#else
+    if (std::system("command -v unzip > /dev/null 2>&1") != 0) {
+        std::printf("unzip not found; skipping the standard tool check\n");
+        return true;
+    }
+    const std::string command = "unzip -tqq '" + archive.string() + "' > /dev/null";
+    return std::system(command.c_str()) == 0;
+#endif
+}
+
+TEST_CASE(StoredEntriesReadBack) {
+    check::TempDir dir;
+    const auto source = dir.Path() / "shot_0002.png";
+    std::string png(300000, '\0');
+    for (size_t i = 0; i < png.size(); ++i) {
+        png[i] = static_cast<char>((i * 131) ^ (i >> 7));
+    }
+    std::ofstream(source, std::ios::binary) << png;
+    const std::string manifest = "CHRNMNFT manifest bytes";
+    const std::string name = "raw/caf\xC3\xA9 \xE2\x82\xAC.png";
+
+    const auto archive = dir.Path() / "session.zip";
+    ZipWriter writer;
+    REQUIRE(writer.Open(archive, 1'760'000'000));
+    CHECK(writer.AddBytes("session.manifest", manifest.data(), manifest.size()));
+    CHECK(writer.AddFile("raw/shot_0002.png", source));
+    CHECK(writer.AddBytes("empty.txt", "", 0));
+    CHECK(writer.AddBytes(name, "x", 1));
+    CHECK(!writer.AddBytes("", "x", 1));
+    CHECK(!writer.AddFile("raw/missing.png", dir.Path() / "missing.png"));
+    REQUIRE(writer.Finish());
+    CHECK(!writer.IsOpen());
+    CHECK(writer.BytesWritten() == fs::file_size(archive));
+    // Stored entries: the archive is the payload plus headers.
+    CHECK(fs::file_size(archive) < png.size() + manifest.size() + 1024);
+
+    std::map<std::string, Listed> entries;
+    uint64_t count = 0;
+    REQUIRE(ReadArchive(archive, entries, count));
+    CHECK(count == 4);
+    CHECK(entries["session.manifest"].data == manifest);
+    CHECK(entries["session.manifest"].crc == Crc(manifest));
+    CHECK(entries["raw/shot_0002.png"].data == png);
+    CHECK(entries["raw/shot_0002.png"].crc == Crc(png));
+    CHECK(entries["raw/shot_0002.png"].stored);
+    CHECK(entries["empty.txt"].data.empty());
+    CHECK(entries[name].data == "x");
+    CHECK(StandardToolAccepts(archive));
+
+#ifndef _WIN32
+    if (std::system("command -v unzip > /dev/null 2>&1") == 0) {
+        const auto extracted = dir.Path() / "extracted";
+        const std::string command = "unzip -qq '" + archive.string() + "' -d '" + extracted.string() + "'";
+        REQUIRE(std::system(command.c_str()) == 0);
+        CHECK(ReadText(extracted / "raw" / "shot_0002.png") == png);
+        CHECK(ReadText(extracted / "session.manifest") == manifest);
+    }
+#endif
+}
+
+TEST_CASE(AbortRemovesThePartialArchive) {
+    check::TempDir dir;
+    const auto archive = dir.Path() / "partial.zip";
+    ZipWriter writer;
+    REQUIRE(writer.Open(archive));
+    CHECK(writer.AddBytes("a.txt", "abc", 3));
+    writer.Abort();
+    CHECK(!fs::exists(archive));
+    CHECK(!writer.AddBytes("b.txt", "abc", 3));
+    CHECK(!writer.Finish());
+}
+
+TEST_CASE(ManyEntriesSwitchToZip64) {
+    check::TempDir dir;
+    const auto archive = dir.Path() / "many.zip";
+    constexpr uint32_t kEntries = 70000;
+    ZipWriter writer;
+    REQUIRE(writer.Open(archive));
+    for (uint32_t i = 0; i < kEntries; ++i) {
+        const auto text = std::to_string(i);
+        REQUIRE(writer.AddBytes("f/" + text, text.data(), text.size()));
+    }
+    REQUIRE(writer.Finish());
+
+    std::map<std::string, Listed> entries;
+    uint64_t count = 0;
+    REQUIRE(ReadArchive(archive, entries, count));
+    CHECK(count == kEntries);
+    CHECK(entries.size() == kEntries);
+    CHECK(entries["f/69999"].data == "69999");
+    CHECK(entries["f/0"].crc == Crc("0"));
+    CHECK(StandardToolAccepts(archive));
+}
+
+} // namespace